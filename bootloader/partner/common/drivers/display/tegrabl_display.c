@@ -23,6 +23,11 @@
 #include <tegrabl_display_dtb.h>
 #include <tegrabl_timer.h>
 #include <tegrabl_display_soc.h>
+#if defined(CONFIG_ENABLE_DISPLAY_ASYNC_INIT)
+#include <string.h>
+#include <kernel/thread.h>
+#include <kernel/mutex.h>
+#endif
 
 #define TEXT_SIZE   1024
 
@@ -32,6 +37,175 @@ struct tegrabl_display {
 };
 static struct tegrabl_display *hdisplay;
 
+#if defined(CONFIG_ENABLE_DISPLAY_ASYNC_INIT)
+#define DISPLAY_INIT_STACK_SIZE		16384U
+#define DISPLAY_DEFERRED_OPS_MAX	32U
+
+enum display_state {
+	DISPLAY_STATE_IDLE,		/* async init not started */
+	DISPLAY_STATE_INIT,		/* probe, mode set and link training running */
+	DISPLAY_STATE_FLUSH,	/* replaying the requests made during init */
+	DISPLAY_STATE_DONE,		/* hdisplay is final, NULL if init failed */
+};
+
+enum display_op_type {
+	DISPLAY_OP_CLEAR,
+	DISPLAY_OP_PRINTF,
+	DISPLAY_OP_SHOW_IMAGE,
+	DISPLAY_OP_SET_CURSOR,
+};
+
+/* Request made while the display was still initializing */
+struct display_op {
+	enum display_op_type type;
+	union {
+		struct {
+			color_t color;
+			char *text;
+		} printf;
+		struct tegrabl_image_info image;
+		cursor_position_t position;
+	} u;
+};
+
+static thread_t *display_thread;
+static mutex_t display_lock = MUTEX_INITIAL_VALUE(display_lock);
+static enum display_state display_state;
+static struct display_op display_ops[DISPLAY_DEFERRED_OPS_MAX];
+static uint32_t display_num_ops;
+
+/**
+ * @brief Queues op if the display is still initializing. Requests from the
+ * init thread itself (the replay) are never queued.
+ *
+ * @return true if op was queued, false if it has to be executed now
+ */
+static bool display_defer(struct display_op *op)
+{
+	bool deferred = false;
+
+	if ((display_thread == NULL) || (current_thread == display_thread)) {
+		return false;
+	}
+
+	mutex_acquire(&display_lock);
+	if (((display_state == DISPLAY_STATE_INIT) || (display_state == DISPLAY_STATE_FLUSH)) &&
+		(display_num_ops < DISPLAY_DEFERRED_OPS_MAX)) {
+		display_ops[display_num_ops++] = *op;
+		deferred = true;
+	}
+	mutex_release(&display_lock);
+
+	if (!deferred) {
+		/* Queue full, or init done: keep the order by finishing init first */
+		tegrabl_display_wait_init();
+	}
+
+	return deferred;
+}
+
+static void display_op_run(struct display_op *op)
+{
+	switch (op->type) {
+	case DISPLAY_OP_CLEAR:
+		(void)tegrabl_display_clear();
+		break;
+	case DISPLAY_OP_PRINTF:
+		(void)tegrabl_display_printf(op->u.printf.color, "%s", op->u.printf.text);
+		break;
+	case DISPLAY_OP_SHOW_IMAGE:
+		(void)tegrabl_display_show_image(&op->u.image);
+		break;
+	case DISPLAY_OP_SET_CURSOR:
+		(void)tegrabl_display_text_set_cursor(op->u.position);
+		break;
+	default:
+		break;
+	}
+}
+
+static int display_init_thread(void *arg)
+{
+	struct display_op op;
+	uint32_t i;
+	bool flush;
+
+	TEGRABL_UNUSED(arg);
+
+	if (tegrabl_display_init() != TEGRABL_NO_ERROR) {
+		pr_warn("display init failed\n");
+	}
+
+	mutex_acquire(&display_lock);
+	display_state = DISPLAY_STATE_FLUSH;
+	mutex_release(&display_lock);
+
+	/* Replay in order; requests made meanwhile are appended and replayed too */
+	for (i = 0; ; i++) {
+		mutex_acquire(&display_lock);
+		flush = (i < display_num_ops);
+		if (flush) {
+			op = display_ops[i];
+		} else {
+			display_num_ops = 0;
+			display_state = DISPLAY_STATE_DONE;
+		}
+		mutex_release(&display_lock);
+		if (!flush) {
+			break;
+		}
+
+		if (hdisplay != NULL) {
+			display_op_run(&op);
+		}
+		if (op.type == DISPLAY_OP_PRINTF) {
+			tegrabl_free(op.u.printf.text);
+		}
+	}
+
+	return 0;
+}
+
+tegrabl_error_t tegrabl_display_init_async(void)
+{
+	if (display_thread != NULL) {
+		return TEGRABL_NO_ERROR;
+	}
+
+	display_state = DISPLAY_STATE_INIT;
+	display_thread = thread_create("display_init", display_init_thread, NULL,
+								   DEFAULT_PRIORITY, DISPLAY_INIT_STACK_SIZE);
+	if (display_thread == NULL) {
+		pr_warn("Failed to create display init thread\n");
+		display_state = DISPLAY_STATE_IDLE;
+		return tegrabl_display_init();
+	}
+	thread_resume(display_thread);
+
+	return TEGRABL_NO_ERROR;
+}
+
+void tegrabl_display_wait_init(void)
+{
+	bool done;
+
+	if ((display_thread == NULL) || (current_thread == display_thread)) {
+		return;
+	}
+
+	/* Polled instead of joined as more than one thread may wait */
+	while (true) {
+		mutex_acquire(&display_lock);
+		done = (display_state == DISPLAY_STATE_DONE);
+		mutex_release(&display_lock);
+		if (done) {
+			break;
+		}
+		thread_sleep(1);
+	}
+}
+#endif
+
 tegrabl_error_t tegrabl_display_init(void)
 {
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
@@ -97,17 +271,36 @@ tegrabl_error_t tegrabl_display_printf(color_t color,
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
 	uint32_t du_idx = 0;
 
-	if (!hdisplay) {
-		pr_error("%s: display is not initialized\n", __func__);
-		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_INITIALIZED, 0);
-		goto fail;
-	}
+#if defined(CONFIG_ENABLE_DISPLAY_ASYNC_INIT)
+	struct display_op op;
+#endif
 
 	/* prepare text */
 	va_start(ap, format);
 	tegrabl_vsnprintf(text, sizeof(text), format, ap);
 	va_end(ap);
 
+#if defined(CONFIG_ENABLE_DISPLAY_ASYNC_INIT)
+	op.type = DISPLAY_OP_PRINTF;
+	op.u.printf.color = color;
+	op.u.printf.text = tegrabl_malloc(strlen(text) + 1U);
+	if (op.u.printf.text == NULL) {
+		tegrabl_display_wait_init();
+	} else {
+		strcpy(op.u.printf.text, text);
+		if (display_defer(&op)) {
+			goto fail;
+		}
+		tegrabl_free(op.u.printf.text);
+	}
+#endif
+
+	if (!hdisplay) {
+		pr_error("%s: display is not initialized\n", __func__);
+		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_INITIALIZED, 0);
+		goto fail;
+	}
+
 	for (du_idx = 0; du_idx < hdisplay->n_du; du_idx++) {
 		err = tegrabl_display_unit_printf(hdisplay->du[du_idx], color, text);
 		if (err != TEGRABL_NO_ERROR) {
@@ -126,6 +319,20 @@ tegrabl_error_t tegrabl_display_show_image(struct tegrabl_image_info *image)
 	struct tegrabl_display_unit_params *disp_param = NULL;
 	struct tegrabl_bmp_image bmp_img = {0};
 	uint32_t du_idx = 0;
+#if defined(CONFIG_ENABLE_DISPLAY_ASYNC_INIT)
+	struct display_op op;
+#endif
+
+#if defined(CONFIG_ENABLE_DISPLAY_ASYNC_INIT)
+	op.type = DISPLAY_OP_SHOW_IMAGE;
+	op.u.image = *image;
+	/* User buffers may not outlive the call, only blob images are queued */
+	if (image->type == IMAGE_USER_DEFINED) {
+		tegrabl_display_wait_init();
+	} else if (display_defer(&op)) {
+		goto fail;
+	}
+#endif
 
 	if (!hdisplay) {
 		pr_error("%s: display is not initialized\n", __func__);
@@ -200,6 +407,16 @@ tegrabl_error_t tegrabl_display_clear(void)
 {
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
 	uint32_t du_idx = 0;
+#if defined(CONFIG_ENABLE_DISPLAY_ASYNC_INIT)
+	struct display_op op;
+#endif
+
+#if defined(CONFIG_ENABLE_DISPLAY_ASYNC_INIT)
+	op.type = DISPLAY_OP_CLEAR;
+	if (display_defer(&op)) {
+		goto fail;
+	}
+#endif
 
 	if (!hdisplay) {
 		pr_error("%s: display is not initialized\n", __func__);
@@ -227,6 +444,17 @@ tegrabl_error_t tegrabl_display_text_set_cursor(cursor_position_t position)
 {
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
 	uint32_t du_idx = 0;
+#if defined(CONFIG_ENABLE_DISPLAY_ASYNC_INIT)
+	struct display_op op;
+#endif
+
+#if defined(CONFIG_ENABLE_DISPLAY_ASYNC_INIT)
+	op.type = DISPLAY_OP_SET_CURSOR;
+	op.u.position = position;
+	if (display_defer(&op)) {
+		goto fail;
+	}
+#endif
 
 	if (!hdisplay) {
 		pr_error("%s: display is not initialized\n", __func__);
@@ -253,6 +481,10 @@ tegrabl_error_t tegrabl_display_shutdown(void)
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
 	uint32_t du_idx = 0;
 
+#if defined(CONFIG_ENABLE_DISPLAY_ASYNC_INIT)
+	tegrabl_display_wait_init();
+#endif
+
 	if (!hdisplay) {
 		pr_error("%s: display is not initialized\n", __func__);
 		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_INITIALIZED, 4);
@@ -279,6 +511,11 @@ tegrabl_error_t tegrabl_display_get_params(
 {
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
 
+#if defined(CONFIG_ENABLE_DISPLAY_ASYNC_INIT)
+	/* The kernel gets the mode and framebuffer of the final configuration */
+	tegrabl_display_wait_init();
+#endif
+
 	if (!hdisplay || du_idx >= hdisplay->n_du) {
 		pr_debug("%s: display or du %d is not initialized\n", __func__, du_idx);
 		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_INITIALIZED, 5);
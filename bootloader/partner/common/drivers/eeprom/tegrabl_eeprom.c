@@ -62,6 +62,43 @@ static tegrabl_error_t verify_eeprom_data(struct tegrabl_eeprom *eeprom)
 	return TEGRABL_NO_ERROR;
 }
 
+static uint32_t eeprom_get_retry_count(tegrabl_instance_i2c_t instance)
+{
+	uint32_t retry_count;
+
+	switch (instance) {
+	case TEGRABL_INSTANCE_I2C2:
+		retry_count = TEGRABL_I2C2_RETRY_COUNT;
+		break;
+	default:
+		retry_count = TEGRABL_I2C_DEFAULT_RETRY_COUNT;
+		break;
+	}
+
+	return retry_count;
+}
+
+static tegrabl_error_t verify_eeprom(struct tegrabl_eeprom *eeprom)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	/*
+	 * Only applicable to CVM as it stores NVCB (nvidia configuration block)
+	 * and we are only concern about the version of that EEPROM and its layout
+	 */
+	if ((eeprom->name != NULL) && (strcmp(eeprom->name, "cvm") == 0)) {
+		error = verify_cvm_eeprom_version(eeprom);
+		if (error != TEGRABL_NO_ERROR) {
+			return error;
+		}
+	}
+
+	if (eeprom->crc_valid)
+		error = verify_eeprom_data(eeprom);
+
+	return error;
+}
+
 tegrabl_error_t tegrabl_eeprom_read(struct tegrabl_eeprom *eeprom)
 {
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
@@ -83,14 +120,7 @@ tegrabl_error_t tegrabl_eeprom_read(struct tegrabl_eeprom *eeprom)
 		goto fail;
 	}
 
-	switch (hi2c_dev->instance) {
-	case TEGRABL_INSTANCE_I2C2:
-		retry_count = TEGRABL_I2C2_RETRY_COUNT;
-		break;
-	default:
-		retry_count = TEGRABL_I2C_DEFAULT_RETRY_COUNT;
-		break;
-	}
+	retry_count = eeprom_get_retry_count(hi2c_dev->instance);
 
 	while (retry_count != 0) {
 		error = tegrabl_i2c_dev_read(hi2c_dev, eeprom->data, 0, eeprom->size);
@@ -109,20 +139,94 @@ tegrabl_error_t tegrabl_eeprom_read(struct tegrabl_eeprom *eeprom)
 		goto fail;
 	}
 
-	/*
-	 * Only applicable to CVM as it stores NVCB (nvidia configuration block)
-	 * and we are only concern about the version of that EEPROM and its layout
-	 */
-	if ((eeprom->name != NULL) && (strcmp(eeprom->name, "cvm") == 0)) {
-		error = verify_cvm_eeprom_version(eeprom);
-		if (error != TEGRABL_NO_ERROR) {
-			goto fail;
-		}
+	error = verify_eeprom(eeprom);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
 	}
 
-	if (eeprom->crc_valid)
-		error = verify_eeprom_data(eeprom);
+	return TEGRABL_NO_ERROR;
+
+fail:
+	TEGRABL_SET_HIGHEST_MODULE(error);
+	return error;
+}
+
+/* Same transactions as tegrabl_i2c_dev_read() of the whole eeprom: offset 0
+ * is written with a repeat start, then the data is read */
+static tegrabl_error_t eeprom_start_transfer(struct tegrabl_eeprom *eeprom)
+{
+	uint8_t offset = 0;
+
+	return tegrabl_i2c_write_read_start(eeprom->hi2c, eeprom->slave_addr, &offset, sizeof(offset),
+										eeprom->data, eeprom->size);
+}
+
+tegrabl_error_t tegrabl_eeprom_read_start(struct tegrabl_eeprom *eeprom)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	if ((eeprom == NULL) || (eeprom->size > MAX_I2C_TRANSFER_SIZE)) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+		goto fail;
+	}
+
+	eeprom->hi2c = tegrabl_i2c_open(eeprom->instance);
+	if (eeprom->hi2c == NULL) {
+		pr_error("eeprom: Can't get handle to eeprom device @%d\n",
+				 eeprom->slave_addr);
+		error = TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, 0);
+		goto fail;
+	}
+	eeprom->retries_left = eeprom_get_retry_count(eeprom->instance) - 1U;
+
+	error = eeprom_start_transfer(eeprom);
+	while ((error != TEGRABL_NO_ERROR) && (eeprom->retries_left != 0U)) {
+		pr_error("eeprom: Retry to read I2C slave device.\n");
+		eeprom->retries_left--;
+		error = eeprom_start_transfer(eeprom);
+	}
+
+	if (error != TEGRABL_NO_ERROR) {
+		pr_error("eeprom: Failed to read I2C slave device\n");
+		goto fail;
+	}
+
+	return TEGRABL_NO_ERROR;
+
+fail:
+	TEGRABL_SET_HIGHEST_MODULE(error);
+	return error;
+}
+
+tegrabl_error_t tegrabl_eeprom_read_poll(struct tegrabl_eeprom *eeprom)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	if ((eeprom == NULL) || (eeprom->hi2c == NULL)) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+		goto fail;
+	}
+
+	error = tegrabl_i2c_read_poll(eeprom->hi2c);
+	if (TEGRABL_ERROR_REASON(error) == TEGRABL_ERR_NOT_READY) {
+		return error;
+	}
+
+	if (error != TEGRABL_NO_ERROR) {
+		if (eeprom->retries_left != 0U) {
+			pr_error("eeprom: Retry to read I2C slave device.\n");
+			eeprom->retries_left--;
+			error = eeprom_start_transfer(eeprom);
+			if (error == TEGRABL_NO_ERROR) {
+				return TEGRABL_ERROR(TEGRABL_ERR_NOT_READY, 0);
+			}
+		}
+		pr_error("eeprom: Failed to read I2C slave device\n");
+		goto fail;
+	}
 
+	/* Check the data as soon as it is in, other reads may still be going */
+	error = verify_eeprom(eeprom);
 	if (error != TEGRABL_NO_ERROR) {
 		goto fail;
 	}
@@ -79,6 +79,7 @@ extern err_t low_level_input(void);
 #define MDIO_TRANSFER_TIMEOUT_USEC						2000U
 #define DMA_RESET_TIMEOUT_USEC							2000U
 #define MTL_TXQ_FLUSH_TIMEOUT_USEC						1000U
+#define AUTO_CALIB_START_TIMEOUT_USEC					100U
 #define AUTO_CALIB_TIMEOUT_USEC							2000U
 
 #define GPIO_PROP_PHANDLE								0U
@@ -649,7 +650,6 @@ static tegrabl_error_t tegrabl_eqos_program_pll(void)
 	}
 
 fail:
-	tegrabl_mdelay(1000);
 	return err;
 }
 
@@ -898,12 +898,20 @@ static tegrabl_error_t tegrabl_eqos_auto_calib(void)
 		  BIT(ETHER_QOS_AUTO_CAL_CONFIG_0_AUTO_CAL_START)	|
 		  BIT(ETHER_QOS_AUTO_CAL_CONFIG_0_AUTO_CAL_ENABLE);
 	NV_WRITE32(REG_ETHER_QOS_AUTO_CAL_CONFIG_0, val);
-	tegrabl_mdelay(1000);
+
+	/* ACTIVE goes high within a few usec of START, then low once done */
+	err = wait_for_bit(REG_ETHER_QOS_AUTO_CAL_STATUS_0, ETHER_QOS_AUTO_CAL_STATUS_0_AUTO_CAL_ACTIVE, SET,
+					   AUTO_CALIB_START_TIMEOUT_USEC);
+	if (err != TEGRABL_NO_ERROR) {
+		pr_error("Auto-calibration did not start\n");
+		goto fail;
+	}
 
 	pr_info("Wait till auto-calibration completes...\n");
 	err = wait_for_bit(REG_ETHER_QOS_AUTO_CAL_STATUS_0, ETHER_QOS_AUTO_CAL_STATUS_0_AUTO_CAL_ACTIVE, RESET,
 					   AUTO_CALIB_TIMEOUT_USEC);
 
+fail:
 	return err;
 }
 
@@ -19,6 +19,7 @@
 #include <tegrabl_io.h>
 #include <tegrabl_debug.h>
 #include <tegrabl_error.h>
+#include <tegrabl_utils.h>
 #include <tegrabl_gpcdma.h>
 #include <tegrabl_clock.h>
 #include <tegrabl_dmamap.h>
@@ -81,6 +82,14 @@
 
 #define MAX_TRANSFER_SIZE				(1U*1024U*1024U*1024U)	/* 1GB */
 
+/* Async copy engine: GPCDMA channels owned by it (0 is used by the sync
+ * utility APIs, 1-2 by QSPI), depth of the software descriptor queue and the
+ * size requests are split into so that large moves spread across channels */
+#define DMA_ASYNC_FIRST_CHANNEL				(4U)
+#define DMA_ASYNC_NUM_CHANNELS				(4U)
+#define DMA_ASYNC_QUEUE_DEPTH				(32U)
+#define DMA_ASYNC_CHUNK_SIZE				(4U*1024U*1024U)
+
 struct s_dma_plat_data {
 	tegrabl_dmatype_t dma_type;
 	uint8_t max_channel_num;
@@ -123,6 +132,26 @@ struct s_dma_privdata {
 
 static struct s_dma_privdata g_dma_data[DMA_MAX_NUM];
 
+struct dma_async_desc {
+	struct tegrabl_dma_xfer_params params;
+	tegrabl_dma_fence_t seq;
+};
+
+/* Descriptors wait in queue[] (oldest at head) until a channel frees up and
+ * are numbered in submission order, a fence is the number of the last
+ * descriptor of a request */
+struct dma_async_state {
+	tegrabl_gpcdma_handle_t handle;
+	struct dma_async_desc queue[DMA_ASYNC_QUEUE_DEPTH];
+	uint32_t head;
+	uint32_t count;
+	struct dma_async_desc chan[DMA_ASYNC_NUM_CHANNELS];
+	bool chan_busy[DMA_ASYNC_NUM_CHANNELS];
+	tegrabl_dma_fence_t next_seq;
+};
+
+static struct dma_async_state g_dma_async;
+
 tegrabl_gpcdma_handle_t tegrabl_dma_request(tegrabl_dmatype_t dma_type)
 {
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
@@ -592,6 +621,215 @@ int tegrabl_dma_memset(void *priv, void *s, uint32_t c, size_t size)
 	return ret;
 }
 
+/* Does a descriptor on the CPU, used if the DMA could not be started */
+static void dma_async_cpu_fallback(struct tegrabl_dma_xfer_params *params)
+{
+	if (params->dir == DMA_PATTERN_FILL) {
+		memset((void *)params->dst, (int32_t)(params->pattern & 0xFFU), params->size);
+	} else {
+		memcpy((void *)params->dst, (void *)params->src, params->size);
+	}
+}
+
+/* Retires finished descriptors and starts queued ones on idle channels */
+static void dma_async_pump(struct dma_async_state *state)
+{
+	struct dma_async_desc *desc;
+	tegrabl_error_t err;
+	uint8_t c_num;
+	uint32_t i;
+
+	for (i = 0; i < DMA_ASYNC_NUM_CHANNELS; i++) {
+		c_num = (uint8_t)(DMA_ASYNC_FIRST_CHANNEL + i);
+		desc = &state->chan[i];
+
+		if (state->chan_busy[i]) {
+			err = tegrabl_dma_transfer_status(state->handle, c_num, &desc->params);
+			if (TEGRABL_ERROR_REASON(err) == TEGRABL_ERR_BUSY) {
+				continue;
+			}
+			state->chan_busy[i] = false;
+		}
+
+		if (state->count == 0U) {
+			continue;
+		}
+
+		*desc = state->queue[state->head];
+		state->head = (state->head + 1U) % DMA_ASYNC_QUEUE_DEPTH;
+		state->count--;
+
+		err = tegrabl_dma_transfer(state->handle, c_num, &desc->params);
+		if (err != TEGRABL_NO_ERROR) {
+			pr_warn("dma: channel %u failed to start (err 0x%08x), copying on cpu\n", c_num, err);
+			dma_async_cpu_fallback(&desc->params);
+			continue;
+		}
+		state->chan_busy[i] = true;
+	}
+}
+
+static tegrabl_error_t dma_async_submit(tegrabl_dmatransferdir_t dir, uintptr_t dst, uintptr_t src,
+										uint32_t pattern, size_t size, tegrabl_dma_fence_t *fence)
+{
+	struct dma_async_state *state = &g_dma_async;
+	struct dma_async_desc *desc;
+	uint32_t chunk;
+	uint32_t tail;
+
+	if (state->handle == NULL) {
+		state->handle = tegrabl_dma_request(DMA_GPC);
+		if (state->handle == NULL) {
+			return TEGRABL_ERROR(TEGRABL_ERR_NOT_INITIALIZED, AUX_INFO_DMA_ASYNC_SUBMIT);
+		}
+		state->next_seq = 1U;
+	}
+
+	while (size != 0U) {
+		while (state->count == DMA_ASYNC_QUEUE_DEPTH) {
+			dma_async_pump(state);
+		}
+
+		chunk = (uint32_t)MIN(size, (size_t)DMA_ASYNC_CHUNK_SIZE);
+		tail = (state->head + state->count) % DMA_ASYNC_QUEUE_DEPTH;
+		desc = &state->queue[tail];
+		desc->params.src = src;
+		desc->params.dst = dst;
+		desc->params.size = chunk;
+		desc->params.pattern = pattern;
+		desc->params.is_async_xfer = true;
+		desc->params.dir = dir;
+		desc->params.io = 0;
+		desc->params.io_bus_width = BUS_WIDTH_32;
+		desc->seq = state->next_seq;
+		state->next_seq++;
+		state->count++;
+
+		dst += chunk;
+		if (dir == DMA_MEM_TO_MEM) {
+			src += chunk;
+		}
+		size -= chunk;
+	}
+
+	if (fence != NULL) {
+		*fence = state->next_seq - 1U;
+	}
+	dma_async_pump(state);
+
+	return TEGRABL_NO_ERROR;
+}
+
+tegrabl_error_t tegrabl_dma_memcpy_async(void *dest, const void *src, size_t size,
+										 tegrabl_dma_fence_t *fence)
+{
+	size_t dma_size = size & ~(size_t)0x3U;
+
+	if ((dest == NULL) || (src == NULL)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, AUX_INFO_DMA_ASYNC_SUBMIT);
+	}
+	pr_trace("%s(%p,%p,%u)\n", __func__, dest, src, (uint32_t)size);
+
+	if (fence != NULL) {
+		*fence = 0;
+	}
+
+	/* Engine moves words only, anything else is done right away */
+	if (((((uintptr_t)dest) & 0x3UL) != 0UL) || ((((uintptr_t)src) & 0x3UL) != 0UL)) {
+		memcpy(dest, src, size);
+		return TEGRABL_NO_ERROR;
+	}
+	if (dma_size != size) {
+		memcpy((uint8_t *)dest + dma_size, (const uint8_t *)src + dma_size, size - dma_size);
+	}
+
+	return dma_async_submit(DMA_MEM_TO_MEM, (uintptr_t)dest, (uintptr_t)src, 0, dma_size, fence);
+}
+
+tegrabl_error_t tegrabl_dma_memset_async(void *s, uint32_t c, size_t size,
+										 tegrabl_dma_fence_t *fence)
+{
+	size_t dma_size = size & ~(size_t)0x3U;
+
+	if (s == NULL) {
+		return TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, AUX_INFO_DMA_ASYNC_SUBMIT);
+	}
+	pr_trace("%s(%p,%u,%u)\n", __func__, s, c, (uint32_t)size);
+
+	if (fence != NULL) {
+		*fence = 0;
+	}
+
+	if ((((uintptr_t)s) & 0x3UL) != 0UL) {
+		memset(s, (int32_t)c, size);
+		return TEGRABL_NO_ERROR;
+	}
+	if (dma_size != size) {
+		memset((uint8_t *)s + dma_size, (int32_t)c, size - dma_size);
+	}
+
+	c &= 0xffU;
+	c |= c << 8;
+	c |= c << 16;
+
+	return dma_async_submit(DMA_PATTERN_FILL, (uintptr_t)s, 0, c, dma_size, fence);
+}
+
+bool tegrabl_dma_fence_signaled(tegrabl_dma_fence_t fence)
+{
+	struct dma_async_state *state = &g_dma_async;
+	tegrabl_dma_fence_t oldest = state->next_seq;
+	uint32_t i;
+
+	if (fence == 0U) {
+		return true;
+	}
+
+	dma_async_pump(state);
+
+	/* Signaled once every descriptor up to and including the fence is done */
+	if (state->count != 0U) {
+		oldest = state->queue[state->head].seq;
+	}
+	for (i = 0; i < DMA_ASYNC_NUM_CHANNELS; i++) {
+		if (state->chan_busy[i] && (state->chan[i].seq < oldest)) {
+			oldest = state->chan[i].seq;
+		}
+	}
+
+	return fence < oldest;
+}
+
+/* Stops the async channels and drops every queued descriptor */
+static void dma_async_cancel(struct dma_async_state *state)
+{
+	uint32_t i;
+
+	for (i = 0; i < DMA_ASYNC_NUM_CHANNELS; i++) {
+		if (state->chan_busy[i]) {
+			tegrabl_dma_transfer_abort(state->handle, (uint8_t)(DMA_ASYNC_FIRST_CHANNEL + i));
+			state->chan_busy[i] = false;
+		}
+	}
+	state->head = 0;
+	state->count = 0;
+}
+
+tegrabl_error_t tegrabl_dma_fence_wait(tegrabl_dma_fence_t fence, time_t timeout_us)
+{
+	time_t start = tegrabl_get_timestamp_us();
+
+	while (!tegrabl_dma_fence_signaled(fence)) {
+		if ((tegrabl_get_timestamp_us() - start) > timeout_us) {
+			pr_error("dma: fence %" PRIu64 " not signaled in %" PRIu64 " us\n", fence, timeout_us);
+			dma_async_cancel(&g_dma_async);
+			return TEGRABL_ERROR(TEGRABL_ERR_TIMEOUT, AUX_INFO_DMA_FENCE_WAIT);
+		}
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
 static struct tegrabl_clib_dma clib_dma;
 
 void tegrabl_dma_enable_clib_callbacks(tegrabl_dmatype_t dma_type,
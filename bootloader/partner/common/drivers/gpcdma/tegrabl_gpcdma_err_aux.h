@@ -18,6 +18,8 @@
 #define AUX_INFO_DMA_TRANSFER_STATUS	0x3U
 #define AUX_INFO_INIT_SCRUB_DMA_1		0x4U
 #define AUX_INFO_INIT_SCRUB_DMA_2		0x5U
+#define AUX_INFO_DMA_ASYNC_SUBMIT		0x6U
+#define AUX_INFO_DMA_FENCE_WAIT			0x7U
 
 #endif
 
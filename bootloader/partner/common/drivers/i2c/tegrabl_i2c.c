@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2019, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2015-2020, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -31,12 +31,75 @@
 #include <tegrabl_i2c_soc_common.h>
 #include <ari2c.h>
 #include <tegrabl_i2c_err_aux.h>
+#if defined(CONFIG_ENABLE_I2C_LOCK)
+#include <kernel/mutex.h>
+#endif
 
 /**
  * @brief List of controllers
  */
 static struct list_node i2c_list;
 
+#if defined(CONFIG_ENABLE_I2C_LOCK)
+/**
+ * @brief Serializes lookups and additions to the list of controllers, the
+ * background display init opens controllers while the boot thread does too.
+ */
+static mutex_t i2c_list_lock = MUTEX_INITIAL_VALUE(i2c_list_lock);
+
+static inline void i2c_list_lock_acquire(void)
+{
+	mutex_acquire(&i2c_list_lock);
+}
+
+static inline void i2c_list_lock_release(void)
+{
+	mutex_release(&i2c_list_lock);
+}
+
+static inline void i2c_lock_init(struct tegrabl_i2c *hi2c)
+{
+	mutex_init(&hi2c->lock);
+}
+
+static inline void i2c_lock_acquire(struct tegrabl_i2c *hi2c)
+{
+	mutex_acquire(&hi2c->lock);
+}
+
+static inline void i2c_lock_release(struct tegrabl_i2c *hi2c)
+{
+	mutex_release(&hi2c->lock);
+}
+#else
+static inline void i2c_list_lock_acquire(void)
+{
+}
+
+static inline void i2c_list_lock_release(void)
+{
+}
+
+static inline void i2c_lock_init(struct tegrabl_i2c *hi2c)
+{
+	TEGRABL_UNUSED(hi2c);
+}
+
+static inline void i2c_lock_acquire(struct tegrabl_i2c *hi2c)
+{
+	TEGRABL_UNUSED(hi2c);
+}
+
+static inline void i2c_lock_release(struct tegrabl_i2c *hi2c)
+{
+	TEGRABL_UNUSED(hi2c);
+}
+#endif
+
+static tegrabl_error_t i2c_bus_clear(struct tegrabl_i2c *hi2c);
+static tegrabl_error_t i2c_write(struct tegrabl_i2c *hi2c, uint16_t slave_addr,
+	bool repeat_start, void *buf, uint32_t len);
+
 static inline void i2c_writel(struct tegrabl_i2c *hi2c, uint32_t reg,
 	uint32_t val)
 {
@@ -90,12 +153,14 @@ void tegrabl_i2c_unregister_instance(tegrabl_instance_i2c_t instance)
 {
 	struct tegrabl_i2c *hi2c, *temp;
 
+	i2c_list_lock_acquire();
 	list_for_every_entry_safe(&i2c_list, hi2c, temp, struct tegrabl_i2c, node) {
 		if (hi2c->instance == instance) {
 			list_delete(&hi2c->node);
 			tegrabl_free(hi2c);
 		}
 	}
+	i2c_list_lock_release();
 }
 
 static uint32_t get_i2c_clock_divisor(uint32_t freq_in, uint32_t tlow, uint32_t thigh, uint32_t freq_out)
@@ -387,6 +452,45 @@ fail:
 	return error;
 }
 
+/**
+ * @brief Checks the controller status for the end of the current packet.
+ *
+ * @param hi2c i2c controller hi2c.
+ * @param is_complete set if the packet has been transferred.
+ * @param status filled with the interrupt status read.
+ *
+ * @return TEGRABL_NO_ERROR if no error was flagged, error code otherwise.
+ */
+static tegrabl_error_t i2c_check_transfer_status(struct tegrabl_i2c *hi2c, bool *is_complete,
+												 uint32_t *status)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	uint32_t val;
+
+	*is_complete = false;
+	val = i2c_readl(hi2c, I2C_INTERRUPT_STATUS_REGISTER_0);
+	*status = val;
+
+	if (NV_DRF_VAL(I2C, INTERRUPT_STATUS_REGISTER, PACKET_XFER_COMPLETE,
+			val) != 0U) {
+		*is_complete = true;
+	} else if (NV_DRF_VAL(I2C, INTERRUPT_STATUS_REGISTER, ARB_LOST, val)
+			!= 0U) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_NO_ACCESS,
+				I2C_WAIT_FOR_TRANSFER_COMPLETE);
+		TEGRABL_SET_ERROR_STRING(error, "bus");
+	} else if (NV_DRF_VAL(I2C, INTERRUPT_STATUS_REGISTER, NOACK, val)
+				!= 0U) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_NOT_FOUND,
+				I2C_WAIT_FOR_TRANSFER_COMPLETE);
+		TEGRABL_SET_ERROR_STRING(error, "slave", "slaves");
+	} else {
+		/* No Action Required */
+	}
+
+	return error;
+}
+
 /**
  * @brief Waits till single packet is completely transferred or timeout.
  *
@@ -398,6 +502,7 @@ static tegrabl_error_t i2c_wait_for_transfer_complete(struct tegrabl_i2c *hi2c)
 {
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
 	time_t timeout;
+	bool is_complete = false;
 	uint32_t val = 0;
 
 	pr_trace("%s: entry\n", __func__);
@@ -413,27 +518,11 @@ static tegrabl_error_t i2c_wait_for_transfer_complete(struct tegrabl_i2c *hi2c)
 			TEGRABL_SET_ERROR_STRING(error, "transfer complete", "0x%08x", val);
 			goto fail;
 		}
-		val = i2c_readl(hi2c, I2C_INTERRUPT_STATUS_REGISTER_0);
-
-		if (NV_DRF_VAL(I2C, INTERRUPT_STATUS_REGISTER, PACKET_XFER_COMPLETE,
-				val) != 0U) {
-			break;
-		} else if (NV_DRF_VAL(I2C, INTERRUPT_STATUS_REGISTER, ARB_LOST, val)
-				!= 0U) {
-			error = TEGRABL_ERROR(TEGRABL_ERR_NO_ACCESS,
-					I2C_WAIT_FOR_TRANSFER_COMPLETE);
-			TEGRABL_SET_ERROR_STRING(error, "bus");
-			goto fail;
-		} else if (NV_DRF_VAL(I2C, INTERRUPT_STATUS_REGISTER, NOACK, val)
-					!= 0U) {
-			error = TEGRABL_ERROR(TEGRABL_ERR_NOT_FOUND,
-					I2C_WAIT_FOR_TRANSFER_COMPLETE);
-			TEGRABL_SET_ERROR_STRING(error, "slave", "slaves");
+		error = i2c_check_transfer_status(hi2c, &is_complete, &val);
+		if (error != TEGRABL_NO_ERROR) {
 			goto fail;
-		} else {
-			/* No Action Required */
 		}
-	} while (true);
+	} while (!is_complete);
 
 fail:
 	return error;
@@ -448,6 +537,9 @@ struct tegrabl_i2c *tegrabl_i2c_open(tegrabl_instance_i2c_t instance)
 
 	pr_trace("%s: entry\n", __func__);
 
+	/* Held until the controller is on the list, so it is set up only once */
+	i2c_list_lock_acquire();
+
 	i2c_get_soc_info(&hi2c_info, &num_of_instances);
 
 	if (instance > num_of_instances - 1UL) {
@@ -457,6 +549,7 @@ struct tegrabl_i2c *tegrabl_i2c_open(tegrabl_instance_i2c_t instance)
 	}
 	list_for_every_entry(&i2c_list, hi2c, struct tegrabl_i2c, node) {
 		if (hi2c->instance == instance) {
+			i2c_list_lock_release();
 			return hi2c;
 		}
 	}
@@ -468,7 +561,7 @@ struct tegrabl_i2c *tegrabl_i2c_open(tegrabl_instance_i2c_t instance)
 		goto fail;
 	}
 	memset(hi2c, 0x0, sizeof(*hi2c));
-
+	i2c_lock_init(hi2c);
 
 	hi2c->instance = instance;
 	hi2c->clk_freq = hi2c_info[instance].clk_freq;
@@ -527,7 +620,7 @@ struct tegrabl_i2c *tegrabl_i2c_open(tegrabl_instance_i2c_t instance)
 	}
 #endif
 
-	error = tegrabl_i2c_bus_clear(hi2c);
+	error = i2c_bus_clear(hi2c);
 	if (error != TEGRABL_NO_ERROR) {
 		TEGRABL_PRINT_ERROR_STRING(TEGRABL_ERR_CLEAR_FAILED, "bus", "instance %d", hi2c->instance);
 		goto fail;
@@ -541,11 +634,13 @@ struct tegrabl_i2c *tegrabl_i2c_open(tegrabl_instance_i2c_t instance)
 
 	hi2c->is_initialized = true;
 	list_add_tail(&i2c_list, &hi2c->node);
+	i2c_list_lock_release();
 	pr_trace("%s: exit\n", __func__);
 
 	return hi2c;
 
 fail:
+	i2c_list_lock_release();
 	TEGRABL_SET_HIGHEST_MODULE(error);
 	if (hi2c != NULL) {
 		tegrabl_free(hi2c);
@@ -554,7 +649,7 @@ fail:
 	return NULL;
 }
 
-tegrabl_error_t tegrabl_i2c_read(struct tegrabl_i2c *hi2c, uint16_t slave_addr,
+static tegrabl_error_t i2c_read(struct tegrabl_i2c *hi2c, uint16_t slave_addr,
 	bool repeat_start, void *buf, uint32_t len)
 {
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
@@ -603,7 +698,7 @@ tegrabl_error_t tegrabl_i2c_read(struct tegrabl_i2c *hi2c, uint16_t slave_addr,
 		}
 
 		data = 0;
-		bytes = MIN(len, sizeof(uint32_t));
+		bytes = MIN(len - i, sizeof(uint32_t));
 		data = i2c_readl(hi2c, I2C_I2C_RX_FIFO_0);
 		memcpy(&buffer[i], &data, bytes);
 		i += bytes;
@@ -621,13 +716,207 @@ fail:
 				"%d bytes from slave: 0x%04x with repeat start %s", len, slave_addr,
 				repeat_start ? "true" : "false");
 		(void)i2c_reset_controller(hi2c);
-		(void)tegrabl_i2c_bus_clear(hi2c);
+		(void)i2c_bus_clear(hi2c);
 	}
 
 	return error;
 }
 
-tegrabl_error_t tegrabl_i2c_write(struct tegrabl_i2c *hi2c, uint16_t slave_addr,
+tegrabl_error_t tegrabl_i2c_read(struct tegrabl_i2c *hi2c, uint16_t slave_addr,
+	bool repeat_start, void *buf, uint32_t len)
+{
+	tegrabl_error_t error;
+
+	if (hi2c == NULL) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, TEGRABL_I2C_READ);
+		TEGRABL_SET_ERROR_STRING(error, "hi2c: %p", hi2c);
+		return error;
+	}
+
+	i2c_lock_acquire(hi2c);
+	error = i2c_read(hi2c, slave_addr, repeat_start, buf, len);
+	i2c_lock_release(hi2c);
+
+	return error;
+}
+
+/* Optionally writes wbuf with a repeat start, then starts the read. The
+ * controller stays locked until tegrabl_i2c_read_poll() sees the read
+ * complete or fail, so nothing gets between the write and the read */
+static tegrabl_error_t i2c_start_read(struct tegrabl_i2c *hi2c, uint16_t slave_addr,
+	void *wbuf, uint32_t wlen, bool repeat_start, void *buf, uint32_t len)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	if ((hi2c == NULL) || (buf == NULL) || (len == 0UL) || (len > MAX_I2C_TRANSFER_SIZE)) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, TEGRABL_I2C_READ_START);
+		TEGRABL_SET_ERROR_STRING(error, "hi2c: %p, buf: %p, len: %d", hi2c, buf, len);
+		return error;
+	}
+
+	/* Checked before locking, the lock is already held by the reader */
+	if (hi2c->is_async_busy) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_BUSY, TEGRABL_I2C_READ_START);
+		TEGRABL_SET_ERROR_STRING(error, "instance %d", hi2c->instance);
+		return error;
+	}
+
+	i2c_lock_acquire(hi2c);
+
+	if (wbuf != NULL) {
+		error = i2c_write(hi2c, slave_addr, true, wbuf, wlen);
+		if (error != TEGRABL_NO_ERROR) {
+			i2c_lock_release(hi2c);
+			return error;
+		}
+	}
+
+	hi2c->async_buf = buf;
+	hi2c->async_len = len;
+	hi2c->async_pos = 0;
+	hi2c->async_slave_addr = slave_addr;
+	hi2c->async_repeat_start = repeat_start;
+
+#if defined(CONFIG_POWER_I2C_BPMPFW)
+	/* Virtual i2c is a synchronous IPC, the read is done by the time it returns */
+	if (hi2c->is_enable_bpmpfw_i2c == true) {
+		error = i2c_read(hi2c, slave_addr, repeat_start, buf, len);
+		if (error == TEGRABL_NO_ERROR) {
+			hi2c->async_pos = len;
+			hi2c->is_async_busy = true;
+		}
+		i2c_lock_release(hi2c);
+		return error;
+	}
+#endif
+
+	pr_trace("%s: instance = %d, slave addr = %x, repeat start = %d, len = %d\n",
+		__func__, hi2c->instance, slave_addr, repeat_start, len);
+
+	error = i2c_send_header(hi2c, repeat_start, false, slave_addr, len);
+	if (error != TEGRABL_NO_ERROR) {
+		TEGRABL_PRINT_ERROR_STRING(TEGRABL_ERR_SEND_FAILED, "header");
+		(void)i2c_reset_controller(hi2c);
+		(void)i2c_bus_clear(hi2c);
+		i2c_lock_release(hi2c);
+		return error;
+	}
+
+	/* same budget as tegrabl_i2c_read(), as an absolute deadline */
+	hi2c->async_deadline_us = tegrabl_get_timestamp_us() + (hi2c->byte_xfer_timeout * (2ULL + len));
+	hi2c->is_async_busy = true;
+
+	return error;
+}
+
+tegrabl_error_t tegrabl_i2c_read_start(struct tegrabl_i2c *hi2c, uint16_t slave_addr,
+	bool repeat_start, void *buf, uint32_t len)
+{
+	return i2c_start_read(hi2c, slave_addr, NULL, 0, repeat_start, buf, len);
+}
+
+tegrabl_error_t tegrabl_i2c_write_read_start(struct tegrabl_i2c *hi2c, uint16_t slave_addr,
+	void *wbuf, uint32_t wlen, void *buf, uint32_t len)
+{
+	if (wbuf == NULL) {
+		return TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, TEGRABL_I2C_READ_START);
+	}
+
+	return i2c_start_read(hi2c, slave_addr, wbuf, wlen, false, buf, len);
+}
+
+tegrabl_error_t tegrabl_i2c_write_read(struct tegrabl_i2c *hi2c, uint16_t slave_addr,
+	void *wbuf, uint32_t wlen, bool repeat_start, void *buf, uint32_t len)
+{
+	tegrabl_error_t error;
+
+	if (hi2c == NULL) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, TEGRABL_I2C_WRITE_READ);
+		TEGRABL_SET_ERROR_STRING(error, "hi2c: %p", hi2c);
+		return error;
+	}
+
+	/* The write ends in a repeat start, the bus stays ours until the read */
+	i2c_lock_acquire(hi2c);
+	error = i2c_write(hi2c, slave_addr, true, wbuf, wlen);
+	if (error == TEGRABL_NO_ERROR) {
+		error = i2c_read(hi2c, slave_addr, repeat_start, buf, len);
+	}
+	i2c_lock_release(hi2c);
+
+	return error;
+}
+
+tegrabl_error_t tegrabl_i2c_read_poll(struct tegrabl_i2c *hi2c)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	uint32_t filled_slots;
+	uint32_t bytes;
+	uint32_t data;
+	uint32_t val;
+	bool is_complete = false;
+
+	if ((hi2c == NULL) || !hi2c->is_async_busy) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, TEGRABL_I2C_READ_POLL);
+		TEGRABL_SET_ERROR_STRING(error, "hi2c: %p", hi2c);
+		return error;
+	}
+
+#if defined(CONFIG_POWER_I2C_BPMPFW)
+	if (hi2c->is_enable_bpmpfw_i2c == true) {
+		hi2c->is_async_busy = false;
+		return TEGRABL_NO_ERROR;
+	}
+#endif
+
+#if defined(I2C_MST_FIFO_STATUS_0)
+	val = i2c_readl(hi2c, I2C_MST_FIFO_STATUS_0);
+	filled_slots = NV_DRF_VAL(I2C, MST_FIFO_STATUS, RX_FIFO_FULL_CNT, val);
+#else
+	val = i2c_readl(hi2c, I2C_FIFO_STATUS_0);
+	filled_slots = NV_DRF_VAL(I2C, FIFO_STATUS, RX_FIFO_FULL_CNT, val);
+#endif
+
+	while ((filled_slots != 0U) && (hi2c->async_pos < hi2c->async_len)) {
+		bytes = MIN(hi2c->async_len - hi2c->async_pos, sizeof(uint32_t));
+		data = i2c_readl(hi2c, I2C_I2C_RX_FIFO_0);
+		memcpy(&hi2c->async_buf[hi2c->async_pos], &data, bytes);
+		hi2c->async_pos += bytes;
+		filled_slots--;
+	}
+
+	error = i2c_check_transfer_status(hi2c, &is_complete, &val);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	if (is_complete && (hi2c->async_pos == hi2c->async_len)) {
+		hi2c->is_async_busy = false;
+		i2c_lock_release(hi2c);
+		return TEGRABL_NO_ERROR;
+	}
+
+	if (tegrabl_get_timestamp_us() > hi2c->async_deadline_us) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_TIMEOUT, TEGRABL_I2C_READ_POLL);
+		TEGRABL_SET_ERROR_STRING(error, "transfer complete");
+		goto fail;
+	}
+
+	return TEGRABL_ERROR(TEGRABL_ERR_NOT_READY, TEGRABL_I2C_READ_POLL);
+
+fail:
+	hi2c->is_async_busy = false;
+	TEGRABL_PRINT_ERROR_STRING(TEGRABL_ERR_READ_FAILED,
+			"%d bytes from slave: 0x%04x with repeat start %s", hi2c->async_len,
+			hi2c->async_slave_addr, hi2c->async_repeat_start ? "true" : "false");
+	(void)i2c_reset_controller(hi2c);
+	(void)i2c_bus_clear(hi2c);
+	i2c_lock_release(hi2c);
+
+	return error;
+}
+
+static tegrabl_error_t i2c_write(struct tegrabl_i2c *hi2c, uint16_t slave_addr,
 	bool repeat_start, void *buf, uint32_t len)
 {
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
@@ -691,12 +980,30 @@ fail:
 		TEGRABL_PRINT_ERROR_STRING(TEGRABL_ERR_WRITE_FAILED, "%d bytes to slave: 0x%04x with repeat start %s",
 				len, slave_addr, repeat_start ? "true" : "false");
 		(void)i2c_reset_controller(hi2c);
-		(void)tegrabl_i2c_bus_clear(hi2c);
+		(void)i2c_bus_clear(hi2c);
 	}
 
 	return error;
 }
 
+tegrabl_error_t tegrabl_i2c_write(struct tegrabl_i2c *hi2c, uint16_t slave_addr,
+	bool repeat_start, void *buf, uint32_t len)
+{
+	tegrabl_error_t error;
+
+	if (hi2c == NULL) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, TEGRABL_I2C_WRITE);
+		TEGRABL_SET_ERROR_STRING(error, "hi2c: %p", hi2c);
+		return error;
+	}
+
+	i2c_lock_acquire(hi2c);
+	error = i2c_write(hi2c, slave_addr, repeat_start, buf, len);
+	i2c_lock_release(hi2c);
+
+	return error;
+}
+
 tegrabl_error_t tegrabl_i2c_transaction(struct tegrabl_i2c *hi2c,
 	struct tegrabl_i2c_transaction *trans, uint32_t num_trans)
 {
@@ -718,14 +1025,16 @@ tegrabl_error_t tegrabl_i2c_transaction(struct tegrabl_i2c *hi2c,
 		}
 #endif
 
+	/* Held across all the messages, they may be chained by repeat starts */
+	i2c_lock_acquire(hi2c);
 
 	for (i = 0; i < num_trans; i++) {
 		ptrans = trans;
 		if (ptrans->is_write == true) {
-			error = tegrabl_i2c_write(hi2c, ptrans->slave_addr,
+			error = i2c_write(hi2c, ptrans->slave_addr,
 					 ptrans->is_repeat_start, ptrans->buf, ptrans->len);
 		} else {
-			error = tegrabl_i2c_read(hi2c, ptrans->slave_addr,
+			error = i2c_read(hi2c, ptrans->slave_addr,
 					 ptrans->is_repeat_start, ptrans->buf, ptrans->len);
 		}
 		if (error != TEGRABL_NO_ERROR) {
@@ -738,13 +1047,15 @@ tegrabl_error_t tegrabl_i2c_transaction(struct tegrabl_i2c *hi2c,
 	if (error != TEGRABL_NO_ERROR) {
 		pr_trace("%s: error = %08x\n", __func__, error);
 		(void)i2c_reset_controller(hi2c);
-		(void)tegrabl_i2c_bus_clear(hi2c);
+		(void)i2c_bus_clear(hi2c);
 	}
 
+	i2c_lock_release(hi2c);
+
 	return error;
 }
 
-tegrabl_error_t tegrabl_i2c_bus_clear(struct tegrabl_i2c *hi2c)
+static tegrabl_error_t i2c_bus_clear(struct tegrabl_i2c *hi2c)
 {
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
 	uint32_t val = 0;
@@ -809,3 +1120,20 @@ fail:
 	}
 	return error;
 }
+
+tegrabl_error_t tegrabl_i2c_bus_clear(struct tegrabl_i2c *hi2c)
+{
+	tegrabl_error_t error;
+
+	if (hi2c == NULL) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, TEGRABL_I2C_BUS_CLEAR);
+		TEGRABL_SET_ERROR_STRING(error, "hi2c: %p", hi2c);
+		return error;
+	}
+
+	i2c_lock_acquire(hi2c);
+	error = i2c_bus_clear(hi2c);
+	i2c_lock_release(hi2c);
+
+	return error;
+}
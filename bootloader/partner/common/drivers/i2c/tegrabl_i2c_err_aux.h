@@ -29,5 +29,8 @@
 #define TEGRABL_VIRTUAL_I2C_BPMP_XFER 0xEU
 #define TEGRABL_I2C_CLOSE 0xFU
 #define I2C_RESET_CONTROLLER 0x10U
+#define TEGRABL_I2C_READ_START 0x11U
+#define TEGRABL_I2C_READ_POLL 0x12U
+#define TEGRABL_I2C_WRITE_READ 0x13U
 
 #endif
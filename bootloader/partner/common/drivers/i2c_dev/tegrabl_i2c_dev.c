@@ -121,16 +121,11 @@ tegrabl_error_t tegrabl_i2c_dev_read(struct tegrabl_i2c_dev *hi2cdev, void *buf,
 			buffer[i] = (uint8_t)((curr_reg_addr >> (8U * i)) & 0xFFU);
 		} while (++i < reg_addr_size);
 
-		error = tegrabl_i2c_write(hi2c, slave_addr, true, buffer, i);
-		if (error != TEGRABL_NO_ERROR) {
-			TEGRABL_SET_HIGHEST_MODULE(error);
-			TEGRABL_PRINT_ERROR_STRING(TEGRABL_ERR_SEND_FAILED, "register address 0x%08x", reg_addr);
-			goto fail;
-		}
-
+		/* Register address and data in one go, the address write ends in a
+		 * repeat start */
+		error = tegrabl_i2c_write_read(hi2c, slave_addr, buffer, i, repeat_start, &pbuf[j],
+									   regs_to_transfer * bytes_per_reg);
 		i = regs_to_transfer * bytes_per_reg;
-
-		error = tegrabl_i2c_read(hi2c, slave_addr, repeat_start, &pbuf[j], i);
 		if (error != TEGRABL_NO_ERROR) {
 			TEGRABL_SET_HIGHEST_MODULE(error);
 			TEGRABL_PRINT_ERROR_STRING(TEGRABL_ERR_READ_FAILED,
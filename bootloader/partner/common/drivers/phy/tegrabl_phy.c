@@ -23,6 +23,9 @@
 #define REG_PHY_IDENTIFIER_2_WIDTH			((15 - 10) + 1)
 #define REG_PHY_IDENTIFIER_2_SHIFT			10
 
+/* MDIO reads are cheap, poll often so autoneg/link-up is seen when it happens */
+#define PHY_POLL_INTERVAL_MS				10U
+
 tegrabl_error_t tegrabl_phy_wait_for_bit(const struct phy_dev * const phy,
 										 uint32_t page,
 										 uint32_t reg_addr,
@@ -47,7 +50,7 @@ tegrabl_error_t tegrabl_phy_wait_for_bit(const struct phy_dev * const phy,
 		if ((!!(val & BIT(pos))) == set) {
 			break;
 		}
-		tegrabl_mdelay(1000);
+		tegrabl_mdelay(PHY_POLL_INTERVAL_MS);
 	}
 
 fail:
@@ -52,6 +52,9 @@
 
 #define QSPI_DMA_THRESOLD				16UL
 
+/* Poll interval for the end of a DMA transfer */
+#define QSPI_DMA_POLL_INTERVAL_US		5U
+
 /* Maximum Instance supported */
 #define AUX_INFO_FLUSH_FIFO 0
 #define AUX_INFO_FILL_TX_FIFO 1
@@ -816,6 +819,7 @@ static void qspi_abort_rx_dma(struct tegrabl_qspi_handle *qspi_handle)
 	qspi_stop_rx(qspi_handle->qspi);
 	tegrabl_dma_transfer_abort(qspi_context->dma_handle,
 							   qspi_handle->qspi->dma_chan_id);
+	qspi_handle->rx_dma_armed = false;
 	qspi_hw_disable_transfer(qspi_handle->qspi);
 }
 
@@ -1016,27 +1020,34 @@ static tegrabl_error_t qspi_receive_start_one_xfer_dma(
 	qspi_handle->cur_req_dma_packet = dma_blk_size;
 	qspi_handle->cur_remain_dma_packet = dma_blk_size;
 
-	qspi_handle->dma_params.dst = (uintptr_t)qspi_handle->cur_buf;
-	qspi_handle->dma_params.src = qspi_handle->qspi->base_address + (uint32_t)QSPI_RX_FIFO_0;
-	qspi_handle->dma_params.size = dma_blk_size * 4UL;
-	qspi_handle->dma_params.is_async_xfer = true;
-	qspi_handle->dma_params.dir = DMA_IO_TO_MEM;
-	qspi_handle->dma_params.io_bus_width = BUS_WIDTH_32;
-
-	if (qspi_context->dma_type == DMA_GPC) {
-		qspi_handle->dma_params.io = qspi_handle->qspi->gpcdma_req;
-	} else if (qspi_context->dma_type == DMA_BPMP) {
-		qspi_handle->dma_params.io = qspi_handle->qspi->bpmpdma_req;
-	} else {
-		/* No Action Required */
-	}
+	/* The DMA channel is armed once for all the remaining packets of the
+	 * transfer, so the controller blocks that follow only need the QSPI side
+	 * re-enabled while the FIFO of the previous block is still draining.
+	 */
+	if (qspi_handle->rx_dma_armed == false) {
+		qspi_handle->dma_params.dst = (uintptr_t)qspi_handle->cur_buf;
+		qspi_handle->dma_params.src = qspi_handle->qspi->base_address + (uint32_t)QSPI_RX_FIFO_0;
+		qspi_handle->dma_params.size = qspi_handle->ramain_dma_packet * 4UL;
+		qspi_handle->dma_params.is_async_xfer = true;
+		qspi_handle->dma_params.dir = DMA_IO_TO_MEM;
+		qspi_handle->dma_params.io_bus_width = BUS_WIDTH_32;
+
+		if (qspi_context->dma_type == DMA_GPC) {
+			qspi_handle->dma_params.io = qspi_handle->qspi->gpcdma_req;
+		} else if (qspi_context->dma_type == DMA_BPMP) {
+			qspi_handle->dma_params.io = qspi_handle->qspi->bpmpdma_req;
+		} else {
+			/* No Action Required */
+		}
 
-	err = tegrabl_dma_transfer(qspi_context->dma_handle, qspi->dma_chan_id,
-							   &qspi_handle->dma_params);
-	if (err != TEGRABL_NO_ERROR) {
-		TEGRABL_SET_HIGHEST_MODULE(err);
-		pr_error("QSPI: dma transfer failed\n");
-		return err;
+		err = tegrabl_dma_transfer(qspi_context->dma_handle, qspi->dma_chan_id,
+								   &qspi_handle->dma_params);
+		if (err != TEGRABL_NO_ERROR) {
+			TEGRABL_SET_HIGHEST_MODULE(err);
+			pr_error("QSPI: dma transfer failed\n");
+			return err;
+		}
+		qspi_handle->rx_dma_armed = true;
 	}
 
 	/* Enable Rx */
@@ -1065,8 +1076,32 @@ static tegrabl_error_t qspi_receive_wait_one_xfer_dma(
 
 continue_wait:
 
+	if (qspi_handle->ramain_dma_packet > qspi_handle->cur_req_dma_packet) {
+		/* More blocks follow, start the next one as soon as this one has
+		 * been clocked in, the armed DMA keeps draining the FIFO.
+		 */
+		err = qspi_wait_for_ready_bit(qspi_handle);
+		if (err != TEGRABL_NO_ERROR) {
+			if (is_abort == true) {
+				qspi_abort_rx_dma(qspi_handle);
+				return err;
+			}
+			return TEGRABL_ERROR(TEGRABL_ERR_XFER_IN_PROGRESS,
+								 AUX_INFO_XFER_RX_DMA);
+		}
+
+		qspi_handle->ramain_dma_packet -= qspi_handle->cur_req_dma_packet;
+		qspi_handle->cur_buf += (qspi_handle->cur_req_dma_packet *
+								  qspi_handle->bytes_pw);
+		err = qspi_receive_start_one_xfer_dma(qspi_handle);
+		if (err != TEGRABL_NO_ERROR) {
+			return err;
+		}
+		goto continue_wait;
+	}
+
 	do {
-		tegrabl_udelay(50);
+		tegrabl_udelay(QSPI_DMA_POLL_INTERVAL_US);
 		err = tegrabl_dma_transfer_status(qspi_context->dma_handle,
 										  qspi->dma_chan_id,
 										  &qspi_handle->dma_params);
@@ -1100,14 +1135,7 @@ continue_wait:
 	qspi_handle->ramain_dma_packet -= qspi_handle->cur_req_dma_packet;
 	qspi_handle->cur_buf += (qspi_handle->cur_req_dma_packet *
 							  qspi_handle->bytes_pw);
-	if (qspi_handle->ramain_dma_packet != 0U) {
-		qspi_clear_ready_bit(qspi_handle->qspi);
-		err = qspi_receive_start_one_xfer_dma(qspi_handle);
-		if (err != TEGRABL_NO_ERROR) {
-			return err;
-		}
-		goto continue_wait;
-	}
+	qspi_handle->rx_dma_armed = false;
 
 	qspi_stop_rx(qspi_handle->qspi);
 
@@ -1226,6 +1254,7 @@ static tegrabl_error_t qspi_start_one_transaction(
 	}
 
 	qspi_handle->requested_bytes = qspi_handle->buf_len;
+	qspi_handle->rx_dma_armed = false;
 
 	if ((qspi_handle->param->fifo_access_mode != (uint32_t)QSPI_MODE_DMA)) {
 		pio_only = true;
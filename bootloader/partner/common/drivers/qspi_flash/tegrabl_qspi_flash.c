@@ -74,9 +74,16 @@ static tegrabl_error_t qspi_bdev_ioctl(
 	TEGRABL_UNUSED(argp);
 
 #if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
+	struct tegrabl_qspi_flash_driver_info *hqfdi;
+
 	if (ioctl == TEGRABL_IOCTL_DEVICE_CACHE_FLUSH) {
 		return TEGRABL_NO_ERROR;
 	}
+	if ((ioctl == TEGRABL_IOCTL_ERASE_BLOCK_SIZE) && (dev->priv_data != NULL)) {
+		hqfdi = dev->priv_data;
+		*(uint32_t *)argp = (uint32_t)(1UL << hqfdi->chip_info.sector_size_log2);
+		return TEGRABL_NO_ERROR;
+	}
 #endif
 	pr_debug("Unknown ioctl %"PRIu32"\n", ioctl);
 	return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, AUX_INFO_IOCTL_NOT_SUPPORTED);
@@ -766,6 +773,97 @@ exit:
 	return TEGRABL_NO_ERROR;
 }
 
+static void qspi_read_cache_invalidate(struct tegrabl_qspi_flash_driver_info *hqfdi)
+{
+	uint32_t i;
+
+	for (i = 0; i < QSPI_READ_CACHE_LINES; i++) {
+		hqfdi->read_cache[i].valid = false;
+	}
+}
+
+/**
+ * @brief Read a few blocks through the read cache. Lines are aligned to
+ * QSPI_READ_CACHE_LINE_BLOCKS and a miss fills the whole line with a single
+ * read command, least recently used line is replaced.
+ *
+ * @param hqfdi driver info
+ * @param block start block
+ * @param count number of blocks
+ * @param p_dest destination buffer
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error
+ */
+static tegrabl_error_t qspi_cached_read(struct tegrabl_qspi_flash_driver_info *hqfdi,
+		uint32_t block, uint32_t count, uint8_t *p_dest)
+{
+	struct tegrabl_qspi_flash_chip_info *chip_info = &hqfdi->chip_info;
+	struct qspi_read_cache_line *line;
+	struct qspi_read_cache_line *victim;
+	uint32_t line_size = QSPI_READ_CACHE_LINE_BLOCKS << chip_info->block_size_log2;
+	uint32_t line_start;
+	uint32_t offset;
+	uint32_t n;
+	uint32_t i;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	if (hqfdi->read_cache_buf == NULL) {
+		hqfdi->read_cache_buf = tegrabl_alloc_align(TEGRABL_HEAP_DMA,
+				TEGRABL_QSPI_BUF_ALIGN_SIZE, QSPI_READ_CACHE_LINES * line_size);
+		if (hqfdi->read_cache_buf == NULL) {
+			pr_debug("QSPI: no memory for read cache\n");
+			return tegrabl_qspi_flash_read(hqfdi, block, count, p_dest, false);
+		}
+		for (i = 0; i < QSPI_READ_CACHE_LINES; i++) {
+			hqfdi->read_cache[i].buf = hqfdi->read_cache_buf + (i * line_size);
+			hqfdi->read_cache[i].valid = false;
+		}
+	}
+
+	while (count != 0U) {
+		line_start = block & ~(QSPI_READ_CACHE_LINE_BLOCKS - 1U);
+		line = NULL;
+		victim = &hqfdi->read_cache[0];
+		for (i = 0; i < QSPI_READ_CACHE_LINES; i++) {
+			if (hqfdi->read_cache[i].valid == false) {
+				victim = &hqfdi->read_cache[i];
+				continue;
+			}
+			if (hqfdi->read_cache[i].start_block == line_start) {
+				line = &hqfdi->read_cache[i];
+				break;
+			}
+			if ((victim->valid == true) &&
+				(hqfdi->read_cache[i].last_use < victim->last_use)) {
+				victim = &hqfdi->read_cache[i];
+			}
+		}
+
+		if (line == NULL) {
+			line = victim;
+			n = MIN(QSPI_READ_CACHE_LINE_BLOCKS, chip_info->block_count - line_start);
+			line->valid = false;
+			err = tegrabl_qspi_flash_read(hqfdi, line_start, n, line->buf, false);
+			if (err != TEGRABL_NO_ERROR) {
+				return err;
+			}
+			line->start_block = line_start;
+			line->valid = true;
+		}
+		line->last_use = ++hqfdi->read_cache_tick;
+
+		offset = block - line_start;
+		n = MIN(count, QSPI_READ_CACHE_LINE_BLOCKS - offset);
+		memcpy(p_dest, line->buf + (offset << chip_info->block_size_log2),
+			   n << chip_info->block_size_log2);
+		block += n;
+		count -= n;
+		p_dest += n << chip_info->block_size_log2;
+	}
+
+	return err;
+}
+
 #define block_num_to_sector_num(blk)		\
 		DIV_FLOOR_LOG2(((blk) << chip_info->block_size_log2), \
 					   chip_info->sector_size_log2)
@@ -801,6 +899,8 @@ tegrabl_qspi_flash_parameter_sector_erase(
 	uint32_t address;
 	uint8_t *cmd = hqfdi->cmd;
 
+	qspi_read_cache_invalidate(hqfdi);
+
 	transfers = hqfdi->transfers;
 	memset(transfers, 0, 2U*(sizeof(struct tegrabl_qspi_transfer)));
 	if (chip_info->address_length == 4UL) {
@@ -944,6 +1044,8 @@ tegrabl_qspi_flash_sector_erase(
 	uint32_t address;
 	uint8_t *cmd = hqfdi->cmd;
 
+	qspi_read_cache_invalidate(hqfdi);
+
 	transfers = hqfdi->transfers;
 	memset(transfers, 0, 2U*(sizeof(struct tegrabl_qspi_transfer)));
 	if (chip_info->address_length == 4U) {
@@ -1061,6 +1163,8 @@ tegrabl_qspi_flash_bulk_erase(struct tegrabl_qspi_flash_driver_info *hqfdi)
 	struct tegrabl_qspi_transfer *transfers;
 	uint8_t *cmd = hqfdi->cmd;
 
+	qspi_read_cache_invalidate(hqfdi);
+
 	/* Enable Write */
 	err = qspi_write_en(hqfdi, true);
 
@@ -1240,6 +1344,8 @@ tegrabl_qspi_flash_write(
 	uint32_t address;
 	uint8_t *p_source = (uint8_t *)p_source_buffer;
 
+	qspi_read_cache_invalidate(hqfdi);
+
 	transfers = hqfdi->transfers;
 	memset(transfers, 0, 2U*(sizeof(struct tegrabl_qspi_transfer)));
 
@@ -1593,5 +1699,10 @@ static tegrabl_error_t qspi_bdev_read_block(tegrabl_bdev_t *dev, void *buf,
 		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 1);
 	}
 	hqfdi = dev->priv_data;
+#if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
+	if (count <= QSPI_READ_CACHE_LINE_BLOCKS) {
+		return qspi_cached_read(hqfdi, block, count, (uint8_t *)buf);
+	}
+#endif
 	return tegrabl_qspi_flash_read(hqfdi, block, count, (uint8_t *)buf, false);
 }
@@ -177,6 +177,17 @@ struct tegrabl_qspi_flash_chip_info {
 	bool qddr_read;
 };
 
+/* Read cache for small repeated reads (GPT, BCT, partition headers) */
+#define QSPI_READ_CACHE_LINES 8U
+#define QSPI_READ_CACHE_LINE_BLOCKS 8U
+
+struct qspi_read_cache_line {
+	uint8_t *buf;
+	uint32_t start_block;
+	uint32_t last_use;
+	bool valid;
+};
+
 struct tegrabl_qspi_flash_driver_info {
 	struct tegrabl_qspi_flash_platform_params plat_params;
 	struct tegrabl_qspi_flash_chip_info chip_info;
@@ -184,6 +195,9 @@ struct tegrabl_qspi_flash_driver_info {
 	struct tegrabl_qspi_transfer *transfers;
 	uint8_t *address_data;
 	uint8_t *cmd;
+	struct qspi_read_cache_line read_cache[QSPI_READ_CACHE_LINES];
+	uint8_t *read_cache_buf;
+	uint32_t read_cache_tick;
 };
 
 struct device_info {
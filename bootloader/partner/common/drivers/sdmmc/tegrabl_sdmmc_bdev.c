@@ -40,12 +40,12 @@ tegrabl_error_t sdmmc_bdev_ioctl(tegrabl_bdev_t *dev, uint32_t ioctl,
 {
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
 	sdmmc_priv_data_t *priv_data = (sdmmc_priv_data_t *)dev->priv_data;
+	struct tegrabl_sdmmc *hsdmmc = NULL;
 
 #if defined(CONFIG_ENABLE_SDMMC_RPMB)
 	uint32_t counter = 0;
 	sdmmc_rpmb_context_t *rpmb_context = NULL;
 #else
-	TEGRABL_UNUSED(args);
 	TEGRABL_UNUSED(dev);
 #endif
 
@@ -55,6 +55,14 @@ tegrabl_error_t sdmmc_bdev_ioctl(tegrabl_bdev_t *dev, uint32_t ioctl,
 		break;
 	case TEGRABL_IOCTL_DEVICE_CACHE_FLUSH:
 		break;
+	case TEGRABL_IOCTL_ERASED_READS_ZERO:
+		hsdmmc = (struct tegrabl_sdmmc *)priv_data->context;
+		if (hsdmmc->device_type == DEVICE_TYPE_SD) {
+			error = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 6);
+			break;
+		}
+		*(bool *)args = (hsdmmc->erased_mem_cont == 0U);
+		break;
 #if defined(CONFIG_ENABLE_SDMMC_RPMB)
 	case TEGRABL_IOCTL_PROTECTED_BLOCK_KEY:
 		error = sdmmc_rpmb_program_key(dev, args, (struct tegrabl_sdmmc *)priv_data->context);
@@ -81,6 +81,7 @@
 #define ECSD_SEC_SANITIZE_MASK					0x40U
 #define ECSD_SEC_SANITIZE_SHIFT					6
 #define ECSD_ERASE_GROUP_DEF					175
+#define ECSD_ERASED_MEM_CONT					181
 #define ECSD_HIGH_CAP_ERASE_MASK				0x1
 #define ECSD_ERASE_GRP_SIZE						224
 #define ECSD_ERASE_TIMEOUT_OFFSET				223
@@ -191,6 +191,9 @@ struct tegrabl_sdmmc {
 	/* is sanitize supported or not */
 	uint8_t sanitize_support;
 
+	/* content of erased/trimmed blocks, 0 or 1 (all bits set) */
+	uint8_t erased_mem_cont;
+
 	/* device type */
 	device_type_t device_type;
 
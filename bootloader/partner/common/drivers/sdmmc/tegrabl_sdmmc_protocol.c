@@ -61,37 +61,15 @@ tegrabl_error_t sdmmc_print_regdump(struct tegrabl_sdmmc *hsdmmc)
 tegrabl_error_t sdmmc_clock_init(uint32_t instance, uint32_t rate,
 								 uint32_t source)
 {
-	tegrabl_error_t err = TEGRABL_NO_ERROR;
-	uint32_t srate;
-
-	TEGRABL_UNUSED(source);
-
-	err = tegrabl_car_rst_set(TEGRABL_MODULE_SDMMC, (uint8_t)instance);
-	if (err != TEGRABL_NO_ERROR) {
-		return err;
-	}
-
-	err = tegrabl_car_clk_enable(TEGRABL_MODULE_SDMMC, (uint8_t)instance, NULL);
-	if (err != TEGRABL_NO_ERROR) {
-		return err;
-	}
-
-	err = tegrabl_car_set_clk_src(TEGRABL_MODULE_SDMMC, (uint8_t)instance, (uint8_t)source);
-	if (err != TEGRABL_NO_ERROR) {
-		return err;
-	}
-
-	err = tegrabl_car_set_clk_rate(TEGRABL_MODULE_SDMMC, (uint8_t)instance, rate, &srate);
-	if (err != TEGRABL_NO_ERROR) {
-		return err;
-	}
-
-	err = tegrabl_car_rst_clear(TEGRABL_MODULE_SDMMC, (uint8_t)instance);
-	if (err != TEGRABL_NO_ERROR) {
-		return err;
-	}
+	struct tegrabl_car_op ops[] = {
+		{ TEGRABL_CAR_OP_RST_SET,       TEGRABL_MODULE_SDMMC, (uint8_t)instance, 0 },
+		{ TEGRABL_CAR_OP_CLK_ENABLE,    TEGRABL_MODULE_SDMMC, (uint8_t)instance, 0 },
+		{ TEGRABL_CAR_OP_CLK_SET_SRC,   TEGRABL_MODULE_SDMMC, (uint8_t)instance, (uint8_t)source },
+		{ TEGRABL_CAR_OP_CLK_SET_RATE,  TEGRABL_MODULE_SDMMC, (uint8_t)instance, rate },
+		{ TEGRABL_CAR_OP_RST_CLEAR,     TEGRABL_MODULE_SDMMC, (uint8_t)instance, 0 },
+	};
 
-	return err;
+	return tegrabl_car_run_ops(ops, ARRAY_SIZE(ops));
 }
 
 /** @brief Sets the default parameters for the hsdmmc.
@@ -886,6 +864,9 @@ tegrabl_error_t sdmmc_get_ext_csd(struct tegrabl_sdmmc *hsdmmc)
 		(buf[ECSD_SEC_FEATURE_OFFSET] &
 			ECSD_SEC_SANITIZE_MASK) >> ECSD_SEC_SANITIZE_SHIFT;
 
+	/* Store the value erased blocks read back as. */
+	hsdmmc->erased_mem_cont = buf[ECSD_ERASED_MEM_CONT] & 0x1U;
+
 	/* Store the high capacity erase group size. */
 	hsdmmc->erase_group_size = (uint32_t)buf[ECSD_ERASE_GRP_SIZE] << 10;
 
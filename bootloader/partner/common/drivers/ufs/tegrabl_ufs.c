@@ -44,6 +44,7 @@ static struct tegrabl_ufs_context *pufs_context;
 
 struct transer_comp_info {
 	uint32_t trd_index;
+	uint32_t cmd_desc_index;
 	uint32_t prdt_length;
 	uint32_t direction;
 	struct cmd_descriptor *plcmd_descriptor;
@@ -132,11 +133,23 @@ tegrabl_error_t
 tegrabl_ufs_get_cmd_descriptor(uint32_t *cmd_desc_index)
 {
 	uint32_t next_cmd_index;
+	uint32_t i;
 
 	if (pufs_context->cmd_desc_in_use < MAX_CMD_DESC_NUM) {
-		next_cmd_index =
-			NEXT_CD_IDX(pufs_context->last_cmd_desc_index);
+		next_cmd_index = pufs_context->last_cmd_desc_index;
+		/* Queued requests can complete out of order, so skip the
+		 * descriptors which are still owned by an in-flight TRD */
+		for (i = 0; i < MAX_CMD_DESC_NUM; i++) {
+			next_cmd_index = NEXT_CD_IDX(next_cmd_index);
+			if ((pufs_context->cmd_desc_busy_mask & (1UL << next_cmd_index)) == 0U) {
+				break;
+			}
+		}
+		if (i == MAX_CMD_DESC_NUM) {
+			return TEGRABL_ERROR(TEGRABL_ERR_NO_RESOURCE, 0U);
+		}
 		pufs_context->last_cmd_desc_index = next_cmd_index;
+		pufs_context->cmd_desc_busy_mask |= (1UL << next_cmd_index);
 		*cmd_desc_index = next_cmd_index;
 		pufs_context->cmd_desc_in_use++;
 		return TEGRABL_NO_ERROR;
@@ -1362,9 +1375,19 @@ tegrabl_error_t tegrabl_ufs_get_tx_rx_descriptor(uint32_t *ptrd_index)
 {
 	uint32_t trd_index;
 	uint32_t reg_data;
+	uint32_t i;
 
 	if (pufs_context->tx_req_des_in_use < MAX_TRD_NUM) {
-		trd_index = NEXT_TRD_IDX(pufs_context->last_trd_index);
+		trd_index = pufs_context->last_trd_index;
+		for (i = 0; i < MAX_TRD_NUM; i++) {
+			trd_index = NEXT_TRD_IDX(trd_index);
+			if ((pufs_context->trd_busy_mask & (1UL << trd_index)) == 0U) {
+				break;
+			}
+		}
+		if (i == MAX_TRD_NUM) {
+			return TEGRABL_ERROR(TEGRABL_ERR_NO_RESOURCE, 1U);
+		}
 		reg_data = UFS_READ32(UTRLDBR);
 		if ((reg_data & (1UL << trd_index)) != 0U) {
 			pr_error("reg data is %0x\n", reg_data);
@@ -1374,6 +1397,7 @@ tegrabl_error_t tegrabl_ufs_get_tx_rx_descriptor(uint32_t *ptrd_index)
 
 		*ptrd_index = trd_index;
 		pufs_context->last_trd_index = trd_index;
+		pufs_context->trd_busy_mask |= (1UL << trd_index);
 		pufs_context->tx_req_des_in_use++;
 		return TEGRABL_NO_ERROR;
 	} else {
@@ -1538,12 +1562,22 @@ tegrabl_ufs_wait_trd_request_complete(uint32_t trd_index, uint32_t timeout)
 	return TEGRABL_NO_ERROR;
 }
 
-void tegrabl_ufs_free_trd_cmd_desc(void)
+static void tegrabl_ufs_release_trd_cmd_desc(uint32_t trd_index,
+		uint32_t cmd_desc_index)
 {
+	pufs_context->trd_busy_mask &= ~(1UL << trd_index);
+	pufs_context->cmd_desc_busy_mask &= ~(1UL << cmd_desc_index);
 	pufs_context->tx_req_des_in_use--;
 	pufs_context->cmd_desc_in_use--;
 }
 
+void tegrabl_ufs_free_trd_cmd_desc(void)
+{
+	/* Sync commands always own the most recently allocated slots */
+	tegrabl_ufs_release_trd_cmd_desc(pufs_context->last_trd_index,
+			pufs_context->last_cmd_desc_index);
+}
+
 tegrabl_error_t tegrabl_ufs_chk_if_dev_ready_to_rec_desc(void)
 {
 
@@ -2378,10 +2412,13 @@ fail:
 	return error;
 }
 
-tegrabl_error_t
-tegrabl_ufs_rw_common(const uint32_t block, const uint32_t page,
-		const uint32_t length, uint32_t *pbuffer,
-		uint32_t opcode, uint8_t lun)
+/** Builds the SCSI command UPIU, PRDT and TRD for a read/write request.
+ *  TRD is not queued to the host controller.
+ */
+static tegrabl_error_t
+tegrabl_ufs_build_rw_trd(const uint32_t block, const uint32_t length,
+		uint32_t *pbuffer, uint32_t opcode, uint8_t lun,
+		uint32_t *ptrd_index, uint32_t *pcmd_desc_index, uint32_t *pprdt_length)
 {
 	uint32_t trd_index = 0;
 	uint32_t cmd_desc_index = 0;
@@ -2390,7 +2427,6 @@ tegrabl_ufs_rw_common(const uint32_t block, const uint32_t page,
 	uint32_t pending_length = length;
 	uint32_t prdt_length;
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
-	uint8_t lun_ready = 0;
 
 	uint32_t direction = ((opcode == SCSI_WRITE10_OPCODE) ||
 		(opcode == SCSI_SECURITY_PROTOCOL_OUT_OPCODE)) ? 1UL : 0UL;
@@ -2398,22 +2434,6 @@ tegrabl_ufs_rw_common(const uint32_t block, const uint32_t page,
 	uint8_t ufs_security_protocol = (lun == UFS_UPIU_RPMB_WLUN) ?
 		SCSI_SECURITY_PROTOCOL_UFS : 0U;
 
-	TEGRABL_UNUSED(page);
-
-	pr_trace("UFS R/W block %d len %d\n", block, length);
-
-	if (length > MAX_PRDT_LENGTH*MAX_BLOCKS) {
-		pr_error("# of blocks %u > %u\n", length,
-			 (unsigned int)MAX_PRDT_LENGTH*MAX_BLOCKS);
-		return error;
-	}
-
-	error = tegrabl_ufs_check_lun_ready(lun, &lun_ready);
-	if ((error != TEGRABL_NO_ERROR) || (lun_ready != 1UL)) {
-		pr_error("LUN %d not ready! error code=%x\n", lun, error);
-		return error;
-	}
-
 	error = tegrabl_ufs_get_tx_rx_descriptor(&trd_index);
 	if (error != TEGRABL_NO_ERROR) {
 		pr_error("UFS: Tx/Rx Descriptor not available.\n");
@@ -2423,6 +2443,8 @@ tegrabl_ufs_rw_common(const uint32_t block, const uint32_t page,
 	error = tegrabl_ufs_get_cmd_descriptor(&cmd_desc_index);
 	if (error != TEGRABL_NO_ERROR) {
 		pr_error("UFS: Command Descriptor not available\n");
+		pufs_context->trd_busy_mask &= ~(1UL << trd_index);
+		pufs_context->tx_req_des_in_use--;
 		return error;
 	}
 
@@ -2437,7 +2459,8 @@ tegrabl_ufs_rw_common(const uint32_t block, const uint32_t page,
 				UFS_UPIU_FLAGS_W_SHIFT : UFS_UPIU_FLAGS_R_SHIFT);
 	pcommand_upiu->basic_header.lun = lun;
 	pcommand_upiu->basic_header.cmd_set_type = UPIU_COMMAND_SET_SCSI;
-	pcommand_upiu->basic_header.task_tag = ((direction == 1UL) ? 0x14U : 0x15U);
+	/* Task tag has to be unique among outstanding requests */
+	pcommand_upiu->basic_header.task_tag = (uint8_t)trd_index;
 	pcommand_upiu->expected_data_tx_len_bige =
 		BYTE_SWAP32(length * (1UL << pufs_context->page_size_log2));
 
@@ -2519,6 +2542,50 @@ tegrabl_ufs_rw_common(const uint32_t block, const uint32_t page,
 	error = tegrabl_ufs_create_trd(trd_index, cmd_desc_index,
 				((direction == 1UL) ? DATA_DIR_H2D : DATA_DIR_D2H),
 				(uint16_t)prdt_length);
+	if (error != TEGRABL_NO_ERROR) {
+		tegrabl_ufs_release_trd_cmd_desc(trd_index, cmd_desc_index);
+		return error;
+	}
+
+	*ptrd_index = trd_index;
+	*pcmd_desc_index = cmd_desc_index;
+	*pprdt_length = prdt_length;
+
+	return error;
+}
+
+tegrabl_error_t
+tegrabl_ufs_rw_common(const uint32_t block, const uint32_t page,
+		const uint32_t length, uint32_t *pbuffer,
+		uint32_t opcode, uint8_t lun)
+{
+	uint32_t trd_index = 0;
+	uint32_t cmd_desc_index = 0;
+	uint32_t prdt_length = 0;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	uint8_t lun_ready = 0;
+
+	uint32_t direction = ((opcode == SCSI_WRITE10_OPCODE) ||
+		(opcode == SCSI_SECURITY_PROTOCOL_OUT_OPCODE)) ? 1UL : 0UL;
+
+	TEGRABL_UNUSED(page);
+
+	pr_trace("UFS R/W block %d len %d\n", block, length);
+
+	if (length > MAX_PRDT_LENGTH*MAX_BLOCKS) {
+		pr_error("# of blocks %u > %u\n", length,
+			 (unsigned int)MAX_PRDT_LENGTH*MAX_BLOCKS);
+		return error;
+	}
+
+	error = tegrabl_ufs_check_lun_ready(lun, &lun_ready);
+	if ((error != TEGRABL_NO_ERROR) || (lun_ready != 1UL)) {
+		pr_error("LUN %d not ready! error code=%x\n", lun, error);
+		return error;
+	}
+
+	error = tegrabl_ufs_build_rw_trd(block, length, pbuffer, opcode, lun,
+			&trd_index, &cmd_desc_index, &prdt_length);
 	if (error != TEGRABL_NO_ERROR) {
 		return error;
 	}
@@ -2530,6 +2597,7 @@ tegrabl_ufs_rw_common(const uint32_t block, const uint32_t page,
 	}
 
 	tcinfo.trd_index = trd_index;
+	tcinfo.cmd_desc_index = cmd_desc_index;
 	tcinfo.prdt_length = prdt_length;
 	tcinfo.plcmd_descriptor = &pcmd_descriptor[cmd_desc_index];
 	tcinfo.direction = direction;
@@ -2579,7 +2647,7 @@ tegrabl_ufs_rw_check_complete(const uint32_t length, uint32_t *pbuffer)
 		return TEGRABL_ERROR(TEGRABL_ERR_READ_FAILED, 6U);
 	}
 
-	tegrabl_ufs_free_trd_cmd_desc();
+	tegrabl_ufs_release_trd_cmd_desc(trd_index, tcinfo.cmd_desc_index);
 
 	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_UFS, 0,
 			pbuffer, (length * 4096UL),
@@ -2590,6 +2658,233 @@ tegrabl_ufs_rw_check_complete(const uint32_t length, uint32_t *pbuffer)
 	return error;
 }
 
+bool tegrabl_ufs_queue_has_space(void)
+{
+	uint32_t queued = 0;
+	uint32_t mask = pufs_context->queued_trd_mask;
+
+	while (mask != 0U) {
+		mask &= (mask - 1U);
+		queued++;
+	}
+
+	return (queued < UFS_MAX_QUEUED_TRD) &&
+		(pufs_context->tx_req_des_in_use < MAX_TRD_NUM) &&
+		(pufs_context->cmd_desc_in_use < MAX_CMD_DESC_NUM);
+}
+
+tegrabl_error_t tegrabl_ufs_queue_rw(uint8_t lun_id, const uint32_t block,
+		const uint32_t length, uint32_t *pbuffer, uint32_t opcode)
+{
+	uint32_t trd_index = 0;
+	uint32_t cmd_desc_index = 0;
+	uint32_t prdt_length = 0;
+	struct trdinfo *ptrd_info;
+	uint8_t lun_ready = 0;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	if ((length == 0U) || (length > (MAX_PRDT_LENGTH * MAX_BLOCKS)) ||
+			(lun_id == UFS_UPIU_RPMB_WLUN)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 8U);
+	}
+
+	if (!tegrabl_ufs_queue_has_space()) {
+		return TEGRABL_ERROR(TEGRABL_ERR_NO_RESOURCE, 2U);
+	}
+
+	/* LUN state only needs a check when a new batch starts */
+	if (pufs_context->queued_trd_mask == 0U) {
+		error = tegrabl_ufs_check_lun_ready(lun_id, &lun_ready);
+		if ((error != TEGRABL_NO_ERROR) || (lun_ready != 1UL)) {
+			pr_error("LUN %d not ready! error code=%x\n", lun_id, error);
+			return (error != TEGRABL_NO_ERROR) ? error :
+				TEGRABL_ERROR(TEGRABL_ERR_NOT_READY, 0U);
+		}
+	}
+
+	error = tegrabl_ufs_build_rw_trd(block, length, pbuffer, opcode, lun_id,
+			&trd_index, &cmd_desc_index, &prdt_length);
+	if (error != TEGRABL_NO_ERROR) {
+		return error;
+	}
+
+	ptrd_info = &pufs_context->trd_info[trd_index];
+	memset((void *)ptrd_info, 0, sizeof(struct trdinfo));
+	ptrd_info->trd_timeout = prdt_length * SCSI_REQ_READ_TIMEOUT;
+	ptrd_info->cmd_desc_index = cmd_desc_index;
+	ptrd_info->length = length;
+	ptrd_info->buffer = pbuffer;
+	ptrd_info->direction = (opcode == SCSI_WRITE10_OPCODE) ? 1UL : 0UL;
+
+	pufs_context->queued_trd_mask |= (1UL << trd_index);
+	pufs_context->doorbell_pending_mask |= (1UL << trd_index);
+
+	pr_trace("UFS queued trd %u: block %u len %u\n", trd_index, block, length);
+
+	return error;
+}
+
+void tegrabl_ufs_ring_doorbell(void)
+{
+	uint32_t mask = pufs_context->doorbell_pending_mask;
+	uint64_t now;
+	uint32_t i;
+
+	if (mask == 0U) {
+		return;
+	}
+
+	now = tegrabl_get_timestamp_us();
+	for (i = 0; i < MAX_TRD_NUM; i++) {
+		if ((mask & (1UL << i)) != 0U) {
+			pufs_context->trd_info[i].trd_starttime = now;
+		}
+	}
+
+	/* Writing 0 to a doorbell bit has no effect, so only the newly queued
+	 * slots are started and in-flight ones are left untouched */
+	UFS_WRITE32(UTRLDBR, mask);
+	pufs_context->doorbell_pending_mask = 0;
+}
+
+/** Checks the response of a completed queued TRD and releases its slot.
+ */
+static tegrabl_error_t tegrabl_ufs_complete_queued_trd(uint32_t trd_index)
+{
+	struct trdinfo *ptrd_info = &pufs_context->trd_info[trd_index];
+	struct cmd_descriptor *plcmd_descriptor;
+	struct response_upiu *presponse_upiu;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	plcmd_descriptor = &pcmd_descriptor[ptrd_info->cmd_desc_index];
+
+	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_UFS, 0,
+		&ptx_rx_desc[trd_index],
+		sizeof(struct transfer_request_descriptor),
+		TEGRABL_DMA_BIDIRECTIONAL);
+
+	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_UFS, 0,
+			&plcmd_descriptor->vucd_generic_resp_upiu,
+			sizeof(union ucd_generic_resp_upiu),
+			TEGRABL_DMA_FROM_DEVICE);
+
+	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_UFS, 0,
+			ptrd_info->buffer, (ptrd_info->length * 4096UL),
+			((ptrd_info->direction == 1UL) ? TEGRABL_DMA_TO_DEVICE :
+			 TEGRABL_DMA_FROM_DEVICE));
+
+	presponse_upiu = (struct response_upiu *)&plcmd_descriptor->vucd_generic_resp_upiu;
+
+	if (ptx_rx_desc[trd_index].dw2.ocs != OCS_SUCCESS) {
+		pr_error("UFS trd %u failed, ocs %u\n", trd_index,
+				ptx_rx_desc[trd_index].dw2.ocs);
+		error = TEGRABL_ERROR(TEGRABL_ERR_FATAL, 8U);
+	} else if (presponse_upiu->basic_header.trans_code != UPIU_RESPONSE_TRANSACTION) {
+		pr_error("Invalid %s response\n", "queued transfer");
+		error = TEGRABL_ERROR(TEGRABL_ERR_COMMAND_FAILED, 0U);
+	} else if ((presponse_upiu->basic_header.response != TARGET_SUCCESS) ||
+			(presponse_upiu->basic_header.status != SCSI_STATUS_GOOD)) {
+		pr_error("UFS queued command response failure\n");
+		error = TEGRABL_ERROR(TEGRABL_ERR_READ_FAILED, 7U);
+	} else {
+		/* No Error */
+	}
+
+	pufs_context->queued_trd_mask &= ~(1UL << trd_index);
+	tegrabl_ufs_release_trd_cmd_desc(trd_index, ptrd_info->cmd_desc_index);
+
+	return error;
+}
+
+tegrabl_error_t tegrabl_ufs_reap_completions(uint32_t *completed_blocks)
+{
+	uint32_t doorbell;
+	uint32_t done_mask;
+	uint32_t reg_data;
+	uint64_t now;
+	uint32_t i;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	tegrabl_error_t trd_error;
+
+	*completed_blocks = 0;
+
+	doorbell = UFS_READ32(UTRLDBR);
+	done_mask = pufs_context->queued_trd_mask &
+		~pufs_context->doorbell_pending_mask & ~doorbell;
+
+	if (done_mask != 0U) {
+		reg_data = UFS_READ32(IS);
+		UFS_WRITE32(IS, reg_data);
+		if ((READ_FLD(IS_SBFES, reg_data) != 0UL) || (READ_FLD(IS_HCFES, reg_data) != 0UL) ||
+		    (READ_FLD(IS_UTPES, reg_data) != 0UL) || (READ_FLD(IS_DFES, reg_data) != 0UL)) {
+			error = TEGRABL_ERROR(TEGRABL_ERR_FATAL, 9U);
+		}
+	}
+
+	for (i = 0; i < MAX_TRD_NUM; i++) {
+		if ((done_mask & (1UL << i)) == 0U) {
+			continue;
+		}
+		*completed_blocks += pufs_context->trd_info[i].length;
+		trd_error = tegrabl_ufs_complete_queued_trd(i);
+		if (trd_error != TEGRABL_NO_ERROR) {
+			error = trd_error;
+		}
+	}
+
+	if (error != TEGRABL_NO_ERROR) {
+		return error;
+	}
+
+	/* Check for the requests which are still outstanding */
+	now = tegrabl_get_timestamp_us();
+	for (i = 0; i < MAX_TRD_NUM; i++) {
+		if ((pufs_context->queued_trd_mask & ~pufs_context->doorbell_pending_mask &
+				(1UL << i)) == 0U) {
+			continue;
+		}
+		if ((now - pufs_context->trd_info[i].trd_starttime) >
+				pufs_context->trd_info[i].trd_timeout) {
+			pr_error("UFS trd %u timed out\n", i);
+			tegrabl_dump_ufs_regs();
+			return TEGRABL_ERROR(TEGRABL_ERR_TIMEOUT, 2U);
+		}
+	}
+
+	return error;
+}
+
+void tegrabl_ufs_abort_queued(void)
+{
+	uint32_t mask = pufs_context->queued_trd_mask;
+	uint32_t stuck_mask = 0;
+	uint32_t i;
+	tegrabl_error_t error;
+
+	/* Clear the slots in UTRLCLR so that controller drops them */
+	UFS_WRITE32(UTRLCLR, ~mask);
+
+	/* A slot may only be reused once the controller has let go of it */
+	error = tegrabl_ufs_pollfield(UTRLDBR, mask, 0, UTRLCLR_TIMEOUT);
+	if (error != TEGRABL_NO_ERROR) {
+		stuck_mask = UFS_READ32(UTRLDBR) & mask;
+		pr_error("UFS trds 0x%x not cleared\n", stuck_mask);
+		tegrabl_dump_ufs_regs();
+	}
+
+	for (i = 0; i < MAX_TRD_NUM; i++) {
+		if ((stuck_mask & (1UL << i)) != 0U) {
+			/* Stop tracking it but keep the TRD and cmd desc busy */
+			pufs_context->queued_trd_mask &= ~(1UL << i);
+		} else if ((mask & (1UL << i)) != 0U) {
+			(void)tegrabl_ufs_complete_queued_trd(i);
+		} else {
+			/* Not queued */
+		}
+	}
+	pufs_context->doorbell_pending_mask = 0;
+}
+
 tegrabl_error_t
 tegrabl_ufs_xfer(uint8_t lun_id, const uint32_t block, const uint32_t page,
 			const uint32_t length, uint32_t *pbuffer)
@@ -96,6 +96,41 @@ static uint32_t total_read_size;
 #endif
 
 
+/** @brief Queues read requests for the remaining part of current transfer
+ *  until either whole transfer is queued or all queue slots are in use, and
+ *  then starts them with a single doorbell write.
+ *
+ *  @param context UFS context
+ *  @param xfer_info State of the transfer to be queued
+ *
+ *  @return TEGRABL_NO_ERROR if successful else appropriate error.
+ */
+static tegrabl_error_t tegrabl_ufs_bdev_fill_queue(
+		struct tegrabl_ufs_context *context,
+		struct tegrabl_ufs_xfer_info *xfer_info)
+{
+	uint32_t bulk_count = 0;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	while ((xfer_info->blocks_to_queue != 0U) && tegrabl_ufs_queue_has_space()) {
+		bulk_count = MIN(xfer_info->blocks_to_queue, UFS_RW_BLOCK_MAX);
+		error = tegrabl_ufs_queue_rw(xfer_info->lun_id, xfer_info->next_block,
+				bulk_count, (uint32_t *)xfer_info->next_buf, SCSI_READ10_OPCODE);
+		if (error != TEGRABL_NO_ERROR) {
+			break;
+		}
+
+		xfer_info->blocks_to_queue -= bulk_count;
+		xfer_info->next_buf += (bulk_count << context->block_size_log2);
+		xfer_info->next_block += bulk_count;
+	}
+
+	/* Start whatever got queued even on failure, it is reaped in wait */
+	tegrabl_ufs_ring_doorbell();
+
+	return error;
+}
+
 /** @brief Executes the either read/write transaction based on the given
 	transaction details. Transfer info block numbers to read/write and
 	contains blocking/non-blocking etc.
@@ -112,9 +147,9 @@ static tegrabl_error_t tegrabl_ufs_blockdev_xfer(
 	uint32_t block = 0;
 	uint32_t count = 0;
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
-	uint32_t bulk_count = 0;
 	struct ufs_priv_data *priv_data = NULL;
 	struct tegrabl_ufs_context *context = NULL;
+	struct tegrabl_ufs_xfer_info *xfer_info = NULL;
 	uint8_t *buf = NULL;
 
 	if ((xfer == NULL) || ((xfer->dev == NULL)) || (xfer->buf == NULL)) {
@@ -146,15 +181,24 @@ static tegrabl_error_t tegrabl_ufs_blockdev_xfer(
 		goto fail;
 	}
 
-	if (count != 0U) {
-		bulk_count = MIN(count, UFS_RW_BLOCK_MAX);
-		error = tegrabl_ufs_xfer(priv_data->lun_id, block, 0,
-				bulk_count, (uint32_t *)buf);
-		if (error != TEGRABL_NO_ERROR) {
-			goto fail;
-		}
-		context->xfer_info.dma_in_progress = true;
-		context->xfer_info.bulk_count = bulk_count;
+	if (context->xfer_info.blocks_pending != 0U) {
+		pr_error("UFS: previous async transfer still pending\n");
+		error = TEGRABL_ERROR(TEGRABL_ERR_BUSY, 0);
+		goto fail;
+	}
+
+	xfer_info = &context->xfer_info;
+	xfer_info->lun_id = priv_data->lun_id;
+	xfer_info->next_buf = buf;
+	xfer_info->next_block = block;
+	xfer_info->blocks_to_queue = count;
+	xfer_info->blocks_pending = count;
+
+	error = tegrabl_ufs_bdev_fill_queue(context, xfer_info);
+	if (error != TEGRABL_NO_ERROR) {
+		tegrabl_ufs_abort_queued();
+		xfer_info->blocks_to_queue = 0;
+		xfer_info->blocks_pending = 0;
 	}
 
 fail:
@@ -176,12 +220,10 @@ static tegrabl_error_t tegrabl_ufs_blockdev_xfer_wait(
 {
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
 	struct tegrabl_bdev *dev = NULL;
-	bnum_t block = 0;
-	bnum_t count = 0;
-	uint32_t bulk_count = 0;
+	uint32_t completed = 0;
 	struct ufs_priv_data *priv_data = NULL;
 	struct tegrabl_ufs_context *context = NULL;
-	uint8_t *buf = NULL;
+	struct tegrabl_ufs_xfer_info *xfer_info = NULL;
 	time_t start_time_us;
 	time_t elapsed_time_us;
 	time_t timeout_us;
@@ -197,9 +239,6 @@ static tegrabl_error_t tegrabl_ufs_blockdev_xfer_wait(
 	}
 
 	dev = xfer->dev;
-	buf = xfer->buf;
-	block = xfer->start_block;
-	count = xfer->block_count;
 	*status_flag = TEGRABL_BLOCKDEV_XFER_IN_PROGRESS;
 
 	priv_data = (struct ufs_priv_data *)dev->priv_data;
@@ -209,43 +248,42 @@ static tegrabl_error_t tegrabl_ufs_blockdev_xfer_wait(
 		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
 		goto fail;
 	}
+	xfer_info = &context->xfer_info;
 
 	elapsed_time_us = 0;
 	timeout_us = timeout;
 	start_time_us = tegrabl_get_timestamp_us();
 
-	while ((count > 0UL) && (elapsed_time_us <= timeout_us)) {
-		if (context->xfer_info.dma_in_progress) {
-			bulk_count = context->xfer_info.bulk_count;
-			error = tegrabl_ufs_rw_check_complete(bulk_count, (uint32_t *)buf);
+	while ((xfer_info->blocks_pending > 0UL) && (elapsed_time_us <= timeout_us)) {
+		error = tegrabl_ufs_reap_completions(&completed);
+		if (error != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+
+		if (completed != 0U) {
+			xfer_info->blocks_pending -= completed;
+			/* Refill freed slots before anything else so that link
+			 * stays busy */
+			error = tegrabl_ufs_bdev_fill_queue(context, xfer_info);
 			if (error != TEGRABL_NO_ERROR) {
 				goto fail;
 			}
-			count -= bulk_count;
-			buf += (bulk_count << context->block_size_log2);
-			block += bulk_count;
-		}
-		bulk_count = MIN(count, UFS_RW_BLOCK_MAX);
-		if (bulk_count <= 0UL) {
-			break;
-		}
-
-		error = tegrabl_ufs_xfer(priv_data->lun_id, block, 0, bulk_count, (uint32_t *)buf);
-
-		if (error != TEGRABL_NO_ERROR) {
-			goto fail;
 		}
 
 		elapsed_time_us = tegrabl_get_timestamp_us() - start_time_us;
 	}
-	if (count > 0UL) {
-		xfer->start_block = block;
-		xfer->block_count = count;
-		xfer->buf = buf;
-	} else {
+
+	if (xfer_info->blocks_pending == 0UL) {
 		*status_flag = TEGRABL_BLOCKDEV_XFER_COMPLETE;
 	}
+
 fail:
+	if ((error != TEGRABL_NO_ERROR) && (xfer_info != NULL)) {
+		tegrabl_ufs_abort_queued();
+		xfer_info->blocks_to_queue = 0;
+		xfer_info->blocks_pending = 0;
+		*status_flag = TEGRABL_BLOCKDEV_XFER_FAILURE;
+	}
 	return error;
 }
 
@@ -268,6 +306,8 @@ static tegrabl_error_t tegrabl_ufs_bdev_read_block(
 	uint32_t bulk_count = 0;
 	struct ufs_priv_data *priv_data = NULL;
 	struct tegrabl_ufs_context *context = NULL;
+	struct tegrabl_ufs_xfer_info xfer_info;
+	uint32_t completed = 0;
 	uint8_t *buf = buffer;
 #if defined(CONFIG_ENABLE_UFS_KPI)
 	last_read_start_time = tegrabl_get_timestamp_us();
@@ -292,17 +332,42 @@ static tegrabl_error_t tegrabl_ufs_bdev_read_block(
 		goto fail;
 	}
 
-	while (count != 0U) {
-		bulk_count = MIN(count, UFS_RW_BLOCK_MAX);
-		error = tegrabl_ufs_read(priv_data->lun_id, block, 0,
-			bulk_count, (uint32_t *)buf);
+	if (context->xfer_info.blocks_pending == 0U) {
+		/* Keep several requests in flight through the queued path */
+		xfer_info.lun_id = priv_data->lun_id;
+		xfer_info.next_buf = buf;
+		xfer_info.next_block = block;
+		xfer_info.blocks_to_queue = count;
+		xfer_info.blocks_pending = count;
+
+		error = tegrabl_ufs_bdev_fill_queue(context, &xfer_info);
+		while ((error == TEGRABL_NO_ERROR) && (xfer_info.blocks_pending != 0U)) {
+			error = tegrabl_ufs_reap_completions(&completed);
+			if ((error == TEGRABL_NO_ERROR) && (completed != 0U)) {
+				xfer_info.blocks_pending -= completed;
+				error = tegrabl_ufs_bdev_fill_queue(context, &xfer_info);
+			}
+		}
 		if (error != TEGRABL_NO_ERROR) {
+			tegrabl_ufs_abort_queued();
+			pr_error("UFS Read transfer failed error = %u\n", error);
 			goto fail;
 		}
+	} else {
+		/* Queue is owned by an async transfer, fall back to one request
+		 * at a time */
+		while (count != 0U) {
+			bulk_count = MIN(count, UFS_RW_BLOCK_MAX);
+			error = tegrabl_ufs_read(priv_data->lun_id, block, 0,
+				bulk_count, (uint32_t *)buf);
+			if (error != TEGRABL_NO_ERROR) {
+				goto fail;
+			}
 
-		count -= bulk_count;
-		buf += (bulk_count << context->block_size_log2);
-		block += bulk_count;
+			count -= bulk_count;
+			buf += (bulk_count << context->block_size_log2);
+			block += bulk_count;
+		}
 	}
 #if defined(CONFIG_ENABLE_UFS_KPI)
 	last_read_end_time = tegrabl_get_timestamp_us();
@@ -27,6 +27,11 @@ struct trdinfo {
 	uint64_t  trd_timeout_in_us;
 	uint64_t trd_starttime;
 	uint64_t trd_timeout;
+	/* Following are valid only for queued read/write requests */
+	uint32_t cmd_desc_index;
+	uint32_t length;
+	uint32_t direction;
+	uint32_t *buffer;
 };
 
 struct tegrabl_ufs_internal_params {
@@ -42,9 +47,18 @@ struct tegrabl_ufs_rpmb_params {
 	uint8_t rpmb_lun;
 };
 
+/* Maximum number of read/write TRDs kept in flight by the queued path.
+ * One TRD/command descriptor is always left free for sync commands
+ * (NOP, query, sense) issued while a queued transfer is in progress.
+ */
+#define UFS_MAX_QUEUED_TRD	(MIN(MAX_TRD_NUM, MAX_CMD_DESC_NUM) - 1U)
+
 struct tegrabl_ufs_xfer_info {
-	bool dma_in_progress;
-	uint32_t bulk_count;
+	uint8_t *next_buf;
+	uint32_t next_block;
+	uint32_t blocks_to_queue;
+	uint32_t blocks_pending;
+	uint8_t lun_id;
 };
 
 struct tegrabl_ufs_context {
@@ -71,6 +85,10 @@ struct tegrabl_ufs_context {
 	uint32_t last_cmd_desc_index;
 	uint32_t tx_req_des_in_use;;
 	uint32_t last_trd_index;
+	uint32_t trd_busy_mask;
+	uint32_t cmd_desc_busy_mask;
+	uint32_t queued_trd_mask;
+	uint32_t doorbell_pending_mask;
 	struct trdinfo trd_info[MAX_TRD_NUM];
 	struct tegrabl_ufs_rpmb_params rpmb_param;
 	/* End: House keeping */
@@ -100,6 +118,53 @@ tegrabl_error_t tegrabl_ufs_xfer(uint8_t lun_id, const uint32_t block, const uin
 tegrabl_error_t tegrabl_ufs_rw_check_complete(const uint32_t length, uint32_t *pbuffer);
 tegrabl_error_t tegrabl_ufs_rw_common(const uint32_t block, const uint32_t page,
 			const uint32_t length, uint32_t *pbuffer, uint32_t direction, uint8_t lun);
+
+/**
+ * @brief Builds a read/write TRD and marks it for the next doorbell ring.
+ * Request is not issued to device until tegrabl_ufs_ring_doorbell() is
+ * called, which allows several requests to be started together.
+ *
+ * @param lun_id LUN to which request is targeted
+ * @param block Start block
+ * @param length Number of blocks (at most MAX_PRDT_LENGTH * MAX_BLOCKS)
+ * @param pbuffer Data buffer
+ * @param opcode SCSI_READ10_OPCODE or SCSI_WRITE10_OPCODE
+ *
+ * @return TEGRABL_NO_ERROR if queued, TEGRABL_ERR_NO_RESOURCE if all queue
+ * slots are in use, else appropriate error.
+ */
+tegrabl_error_t tegrabl_ufs_queue_rw(uint8_t lun_id, const uint32_t block,
+		const uint32_t length, uint32_t *pbuffer, uint32_t opcode);
+
+/**
+ * @brief Issues all TRDs queued by tegrabl_ufs_queue_rw() with a single
+ * doorbell register write.
+ */
+void tegrabl_ufs_ring_doorbell(void);
+
+/**
+ * @brief Checks if another queued request can be accepted.
+ *
+ * @return true if a queue slot is free.
+ */
+bool tegrabl_ufs_queue_has_space(void);
+
+/**
+ * @brief Reaps all queued TRDs which completed since last call. Requests
+ * can complete in any order.
+ *
+ * @param completed_blocks Number of blocks transferred by reaped requests
+ *
+ * @return TEGRABL_NO_ERROR if all reaped requests are successful, error
+ * if any of them failed or timed out.
+ */
+tegrabl_error_t tegrabl_ufs_reap_completions(uint32_t *completed_blocks);
+
+/**
+ * @brief Aborts all queued requests and releases their slots. Slots the
+ * controller does not clear in time are left busy and never reused.
+ */
+void tegrabl_ufs_abort_queued(void);
 tegrabl_error_t tegrabl_ufs_read(uint8_t lun_id, const uint32_t block, const uint32_t page,
 		const uint32_t length, uint32_t *pbuffer);
 tegrabl_error_t tegrabl_ufs_write(uint8_t lun_id, const uint32_t block, const uint32_t page,
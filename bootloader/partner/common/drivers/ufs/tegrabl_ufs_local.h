@@ -35,6 +35,7 @@
 #define HCE_SET_TIMEOUT             500000
 #define UTRLRDY_SET_TIMEOUT         500000
 #define UTMRLRDY_SET_TIMEOUT        500000
+#define UTRLCLR_TIMEOUT             500000
 #define IS_UCCS_TIMEOUT             500000
 #define IS_UPMS_TIMEOUT             500000
 #define NOP_TIMEOUT                 500000
@@ -95,6 +96,7 @@
 #define UTMRLBA				(UFSHC_BLOCK_BASEADDRESS + 0x70U)
 #define UTMRLBAU			(UFSHC_BLOCK_BASEADDRESS + 0x74U)
 #define UTRLDBR				(UFSHC_BLOCK_BASEADDRESS + 0x58U)
+#define UTRLCLR				(UFSHC_BLOCK_BASEADDRESS + 0x5cU)
 #define UECPA				(UFSHC_BLOCK_BASEADDRESS + 0x38U)
 #define UECDL				(UFSHC_BLOCK_BASEADDRESS + 0x3cU)
 #define UECN				(UFSHC_BLOCK_BASEADDRESS + 0x40U)
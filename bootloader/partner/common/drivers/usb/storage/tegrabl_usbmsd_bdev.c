@@ -107,6 +107,48 @@ void dump_buf(const void *data, size_t size)
 
 #endif	/* USB_DEBUG */
 
+/**
+ * @brief Fills the context CDB for a block read/write. READ(10)/WRITE(10)
+ * is used when LBA and count fit, READ(16)/WRITE(16) otherwise.
+ *
+ * @param context Context information
+ * @param is_write True if write operation
+ * @param block Start sector
+ * @param count Number of sectors
+ */
+static void usbmsd_setup_rw_cdb(struct tegrabl_usbmsd_context *context,
+				bool is_write, uint64_t block, uint32_t count)
+{
+	if ((count <= USBMSD_MAX_RW10_SECTORS) && (block <= 0xFFFFFFFFULL)) {
+		context->cmdlen = 10;
+		memset(context->cmd, 0x0, context->cmdlen);
+		context->cmd[0] = is_write ? WRITE_10 : READ_10;
+		context->cmd[2] = (uint8_t)(block >> 24);
+		context->cmd[3] = (uint8_t)(block >> 16);
+		context->cmd[4] = (uint8_t)(block >> 8);
+		context->cmd[5] = (uint8_t)(block);
+		context->cmd[7] = (uint8_t)(count >> 8);
+		context->cmd[8] = (uint8_t)(count);
+	} else {
+		context->cmdlen = 16;
+		memset(context->cmd, 0x0, context->cmdlen);
+		context->cmd[0] = is_write ? WRITE_16 : READ_16;
+		context->cmd[2] = (uint8_t)(block >> 56);
+		context->cmd[3] = (uint8_t)(block >> 48);
+		context->cmd[4] = (uint8_t)(block >> 40);
+		context->cmd[5] = (uint8_t)(block >> 32);
+		context->cmd[6] = (uint8_t)(block >> 24);
+		context->cmd[7] = (uint8_t)(block >> 16);
+		context->cmd[8] = (uint8_t)(block >> 8);
+		context->cmd[9] = (uint8_t)(block);
+		context->cmd[10] = (uint8_t)(count >> 24);
+		context->cmd[11] = (uint8_t)(count >> 16);
+		context->cmd[12] = (uint8_t)(count >> 8);
+		context->cmd[13] = (uint8_t)(count);
+	}
+	context->xfer_info.is_write = is_write;
+}
+
 /**
  * @brief Processes ioctl request.
  *
@@ -218,6 +260,7 @@ static tegrabl_error_t tegrabl_usbmsd_bdev_xfer(
 	else
 		is_write = true;
 
+	usbmsd_setup_rw_cdb(context, is_write, block, bulk_count);
 	xfer_length = (bulk_count << context->block_size_log2);
 	error = tegrabl_usbmsd_io(context, xfer->buf, xfer_length,
 				  TEGRABL_USBMSD_READ_TIMEOUT);
@@ -289,27 +332,12 @@ static tegrabl_error_t tegrabl_usbmsd_bdev_read_block(struct tegrabl_bdev *dev,
 		goto fail;
 	}
 
-	/* Set up SCSI CDB in here for READ_10 */
-	context->cmdlen = 10;
-	memset(context->cmd, 0x0, context->cmdlen);
-	context->cmd[0] = READ_10;
-	context->xfer_info.is_write = 0;	/* data comes from device */
-
 	pr_debug("start block = %d, count = %d\n", block, count);
 	while (count != 0U) {
 		bulk_count = MIN(count, USBMSD_MAX_READ_WRITE_SECTORS);
 
 		pr_debug("%s: bulk count = %d\n", __func__, bulk_count);
-		/*
-		 * Find a cleaner way of storing block/count in the CDB
-		 * NOTE: Assumes 32-bit LBA and 16-bit count, max!
-		 */
-		context->cmd[2] = ((uint8_t)(block >> 24)) & 0xFF;
-		context->cmd[3] = ((uint8_t)(block >> 16)) & 0xFF;
-		context->cmd[4] = ((uint8_t)(block >> 8)) & 0xFF;
-		context->cmd[5] = ((uint8_t)(block)) & 0xFF;
-		context->cmd[7] = ((uint8_t)(bulk_count >> 8)) & 0xFF;
-		context->cmd[8] = ((uint8_t)(bulk_count)) & 0xFF;
+		usbmsd_setup_rw_cdb(context, false, block, bulk_count);
 
 		xfer_length = (bulk_count << context->block_size_log2);
 		pr_debug("%s: xfer_length = %d\n", __func__, xfer_length);
@@ -392,26 +420,10 @@ static tegrabl_error_t tegrabl_usbmsd_bdev_write_block(struct tegrabl_bdev *dev,
 		goto fail;
 	}
 
-	/* Set up SCSI CDB in here for WRITE_10 */
-	context->cmdlen = 10;
-	memset(context->cmd, 0x0, context->cmdlen);
-	context->cmd[0] = WRITE_10;
-	context->xfer_info.is_write = 1;	/* data comes from host */
-
 	pr_debug("start block = %d, count = %d\n", block, count);
 	while (count > 0UL) {
 		bulk_count = MIN(count, USBMSD_MAX_READ_WRITE_SECTORS);
-
-		/*
-		 * Find a cleaner way of storing block/count in the CDB
-		 * NOTE: Assumes 32-bit LBA and 16-bit count, max!
-		 */
-		context->cmd[2] = ((uint8_t)(block >> 24)) & 0xFF;
-		context->cmd[3] = ((uint8_t)(block >> 16)) & 0xFF;
-		context->cmd[4] = ((uint8_t)(block >> 8)) & 0xFF;
-		context->cmd[5] = ((uint8_t)(block)) & 0xFF;
-		context->cmd[7] = ((uint8_t)(bulk_count >> 8)) & 0xFF;
-		context->cmd[8] = ((uint8_t)(bulk_count)) & 0xFF;
+		usbmsd_setup_rw_cdb(context, true, block, bulk_count);
 
 		xfer_length = (bulk_count << context->block_size_log2);
 		error = tegrabl_usbmsd_io(context, (void *)buf, xfer_length,
@@ -921,19 +933,17 @@ tegrabl_error_t tegrabl_usbmsd_init(struct tegrabl_usbmsd_context *context)
  */
 
 /*
- * status = NO_ERROR: Success, command sent to device
- * status = NOT_READY: Device NAK'd the command
- * status = anything else: Command phase failed
+ * status = NO_ERROR: Success, CBW ready to be sent
+ * status = anything else: Bad command
  * entry: context = MSD context
  * entry: num_bytes = data length
+ * entry: cbw = CBW to fill in
  */
-tegrabl_error_t usbmsd_send_cbw(struct tegrabl_usbmsd_context *context,
-				uint32_t num_bytes)
+static tegrabl_error_t usbmsd_setup_cbw(struct tegrabl_usbmsd_context *context,
+				uint32_t num_bytes, usb_msd_cbw_t *cbw)
 {
-	usb_msd_cbw_t cbw;
-	uint32_t xfer_length;
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
-	uint8_t cmdlen, dev_id;
+	uint8_t cmdlen;
 
 	TEGRABL_ASSERT(context != NULL);
 	pr_debug("Entry, num_bytes = %d\n", num_bytes);
@@ -948,8 +958,6 @@ tegrabl_error_t usbmsd_send_cbw(struct tegrabl_usbmsd_context *context,
 	}
 	pr_debug("cmdlen = %d\n", cmdlen);
 
-	dev_id = context->host_context.curr_dev_priv->enum_dev.dev_addr;
-
 	/*
 	 * NOTE: num_bytes == 0 is OK here, just means no data phase.
 	 *  Also, if this is a SCSI query op, like INQUIRY, TUR, etc.,
@@ -957,103 +965,96 @@ tegrabl_error_t usbmsd_send_cbw(struct tegrabl_usbmsd_context *context,
 	 */
 
 	pr_debug("Set up CBW...\n");
-	/* Wrap xfer_info in CBW, send down to host driver */
-	cbw.Signature = CBW_SIGNATURE;
-	cbw.Tag = context->tag;
-	cbw.DataTransferLength = num_bytes;
-	cbw.Flags = context->xfer_info.is_write ? CBW_OUT_FLAG : CBW_IN_FLAG;
-	cbw.LUN = context->current_lun;
+	/* Wrap xfer_info in CBW, sent down to host driver by the caller */
+	cbw->Signature = CBW_SIGNATURE;
+	cbw->Tag = context->tag;
+	cbw->DataTransferLength = num_bytes;
+	cbw->Flags = context->xfer_info.is_write ? CBW_OUT_FLAG : CBW_IN_FLAG;
+	cbw->LUN = context->current_lun;
 
 	pr_debug("Copy CDB from context...\n");
-	cbw.Length = cmdlen;
-	memset(cbw.CDB, 0x0, CBW_CDBLENGTH);
+	cbw->Length = cmdlen;
+	memset(cbw->CDB, 0x0, CBW_CDBLENGTH);
 	/* CDB (context->cmd) should have already been set up by the caller */
-	memcpy(cbw.CDB, context->cmd, cmdlen);
-	xfer_length = CBW_SIZE;
+	memcpy(cbw->CDB, context->cmd, cmdlen);
 
 #ifdef	USB_DEBUG
-	pr_info("device ID (address) = %d, IO direction is %s\n", dev_id,
-		 cbw.Flags & CBW_IN_FLAG ? "IN" : "OUT");
-	dump_cbw(&cbw);
+	pr_info("IO direction is %s\n",
+		 cbw->Flags & CBW_IN_FLAG ? "IN" : "OUT");
+	dump_cbw(cbw);
 #endif
-
-	/* Send CBW to device via host driver I/O */
-	error = tegrabl_usbh_snd_data(dev_id, &cbw, &xfer_length);
-
-	/* check xfer_length, s/b == CBW_SIZE, 31 bytes */
-	if (xfer_length != CBW_SIZE) {
-		pr_error("Warning: Transferred %d CBW bytes, should be %d!\n",
-			 xfer_length, CBW_SIZE);
-		error = TEGRABL_ERROR(TEGRABL_ERR_SEND_FAILED,
-				      TEGRABL_USBMSD_START_COMMAND_2);
-	}
 fail:
 	pr_debug("%s: Exit, returning error code 0x%X\n", __func__, error);
 	return error;
 }
 
 /*
- * status = NO_ERROR: Success, data transferred OK
- * status = NOT_READY: Device NAK'd the transfer
- * status = anything else: Data phase failed
+ * status = NO_ERROR: Success, valid status returned by device
+ * status = anything else: Bad or missing CSW
  * entry: context = MSD context
- * entry: num_bytes = data length
+ * entry: csw = CSW received from the device
+ * entry: xfer_length = CSW bytes received
+ * entry: status = CSW status byte
  */
-tegrabl_error_t usbmsd_transfer_data(struct tegrabl_usbmsd_context *context,
-				uint32_t num_bytes)
+static tegrabl_error_t usbmsd_check_csw(struct tegrabl_usbmsd_context *context,
+					usb_msd_csw_t *csw, uint32_t xfer_length,
+					uint8_t *status)
 {
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
-	uint32_t xfer_length;
-	uint8_t dev_id;
 
-	TEGRABL_ASSERT(context != NULL);
-	pr_debug("%s: Entry, num_bytes = %d\n", __func__, num_bytes);
-
-	/* Transfer data, either HOST2DEV or DEV2HOST */
-
-	/* Just return SUCCESS/NO_ERROR if no data transfer required */
-	if (num_bytes == 0)
-		goto fail;
-
-	xfer_length = num_bytes;
-	dev_id = context->host_context.curr_dev_priv->enum_dev.dev_addr;
-
-	if (context->xfer_info.buf == NULL) {
-		pr_error("xfer_info buffer is NULL!\n");
-		error =  TEGRABL_ERR_NO_MEMORY;
+	/* Validate xfer_length == CSW_SIZE */
+	if (xfer_length != CSW_SIZE) {
+		pr_error("Warning: Transferred %d CSW bytes, should be %d!\n",
+			 xfer_length, CSW_SIZE);
+		error = TEGRABL_ERROR(TEGRABL_ERR_UNKNOWN_STATUS,
+				      TEGRABL_USBMSD_BAD_STATUS);
 		goto fail;
 	}
-	pr_debug("%s: xfer_info buf = %p\n", __func__, context->xfer_info.buf);
 
+	/* Handle data/phase errors, do reset recovery */
 #ifdef	USB_DEBUG
-	pr_info("device ID (address) = %d, IO direction is %s\n", dev_id,
-		 context->xfer_info.is_write ? "OUT" : "IN");
-	pr_info("requested data length = %u bytes\n", xfer_length);
+	dump_csw(csw);
 #endif
-	/* Transfer data via host driver I/O */
-	if (context->xfer_info.is_write)
-		error = tegrabl_usbh_snd_data(dev_id,
-				context->xfer_info.buf,
-				&xfer_length);
-	else
-		error = tegrabl_usbh_rcv_data(dev_id,
-				context->xfer_info.buf,
-				&xfer_length);
-
-	/* TBD: Check xfer length, handle short xfer condition */
-	pr_debug("transferred data length = %u bytes\n", xfer_length);
+	if (csw->Signature != CSW_SIGNATURE) {
+		/* Invalid data, bulk reset and fail */
+		pr_error("Bad CSW SIG (%X)!\n", csw->Signature);
+		do_bulk_reset(context);
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID,
+				      TEGRABL_USBMSD_BAD_SIG);
+		TEGRABL_SET_ERROR_STRING(error, "CSW SIG %X",
+					 csw->Signature);
+		goto fail;
+	} else if (csw->Tag != context->tag) {
+		/* Device confused?, bulk reset and fail */
+		do_bulk_reset(context);
+		pr_error("Bad CSW Tag (%X), context->tag = %X\n",
+			 csw->Tag, context->tag);
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID,
+				      TEGRABL_USBMSD_BAD_TAG);
+		TEGRABL_SET_ERROR_STRING(error, "CSW TAG %X", csw->Tag);
+		goto fail;
+	} else if (csw->Status >= CSW_PHASE_STAT) {
+		/* Phase error, do reset recovery */
+		pr_error("Bad CSW status (%d)!\n", csw->Status);
+		do_bulk_reset(context);
+		clear_endpoint_stall(context, context->in_ep);
+		clear_endpoint_stall(context, context->out_ep);
+		error = TEGRABL_ERROR(TEGRABL_ERR_UNKNOWN_STATUS,
+				      TEGRABL_USBMSD_PHASE_ERR);
+		TEGRABL_SET_ERROR_STRING(error, "CSW status 0x%02X",
+					 csw->Status);
+	}
 
-#ifdef	USB_DEBUG
-	if (num_bytes <= 1024)
-		dump_buf(context->xfer_info.buf, num_bytes);
-	else
-		dump_buf(context->xfer_info.buf, 1024);	/* 1st 2 sectors */
-#endif
-	/* TBD: Process error, send bulk reset/clear endpoint on STALL */
-	/* TBD: Return NOT_READY if device NAK'd so caller can retry? */
+	/* OK, return csw->Status, error s/b NO_ERROR */
+	*status = csw->Status;
+	context->csw_status = csw->Status;	/* save for later */
 
 fail:
-	pr_debug("%s: Exit, returning error code 0x%X\n", __func__, error);
+	pr_debug("%s: Incrementing tag, was %X\n", __func__, context->tag);
+	context->tag++;		/* Bump tag regardless */
+
+	pr_debug("%s: Exit, returning error code 0x%X, status = %d, tag = %X\n",
+		 __func__, error, *status, context->tag);
 	return error;
 }
 
@@ -1068,6 +1069,7 @@ tegrabl_error_t usbmsd_get_csw(struct tegrabl_usbmsd_context *context,
 			       uint8_t *status)
 {
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	tegrabl_error_t csw_error;
 	struct xusb_host_context *host_ctx = NULL;
 	usb_msd_csw_t csw;
 	uint32_t xfer_length;
@@ -1104,59 +1106,11 @@ tegrabl_error_t usbmsd_get_csw(struct tegrabl_usbmsd_context *context,
 		}
 	}
 
-	/* Validate xfer_length == CSW_SIZE */
-	if (xfer_length != CSW_SIZE) {
-		pr_error("Warning: Transferred %d CSW bytes, should be %d!\n",
-			 xfer_length, CSW_SIZE);
-		error = TEGRABL_ERROR(TEGRABL_ERR_UNKNOWN_STATUS,
-				      TEGRABL_USBMSD_BAD_STATUS);
-		goto fail;
-	}
+	csw_error = usbmsd_check_csw(context, &csw, xfer_length, status);
+	if (csw_error != TEGRABL_NO_ERROR)
+		error = csw_error;
 
-	/* Handle data/phase errors, do reset recovery */
-#ifdef	USB_DEBUG
-	dump_csw(&csw);
-#endif
-	if (csw.Signature != CSW_SIGNATURE) {
-		/* Invalid data, bulk reset and fail */
-		pr_error("Bad CSW SIG (%X)!\n", csw.Signature);
-		do_bulk_reset(context);
-		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID,
-				      TEGRABL_USBMSD_BAD_SIG);
-		TEGRABL_SET_ERROR_STRING(error, "CSW SIG %X",
-					 csw.Signature);
-		goto fail;
-	} else if (csw.Tag != context->tag) {
-		/* Device confused?, bulk reset and fail */
-		do_bulk_reset(context);
-		pr_error("Bad CSW Tag (%X), context->tag = %X\n",
-			 csw.Tag, context->tag);
-		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID,
-				      TEGRABL_USBMSD_BAD_TAG);
-		TEGRABL_SET_ERROR_STRING(error, "CSW TAG %X", csw.Tag);
-		goto fail;
-	} else if (csw.Status >= CSW_PHASE_STAT) {
-		/* Phase error, do reset recovery */
-		pr_error("Bad CSW status (%d)!\n", csw.Status);
-		do_bulk_reset(context);
-		clear_endpoint_stall(context, context->in_ep);
-		clear_endpoint_stall(context, context->out_ep);
-		error = TEGRABL_ERROR(TEGRABL_ERR_UNKNOWN_STATUS,
-				      TEGRABL_USBMSD_PHASE_ERR);
-		TEGRABL_SET_ERROR_STRING(error, "CSW status 0x%02X",
-					 csw.Status);
-	}
-
-	/* OK, return csw.Status, error s/b NO_ERROR */
-	*status = csw.Status;
-	context->csw_status = csw.Status;	/* save for later */
-
-fail:
-	pr_debug("%s: Incrementing tag, was %X\n", __func__, context->tag);
-	context->tag++;		/* Bump tag regardless */
-
-	pr_debug("%s: Exit, returning error code 0x%X, status = %d, tag = %X\n",
-		 __func__, error, *status, context->tag);
+	pr_debug("%s: Exit, returning error code 0x%X\n", __func__, error);
 	return error;
 }
 
@@ -1376,19 +1330,63 @@ tegrabl_error_t tegrabl_usbmsd_read_capacity(
 	buf[0] = be32tole32(buf[0]);	/* Max LBA */
 	buf[1] = be32tole32(buf[1]);	/* Block size */
 
-	/* TBD: If FFFFFFFFh is returned, use READ_CAPACITY(16)? */
 	pr_debug("Max LBA (buf[0]) = 0x%X, block size (buf[1]) = %u\n",
 		 (buf[0])+1, buf[1]);
 
 	if (error == TEGRABL_NO_ERROR)
 		context->block_count = (uint64_t)(buf[0] + 1);
 
+	/* Devices larger than 2TB report max LBA FFFFFFFFh, ask READ_CAP(16) */
+	if ((error == TEGRABL_NO_ERROR) && (buf[0] == 0xFFFFFFFFU)) {
+		error = tegrabl_usbmsd_read_capacity_16(context);
+	}
+
 	/* TBD: Use buf[1] from READ_CAP as block size? (s/b 512) */
 
 	pr_debug("%s: Exiting with error code 0x%X\n", __func__, error);
 	return error;
 }
 
+tegrabl_error_t tegrabl_usbmsd_read_capacity_16(
+					struct tegrabl_usbmsd_context *context)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	uint32_t xfer_length, buf[8];
+	uint8_t *p = (uint8_t *)buf;
+	uint64_t max_lba = 0;
+	uint32_t i;
+
+	TEGRABL_ASSERT(context != NULL);
+	pr_debug("%s: Entry\n", __func__);
+
+	xfer_length = 32;	/* READ CAPACITY(16) parameter data */
+
+	context->cmdlen = 16;
+	memset(context->cmd, 0x0, context->cmdlen);
+	context->cmd[0] = SERVICE_ACTION_IN_16;
+	context->cmd[1] = SAI_READ_CAPACITY_16;
+	context->cmd[13] = (uint8_t)xfer_length;
+	context->xfer_info.is_write = 0;	/* data comes from device */
+
+	error = tegrabl_usbmsd_io(context, &buf, xfer_length,
+				  TEGRABL_USBMSD_READ_TIMEOUT);
+	if (error != TEGRABL_NO_ERROR) {
+		pr_error("READ CAPACITY(16) returned error 0x%X ...\n", error);
+		goto fail;
+	}
+
+	/* Bytes 0-7 hold the last LBA, big endian */
+	for (i = 0; i < 8U; i++) {
+		max_lba = (max_lba << 8) | p[i];
+	}
+	context->block_count = max_lba + 1ULL;
+	pr_debug("Max LBA (16) = 0x%"PRIx64"\n", max_lba);
+
+fail:
+	pr_debug("%s: Exiting with error code 0x%X\n", __func__, error);
+	return error;
+}
+
 /**
  * @brief Do I/O using CBW/CSW
  *
@@ -1409,53 +1407,92 @@ static tegrabl_error_t tegrabl_usbmsd_io(struct tegrabl_usbmsd_context *context,
 	 * if SCSI op, length is number bytes in response data (INQUIRY, etc.)
 	 */
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
-	uint8_t csw_status, data_dir, comp_code = 0;
-	struct xusb_host_context *host_ctx = NULL;
+	struct tegrabl_usbh_bulk_xfer xfers[3];
+	struct tegrabl_usbh_bulk_xfer *cbw_xfer, *data_xfer, *csw_xfer;
+	usb_msd_cbw_t cbw;
+	usb_msd_csw_t csw;
+	uint32_t num_xfers = 0;
+	uint8_t csw_status = 0;
 
 	TEGRABL_ASSERT(context != NULL);
 	TEGRABL_ASSERT(buf != NULL);
 	pr_debug("%s: Entry, buf = %p\n", __func__, buf);
 
 	context->xfer_info.buf = buf;
-	if (context->xfer_info.is_write)
-		data_dir = HOST2DEV;
-	else
-		data_dir = DEV2HOST;
 
-	pr_debug("Calling Send_CBW ...\n");
-	error = usbmsd_send_cbw(context, length);
+	error = usbmsd_setup_cbw(context, length, &cbw);
 	if (error != TEGRABL_NO_ERROR)
 		goto fail;
 
-	pr_debug("%sING\n", data_dir ? "READ" : "WRIT");
+	pr_debug("%sING\n", context->xfer_info.is_write ? "WRIT" : "READ");
 	pr_debug("  %u bytes\n", length);
 
-	/* TBD: Check for short data xfer here? (pass &xfer_length) */
-	pr_debug("Calling Transfer_Data, buffer @ %p ...\n",
-		 context->xfer_info.buf);
-	error = usbmsd_transfer_data(context, length);
-	if (error != TEGRABL_NO_ERROR) {
-		pr_warn("DATA TRANSFER FAILED, INCREMENT TAG!?\n");
+	/*
+	 * Queue CBW, data and CSW back to back, the controller starts each
+	 * phase as soon as the device is ready for it. A short data phase
+	 * ends its own TD only, the CSW still lands in the CSW buffer.
+	 */
+	cbw_xfer = &xfers[num_xfers++];
+	cbw_xfer->buffer = &cbw;
+	cbw_xfer->length = CBW_SIZE;
+	cbw_xfer->is_in = false;
+
+	data_xfer = NULL;
+	if (length != 0U) {
+		data_xfer = &xfers[num_xfers++];
+		data_xfer->buffer = buf;
+		data_xfer->length = length;
+		data_xfer->is_in = !context->xfer_info.is_write;
+	}
+
+	memset(&csw, 0, CSW_SIZE);
+	csw_xfer = &xfers[num_xfers++];
+	csw_xfer->buffer = &csw;
+	csw_xfer->length = CSW_SIZE;
+	csw_xfer->is_in = true;
+
+	error = tegrabl_usbh_bulk_xfer_list(xfers, num_xfers);
+	pr_debug("%s: bulk transfers returned 0x%X\n", __func__, error);
+
+	/* check xfer_length, s/b == CBW_SIZE, 31 bytes */
+	if ((cbw_xfer->comp_code != COMP_SUCCESS) ||
+		(cbw_xfer->actual_length != CBW_SIZE)) {
+		pr_error("Warning: Transferred %d CBW bytes, should be %d!\n",
+			 cbw_xfer->actual_length, CBW_SIZE);
+		error = TEGRABL_ERROR(TEGRABL_ERR_SEND_FAILED,
+				      TEGRABL_USBMSD_START_COMMAND_2);
+		goto fail;
 	}
 
 	/* Handle DATA STALL here */
-	host_ctx = tegrabl_get_usbh_context();	/* Current host context */
-	if (host_ctx != NULL)
-		comp_code = host_ctx->comp_code;
-	if (comp_code != COMP_SUCCESS) {
-		pr_debug("%s: Host driver returned COMP CODE 0x%02X\n",
-			 __func__, comp_code);
-		if (comp_code == COMP_STALL_ERROR) {
-			if (data_dir == DEV2HOST)
+	if (data_xfer != NULL) {
+		pr_debug("transferred data length = %u bytes\n",
+			 data_xfer->actual_length);
+#ifdef	USB_DEBUG
+		dump_buf(buf, MIN(length, 1024U));	/* 1st 2 sectors */
+#endif
+		if ((data_xfer->comp_code != COMP_SUCCESS) &&
+		    (data_xfer->comp_code != COMP_SHORT_PACKET)) {
+			pr_warn("DATA TRANSFER FAILED (COMP CODE 0x%02X)\n",
+				data_xfer->comp_code);
+		}
+		if (data_xfer->comp_code == COMP_STALL_ERROR) {
+			if (data_xfer->is_in)
 				clear_endpoint_stall(context, context->in_ep);
 			else
 				clear_endpoint_stall(context, context->out_ep);
 		}
-		/* TBD: Handle any other bad completion codes here? */
 	}
 
-	pr_debug("Calling Get_CSW ...\n");
-	error = usbmsd_get_csw(context, &csw_status);
+	/* The queued CSW is lost if the data phase stalled its endpoint */
+	if ((csw_xfer->comp_code == COMP_SUCCESS) ||
+	    (csw_xfer->comp_code == COMP_SHORT_PACKET)) {
+		error = usbmsd_check_csw(context, &csw,
+					 csw_xfer->actual_length, &csw_status);
+	} else {
+		pr_debug("Calling Get_CSW ...\n");
+		error = usbmsd_get_csw(context, &csw_status);
+	}
 	pr_debug("%s: CSW status = 0x%02X, tegrabl error = 0x%X\n", __func__,
 		 csw_status, error);
 
@@ -18,7 +18,17 @@
 
 #define USBMSD_BUFFER_ALIGNMENT		(4096)
 #define TEGRABL_USB_BUF_ALIGN_SIZE	8
-#define USBMSD_MAX_READ_WRITE_SECTORS	128 /* TODO: This is a WAR for usb read/write to work */
+/* Sectors moved by a single CBW. xHCI driver splits the data phase into
+ * 64KB TRBs chained in one TD, so this is bounded only by the TR size.
+ */
+#if defined(CONFIG_USBMSD_MAX_XFER_SECTORS)
+#define USBMSD_MAX_READ_WRITE_SECTORS	CONFIG_USBMSD_MAX_XFER_SECTORS
+#else
+#define USBMSD_MAX_READ_WRITE_SECTORS	8192 /* 4MB */
+#endif
+
+/* Largest count which fits in a READ(10)/WRITE(10) CDB */
+#define USBMSD_MAX_RW10_SECTORS		0xFFFFU
 
 #define TEGRABL_USBMSD_WRITE_TIMEOUT		1000000	/* usec */
 #define TEGRABL_USBMSD_READ_TIMEOUT		1000000	/* usec */
@@ -187,4 +197,7 @@ tegrabl_error_t tegrabl_usbmsd_test_unit_ready(
 tegrabl_error_t tegrabl_usbmsd_read_capacity(
 					struct tegrabl_usbmsd_context *context);
 
+tegrabl_error_t tegrabl_usbmsd_read_capacity_16(
+					struct tegrabl_usbmsd_context *context);
+
 #endif	/* TEGRABL_USB_MSD_H */
@@ -31,5 +31,11 @@
 #define READ_12			0xA8
 #define WRITE_12		0xAA
 #define VERIFY_12		0xAF
+#define READ_16			0x88
+#define WRITE_16		0x8A
+#define SERVICE_ACTION_IN_16	0x9E
+
+/* SERVICE ACTION IN(16) service actions */
+#define SAI_READ_CAPACITY_16	0x10
 
 #endif	/* TEGRABL_USBMSD_SCSI_H */
@@ -37,6 +37,10 @@
 #endif
 
 #define MAX_TFR_LENGTH	 (64U * 1024U)
+/* Large buffers move as several queued requests so the controller always
+ * has the next one while the previous completes */
+#define USBF_REQ_LENGTH	 (1024U * 1024U)
+#define USBF_REQS_IN_FLIGHT 3U
 #define MAX_TCM_BUFFER_SUPPORTED 1024U
 
 #define MAX_SERIALNO_LEN 32
@@ -461,6 +465,77 @@ static bool is_buffer_from_tcm(const void *buf)
 		return false;
 }
 
+struct usbf_queued_xfer {
+	uint32_t bytes_done;
+	uint32_t completed;
+	tegrabl_error_t error;
+};
+
+static void transport_usbf_xfer_cb(void *priv, uint8_t *buffer, uint32_t bytes,
+								   tegrabl_error_t status)
+{
+	struct usbf_queued_xfer *xfer = (struct usbf_queued_xfer *)priv;
+
+	TEGRABL_UNUSED(buffer);
+	xfer->bytes_done += bytes;
+	xfer->completed++;
+	if ((status != TEGRABL_NO_ERROR) && (xfer->error == TEGRABL_NO_ERROR)) {
+		xfer->error = status;
+	}
+}
+
+/* Moves length bytes straight from/to buf keeping USBF_REQS_IN_FLIGHT
+ * requests queued. The host is expected to move exactly length bytes. */
+static tegrabl_error_t transport_usbf_queued_xfer(uint8_t *buf, uint32_t length,
+												  bool is_transmit, uint32_t *bytes_done)
+{
+	struct usbf_queued_xfer xfer = { 0, 0, TEGRABL_NO_ERROR };
+	tegrabl_error_t retval = TEGRABL_NO_ERROR;
+	uint32_t queued = 0;
+	uint32_t offset = 0;
+	uint32_t tfr_length;
+
+	while ((offset < length) || (xfer.completed < queued)) {
+		while ((offset < length) && ((queued - xfer.completed) < USBF_REQS_IN_FLIGHT) &&
+			   (xfer.error == TEGRABL_NO_ERROR)) {
+			tfr_length = MIN(length - offset, USBF_REQ_LENGTH);
+			if (is_transmit) {
+				retval = tegrabl_usbf_queue_transmit(buf + offset, tfr_length,
+													 transport_usbf_xfer_cb, &xfer);
+			} else {
+				retval = tegrabl_usbf_queue_receive(buf + offset, tfr_length,
+													transport_usbf_xfer_cb, &xfer);
+			}
+			if (retval != TEGRABL_NO_ERROR) {
+				goto fail;
+			}
+			offset += tfr_length;
+			queued++;
+		}
+
+		if (xfer.completed == queued) {
+			break;
+		}
+		retval = tegrabl_usbf_process_events(0xFFFFFFFFUL);
+		if (retval != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+	}
+
+	retval = xfer.error;
+	if ((retval == TEGRABL_NO_ERROR) && (offset != length)) {
+		retval = TEGRABL_ERROR(TEGRABL_ERR_XFER_FAILED, 2);
+	}
+
+fail:
+	/* Requests still on the ring point at xfer, drop them before it goes */
+	if (xfer.completed != queued) {
+		(void)tegrabl_usbf_queue_cancel(is_transmit);
+	}
+	*bytes_done = xfer.bytes_done;
+	return retval;
+}
+
 tegrabl_error_t tegrabl_transport_usbf_send(const void *buffer,
 											uint32_t length,
 											uint32_t *bytes_transmitted,
@@ -486,6 +561,12 @@ tegrabl_error_t tegrabl_transport_usbf_send(const void *buffer,
 							   "ERROR: Passed TCM buffer greater than 1K\n");
 			return TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, 0);
 		}
+	} else {
+		retval = transport_usbf_queued_xfer(buf, length, true, bytes_transmitted);
+		if (retval != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+		return TEGRABL_NO_ERROR;
 	}
 
 	while (length != 0U) {
@@ -534,6 +615,12 @@ tegrabl_error_t tegrabl_transport_usbf_receive(void *buf, uint32_t length,
 							   "ERROR: Passed TCM buffer greater than 1K\n");
 			return TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, 1);
 		}
+	} else {
+		retval = transport_usbf_queued_xfer((uint8_t *)buf, length, false, received);
+		if (retval != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+		return TEGRABL_NO_ERROR;
 	}
 
 	while (length != 0U) {
@@ -12,6 +12,7 @@
 #define __TEGRABL_XUSB_PRIV_H
 
 #include <stdint.h>
+#include <tegrabl_usbf.h>
 
 /* Desc macros */
 #define USB_DEV_DESCRIPTOR_SIZE 18
@@ -153,6 +154,33 @@ typedef uint32_t device_state_t;
 #define CONFIGURED 7U
 #define SUSPENDED 8U
 
+/* Max bulk requests queued per endpoint with tegrabl_usbf_queue_*() */
+#define XUSBF_MAX_QUEUED_REQ 8U
+
+/**
+ * @brief Bulk request queued on EP1_OUT/EP1_IN, spans first_trb..last_trb
+ */
+struct xusbf_request {
+	uint8_t *buffer;
+	uint32_t bytes;
+	struct data_trb *first_trb;
+	struct data_trb *last_trb;
+	uint32_t num_trbs;
+	tegrabl_usbf_xfer_cb_t cb;
+	void *priv;
+};
+
+/**
+ * @brief Requests of one bulk endpoint, completed in order from head
+ */
+struct xusbf_req_queue {
+	struct xusbf_request req[XUSBF_MAX_QUEUED_REQ];
+	uint32_t head;
+	uint32_t count;
+	uint32_t trbs; /* ring TRBs owned by queued requests */
+	dma_addr_t dma_ring_start;
+};
+
 /**
  * @brief USB function interface structure
  */
@@ -186,6 +214,8 @@ struct xusb_device_context {
 	uint32_t interface_num;
 	uint32_t wait_for_eventt;
 	uint32_t port_speed;
+	struct xusbf_req_queue bulkout_queue;
+	struct xusbf_req_queue bulkin_queue;
 };
 
 /**
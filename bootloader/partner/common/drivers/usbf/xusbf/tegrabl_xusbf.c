@@ -58,6 +58,9 @@
  */
 #define NUM_TRB_EVENT_RING 32U
 #define NUM_TRB_TRANSFER_RING 16U
+/* Bulk rings hold several queued multi-MB requests, one TRB per 64KB */
+#define NUM_TRB_BULK_RING 128U
+#define MAX_TRB_LENGTH (64U * 1024U)
 #define NUM_EP_CONTEXT  4
 
 /* 512 bytes. */
@@ -85,9 +88,9 @@ static uint8_t *usb_setup_data;
 #define TX_RING_EP0_START   (EVENT_RING_START+EVENT_RING_SIZE)
 #define TX_RING_EP0_SIZE    (NUM_TRB_TRANSFER_RING * sizeof(struct data_trb))
 #define TX_RING_EP1_OUT_START (TX_RING_EP0_START+TX_RING_EP0_SIZE)
-#define TX_RING_EP1_OUT_SIZE  (NUM_TRB_TRANSFER_RING * sizeof(struct data_trb))
+#define TX_RING_EP1_OUT_SIZE  (NUM_TRB_BULK_RING * sizeof(struct data_trb))
 #define TX_RING_EP1_IN_START   (TX_RING_EP1_OUT_START+TX_RING_EP1_OUT_SIZE)
-#define TX_RING_EP1_IN_SIZE    (NUM_TRB_TRANSFER_RING * sizeof(struct data_trb))
+#define TX_RING_EP1_IN_SIZE    (NUM_TRB_BULK_RING * sizeof(struct data_trb))
 #define EP_CONTEXT_START    (TX_RING_EP1_IN_START+TX_RING_EP1_IN_SIZE)
 #define EP_CONTEXT_SIZE     (NUM_EP_CONTEXT*sizeof(struct ep_context))
 #define SETUP_DATA_BUFFER_START     (EP_CONTEXT_START+EP_CONTEXT_SIZE)
@@ -124,8 +127,8 @@ static struct ep_context *p_ep_context;
 
 #define EVENT_RING_SIZE     (NUM_TRB_EVENT_RING * sizeof(struct event_trb))
 #define TX_RING_EP0_SIZE    (NUM_TRB_TRANSFER_RING * sizeof(struct data_trb))
-#define TX_RING_EP1_OUT_SIZE  (NUM_TRB_TRANSFER_RING * sizeof(struct data_trb))
-#define TX_RING_EP1_IN_SIZE    (NUM_TRB_TRANSFER_RING * sizeof(struct data_trb))
+#define TX_RING_EP1_OUT_SIZE  (NUM_TRB_BULK_RING * sizeof(struct data_trb))
+#define TX_RING_EP1_IN_SIZE    (NUM_TRB_BULK_RING * sizeof(struct data_trb))
 #define EP_CONTEXT_SIZE     (NUM_EP_CONTEXT*sizeof(struct ep_context))
 #define SETUP_DATA_BUFFER_SIZE     (0x200)
 #define XUSB_BUFFERS_SIZE (EVENT_RING_SIZE + TX_RING_EP0_SIZE + TX_RING_EP1_OUT_SIZE + TX_RING_EP1_IN_SIZE + \
@@ -290,10 +293,10 @@ static tegrabl_error_t tegrabl_init_transfer_ring(uint8_t ep_index)
 			   NUM_TRB_TRANSFER_RING * sizeof(struct event_trb));
 	} else if (ep_index == EP1_IN) {
 		memset((void *)&p_txringep1in[0], 0,
-			   NUM_TRB_TRANSFER_RING * sizeof(struct event_trb));
+			   NUM_TRB_BULK_RING * sizeof(struct event_trb));
 	} else if (ep_index == EP1_OUT) {
 		memset((void *)&p_txringep1out[0], 0,
-			   NUM_TRB_TRANSFER_RING * sizeof(struct event_trb));
+			   NUM_TRB_BULK_RING * sizeof(struct event_trb));
 	} else {
 		e = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, AUX_INFO_INIT_TRANSFER_RING);
 		TEGRABL_SET_CRITICAL_STRING(e, "endpoint %u", ep_index);
@@ -491,6 +494,23 @@ static tegrabl_error_t tegrabl_issue_status_trb(uint32_t direction)
 	return e;
 }
 
+static void tegrabl_flush_bulk_queue(struct xusbf_req_queue *queue)
+{
+	struct xusbf_request *req;
+
+	while (queue->count != 0U) {
+		req = &queue->req[queue->head];
+		queue->head = (queue->head + 1U) % XUSBF_MAX_QUEUED_REQ;
+		queue->count--;
+		if (req->cb != NULL) {
+			req->cb(req->priv, req->buffer, 0,
+					TEGRABL_ERROR(TEGRABL_ERR_RESET_FAILED, AUX_INFO_COMPLETE_BULK_REQ));
+		}
+	}
+	queue->head = 0;
+	queue->trbs = 0;
+}
+
 static tegrabl_error_t tegrabl_init_epcontext(uint8_t ep_index)
 {
 	struct ep_context *ep_info;
@@ -625,9 +645,13 @@ static tegrabl_error_t tegrabl_init_epcontext(uint8_t ep_index)
 			ep_info->trd_dequeueptr_lo = (U64_TO_U32_LO(dma_buf) >> 4);
 			ep_info->trd_dequeueptr_hi = U64_TO_U32_HI(dma_buf);
 
+			/* Requests queued before the ring reset are lost */
+			tegrabl_flush_bulk_queue(&p_xusb_dev_context->bulkout_queue);
+			p_xusb_dev_context->bulkout_queue.dma_ring_start = dma_buf;
+
 			/* Setup Link TRB. Last TRB of ring. */
 			p_link_trb = (struct link_trb *)
-						&p_txringep1out[NUM_TRB_TRANSFER_RING - 1U];
+						&p_txringep1out[NUM_TRB_BULK_RING - 1U];
 			p_link_trb->tc = 1;
 			p_link_trb->ring_seg_ptrlo = (U64_TO_U32_LO(dma_buf) >> 4);
 
@@ -669,6 +693,9 @@ static tegrabl_error_t tegrabl_init_epcontext(uint8_t ep_index)
 			ep_info->trd_dequeueptr_lo = (U64_TO_U32_LO(dma_buf) >> 4);
 			ep_info->trd_dequeueptr_hi = U64_TO_U32_HI(dma_buf);
 
+			tegrabl_flush_bulk_queue(&p_xusb_dev_context->bulkin_queue);
+			p_xusb_dev_context->bulkin_queue.dma_ring_start = dma_buf;
+
 #if defined(CONFIG_ENABLE_XUSBF_SS)
 			if (p_xusb_dev_context->port_speed == XUSB_SUPER_SPEED) {
 				ep_info->avg_trb_len = 1024;
@@ -684,7 +711,7 @@ static tegrabl_error_t tegrabl_init_epcontext(uint8_t ep_index)
 			}
 			/* Setup Link TRB. Last TRB of ring. */
 			p_link_trb = (struct link_trb *)
-						&p_txringep1in[NUM_TRB_TRANSFER_RING-1U];
+						&p_txringep1in[NUM_TRB_BULK_RING - 1U];
 			p_link_trb->tc = 1;
 
 			p_link_trb->ring_seg_ptrlo = (U64_TO_U32_LO(dma_buf) >> 4);
@@ -1599,6 +1626,99 @@ static tegrabl_error_t tegrabl_handle_port_status(void)
 	return e;
 }
 
+static struct data_trb *tegrabl_next_bulk_trb(struct data_trb *ring,
+		struct data_trb *p_trb)
+{
+	p_trb++;
+	if (p_trb->trb_type == LINK_TRB) {
+		p_trb = &ring[0];
+	}
+	return p_trb;
+}
+
+/* Retire the oldest queued request of a bulk endpoint on its event */
+static tegrabl_error_t tegrabl_complete_bulk_req(
+		struct transfer_event_trb *p_tx_eventrb)
+{
+	struct xusb_device_context *p_xusb_dev_context = &s_xusb_device_context;
+	struct xusbf_req_queue *queue;
+	struct xusbf_request *req;
+	struct data_trb *ring;
+	struct data_trb *p_trb;
+	struct data_trb *p_event_trb;
+	uintptr_t *p_dequeue;
+	dma_addr_t trb_dma;
+	uint32_t trb_index;
+	uint32_t bytes = 0;
+	tegrabl_error_t e = TEGRABL_NO_ERROR;
+
+	if (p_tx_eventrb->emp_id == EP1_OUT) {
+		queue = &p_xusb_dev_context->bulkout_queue;
+		ring = p_txringep1out;
+		p_dequeue = &p_xusb_dev_context->bulkout_epdequeue_ptr;
+	} else {
+		queue = &p_xusb_dev_context->bulkin_queue;
+		ring = p_txringep1in;
+		p_dequeue = &p_xusb_dev_context->bulkin_epdequeue_ptr;
+	}
+	if (queue->count == 0U) {
+		/* Trailing event of a request already retired on a short packet */
+		return TEGRABL_NO_ERROR;
+	}
+	req = &queue->req[queue->head];
+
+	trb_dma = U64_FROM_U32(p_tx_eventrb->trb_pointer_lo, p_tx_eventrb->trb_pointer_hi);
+	trb_index = (uint32_t)((trb_dma - queue->dma_ring_start) / sizeof(struct data_trb));
+	if ((trb_dma < queue->dma_ring_start) || (trb_index >= NUM_TRB_BULK_RING)) {
+		e = TEGRABL_ERROR(TEGRABL_ERR_BAD_ADDRESS, AUX_INFO_COMPLETE_BULK_REQ);
+		TEGRABL_SET_CRITICAL_STRING(e, "trb 0x%08x", U64_TO_U32_LO(trb_dma));
+		return e;
+	}
+	p_event_trb = &ring[trb_index];
+
+	/* Bytes of the TRBs before the one that raised the event */
+	p_trb = req->first_trb;
+	while ((p_trb != p_event_trb) && (p_trb != req->last_trb)) {
+		bytes += p_trb->trb_tx_len;
+		p_trb = tegrabl_next_bulk_trb(ring, p_trb);
+	}
+	if (p_trb != p_event_trb) {
+		/* Trailing event of a request already retired on a short packet */
+		return TEGRABL_NO_ERROR;
+	}
+	bytes += p_trb->trb_tx_len - MIN(p_tx_eventrb->trb_tx_len, p_trb->trb_tx_len);
+
+	if ((p_tx_eventrb->comp_code == SUCCESS_ERR_CODE) ||
+		(p_tx_eventrb->comp_code == SHORT_PKT_ERR_CODE)) {
+		/* For IN, we should not have remaining bytes. Flag error */
+		if ((p_tx_eventrb->emp_id == EP1_IN) && (bytes != req->bytes)) {
+			e = TEGRABL_ERROR(TEGRABL_ERR_TOO_LARGE, AUX_INFO_COMPLETE_BULK_REQ);
+		}
+	} else {
+		e = TEGRABL_ERROR(TEGRABL_ERR_XFER_FAILED, AUX_INFO_COMPLETE_BULK_REQ);
+		TEGRABL_SET_CRITICAL_STRING(e, "comp_code:0x%08x", p_tx_eventrb->comp_code);
+	}
+
+	/* Controller moves on to the TRB after the request either way */
+	*p_dequeue = (uintptr_t)tegrabl_next_bulk_trb(ring, req->last_trb);
+	queue->trbs -= req->num_trbs;
+	queue->head = (queue->head + 1U) % XUSBF_MAX_QUEUED_REQ;
+	queue->count--;
+
+	if (p_tx_eventrb->emp_id == EP1_OUT) {
+		tegrabl_dma_unmap_buffer(TEGRABL_MODULE_XUSBF, 0,
+				(void *)req->buffer, req->bytes, TEGRABL_DMA_FROM_DEVICE);
+	} else {
+		tegrabl_dma_unmap_buffer(TEGRABL_MODULE_XUSBF, 0,
+				(void *)req->buffer, req->bytes, TEGRABL_DMA_TO_DEVICE);
+	}
+	if (req->cb != NULL) {
+		req->cb(req->priv, req->buffer, bytes, e);
+	}
+
+	return e;
+}
+
 static tegrabl_error_t tegrabl_handle_txfer_event(
 		struct transfer_event_trb *p_tx_eventrb)
 {
@@ -1610,6 +1730,12 @@ static tegrabl_error_t tegrabl_handle_txfer_event(
 
 	TEGRABL_UNUSED(p_link_trb);
 
+	/* Bulk events belong to queued requests unless a single TRB is pending */
+	if (((p_tx_eventrb->emp_id == EP1_OUT) || (p_tx_eventrb->emp_id == EP1_IN)) &&
+		(p_xusb_dev_context->tx_count == 0U)) {
+		return tegrabl_complete_bulk_req(p_tx_eventrb);
+	}
+
 	/* Make sure update local copy for dequeue ptr */
 	if (p_tx_eventrb->emp_id == EP0_IN) {
 		p_xusb_dev_context->cntrl_epdequeue_ptr +=
@@ -1893,6 +2019,11 @@ static tegrabl_error_t tegrabl_issue_normal_trb(dma_addr_t buffer,
 	struct xusb_device_context *p_xusb_dev_context = &s_xusb_device_context;
 	uint8_t ep_index;
 
+	if ((p_xusb_dev_context->bulkout_queue.count != 0U) ||
+		(p_xusb_dev_context->bulkin_queue.count != 0U)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_BUSY, AUX_INFO_USBF_QUEUE_XFER);
+	}
+
 	memset((void *)&normal_trb, 0, sizeof(struct normal_trb));
 	e = tegrabl_create_normal_trb(&normal_trb, buffer, bytes, direction);
 	if (e != TEGRABL_NO_ERROR) {
@@ -2255,6 +2386,157 @@ tegrabl_error_t tegrabl_usbf_transmit_complete(uint32_t *p_bytes_transferred,
 	return e;
 }
 
+/* Drops every request queued on a bulk endpoint, completing them with an
+ * error, and restarts the endpoint on an empty ring */
+static tegrabl_error_t tegrabl_usbf_cancel_bulk(uint8_t ep_index)
+{
+	struct xusb_device_context *p_xusb_dev_context = &s_xusb_device_context;
+	struct xusbf_req_queue *queue;
+	uint32_t mask = 1UL << ep_index;
+	uint32_t reg_data;
+	tegrabl_error_t e;
+
+	queue = (ep_index == EP1_IN) ? &p_xusb_dev_context->bulkin_queue :
+								   &p_xusb_dev_context->bulkout_queue;
+	if (queue->count == 0U) {
+		return TEGRABL_NO_ERROR;
+	}
+
+	/* Stop the endpoint before its ring is reset under it */
+	reg_data = NV_READ32(XUSB_BASE + XUSB_DEV_XHCI_EP_PAUSE_0);
+	NV_WRITE32(XUSB_BASE + XUSB_DEV_XHCI_EP_PAUSE_0, reg_data | mask);
+	e = tegrabl_poll_field(XUSB_BASE + XUSB_DEV_XHCI_EP_STCHG_0, mask, mask, 1000);
+	if (e != TEGRABL_NO_ERROR) {
+		pr_warn("Bulk endpoint %u did not pause\n", ep_index);
+	}
+	NV_WRITE32(XUSB_BASE + XUSB_DEV_XHCI_EP_STCHG_0, mask);
+
+	/* Flushes the queue and reloads the context with an empty ring */
+	e = tegrabl_initep(ep_index, false);
+	if (e != TEGRABL_NO_ERROR) {
+		pr_error("Failed to restart bulk endpoint %u\n", ep_index);
+	}
+
+	return e;
+}
+
+static tegrabl_error_t tegrabl_usbf_queue_xfer(uint8_t ep_index, uint8_t *buffer,
+		uint32_t bytes, tegrabl_usbf_xfer_cb_t cb, void *priv)
+{
+	struct xusb_device_context *p_xusb_dev_context = &s_xusb_device_context;
+	struct xusbf_req_queue *queue;
+	struct xusbf_request *req;
+	struct normal_trb normal_trb;
+	uintptr_t *p_enqueue;
+	dma_addr_t dma_buf;
+	uint32_t direction;
+	uint32_t max_packet_size;
+	uint32_t num_trbs;
+	uint32_t remaining;
+	uint32_t len;
+	tegrabl_error_t e = TEGRABL_NO_ERROR;
+
+	if ((buffer == NULL) || (bytes == 0U)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, AUX_INFO_USBF_QUEUE_XFER);
+	}
+
+	/* Queued requests and the single TRB API share the ring */
+	if (p_xusb_dev_context->tx_count != 0U) {
+		return TEGRABL_ERROR(TEGRABL_ERR_BUSY, AUX_INFO_USBF_QUEUE_XFER);
+	}
+
+	if (ep_index == EP1_IN) {
+		queue = &p_xusb_dev_context->bulkin_queue;
+		p_enqueue = &p_xusb_dev_context->bulkin_epenqueue_ptr;
+		direction = DIR_IN;
+	} else {
+		queue = &p_xusb_dev_context->bulkout_queue;
+		p_enqueue = &p_xusb_dev_context->bulkout_epenqueue_ptr;
+		direction = DIR_OUT;
+	}
+
+	/* A TRB buffer must not cross a 64KB boundary, so worst case one extra */
+	num_trbs = DIV_CEIL(bytes, MAX_TRB_LENGTH) + 1U;
+	if ((queue->count == XUSBF_MAX_QUEUED_REQ) ||
+		((queue->trbs + num_trbs) > (NUM_TRB_BULK_RING - 1U))) {
+		return TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, AUX_INFO_USBF_QUEUE_XFER);
+	}
+
+	if (p_xusb_dev_context->port_speed == XUSB_SUPER_SPEED) {
+		max_packet_size = 1024;
+	} else if (p_xusb_dev_context->port_speed == XUSB_HIGH_SPEED) {
+		max_packet_size = 512;
+	} else {
+		max_packet_size = 64;
+	}
+
+	dma_buf = tegrabl_dma_map_buffer(TEGRABL_MODULE_XUSBF, 0, (void *)buffer, bytes,
+			(direction == DIR_IN) ? TEGRABL_DMA_TO_DEVICE : TEGRABL_DMA_FROM_DEVICE);
+
+	req = &queue->req[(queue->head + queue->count) % XUSBF_MAX_QUEUED_REQ];
+	req->buffer = buffer;
+	req->bytes = bytes;
+	req->cb = cb;
+	req->priv = priv;
+	req->num_trbs = 0;
+	req->first_trb = (struct data_trb *)*p_enqueue;
+
+	remaining = bytes;
+	while (remaining != 0U) {
+		len = MAX_TRB_LENGTH - (uint32_t)(dma_buf & (MAX_TRB_LENGTH - 1U));
+		len = MIN(len, remaining);
+		remaining -= len;
+
+		memset((void *)&normal_trb, 0, sizeof(struct normal_trb));
+		(void)tegrabl_create_normal_trb(&normal_trb, dma_buf, len, direction);
+		/* Chain the TD and only interrupt on its last TRB (or a short packet) */
+		normal_trb.ch = (remaining != 0U) ? 1U : 0U;
+		normal_trb.ioc = (remaining != 0U) ? 0U : 1U;
+		normal_trb.tdsize = MIN(DIV_CEIL(remaining, max_packet_size), 31U);
+
+		req->last_trb = (struct data_trb *)*p_enqueue;
+		e = tegrabl_queue_trb(ep_index, &normal_trb, (remaining == 0U) ? 1U : 0U);
+		if (e != TEGRABL_NO_ERROR) {
+			/* The TRBs already on the ring can only go with the whole ring,
+			 * this request is not reported as it was never queued */
+			req->cb = NULL;
+			queue->trbs += req->num_trbs;
+			queue->count++;
+			(void)tegrabl_usbf_cancel_bulk(ep_index);
+			return e;
+		}
+		req->num_trbs++;
+		dma_buf += len;
+	}
+
+	queue->trbs += req->num_trbs;
+	queue->count++;
+
+	return e;
+}
+
+tegrabl_error_t tegrabl_usbf_queue_receive(uint8_t *buffer, uint32_t bytes,
+		tegrabl_usbf_xfer_cb_t cb, void *priv)
+{
+	return tegrabl_usbf_queue_xfer(EP1_OUT, buffer, bytes, cb, priv);
+}
+
+tegrabl_error_t tegrabl_usbf_queue_transmit(uint8_t *buffer, uint32_t bytes,
+		tegrabl_usbf_xfer_cb_t cb, void *priv)
+{
+	return tegrabl_usbf_queue_xfer(EP1_IN, buffer, bytes, cb, priv);
+}
+
+tegrabl_error_t tegrabl_usbf_queue_cancel(bool is_transmit)
+{
+	return tegrabl_usbf_cancel_bulk(is_transmit ? EP1_IN : EP1_OUT);
+}
+
+tegrabl_error_t tegrabl_usbf_process_events(uint32_t timeout_us)
+{
+	return tegrabl_poll_for_event(timeout_us);
+}
+
 static tegrabl_error_t tegrabl_usbf_setup_static_params_pad(void)
 {
 	uint32_t reg_data;
@@ -2657,8 +2939,11 @@ static tegrabl_error_t tegrabl_usbf_priv_init(bool reinit)
 #if !defined(CONFIG_ENABLE_XUSBF_UNCACHED_STRUCT)
 	p_event_ring = (struct event_trb*) tegrabl_alloc_align(TEGRABL_HEAP_DMA, 16, EVENT_RING_SIZE);
 	p_txringep0 = (struct data_trb*) tegrabl_alloc_align(TEGRABL_HEAP_DMA, 16, TX_RING_EP0_SIZE);
-	p_txringep1out = (struct data_trb*) tegrabl_alloc_align(TEGRABL_HEAP_DMA, 16, TX_RING_EP1_OUT_SIZE);
-	p_txringep1in = (struct data_trb*) tegrabl_alloc_align(TEGRABL_HEAP_DMA, 16, TX_RING_EP1_IN_SIZE);
+	/* size alignment keeps the bulk rings from crossing a 64KB boundary */
+	p_txringep1out = (struct data_trb*) tegrabl_alloc_align(TEGRABL_HEAP_DMA, TX_RING_EP1_OUT_SIZE,
+															TX_RING_EP1_OUT_SIZE);
+	p_txringep1in = (struct data_trb*) tegrabl_alloc_align(TEGRABL_HEAP_DMA, TX_RING_EP1_IN_SIZE,
+														   TX_RING_EP1_IN_SIZE);
 	p_setup_buffer = (uint8_t*)tegrabl_alloc_align(TEGRABL_HEAP_DMA, 16, SETUP_DATA_BUFFER_SIZE);
 	p_ep_context = (struct ep_context *) tegrabl_alloc_align(TEGRABL_HEAP_DMA, 64, EP_CONTEXT_SIZE);
 	if ((p_event_ring == NULL) || (p_txringep0 == NULL) || (p_txringep1out == NULL) ||
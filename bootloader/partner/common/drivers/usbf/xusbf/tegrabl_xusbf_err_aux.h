@@ -35,6 +35,8 @@
 #define AUX_INFO_USBF_TRANSMIT_START_2			0x14U
 #define AUX_INFO_USBF_REGULATOR_INIT_1			0x15U
 #define AUX_INFO_USBF_REGULATOR_INIT_2			0x16U
+#define AUX_INFO_USBF_QUEUE_XFER			0x17U
+#define AUX_INFO_COMPLETE_BULK_REQ			0x18U
 
 #endif
 
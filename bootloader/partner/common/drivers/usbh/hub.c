@@ -22,6 +22,10 @@
 
 #define HUB_DEVICE_DETECT_TIMEOUT_MS		500
 #define HUB_PORT_RESET_TIMEOUT_MS			200
+/* Port status poll interval, and how long detection keeps looking for more
+ * devices after the last one showed up */
+#define HUB_PORT_POLL_INTERVAL_MS			10
+#define HUB_DEVICE_SETTLE_MS				100
 
 static tegrabl_error_t send_dev_req(struct xusb_host_context *ctx, uint8_t req_type, uint8_t req,
 									uint16_t val, uint16_t index, uint16_t len)
@@ -151,6 +155,7 @@ tegrabl_error_t hub_detect_device(struct xusb_host_context *ctx, uint32_t *port_
 	uint32_t port_dev_bmap = 0;
 	time_t elapsed_time_ms;
 	time_t start_time_ms;
+	time_t last_detect_ms = 0;
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
 
 	if (port_device_bitmap == NULL) {
@@ -177,9 +182,15 @@ tegrabl_error_t hub_detect_device(struct xusb_host_context *ctx, uint32_t *port_
 			if ((port_status & HUB_PORT_CONN_MASK) && (port_status_change & HUB_PORT_CONN_CHANGE_MASK)) {
 				pr_info("Device detected on port %u\n", port_no);
 				port_dev_bmap = port_dev_bmap | (0x1 << port_no);
+				last_detect_ms = elapsed_time_ms;
 			}
 		}
-		tegrabl_mdelay(100);
+		/* Ports that connect together do so within a short window, stop
+		 * once it has passed instead of running out the full timeout */
+		if ((port_dev_bmap != 0) && ((elapsed_time_ms - last_detect_ms) >= HUB_DEVICE_SETTLE_MS)) {
+			break;
+		}
+		tegrabl_mdelay(HUB_PORT_POLL_INTERVAL_MS);
 		elapsed_time_ms = tegrabl_get_timestamp_ms() - start_time_ms;
 		pr_trace("elapsed time: %lu\n\n", elapsed_time_ms);
 	}
@@ -247,7 +258,7 @@ tegrabl_error_t hub_reset_port(struct xusb_host_context *ctx, uint32_t port_no,
 			/* Port reset completed */
 			break;
 		}
-		tegrabl_mdelay(50);
+		tegrabl_mdelay(HUB_PORT_POLL_INTERVAL_MS);
 		elapsed_time_ms = tegrabl_get_timestamp_ms() - start_time_ms;
 		pr_trace("elapsed time: %lu\n", elapsed_time_ms);
 	}
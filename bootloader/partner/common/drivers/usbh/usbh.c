@@ -30,11 +30,23 @@ struct xusb_host_context *tegrabl_get_usbh_context(void)
 	return g_context;
 }
 
-tegrabl_error_t tegrabl_usbh_init(void)
+void usbh_free_context(void)
+{
+	if (g_context != NULL) {
+		tegrabl_free(g_context);
+		g_context = NULL;
+	}
+}
+
+tegrabl_error_t tegrabl_usbh_init_start(void)
 {
 	struct xusb_host_context *context = NULL;
 	tegrabl_error_t e = TEGRABL_NO_ERROR;
 
+	if (g_context != NULL) {
+		goto fail;
+	}
+
 	/* Allocate and initialize usbh context */
 	context = (struct xusb_host_context *)tegrabl_alloc(TEGRABL_HEAP_DEFAULT,
 														sizeof(struct xusb_host_context));
@@ -44,22 +56,47 @@ tegrabl_error_t tegrabl_usbh_init(void)
 		goto fail;
 	}
 	memset(context, 0x0, sizeof(struct xusb_host_context));
-	g_context = context;
 
 	/* Initialize xhci */
 	e = xhci_controller_init(context);
 	if (e != TEGRABL_NO_ERROR) {
 		pr_error("failed to initialize xhci controller\n");
+		tegrabl_free(context);
+		goto fail;
+	}
+	g_context = context;
+
+fail:
+	return e;
+}
+
+tegrabl_error_t tegrabl_usbh_init(void)
+{
+	tegrabl_error_t e = TEGRABL_NO_ERROR;
+
+	if (g_context == NULL) {
+		e = tegrabl_usbh_init_start();
+		if (e != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+	}
+
+	e = xhci_wait_for_root_port(g_context);
+	if (e != TEGRABL_NO_ERROR) {
 		goto fail;
 	}
 
-	e = xhci_start(context);
+	e = xhci_start(g_context);
 	if (e != TEGRABL_NO_ERROR) {
 		pr_error("failed to start xhci controller\n");
 		goto fail;
 	}
 
 fail:
+	if (e != TEGRABL_NO_ERROR) {
+		/* Start over from controller init on the next attempt */
+		usbh_free_context();
+	}
 	return e;
 }
 
@@ -95,61 +132,161 @@ tegrabl_error_t tegrabl_usbh_snd_command(struct device_request request, void *bu
 	return err;
 }
 
-#define MAX_TRANSFER_SIZE (254 * 65536)
-tegrabl_error_t tegrabl_usbh_snd_data(uint8_t dev_id, void *buffer, uint32_t *length)
+/* Two TDs of this size always fit the 2047 usable trbs of a transfer ring, */
+/* so the next TD is queued while the xHC is still working on the current  */
+#define MAX_TRANSFER_SIZE (1020 * 65536)
+#define USBH_TDS_IN_FLIGHT 2U
+
+static tegrabl_error_t usbh_bulk_xfer(struct xusb_host_context *ctx, uint8_t ep_id, void *buffer,
+									  uint32_t *length)
 {
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
-	struct xusb_host_context *ctx = tegrabl_get_usbh_context();
-	uint32_t i = 0;
-	uint32_t j = 0;
+	struct xhci_sg_entry sg;
+	uint32_t queued = 0;
+	uint32_t reaped = 0;
 	uint32_t transfered_total = 0;
 	uint32_t transfered = 0;
+	uint32_t in_flight = 0;
+	uint32_t chunk;
+	uint32_t timeout;
 
-	/* xHC reserved 255(normal) + 1(link) trbs for transfer EPs */
-	/* So the max. size of each transfer is 254 * 64K bytes     */
-	/* if the buffer is not 64K aligned                         */
-	i = *length;
-	while (i > 0) {
-		transfered = (i >= MAX_TRANSFER_SIZE) ? MAX_TRANSFER_SIZE : i;
-		err = tegrabl_xhci_xfer_data(ctx, ctx->curr_dev_priv->enum_dev.ep[0].addr, buffer + j, &transfered);
+	while (reaped < *length) {
+		while ((in_flight < USBH_TDS_IN_FLIGHT) && (queued < *length)) {
+			sg.buffer = (uint8_t *)buffer + queued;
+			sg.length = MIN(*length - queued, MAX_TRANSFER_SIZE);
+			err = tegrabl_xhci_queue_td(ctx, ep_id, &sg, 1);
+			if (err != TEGRABL_NO_ERROR) {
+				goto fail;
+			}
+			queued += sg.length;
+			in_flight++;
+		}
+		err = tegrabl_xhci_ring_ep(ctx, ep_id);
+		if (err != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+
+		chunk = MIN(*length - reaped, MAX_TRANSFER_SIZE);
+		timeout = XHCI_XFER_TIMEOUT_MS + (chunk / XHCI_MIN_BYTES_PER_MS);
+		transfered = 0;
+		err = tegrabl_xhci_reap_td(ctx, timeout, &transfered);
+		in_flight--;
+		if ((ep_id & 0x80) == 0x80) {
+			tegrabl_dma_unmap_buffer(TEGRABL_MODULE_XUSB_HOST, 0, (uint8_t *)buffer + reaped, chunk,
+									 TEGRABL_DMA_FROM_DEVICE);
+		}
 		transfered_total += transfered;
+		reaped += chunk;
 		if (err != TEGRABL_NO_ERROR) {
-			*length = transfered_total;
-			return err;
+			goto fail;
+		}
+		/* a short packet ends the transfer */
+		if (transfered < chunk) {
+			break;
 		}
-		i -= transfered;
-		j += transfered;
+	}
+
+fail:
+	/* TDs left after a short packet would take the next transfer's data */
+	if ((in_flight != 0U) || (err != TEGRABL_NO_ERROR)) {
+		tegrabl_xhci_abort_tds(ctx);
 	}
 	*length = transfered_total;
 	return err;
 }
 
-tegrabl_error_t tegrabl_usbh_rcv_data(uint8_t dev_id, void *buffer, uint32_t *length)
+tegrabl_error_t tegrabl_usbh_bulk_xfer_list(struct tegrabl_usbh_bulk_xfer *xfers, uint32_t num_xfers)
 {
-	tegrabl_error_t err = TEGRABL_NO_ERROR;
 	struct xusb_host_context *ctx = tegrabl_get_usbh_context();
-	uint32_t i = 0;
-	uint32_t j = 0;
-	uint32_t transfered_total = 0;
-	uint32_t transfered = 0;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	tegrabl_error_t e;
+	struct xhci_sg_entry sg;
+	bool halted[2] = { false, false };
+	uint8_t ep_out;
+	uint8_t ep_in;
+	uint32_t timeout;
+	uint32_t dir;
+	uint32_t i;
 
-	/* xHC reserved 255(normal) + 1(link) trbs for transfer EPs */
-	/* So the max. size of each transfer is 255 * 64K bytes     */
-	i = *length;
-	while (i > 0) {
-		transfered = (i >= MAX_TRANSFER_SIZE) ? MAX_TRANSFER_SIZE : i;
-		err = tegrabl_xhci_xfer_data(ctx, (ctx->curr_dev_priv->enum_dev.ep[1].addr | 0x80), buffer + j,
-									 &transfered);
-		transfered_total += transfered;
-		tegrabl_dma_unmap_buffer(TEGRABL_MODULE_XUSB_HOST, 0, buffer + j, transfered,
-								 TEGRABL_DMA_FROM_DEVICE);
+	for (i = 0; i < num_xfers; i++) {
+		xfers[i].actual_length = 0;
+		xfers[i].comp_code = COMP_INVALID;
+	}
+
+	if (ctx->td_count != 0U) {
+		pr_error("%s: %u TDs still queued\n", __func__, ctx->td_count);
+		return TEGRABL_ERROR(TEGRABL_ERR_BUSY, 1);
+	}
+
+	ep_out = ctx->curr_dev_priv->enum_dev.ep[USB_DIR_OUT].addr;
+	ep_in = ctx->curr_dev_priv->enum_dev.ep[USB_DIR_IN].addr | 0x80;
+
+	for (i = 0; i < num_xfers; i++) {
+		if (xfers[i].length > MAX_TRANSFER_SIZE) {
+			err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+			goto fail;
+		}
+		sg.buffer = xfers[i].buffer;
+		sg.length = xfers[i].length;
+		err = tegrabl_xhci_queue_td(ctx, xfers[i].is_in ? ep_in : ep_out, &sg, 1);
 		if (err != TEGRABL_NO_ERROR) {
-			*length = transfered_total;
-			return err;
+			goto fail;
 		}
-		i -= transfered;
-		j += transfered;
 	}
-	*length = transfered_total;
+	err = tegrabl_xhci_ring_ep(ctx, ep_out);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+	err = tegrabl_xhci_ring_ep(ctx, ep_in);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	for (i = 0; i < num_xfers; i++) {
+		/* the transfers behind a failed one on its endpoint never complete */
+		dir = xfers[i].is_in ? USB_DIR_IN : USB_DIR_OUT;
+		if (halted[dir]) {
+			break;
+		}
+		timeout = XHCI_XFER_TIMEOUT_MS + (xfers[i].length / XHCI_MIN_BYTES_PER_MS);
+		e = tegrabl_xhci_reap_td(ctx, timeout, &xfers[i].actual_length);
+		if (xfers[i].is_in) {
+			tegrabl_dma_unmap_buffer(TEGRABL_MODULE_XUSB_HOST, 0, xfers[i].buffer, xfers[i].length,
+									 TEGRABL_DMA_FROM_DEVICE);
+		}
+		if (e == TEGRABL_NO_ERROR) {
+			xfers[i].comp_code = ctx->comp_code;
+			continue;
+		}
+		if (err == TEGRABL_NO_ERROR) {
+			err = e;
+		}
+		/* a TD that did not complete blocks the queue */
+		if (TEGRABL_ERROR_REASON(e) != TEGRABL_ERR_COMMAND_FAILED) {
+			break;
+		}
+		xfers[i].comp_code = ctx->comp_code;
+		halted[dir] = true;
+	}
+
+fail:
+	/* also resets an endpoint that halted on a failed transfer */
+	if ((ctx->td_count != 0U) || (err != TEGRABL_NO_ERROR)) {
+		tegrabl_xhci_abort_tds(ctx);
+	}
 	return err;
 }
+
+tegrabl_error_t tegrabl_usbh_snd_data(uint8_t dev_id, void *buffer, uint32_t *length)
+{
+	struct xusb_host_context *ctx = tegrabl_get_usbh_context();
+
+	return usbh_bulk_xfer(ctx, ctx->curr_dev_priv->enum_dev.ep[0].addr, buffer, length);
+}
+
+tegrabl_error_t tegrabl_usbh_rcv_data(uint8_t dev_id, void *buffer, uint32_t *length)
+{
+	struct xusb_host_context *ctx = tegrabl_get_usbh_context();
+
+	return usbh_bulk_xfer(ctx, (ctx->curr_dev_priv->enum_dev.ep[1].addr | 0x80), buffer, length);
+}
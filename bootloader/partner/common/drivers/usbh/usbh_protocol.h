@@ -11,6 +11,7 @@
 #define __USBH_PROTOCOL_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <tegrabl_dmamap.h>
 
 #define MAX_DEVICE_SLOTS	5
@@ -444,6 +445,25 @@ struct xhci_ring {
 	uint32_t num_of_trbs;
 	uint32_t cycle_state;
 	uint32_t start_cycle_state;
+	/* Bus address of first TRB, maps event TRB pointers back to the ring */
+	dma_addr_t first_dma;
+};
+
+/* Max bulk TDs outstanding across all transfer rings */
+#define XHCI_MAX_QUEUED_TDS	16
+
+/*
+ * xhci_td - Bookkeeping for one bulk TD queued with tegrabl_xhci_queue_td().
+ */
+struct xhci_td {
+	struct TRB *first_trb;
+	struct TRB *last_trb;
+	uint32_t ring_index;
+	uint32_t num_trbs;
+	uint32_t length;
+	uint32_t actual_length;
+	uint8_t comp_code;
+	bool done;
 };
 
 /*
@@ -542,6 +562,17 @@ struct xusb_host_context {
 
 	/* Completion code from handle_transfer_event */
 	uint8_t comp_code;
+	/* Completion code of the last command, COMP_INVALID while it is pending */
+	uint8_t cmd_comp_code;
+
+	/* Queued bulk TDs, oldest at td_head */
+	struct xhci_td td_queue[XHCI_MAX_QUEUED_TDS];
+	uint32_t td_head;
+	uint32_t td_count;
+	/* Per transfer ring: TRBs owned by queued TDs, TDs not yet rung, TDs rung */
+	uint32_t ring_trbs[3];
+	uint32_t ring_unrung_tds[3];
+	uint32_t ring_active_tds[3];
 
 	/* Required for Read command */
 	uint8_t logical_blk_addr[4];
@@ -556,6 +587,9 @@ struct xusb_host_context {
 	uint8_t page_size_log2;
 	uint32_t page_size;
 
+	/* Time by which a device must have connected to a root port */
+	uint64_t port_deadline_ms;
+
 	/* Holds the xusb Read start time */
 	uint64_t read_start_time;
 	/* Sequence no., for bulk out */
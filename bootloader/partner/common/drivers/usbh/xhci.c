@@ -162,8 +162,14 @@ static tegrabl_error_t xusbh_port_reset(struct xusb_host_context *ctx)
 		pr_debug("USB 2.0 port %d disconnected\n", ctx->root_port_number);
 	}
 
-	tegrabl_mdelay(60);
-	temp = xusbh_xhci_readl(OP_PORTSC(ctx->root_port_number + 3));
+	/* Reset completes in 10-20ms, poll for it rather than always waiting for
+	 * the worst case */
+	timeout = 60;
+	do {
+		tegrabl_mdelay(1);
+		temp = xusbh_xhci_readl(OP_PORTSC(ctx->root_port_number + 3));
+		timeout--;
+	} while (((temp & PORT_RC) != PORT_RC) && (timeout > 0));
 	if ((temp & PORT_RC) == PORT_RC) {
 		temp &= ~PORT_PE;
 		xusbh_xhci_writel(OP_PORTSC(ctx->root_port_number + 3), temp);
@@ -350,6 +356,7 @@ static tegrabl_error_t handle_command_completion_event(struct xusb_host_context
 	uint64_t cmd_trb_ptr;
 
 	pr_debug("event: %p\n", event);
+	ctx->cmd_comp_code = COMP_CODE(event->field[2]);
 	if ((COMP_CODE(event->field[2]) != COMP_SUCCESS) && (COMP_CODE(event->field[2]) != COMP_SHORT_PACKET)) {
 		pr_warn("%s: WARNING: Command was not successfully completed (0x%02x)\n",
 			__func__, COMP_CODE(event->field[2]));
@@ -375,6 +382,82 @@ static tegrabl_error_t handle_command_completion_event(struct xusb_host_context
 	return err;
 }
 
+static struct TRB *xhci_next_trb(struct xhci_ring *ring, struct TRB *trb)
+{
+	trb++;
+	if (TRB_TYPE_LINK(trb->field[3])) {
+		trb = ring->first;
+	}
+	return trb;
+}
+
+/* Account a transfer event against the queued TD owning the event TRB */
+static void xhci_td_event(struct xusb_host_context *ctx, struct TRB *event)
+{
+	struct xhci_ring *ring;
+	struct xhci_td *td;
+	struct TRB *event_trb;
+	struct TRB *trb;
+	uint64_t trb_ptr;
+	uint32_t ring_index;
+	uint32_t dci;
+	uint32_t size;
+	uint32_t i;
+	uint8_t comp_code;
+
+	dci = TRB_TO_EP_ID(event->field[3]);
+	if ((ctx->td_count == 0U) || (dci < 2U)) {
+		return;
+	}
+	/* odd DCIs are IN endpoints */
+	ring_index = ((dci & 1U) != 0U) ? 2U : 1U;
+	ring = &ctx->curr_dev_priv->ep_ring[ring_index];
+
+	trb_ptr = (event->field[0] & ~0xfU) | ((uint64_t)event->field[1] << 32);
+	if ((trb_ptr < ring->first_dma) ||
+		(trb_ptr >= (ring->first_dma + (ring->num_of_trbs * sizeof(struct TRB))))) {
+		pr_warn("%s: event TRB 0x%08x not on ring %u\n", __func__, (uint32_t)trb_ptr, ring_index);
+		return;
+	}
+	event_trb = ring->first + ((trb_ptr - ring->first_dma) / sizeof(struct TRB));
+	comp_code = COMP_CODE(event->field[2]);
+
+	/* Completed TDs are skipped, this drops the IOC event that may follow */
+	/* a short packet event for the same TD                                */
+	for (i = 0; i < ctx->td_count; i++) {
+		td = &ctx->td_queue[(ctx->td_head + i) % XHCI_MAX_QUEUED_TDS];
+		if ((td->ring_index != ring_index) || (td->done == true)) {
+			continue;
+		}
+
+		size = 0;
+		trb = td->first_trb;
+		while ((trb != event_trb) && (trb != td->last_trb)) {
+			size += ((struct normal_trb *)trb)->trb_tfr_len;
+			trb = xhci_next_trb(ring, trb);
+		}
+		if (trb != event_trb) {
+			continue;
+		}
+
+		if (comp_code == COMP_SUCCESS) {
+			if (event_trb != td->last_trb) {
+				/* stray IOC in the middle of the TD */
+				return;
+			}
+			td->actual_length = td->length;
+		} else {
+			size += ((struct normal_trb *)trb)->trb_tfr_len;
+			size -= MIN(size, ((struct event_trb *)event)->trb_tfr_len);
+			td->actual_length = size;
+		}
+		td->comp_code = comp_code;
+		td->done = true;
+		ctx->ring_active_tds[ring_index]--;
+		return;
+	}
+}
+
 static tegrabl_error_t handle_transfer_event(struct xusb_host_context *ctx, struct TRB *event)
 {
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
@@ -391,6 +474,7 @@ static tegrabl_error_t handle_transfer_event(struct xusb_host_context *ctx, stru
 		pr_debug("%s: Stashed completion code 0x%02X\n", __func__,
 			 ctx->comp_code);
 	}
+	xhci_td_event(ctx, event);
 
 	return err;
 }
@@ -476,8 +560,10 @@ static tegrabl_error_t xusbh_wait_irq(struct xusb_host_context *ctx,
 		xusbh_xhci_writel(RT_IMAN(0), irq_pending);
 	}
 
+	/* Drain every event posted so far, a failed one must not hide the */
+	/* completions of TDs queued behind it                            */
 	event = ctx->event_ring.deque_ptr;
-	while (xhci_handle_events(ctx) == TEGRABL_NO_ERROR) {
+	while (xhci_handle_events(ctx) != TEGRABL_ERR_INVALID) {
 	};
 
 	temp_64 = xusbh_xhci_readl(RT_ERDP0(0)) | ((uint64_t)xusbh_xhci_readl(RT_ERDP1(0)) << 32);
@@ -697,11 +783,9 @@ void prepare_ep_ctx(struct xusb_host_context *ctx, uint32_t ep_index, enum xhci_
 }
 
 #define DB_VALUE(ep, stream)	((((ep) + 1) & 0xff) | ((stream) << 16))
-static tegrabl_error_t xhci_ring_doorbell_wait(struct xusb_host_context *ctx,
-											   enum xhci_endpoint_type trb_type,
-											   uint8_t ep_index)
+static void xhci_ring_doorbell(struct xusb_host_context *ctx, enum xhci_endpoint_type trb_type,
+							   uint8_t ep_index)
 {
-	tegrabl_error_t err = TEGRABL_NO_ERROR;
 	struct TRB *trb;
 	uint32_t ep_ring_index;
 
@@ -729,9 +813,14 @@ static tegrabl_error_t xhci_ring_doorbell_wait(struct xusb_host_context *ctx,
 	/* Ring EP doorbell */
 	xusbh_xhci_writel(DB(ctx->slot_id), DB_VALUE(ep_index, 0));
 	pr_debug("Ding Dong!!!  Ring EP%d doorbell (%x)\n", ep_index, xusbh_xhci_readl(DB(ctx->slot_id)));
+}
 
-	err = xusbh_wait_irq(ctx, 1000);
-	return err;
+static tegrabl_error_t xhci_ring_doorbell_wait(struct xusb_host_context *ctx,
+											   enum xhci_endpoint_type trb_type,
+											   uint8_t ep_index, uint32_t timeout)
+{
+	xhci_ring_doorbell(ctx, trb_type, ep_index);
+	return xusbh_wait_irq(ctx, timeout);
 }
 
 /* clear endpoint stall */
@@ -759,7 +848,7 @@ static tegrabl_error_t xusbh_process_ep_stall_clear_req(struct xusb_host_context
 	if (err == TEGRABL_NO_ERROR) {
 		prepare_ctrl_status_trb(ctx, &device_request_var);
 		prepare_ep_ctx(ctx, 0, EP_TYPE_CONTROL_BI);
-		err = xhci_ring_doorbell_wait(ctx, EP_TYPE_CONTROL_BI, 0);
+		err = xhci_ring_doorbell_wait(ctx, EP_TYPE_CONTROL_BI, 0, XHCI_XFER_TIMEOUT_MS);
 		if (err != TEGRABL_NO_ERROR) {
 			err = TEGRABL_ERROR(TEGRABL_ERR_NO_ACCESS, 0);
 		}
@@ -784,7 +873,7 @@ tegrabl_error_t tegrabl_xusbh_process_ctrl_req(struct xusb_host_context *ctx,
 			prepare_ctrl_status_trb(ctx, device_request_ptr);
 			prepare_ep_ctx(ctx, 0, EP_TYPE_CONTROL_BI);
 
-			err = xhci_ring_doorbell_wait(ctx, EP_TYPE_CONTROL_BI, 0);
+			err = xhci_ring_doorbell_wait(ctx, EP_TYPE_CONTROL_BI, 0, XHCI_XFER_TIMEOUT_MS);
 			if (err == TEGRABL_NO_ERROR) {
 				break;
 			}
@@ -1376,13 +1465,29 @@ tegrabl_error_t xhci_controller_init(struct xusb_host_context *context)
 		goto fail;
 	}
 
-	tegrabl_mdelay(1000);
-
+	/* VBUS is up, the device gets XHCI_PORT_CONNECT_TIMEOUT_MS to show up on a
+	 * root port. xhci_wait_for_root_port() polls for it so that the caller can
+	 * do other work in between. */
 	context->root_port_number = 0xff;
-	if (xhci_set_root_port(context) == false) {
-		e = TEGRABL_ERROR(TEGRABL_ERR_NOT_CONNECTED, 0);
-		goto fail;
+	context->port_deadline_ms = tegrabl_get_timestamp_ms() + XHCI_PORT_CONNECT_TIMEOUT_MS;
+
+fail:
+	return e;
+}
+
+tegrabl_error_t xhci_wait_for_root_port(struct xusb_host_context *context)
+{
+	tegrabl_error_t e = TEGRABL_NO_ERROR;
+
+	while (xhci_set_root_port(context) == false) {
+		if (tegrabl_get_timestamp_ms() >= context->port_deadline_ms) {
+			pr_error("no device connected to root ports\n");
+			e = TEGRABL_ERROR(TEGRABL_ERR_NOT_CONNECTED, 0);
+			goto fail;
+		}
+		tegrabl_mdelay(XHCI_PORT_POLL_INTERVAL_MS);
 	}
+	pr_debug("root port %u connected\n", context->root_port_number);
 
 fail:
 	return e;
@@ -1440,6 +1545,7 @@ tegrabl_error_t init_common_data_struct(struct xusb_host_context *ctx)
 	ring->type = TYPE_COMMAND;
 	trb += NUM_TRB_CMD_RING - 1;
 	ring->dma = dma;
+	ring->first_dma = dma;
 	xusbh_xhci_writel(OP_CRCR0, (U64_TO_U32_LO(dma) | 0x1));
 	xusbh_xhci_writel(OP_CRCR1, U64_TO_U32_HI(dma));
 	trb->field[0] = U64_TO_U32_LO(dma);
@@ -1540,6 +1646,7 @@ tegrabl_error_t init_data_struct(struct xusb_host_context *ctx)
 		ring->cycle_state = 1;
 		ring->start_cycle_state = 1;
 		ring->dma = dma;
+		ring->first_dma = dma;
 		trb = ring->first;
 		trb += (NUM_TRB_TX_RING - 1);
 		trb->field[0] = U64_TO_U32_LO(dma);
@@ -1717,111 +1824,288 @@ fail:
 }
 
 #define MAX_TX_LENGTH   0x10000
-tegrabl_error_t tegrabl_xhci_xfer_data(struct xusb_host_context *ctx,
-				uint8_t ep_id, void *buffer, uint32_t *length)
+#define TD_SIZE_MAX     31U
+tegrabl_error_t tegrabl_xhci_queue_td(struct xusb_host_context *ctx, uint8_t ep_id,
+									  struct xhci_sg_entry *sg, uint32_t num_sg)
 {
-	tegrabl_error_t err = TEGRABL_NO_ERROR;
 	struct xhci_ring *ep_ring;
 	struct normal_trb *trb;
+	struct xhci_td *td;
 	struct TRB *t;
-	uint32_t size;
 	dma_addr_t dma;
-	uint32_t transfer_size;
-	uint32_t need_trbs;
-	uint32_t count;
+	uint32_t ring_index;
+	uint32_t packet_size;
 	uint32_t total_packets;
+	uint32_t total_length;
+	uint32_t max_trbs;
+	uint32_t transfer_size;
+	uint32_t remaining;
+	uint32_t size;
+	uint32_t i;
 	enum usb_dir dir;
 
-	if (*length == 0) {
-		return err;
+	if ((sg == NULL) || (num_sg == 0U)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
 	}
 
 	dir = ((ep_id & 0x80) == 0x80) ? USB_DIR_IN : USB_DIR_OUT;
-	ep_id = (ep_id & 0x7f) * 2 + dir;
-	ep_ring = (struct xhci_ring *)&ctx->curr_dev_priv->ep_ring[(uint32_t)dir + 1];
+	ring_index = (uint32_t)dir + 1U;
+	ep_ring = (struct xhci_ring *)&ctx->curr_dev_priv->ep_ring[ring_index];
+	packet_size = ctx->curr_dev_priv->enum_dev.ep[dir].packet_size;
 
-	/* prepare normal trbs */
-	dma = tegrabl_dma_map_buffer(TEGRABL_MODULE_XUSB_HOST, 0, (void *)buffer, *length, TEGRABL_DMA_TO_DEVICE);
-
-	/* extra 1 trb is needed when buffer is not at 64K bindary */
-	transfer_size = MAX_TX_LENGTH - ((uint32_t)dma & (MAX_TX_LENGTH - 1));
-	need_trbs = 0;
-	if (transfer_size != 0) {
-		need_trbs = 1;
+	/* worst case every entry needs one extra trb for a 64K boundary */
+	total_length = 0;
+	max_trbs = 0;
+	for (i = 0; i < num_sg; i++) {
+		total_length += sg[i].length;
+		max_trbs += DIV_ROUND_UP(sg[i].length, MAX_TX_LENGTH) + 1U;
+	}
+	if ((total_length == 0U) || (packet_size == 0U)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 1);
 	}
 
-	if (transfer_size < *length) {
-		transfer_size = *length - transfer_size;
-		need_trbs += (transfer_size + MAX_TX_LENGTH - 1) >> 16;
+	/* link trb is not available for TDs */
+	if ((ctx->td_count == XHCI_MAX_QUEUED_TDS) ||
+		((ctx->ring_trbs[ring_index] + max_trbs) >= ep_ring->num_of_trbs)) {
+		pr_debug("%s: no room for %u trbs on ring %u\n", __func__, max_trbs, ring_index);
+		return TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 0);
 	}
-	pr_debug("%s - need %d trbs for xfer\n", __func__, (int)need_trbs);
 
-	total_packets = DIV_ROUND_UP((*length), ctx->curr_dev_priv->enum_dev.ep[dir].packet_size);
-	if (need_trbs == 1) {
-		transfer_size = *length;
-	} else {
-		transfer_size = MAX_TX_LENGTH - ((uint32_t)dma & (MAX_TX_LENGTH - 1));
+	/* First TD after a doorbell starts a new batch; the batch's first trb */
+	/* keeps a stale cycle bit until tegrabl_xhci_ring_ep() hands it over */
+	if (ctx->ring_unrung_tds[ring_index] == 0U) {
+		ep_ring->enque_start_ptr = ep_ring->enque_curr_ptr;
+		ep_ring->start_cycle_state = ep_ring->cycle_state;
 	}
 
-	count = 0;
-	ep_ring->enque_start_ptr = ep_ring->enque_curr_ptr;
-	ep_ring->start_cycle_state = ep_ring->cycle_state;
+	td = &ctx->td_queue[(ctx->td_head + ctx->td_count) % XHCI_MAX_QUEUED_TDS];
+	memset(td, 0, sizeof(struct xhci_td));
+	td->first_trb = ep_ring->enque_curr_ptr;
+	td->ring_index = ring_index;
+	td->length = total_length;
+
+	total_packets = DIV_ROUND_UP(total_length, packet_size);
 	size = 0;
-	while (count < need_trbs) {
-		trb = (struct normal_trb *)ep_ring->enque_curr_ptr;
-		if (ep_ring->enque_curr_ptr != ep_ring->enque_start_ptr) {
-			trb->cycle_bit = ep_ring->cycle_state;
+	for (i = 0; i < num_sg; i++) {
+		remaining = sg[i].length;
+		if (remaining == 0U) {
+			continue;
 		}
-		trb->data_buffer_lo = U64_TO_U32_LO(dma);
-		trb->data_buffer_hi = U64_TO_U32_HI(dma);
-		dma += transfer_size;
-		trb->trb_tfr_len = transfer_size;
-		trb->td_size = (total_packets - ((size + transfer_size) / ctx->curr_dev_priv->enum_dev.ep[dir].packet_size));
-		if (count != (need_trbs - 1)) {
-			trb->CH = 1;
-		} else {
-			trb->td_size = 0;
-			trb->IOC = 1;
+		dma = tegrabl_dma_map_buffer(TEGRABL_MODULE_XUSB_HOST, 0, sg[i].buffer, remaining,
+									 TEGRABL_DMA_TO_DEVICE);
+		while (remaining > 0U) {
+			/* trb buffers must not cross a 64K boundary */
+			transfer_size = MAX_TX_LENGTH - ((uint32_t)dma & (MAX_TX_LENGTH - 1));
+			transfer_size = MIN(transfer_size, remaining);
+
+			trb = (struct normal_trb *)ep_ring->enque_curr_ptr;
+			memset((void *)trb, 0, sizeof(struct TRB));
+			if (ep_ring->enque_curr_ptr != ep_ring->enque_start_ptr) {
+				trb->cycle_bit = ep_ring->cycle_state;
+			} else {
+				trb->cycle_bit = ~ep_ring->start_cycle_state & 0x1;
+			}
+			trb->data_buffer_lo = U64_TO_U32_LO(dma);
+			trb->data_buffer_hi = U64_TO_U32_HI(dma);
+			trb->trb_tfr_len = transfer_size;
+
+			size += transfer_size;
+			dma += transfer_size;
+			remaining -= transfer_size;
+
+			/* TD size is the remaining packet count, saturated to 5 bits */
+			trb->td_size = MIN(TD_SIZE_MAX, (total_packets - (size / packet_size)));
+			if (size != total_length) {
+				trb->CH = 1;
+			} else {
+				trb->td_size = 0;
+				trb->IOC = 1;
+			}
+			if (dir == USB_DIR_IN) {
+				trb->ISP = 1;
+			}
+			trb->trb_type = TRB_NORMAL;
+			tegrabl_dma_map_buffer(TEGRABL_MODULE_XUSB_HOST, 0, (void *)trb, sizeof(struct TRB),
+								   TEGRABL_DMA_TO_DEVICE);
+
+			t = (struct TRB *)trb;
+			pr_debug("xfer[%d] %08x  %08x  %08x  %08x\n", (int)td->num_trbs, t->field[0], t->field[1],
+					 t->field[2], t->field[3]);
+			td->last_trb = t;
+			td->num_trbs++;
+			set_enq_ptr(ep_ring);
 		}
-		if (dir == USB_DIR_IN)
-			trb->ISP = 1;
-		trb->trb_type = TRB_NORMAL;
-
-		size += transfer_size;
-		dma += transfer_size;
-		transfer_size = *length - size;
-		if (transfer_size > MAX_TX_LENGTH) {
-			transfer_size = MAX_TX_LENGTH;
+	}
+
+	ctx->ring_trbs[ring_index] += td->num_trbs;
+	ctx->ring_unrung_tds[ring_index]++;
+	ctx->td_count++;
+
+	return TEGRABL_NO_ERROR;
+}
+
+tegrabl_error_t tegrabl_xhci_ring_ep(struct xusb_host_context *ctx, uint8_t ep_id)
+{
+	struct xhci_ring *ep_ring;
+	enum xhci_endpoint_type ep_type;
+	uint32_t ring_index;
+	uint8_t ep_index;
+	enum usb_dir dir;
+
+	dir = ((ep_id & 0x80) == 0x80) ? USB_DIR_IN : USB_DIR_OUT;
+	ring_index = (uint32_t)dir + 1U;
+	if (ctx->ring_unrung_tds[ring_index] == 0U) {
+		return TEGRABL_NO_ERROR;
+	}
+	ep_ring = (struct xhci_ring *)&ctx->curr_dev_priv->ep_ring[ring_index];
+	ep_type = (dir == USB_DIR_IN) ? EP_TYPE_BULK_IN : EP_TYPE_BULK_OUT;
+	ep_index = (ep_id & 0x7f) * 2 + dir - 1;
+
+	/* An idle endpoint is pointed at the batch, a busy one walks into it */
+	/* from its current dequeue pointer once the doorbell rings            */
+	if (ctx->ring_active_tds[ring_index] == 0U) {
+		ep_ring->dma = ep_ring->first_dma +
+			((dma_addr_t)(ep_ring->enque_start_ptr - ep_ring->first) * sizeof(struct TRB));
+		prepare_ep_ctx(ctx, ep_index, ep_type);
+	}
+	ctx->ring_active_tds[ring_index] += ctx->ring_unrung_tds[ring_index];
+	ctx->ring_unrung_tds[ring_index] = 0;
+
+	xhci_ring_doorbell(ctx, ep_type, ep_index);
+
+	return TEGRABL_NO_ERROR;
+}
+
+tegrabl_error_t tegrabl_xhci_reap_td(struct xusb_host_context *ctx, uint32_t timeout,
+									 uint32_t *actual_length)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	struct xhci_td *td;
+	time_t start;
+	uint32_t elapsed;
+	uint32_t remaining;
+
+	if (ctx->td_count == 0U) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 2);
+	}
+	td = &ctx->td_queue[ctx->td_head];
+
+	/* every pass drains all pending events, completing any TD they cover */
+	start = tegrabl_get_timestamp_ms();
+	while (td->done == false) {
+		elapsed = (uint32_t)(tegrabl_get_timestamp_ms() - start);
+		remaining = (elapsed < timeout) ? (timeout - elapsed) : 0U;
+		if ((remaining == 0U) && ((xusbh_xhci_readl(OP_USBSTS) & STS_EINT) != STS_EINT)) {
+			if (timeout == 0U) {
+				return TEGRABL_ERROR(TEGRABL_ERR_NOT_READY, 0);
+			}
+			pr_warn("%s: TD of %u bytes timed out\n", __func__, td->length);
+			return TEGRABL_ERROR(TEGRABL_ERR_TIMEOUT, 0);
 		}
-		count++;
-		set_enq_ptr(ep_ring);
+		err = xusbh_wait_irq(ctx, remaining);
+		if (err != TEGRABL_NO_ERROR) {
+			return TEGRABL_ERROR(TEGRABL_ERR_TIMEOUT, 1);
+		}
+	}
 
-		t = (struct TRB *)trb;
-		pr_debug("xfer[%d] %08x  %08x  %08x  %08x\n", (int)count, t->field[0], t->field[1],
-				t->field[2], t->field[3]);
+	if (actual_length != NULL) {
+		*actual_length = td->actual_length;
 	}
-	ep_ring->dma = tegrabl_dma_map_buffer(TEGRABL_MODULE_XUSB_HOST, 0, (void *)ep_ring->enque_start_ptr,
-					  sizeof(struct TRB) * need_trbs, TEGRABL_DMA_TO_DEVICE);
+	ctx->comp_code = td->comp_code;
+	ctx->ring_trbs[td->ring_index] -= td->num_trbs;
+	ctx->td_head = (ctx->td_head + 1U) % XHCI_MAX_QUEUED_TDS;
+	ctx->td_count--;
 
-	/* prepare ep context */
-	/* ring ep doorbell and wait*/
-	if (dir == USB_DIR_IN) {
-		prepare_ep_ctx(ctx, (ep_id - 1), EP_TYPE_BULK_IN);
-		err = xhci_ring_doorbell_wait(ctx, EP_TYPE_BULK_IN, (ep_id - 1));
-	} else {
-		prepare_ep_ctx(ctx, (ep_id - 1), EP_TYPE_BULK_OUT);
-		err = xhci_ring_doorbell_wait(ctx, EP_TYPE_BULK_OUT, (ep_id - 1));
+	if ((td->comp_code != COMP_SUCCESS) && (td->comp_code != COMP_SHORT_PACKET)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_COMMAND_FAILED, 1);
 	}
-	if (err != TEGRABL_NO_ERROR) {
-		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
+
+	return TEGRABL_NO_ERROR;
+}
+
+#define XHCI_CMD_TIMEOUT_MS 100
+
+/* Issues an endpoint command for the current slot and waits for its completion event */
+static uint8_t xhci_ep_command(struct xusb_host_context *ctx, uint32_t trb_type, uint32_t dci,
+							   dma_addr_t param)
+{
+	struct TRB *cmd;
+	time_t start;
+	uint32_t elapsed;
+
+	cmd = ctx->cmd_ring.enque_curr_ptr;
+	cmd->field[0] = U64_TO_U32_LO(param);
+	cmd->field[1] = U64_TO_U32_HI(param);
+	cmd->field[2] = 0;
+	cmd->field[3] = TRB_TYPE(trb_type) | (dci << 16) | (ctx->slot_id << 24) | ctx->cmd_ring.cycle_state;
+	tegrabl_dma_map_buffer(TEGRABL_MODULE_XUSB_HOST, 0, (void *)cmd, sizeof(struct TRB),
+						   TEGRABL_DMA_TO_DEVICE);
+	ctx->cmd_comp_code = COMP_INVALID;
+
+	xusbh_xhci_writel(DB(0), 0);
+	/* transfer events, e.g. the one for a stopped TD, may come first */
+	start = tegrabl_get_timestamp_ms();
+	while (ctx->cmd_comp_code == COMP_INVALID) {
+		elapsed = (uint32_t)(tegrabl_get_timestamp_ms() - start);
+		if ((elapsed >= XHCI_CMD_TIMEOUT_MS) ||
+			(xusbh_wait_irq(ctx, XHCI_CMD_TIMEOUT_MS - elapsed) != TEGRABL_NO_ERROR)) {
+			pr_warn("%s: command %u on endpoint %u timed out\n", __func__, trb_type, dci);
+			break;
+		}
+	}
+	set_enq_ptr(&ctx->cmd_ring);
+
+	return ctx->cmd_comp_code;
+}
+
+/* Stops a bulk endpoint and moves its dequeue pointer to the enqueue pointer */
+static tegrabl_error_t xhci_skip_ring(struct xusb_host_context *ctx, uint32_t ring_index)
+{
+	struct xhci_ring *ep_ring;
+	enum usb_dir dir;
+	dma_addr_t deq;
+	uint32_t dci;
+	uint8_t comp_code;
+
+	dir = (ring_index == 2U) ? USB_DIR_IN : USB_DIR_OUT;
+	if (ctx->curr_dev_priv->enum_dev.ep[dir].addr == 0U) {
+		return TEGRABL_NO_ERROR;
 	}
+	ep_ring = (struct xhci_ring *)&ctx->curr_dev_priv->ep_ring[ring_index];
+	dci = ((ctx->curr_dev_priv->enum_dev.ep[dir].addr & 0x7fU) * 2U) + (uint32_t)dir;
 
-	if (dir == USB_DIR_IN) {
-		tegrabl_dma_unmap_buffer(TEGRABL_MODULE_XUSB_HOST, 0, (void *)buffer, *length,
-					 TEGRABL_DMA_FROM_DEVICE);
+	/* A halted endpoint refuses Stop Endpoint and needs a Reset Endpoint */
+	/* instead, either leaves it stopped                                  */
+	comp_code = xhci_ep_command(ctx, TRB_STOP_RING, dci, 0);
+	if (comp_code == COMP_CONTEXT_STATE_ERROR) {
+		comp_code = xhci_ep_command(ctx, TRB_RESET_EP, dci, 0);
 	}
 
-	return err;
+	deq = ep_ring->first_dma +
+		((dma_addr_t)(ep_ring->enque_curr_ptr - ep_ring->first) * sizeof(struct TRB));
+	comp_code = xhci_ep_command(ctx, TRB_SET_DEQ, dci, deq | ep_ring->cycle_state);
+	if (comp_code != COMP_SUCCESS) {
+		pr_error("%s: Set TR Dequeue on endpoint %u failed (0x%02x)\n", __func__, dci, comp_code);
+		return TEGRABL_ERROR(TEGRABL_ERR_COMMAND_FAILED, 2);
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+void tegrabl_xhci_abort_tds(struct xusb_host_context *ctx)
+{
+	uint32_t ring_index;
+
+	/* TDs handed to the xHC stay on the ring until it is told to skip them */
+	for (ring_index = 1U; ring_index < 3U; ring_index++) {
+		(void)xhci_skip_ring(ctx, ring_index);
+	}
+
+	ctx->td_head = 0;
+	ctx->td_count = 0;
+	memset(ctx->ring_trbs, 0, sizeof(ctx->ring_trbs));
+	memset(ctx->ring_unrung_tds, 0, sizeof(ctx->ring_unrung_tds));
+	memset(ctx->ring_active_tds, 0, sizeof(ctx->ring_active_tds));
 }
 
 void xhci_power_down_controller(void)
@@ -1856,5 +2140,6 @@ tegrabl_error_t tegrabl_usbh_close(void)
 	}
 
 fail:
+	usbh_free_context();
 	return err;
 }
@@ -28,16 +28,103 @@
 #define ERST_SIZE 2048
 #define SETUP_DATA_BUFFER_SIZE 0x200
 
+/* Transfer timeouts in ms; bulk TDs get extra time per byte assuming the
+ * link moves at least XHCI_MIN_BYTES_PER_MS */
+#define XHCI_XFER_TIMEOUT_MS 1000
+#define XHCI_MIN_BYTES_PER_MS (16 * 1024)
+
+/* Time allowed for a device to connect once VBUS is enabled and the interval
+ * at which the root ports are polled for it */
+#define XHCI_PORT_CONNECT_TIMEOUT_MS 1000
+#define XHCI_PORT_POLL_INTERVAL_MS 5
+
+/**
+ * @brief Powers up the controller, loads the firmware and enables VBUS. Does
+ * not wait for a device, see xhci_wait_for_root_port().
+ *
+ * @param context host context
+ *
+ * @return TEGRABL_NO_ERROR on success
+ */
 tegrabl_error_t xhci_controller_init(struct xusb_host_context *context);
 
+/**
+ * @brief Polls the root ports until a device connects or
+ * XHCI_PORT_CONNECT_TIMEOUT_MS has passed since xhci_controller_init().
+ *
+ * @param context host context
+ *
+ * @return TEGRABL_NO_ERROR once a root port reports a connection,
+ * TEGRABL_ERR_NOT_CONNECTED on timeout.
+ */
+tegrabl_error_t xhci_wait_for_root_port(struct xusb_host_context *context);
+
 tegrabl_error_t xhci_start(struct xusb_host_context *ctx);
 
+/* Drops the host context, tegrabl_usbh_init() then starts from controller init */
+void usbh_free_context(void);
+
 tegrabl_error_t init_data_struct(struct xusb_host_context *context);
 
 tegrabl_error_t tegrabl_xusbh_process_ctrl_req(struct xusb_host_context *ctx,
 											   struct device_request *device_request_ptr,
 											   void *buffer);
 
-tegrabl_error_t tegrabl_xhci_xfer_data(struct xusb_host_context *ctx, uint8_t ep_id, void *buffer,
-									   uint32_t *length);
+/* One buffer of a scatter list handed to tegrabl_xhci_queue_td() */
+struct xhci_sg_entry {
+	void *buffer;
+	uint32_t length;
+};
+
+/**
+ * @brief Builds one bulk TD out of a scatter list and appends it to the
+ * endpoint's transfer ring. Entries are split at 64K boundaries and chained,
+ * the TD is not visible to the xHC until tegrabl_xhci_ring_ep() is called.
+ *
+ * @param ctx host context
+ * @param ep_id endpoint address, bit 7 set for IN
+ * @param sg scatter list
+ * @param num_sg number of entries in sg
+ *
+ * @return TEGRABL_NO_ERROR if queued, TEGRABL_ERR_OVERFLOW if the ring or
+ * the TD queue is full.
+ */
+tegrabl_error_t tegrabl_xhci_queue_td(struct xusb_host_context *ctx, uint8_t ep_id,
+									  struct xhci_sg_entry *sg, uint32_t num_sg);
+
+/**
+ * @brief Hands all TDs queued on the endpoint since the last call to the
+ * xHC and rings its doorbell once.
+ *
+ * @param ctx host context
+ * @param ep_id endpoint address, bit 7 set for IN
+ *
+ * @return TEGRABL_NO_ERROR on success
+ */
+tegrabl_error_t tegrabl_xhci_ring_ep(struct xusb_host_context *ctx, uint8_t ep_id);
+
+/**
+ * @brief Waits for the oldest queued TD to complete and removes it from the
+ * queue. TDs complete in the order they were queued.
+ *
+ * @param ctx host context
+ * @param timeout time to wait in ms, 0 to only poll the event ring
+ * @param actual_length bytes transferred by the TD (may be NULL)
+ *
+ * @return TEGRABL_NO_ERROR if the TD completed successfully,
+ * TEGRABL_ERR_NOT_READY if polling and the TD is still in flight,
+ * TEGRABL_ERR_TIMEOUT on timeout, TEGRABL_ERR_COMMAND_FAILED if the xHC
+ * reported an error (completion code is stashed in ctx->comp_code).
+ */
+tegrabl_error_t tegrabl_xhci_reap_td(struct xusb_host_context *ctx, uint32_t timeout,
+									 uint32_t *actual_length);
+
+/**
+ * @brief Drops all queued TDs. Used after a failed or short TD: both bulk
+ * endpoints are stopped (or reset if halted) and their dequeue pointers set
+ * past the dropped TDs, so none of them can take data meant for a later TD.
+ *
+ * @param ctx host context
+ */
+void tegrabl_xhci_abort_tds(struct xusb_host_context *ctx);
 #endif
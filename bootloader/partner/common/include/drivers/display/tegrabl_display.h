@@ -24,6 +24,24 @@
  */
 tegrabl_error_t tegrabl_display_init(void);
 
+#if defined(CONFIG_ENABLE_DISPLAY_ASYNC_INIT)
+/**
+ *  @brief Initializes the display in a background thread. Clear, printf,
+ *  show_image and set_cursor requests made meanwhile are queued and replayed
+ *  once the display is up; get_params and shutdown wait for it. Falls back
+ *  to tegrabl_display_init() if the thread cannot be created.
+ *
+ *  @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+tegrabl_error_t tegrabl_display_init_async(void);
+
+/**
+ *  @brief Waits until the background init and the replay of queued
+ *  requests are done. Must be called before handing off to the OS.
+ */
+void tegrabl_display_wait_init(void);
+#endif
+
 /**
  *  @brief Prints the given text in given color on display
  *
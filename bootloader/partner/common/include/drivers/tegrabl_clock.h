@@ -83,6 +83,44 @@ tegrabl_error_t tegrabl_car_rst_set(tegrabl_module_t module,
 tegrabl_error_t tegrabl_car_rst_clear(tegrabl_module_t module,
 				      uint8_t instance);
 
+/**
+ * Clock/reset operations accepted by tegrabl_car_run_ops()
+ */
+typedef enum {
+	TEGRABL_CAR_OP_CLK_ENABLE,
+	TEGRABL_CAR_OP_CLK_DISABLE,
+	TEGRABL_CAR_OP_CLK_SET_SRC,	/* arg is a tegrabl_clk_src_id_t */
+	TEGRABL_CAR_OP_CLK_SET_RATE,	/* arg is the rate in KHz */
+	TEGRABL_CAR_OP_RST_SET,
+	TEGRABL_CAR_OP_RST_CLEAR,
+} tegrabl_car_op_type_t;
+
+struct tegrabl_car_op {
+	tegrabl_car_op_type_t type;
+	tegrabl_module_t module;
+	uint8_t instance;
+	uint32_t arg;
+};
+
+/**
+ * @brief Runs a sequence of clock/reset operations in order and stops at the
+ * first failure. Lets the clock driver merge requests that would otherwise
+ * each cost a round-trip to the clock controller firmware.
+ *
+ * @ops - Operations to run
+ * @num_ops - Number of entries in ops
+ * @return - TEGRABL_NO_ERROR if success, error-reason otherwise.
+ */
+tegrabl_error_t tegrabl_car_run_ops(const struct tegrabl_car_op *ops,
+				    uint32_t num_ops);
+
+/**
+ * @brief Forgets any clock state cached by the clock driver. Needs to be
+ * called after changing clocks behind its back, e.g. by power gating a
+ * partition.
+ */
+void tegrabl_car_invalidate_clk_cache(void);
+
 /**
  * @brief - Gets the current clock source of the module
  *
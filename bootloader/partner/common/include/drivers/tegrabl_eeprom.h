@@ -26,6 +26,8 @@
  * @param crc_valid defines whether eeprom has crc field programmed
  * @param data stores the data that is read from eeprom. initialized to null.
  * @param data_valid true if the data from EEPROM is already read, else false
+ * @param hi2c i2c controller of a read started with tegrabl_eeprom_read_start()
+ * @param retries_left retries left for that read
 */
 struct tegrabl_eeprom {
 	char *name;
@@ -36,6 +38,8 @@ struct tegrabl_eeprom {
 	bool crc_valid;
 	uint8_t *data;
 	bool data_valid;
+	struct tegrabl_i2c *hi2c;
+	uint32_t retries_left;
 };
 
 /**
@@ -51,6 +55,30 @@ struct tegrabl_eeprom {
  */
 tegrabl_error_t tegrabl_eeprom_read(struct tegrabl_eeprom *eeprom);
 
+/**
+ * @brief Starts reading the eeprom like tegrabl_eeprom_read() but returns as
+ *        soon as the read is on the bus. Reads of eeproms on different i2c
+ *        controllers can be in flight at the same time.
+ *
+ * @param eeprom object corresponding to the eeprom to be read, as for
+ *               tegrabl_eeprom_read()
+ *
+ * @return TEGRABL_NO_ERROR if the read was started else appropriate error.
+ */
+tegrabl_error_t tegrabl_eeprom_read_start(struct tegrabl_eeprom *eeprom);
+
+/**
+ * @brief Collects data of a read started with tegrabl_eeprom_read_start() and
+ *        verifies it once complete. Does not wait.
+ *
+ * @param eeprom object passed to tegrabl_eeprom_read_start()
+ *
+ * @return TEGRABL_NO_ERROR once the data has been read and verified,
+ *         TEGRABL_ERR_NOT_READY while the read is in progress, else
+ *         appropriate error.
+ */
+tegrabl_error_t tegrabl_eeprom_read_poll(struct tegrabl_eeprom *eeprom);
+
 /**
  * @brief Dumps the contents of EEPROM data structure, and the contents of the
  *		  physical EEPROM. Mostly used for debugging purposes
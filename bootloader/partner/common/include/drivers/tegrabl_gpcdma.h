@@ -14,6 +14,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <tegrabl_timer.h>
 
 /**
  * @brief Defines DMA engines available
@@ -74,6 +75,11 @@ struct tegrabl_dma_xfer_params {
 
 typedef void *tegrabl_gpcdma_handle_t;
 
+/**
+ * @brief Completion marker of an async copy/fill, 0 is always signaled
+ */
+typedef uint64_t tegrabl_dma_fence_t;
+
 /**
  * @brief Returns a opaque handle of the requested DMA type.
  * Once requested, client can use it for multiple DMA transfers.
@@ -173,6 +179,61 @@ int tegrabl_dma_memset(void *priv, void *s, uint32_t c, size_t size);
 void tegrabl_dma_enable_clib_callbacks(tegrabl_dmatype_t dma_type,
 									   size_t threshold);
 
+/*			ASYNC COPY ENGINE			*/
+
+/* Async requests are split in chunks that are spread over a set of GPCDMA
+ * channels reserved for this purpose. The CPU is free to do other work until
+ * it needs the data, but must not touch either buffer before the fence of the
+ * request is signaled. Buffers and sizes that are not word aligned are
+ * (partly) handled on the CPU before returning. */
+
+/**
+ * @brief Starts copying memory using GPCDMA and returns without waiting
+ *
+ * @param dest pointer to destination buffer
+ * @param src pointer to source buffer, must not overlap dest
+ * @param size number of bytes to copy
+ * @param fence set to the fence of the request (may be NULL)
+ *
+ * @return TEGRABL_NO_ERROR if queued
+ */
+tegrabl_error_t tegrabl_dma_memcpy_async(void *dest, const void *src, size_t size,
+										 tegrabl_dma_fence_t *fence);
+
+/**
+ * @brief Starts filling memory using GPCDMA and returns without waiting
+ *
+ * @param s pointer to buffer
+ * @param c value to set each byte with
+ * @param size number of bytes to set
+ * @param fence set to the fence of the request (may be NULL)
+ *
+ * @return TEGRABL_NO_ERROR if queued
+ */
+tegrabl_error_t tegrabl_dma_memset_async(void *s, uint32_t c, size_t size,
+										 tegrabl_dma_fence_t *fence);
+
+/**
+ * @brief Reaps finished transfers, feeds idle channels and checks if the
+ * request of the fence and all requests made before it are done
+ *
+ * @param fence fence of the request
+ *
+ * @return true if done
+ */
+bool tegrabl_dma_fence_signaled(tegrabl_dma_fence_t fence);
+
+/**
+ * @brief Waits for the request of the fence (and all earlier ones) to complete.
+ * On timeout all outstanding requests are cancelled.
+ *
+ * @param fence fence of the request
+ * @param timeout_us time to wait in microseconds
+ *
+ * @return TEGRABL_NO_ERROR if done, TEGRABL_ERR_TIMEOUT otherwise
+ */
+tegrabl_error_t tegrabl_dma_fence_wait(tegrabl_dma_fence_t fence, time_t timeout_us);
+
 /**
  * @brief DRAM Init scrubbing using GPCDMA
  *
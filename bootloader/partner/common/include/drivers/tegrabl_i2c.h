@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2019, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2015-2020, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -17,6 +17,9 @@
 #include <list.h>
 #include <tegrabl_error.h>
 #include <tegrabl_timer.h>
+#if defined(CONFIG_ENABLE_I2C_LOCK)
+#include <kernel/mutex.h>
+#endif
 
 /* macro tegrabl instance i2c */
 typedef uint32_t tegrabl_instance_i2c_t;
@@ -51,6 +54,19 @@ struct tegrabl_i2c {
 	time_t fifo_timeout;
 	time_t byte_xfer_timeout;
 	time_t xfer_timeout;
+	/* State of the read started with tegrabl_i2c_read_start() */
+	bool is_async_busy;
+	uint8_t *async_buf;
+	uint32_t async_len;
+	uint32_t async_pos;
+	uint16_t async_slave_addr;
+	bool async_repeat_start;
+	time_t async_deadline_us;
+#if defined(CONFIG_ENABLE_I2C_LOCK)
+	/* Held for each transfer, and from tegrabl_i2c_read_start() until the
+	 * read completes */
+	mutex_t lock;
+#endif
 };
 
 /**
@@ -128,6 +144,70 @@ tegrabl_error_t tegrabl_i2c_write(struct tegrabl_i2c *hi2c, uint16_t slave_addr,
 tegrabl_error_t tegrabl_i2c_read(struct tegrabl_i2c *hi2c, uint16_t slave_addr,
 	bool repeat_start, void *buf, uint32_t len);
 
+/**
+* @brief Writes the given data with a repeat start and reads back, e.g. a
+* register offset and then the register contents. No other transfer can get
+* on the controller between the two.
+*
+* @param hi2c Handle of the i2c.
+* @param slave_addr Address of the i2c slave.
+* @param wbuf Buffer from which data has to be written.
+* @param wlen Number of bytes to write.
+* @param repeat_start Whether the read ends in a repeat start or not
+* @param buf Buffer to which read data has to be passed.
+* @param len Number of bytes to read.
+*
+* @return TEGRABL_NO_ERROR if success, error code if fails.
+*/
+tegrabl_error_t tegrabl_i2c_write_read(struct tegrabl_i2c *hi2c, uint16_t slave_addr,
+	void *wbuf, uint32_t wlen, bool repeat_start, void *buf, uint32_t len);
+
+/**
+* @brief Starts reading data on the i2c interface and returns without waiting
+* for it. Only one read can be in progress per controller, reads on different
+* controllers run in parallel. tegrabl_i2c_read_poll() completes the read,
+* other threads wait for the controller until then.
+*
+* @param hi2c Handle of the i2c.
+* @param slave_addr Address of the i2c slave.
+* @param repeat_start Whether the repeat start is required or not
+* @param buf Buffer to which read data has to be passed.
+* @param len Number of bytes to read.
+*
+* @return TEGRABL_NO_ERROR if started, TEGRABL_ERR_BUSY if a read is already
+* in progress on the controller, error code if fails.
+*/
+tegrabl_error_t tegrabl_i2c_read_start(struct tegrabl_i2c *hi2c, uint16_t slave_addr,
+	bool repeat_start, void *buf, uint32_t len);
+
+/**
+* @brief Same as tegrabl_i2c_read_start(), preceded by a write that ends in a
+* repeat start, e.g. of the register offset to read from. No other transfer
+* can get on the controller between the two.
+*
+* @param hi2c Handle of the i2c.
+* @param slave_addr Address of the i2c slave.
+* @param wbuf Buffer from which data has to be written.
+* @param wlen Number of bytes to write.
+* @param buf Buffer to which read data has to be passed.
+* @param len Number of bytes to read.
+*
+* @return TEGRABL_NO_ERROR if started, error code if fails.
+*/
+tegrabl_error_t tegrabl_i2c_write_read_start(struct tegrabl_i2c *hi2c, uint16_t slave_addr,
+	void *wbuf, uint32_t wlen, void *buf, uint32_t len);
+
+/**
+* @brief Drains whatever the controller has received for the read started by
+* tegrabl_i2c_read_start(), without waiting.
+*
+* @param hi2c Handle of the i2c.
+*
+* @return TEGRABL_NO_ERROR once the read has completed, TEGRABL_ERR_NOT_READY
+* while it is in progress, error code if it failed.
+*/
+tegrabl_error_t tegrabl_i2c_read_poll(struct tegrabl_i2c *hi2c);
+
 /**
 * @brief Performs the given i2c transactions.
 *
@@ -291,6 +291,7 @@ struct tegrabl_qspi_handle {
 	struct tegrabl_qspi_transfer *req_xfer;
 	uint32_t req_xfer_count;
 	bool cur_xfer_is_dma;
+	bool rx_dma_armed;
 	bool xfer_is_progress;
 	bool is_async;
 	qspi_op_mode_t curr_op_mode;
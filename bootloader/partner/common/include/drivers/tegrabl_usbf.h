@@ -197,6 +197,67 @@ tegrabl_error_t tegrabl_usbf_receive_start(uint8_t *buffer, uint32_t bytes);
 tegrabl_error_t tegrabl_usbf_receive_complete(uint32_t *bytes_received,
 		uint32_t timeout_us);
 
+/**
+ * @brief Completion callback of a queued bulk transfer. Called from
+ * tegrabl_usbf_process_events() once the buffer is owned by the CPU again.
+ *
+ * @param priv caller data passed at queue time.
+ * @param buffer buffer of the request.
+ * @param bytes number of bytes actually transfered.
+ * @param status TEGRABL_NO_ERROR or the failure of the request.
+ */
+typedef void (*tegrabl_usbf_xfer_cb_t)(void *priv, uint8_t *buffer,
+		uint32_t bytes, tegrabl_error_t status);
+
+/**
+ * @brief Queue a receive request on the bulk OUT endpoint and return
+ * immediately. Several requests can be queued, each may span several MB and
+ * they complete in order.
+ *
+ * @param buffer buffer to receive into.
+ *
+ * @param bytes Number of bytes to be received.
+ *
+ * @param cb completion callback, may be NULL.
+ *
+ * @param priv passed to cb.
+ *
+ * @return TEGRABL_NO_ERROR if queued, TEGRABL_ERR_OVERFLOW if the endpoint
+ * ring has no room left. On any other error all requests of the endpoint are
+ * cancelled, as by tegrabl_usbf_queue_cancel().
+ */
+tegrabl_error_t tegrabl_usbf_queue_receive(uint8_t *buffer, uint32_t bytes,
+		tegrabl_usbf_xfer_cb_t cb, void *priv);
+
+/**
+ * @brief Queue a transmit request on the bulk IN endpoint and return
+ * immediately. See tegrabl_usbf_queue_receive().
+ */
+tegrabl_error_t tegrabl_usbf_queue_transmit(uint8_t *buffer, uint32_t bytes,
+		tegrabl_usbf_xfer_cb_t cb, void *priv);
+
+/**
+ * @brief Cancel all requests queued on a bulk endpoint. Their callbacks run
+ * before this returns, with an error status, and the endpoint is restarted
+ * with an empty ring.
+ *
+ * @param is_transmit true for the bulk IN endpoint, false for bulk OUT.
+ *
+ * @return TEGRABL_NO_ERROR if success, error code if the endpoint could not
+ * be restarted.
+ */
+tegrabl_error_t tegrabl_usbf_queue_cancel(bool is_transmit);
+
+/**
+ * @brief Wait for the next batch of controller events and handle them,
+ * running the callbacks of completed requests.
+ *
+ * @param timeout_us Maximum time to wait for an event.
+ *
+ * @return returns the status.
+ */
+tegrabl_error_t tegrabl_usbf_process_events(uint32_t timeout_us);
+
 /**
  * @brief stop the already initialized controller.
  *
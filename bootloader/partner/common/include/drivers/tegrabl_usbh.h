@@ -41,7 +41,17 @@ struct device_request {
 
 };
 
-/* Initialize host controller, clocks and enumerate the device that is atttached */
+/**
+ * @brief Powers up the host controller and enables VBUS without waiting for a
+ * device to connect. Lets callers get the connect time overlapped with other
+ * work, tegrabl_usbh_init() completes the bring-up.
+ *
+ * @return tegrabl error code
+ */
+tegrabl_error_t tegrabl_usbh_init_start(void);
+
+/* Initialize host controller, clocks and enumerate the device that is atttached.
+ * Picks up from tegrabl_usbh_init_start() if that has been called. */
 tegrabl_error_t tegrabl_usbh_init(void);
 
 /**
@@ -90,6 +100,28 @@ tegrabl_error_t tegrabl_usbh_snd_data(uint8_t dev_id, void *buffer, uint32_t *le
  */
 tegrabl_error_t tegrabl_usbh_rcv_data(uint8_t dev_id, void *buffer, uint32_t *length);
 
+/* One bulk transfer of a list handed to tegrabl_usbh_bulk_xfer_list() */
+struct tegrabl_usbh_bulk_xfer {
+	void *buffer;
+	/* bytes to transfer, not 0 */
+	uint32_t length;
+	bool is_in;
+	/* filled in on return, COMP_INVALID if the transfer did not complete */
+	uint32_t actual_length;
+	uint8_t comp_code;
+};
+
+/**
+ * @brief queue a list of bulk transfers to the current device back to back
+ * and wait for them. The controller moves from one transfer to the next on
+ * its own, a short packet only ends the transfer it happens in. A failed
+ * transfer drops the ones queued behind it on the same endpoint.
+ * @param xfers transfers in the order the device handles them
+ * @param num_xfers number of transfers
+ * @return tegrabl error code of the first failed transfer
+ */
+tegrabl_error_t tegrabl_usbh_bulk_xfer_list(struct tegrabl_usbh_bulk_xfer *xfers, uint32_t num_xfers);
+
 struct xusb_host_context *tegrabl_get_usbh_context(void);
 
 tegrabl_error_t tegrabl_xusbh_test_sample(void);
@@ -34,7 +34,11 @@ typedef uint64_t off_t;
 #define TEGRABL_IOCTL_GET_RPMB_WRITE_COUNTER   6U
 #define TEGRABL_IOCTL_BLOCK_DEV_SUSPEND	       7U
 #define TEGRABL_IOCTL_SEND_STATUS		       8U
-#define TEGRABL_IOCTL_INVALID                  9U
+/* args: bool *, set if erased blocks read back as zeroes */
+#define TEGRABL_IOCTL_ERASED_READS_ZERO        9U
+/* args: uint32_t *, smallest erasable unit in bytes */
+#define TEGRABL_IOCTL_ERASE_BLOCK_SIZE         10U
+#define TEGRABL_IOCTL_INVALID                  11U
 
 #define TEGRABL_BLOCKDEV_WRITE			1U
 #define TEGRABL_BLOCKDEV_READ			2U
@@ -187,7 +191,9 @@ tegrabl_error_t tegrabl_blockdev_init(void);
 */
 tegrabl_bdev_t *tegrabl_blockdev_next_device(tegrabl_bdev_t *curr_bdev);
 
-/** @brief Checks and returns the handle of the given device.
+/** @brief Checks and returns the handle of the given device. If the device
+ *         is not registered yet, it is initialized through the deferred init
+ *         callback, if one is set.
  *
  *  @param name String which specifies the name of the
  *              block device
@@ -197,6 +203,34 @@ tegrabl_bdev_t *tegrabl_blockdev_next_device(tegrabl_bdev_t *curr_bdev);
 tegrabl_bdev_t *tegrabl_blockdev_open(tegrabl_storage_type_t storage_type,
 		uint32_t instance);
 
+/** @brief Initializes storage devices whose initialization was deferred.
+ *
+ *  @param storage_type Storage type of the device, TEGRABL_STORAGE_INVALID
+ *                      for all deferred devices
+ *  @param instance Instance of the device, ignored for TEGRABL_STORAGE_INVALID
+ *
+ *  @return TEGRABL_NO_ERROR if at least one device was initialized and
+ *          registered, error code otherwise.
+ */
+typedef tegrabl_error_t (*tegrabl_blockdev_deferred_init_t)(
+		tegrabl_storage_type_t storage_type, uint32_t instance);
+
+/** @brief Sets the callback used to initialize deferred storage devices
+ *
+ *  @param deferred_init Callback, NULL once there are no deferred devices
+ */
+void tegrabl_blockdev_set_deferred_init(tegrabl_blockdev_deferred_init_t deferred_init);
+
+/** @brief Initializes the given deferred storage device(s), see
+ *         tegrabl_blockdev_deferred_init_t.
+ *
+ *  @return TEGRABL_NO_ERROR if at least one device was initialized,
+ *          TEGRABL_ERR_NOT_FOUND if no device was deferred, other error code
+ *          if the initialization failed.
+ */
+tegrabl_error_t tegrabl_blockdev_init_deferred(tegrabl_storage_type_t storage_type,
+		uint32_t instance);
+
 /** @brief Closes the given block device.
  *
  *  @param name String which specifies the name of the
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2014-2016, NVIDIA Corporation.  All Rights Reserved.
+ * Copyright (c) 2014-2020, NVIDIA Corporation.  All Rights Reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property and
  * proprietary rights in and to this software and related documentation.  Any
@@ -23,9 +23,13 @@ extern "C"
 
 #define DECOMP_PAGESIZE (1024 * 32)
 
+/* longest magic ID, bytes of the head to pass to decompress_method */
+#define DECOMP_MAGIC_SIZE 4
+
 typedef struct {
 	/* magic ID for compression algorithm */
-	uint8_t magic[2];
+	uint8_t magic[DECOMP_MAGIC_SIZE];
+	uint32_t magic_len;
 
 	/* name string for compression algorithm */
 	const char *name;
@@ -56,6 +60,37 @@ typedef struct {
 								  uint32_t in_size, void *out_buffer,
 								  uint32_t outbuf_size, uint32_t *written_size);
 
+	/**
+	 * @brief: streaming decompression handler, optional. Can be called
+	 * repeatedly after init, each call continuing where the previous one
+	 * stopped, so that the output never has to be held all at once
+	 *
+	 * @param cntxt: the context returned by init
+	 * @param in_buffer: pointer to the compressed data not consumed yet
+	 * @param in_size: input data size
+	 * @param in_used: input data consumed by this call
+	 * @param out_buffer: pointer to output buffer
+	 * @param outbuf_size: output buffer size
+	 * @param written_size: decompressed data size, no more than outbuf_size
+	 *
+	 * @return SUCCESS or FAILURE. A call that neither consumes input nor
+	 *         produces output has reached the end of the stream
+	 */
+	tegrabl_error_t (*stream)(void *cntxt, void *in_buffer, uint32_t in_size,
+							  uint32_t *in_used, void *out_buffer,
+							  uint32_t outbuf_size, uint32_t *written_size);
+
+	/**
+	 * @brief: end of stream handler, required along with stream. Input that
+	 * runs out before the end of the stream is truncated
+	 *
+	 * @param cntxt: the context returned by init
+	 *
+	 * @return true once the stream handler has consumed the whole compressed
+	 *         stream and handed out all of its output
+	 */
+	bool (*stream_done)(void *cntxt);
+
 	/**
 	 * @brief: function to cleanup and free up resources/context
 	 *
@@ -70,7 +105,7 @@ typedef struct {
  * @brief: get the decompression handle as per magic ID
  *
  * @param c_magic: magic id from compressed file header
- * @param len: length of magic id
+ * @param len: length of magic id, methods with a longer magic id never match
  *
  * @return decompressor: decompression handle pointer, return
  *         NULL if not found any magic matched
@@ -80,7 +115,8 @@ decompressor *decompress_method(uint8_t *c_magic, uint32_t len);
 /**
  * @brief: judge whether content is compressed by magic id
  *
- * @param head_buf: pointer to buffer saving head of content
+ * @param head_buf: pointer to buffer saving head of content, at least
+ *                  DECOMP_MAGIC_SIZE bytes
  * @param pdecomp: pointer to decompressor handler
  *
  * @return true if content is compressed; false otherwise
@@ -104,6 +140,43 @@ tegrabl_error_t do_decompress(decompressor *decomp, uint8_t *read_buffer,
 							  uint32_t read_size, uint8_t *out_buffer,
 							  uint32_t *outbuf_size);
 
+/**
+ * @brief: start a streaming decompression, to be fed through decomp->stream
+ *
+ * @param decomp: decompression handler, must have a stream handler
+ * @param compressed_size: compressed data size (in byte)
+ * @param session: filled with the id to check the context against
+ *
+ * @return context for decomp->stream and decomp->end, NULL on failure
+ */
+void *decompress_stream_start(decompressor *decomp, uint32_t compressed_size,
+							  uint32_t *session);
+
+/**
+ * @brief: check that a stream can be continued. Contexts are shared between
+ * all users of a method, so a stream is over as soon as another stream or
+ * do_decompress() is started with the same method.
+ *
+ * @param decomp: decompression handler the stream was started with
+ * @param session: id returned by decompress_stream_start
+ *
+ * @return true if the context of the session is still intact
+ */
+bool decompress_stream_is_valid(decompressor *decomp, uint32_t session);
+
+/**
+ * @brief: set the dictionary used for zstd frames, the buffer is referenced
+ *         and must stay valid while decompressing. Only present when the
+ *         zstd decompressor is built in.
+ *
+ * @param dict: dictionary (zstd dictionary format or raw content), NULL to
+ *              drop the current one
+ * @param dict_size: size of dict in bytes
+ *
+ * @return TEGRABL_NO_ERROR if success, error code otherwise
+ */
+tegrabl_error_t tegrabl_zstd_load_dict(const void *dict, uint32_t dict_size);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2019, NVIDIA Corporation.  All Rights Reserved.
+ * Copyright (c) 2015-2020, NVIDIA Corporation.  All Rights Reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property and
  * proprietary rights in and to this software and related documentation.  Any
@@ -34,7 +34,11 @@ typedef uint32_t tegrabl_linux_boot_info_t;
 #define TEGRABL_LINUXBOOT_INFO_INITRD 8
 #define TEGRABL_LINUXBOOT_INFO_BOOTIMAGE_CMDLINE 9
 #define TEGRABL_LINUXBOOT_INFO_SECUREOS 10
-#define TEGRABL_LINUXBOOT_INFO_MAX 11
+/* in_data: region index, out_data: struct tegrabl_linuxboot_memblock with the
+ * address/size of a region of platform inputs to the kernel DTB fixups, size
+ * is 0 past the last region */
+#define TEGRABL_LINUXBOOT_INFO_DTB_CACHE_KEY 11
+#define TEGRABL_LINUXBOOT_INFO_MAX 12
 
 /**
  * @brief Helper API (with BL-specific implementation), to extract what information
@@ -121,8 +125,15 @@ struct tegrabl_linuxboot_dtnode_info {
 	 * @return TEGRABL_NO_ERROR in case of success, otherwise appropriate error
 	 */
 	tegrabl_error_t (*fill_dtnode)(void *fdt, int offset);
+	/* flags - TEGRABL_LINUXBOOT_DTNODE_* */
+	uint32_t flags;
 };
 
+/* The node is filled from data that may change on every boot (reset reason,
+ * ramdisk, bootargs, ...). Such nodes are not part of the cached kernel DTB
+ * and are filled again on top of it. */
+#define TEGRABL_LINUXBOOT_DTNODE_PER_BOOT (1U << 0)
+
 /**
  * @brief Type of carveout
  */
@@ -224,11 +235,33 @@ uint32_t get_free_dram_regions_info(struct tegrabl_linuxboot_memblock
 
 #if defined(CONFIG_ENABLE_STAGED_SCRUBBING)
 /**
- * @brief Scrubs the DRAM regions not already scrubbed by early BL
+ * @brief Starts scrubbing the DRAM regions not already scrubbed by early BL
+ * in the background. Scrubs them before returning if the background thread
+ * cannot be created.
  *
  * @return TEGRABL_NO_ERROR if success; relevant error codes in case of failure
  */
 tegrabl_error_t dram_staged_scrub(void);
+
+/**
+ * @brief Moves the given range to the front of the background scrub and
+ * waits until it is scrubbed. Returns immediately if the range was not
+ * pending.
+ *
+ * @param base start address of the range
+ * @param size size of the range
+ *
+ * @return TEGRABL_NO_ERROR if success; relevant error codes in case of failure
+ */
+tegrabl_error_t dram_staged_scrub_range(uint64_t base, uint64_t size);
+
+/**
+ * @brief Waits for the background scrub to finish. Must be called before
+ * handing DRAM over to the OS.
+ *
+ * @return TEGRABL_NO_ERROR if success; relevant error codes in case of failure
+ */
+tegrabl_error_t dram_staged_scrub_wait(void);
 #endif
 
 /**
@@ -241,7 +274,9 @@ tegrabl_error_t dram_staged_scrub(void);
 tegrabl_error_t tegrabl_get_nct_load_addr(void **load_addr);
 
 /**
- * @brief Get boot image load address
+ * @brief Get boot image load address. With CONFIG_ENABLE_KERNEL_INPLACE_DECOMP
+ * this is the tail of the kernel region rather than a heap buffer, and the
+ * boot image is overwritten when the kernel is extracted.
  *
  * @param load_addr ptr to load address of boot image (output)
  *
@@ -291,6 +326,17 @@ uint64_t tegrabl_get_ramdisk_load_addr(void);
  */
 bool tegrabl_do_ratchet_check(uint8_t bin_type, void * const addr);
 
+/**
+ * @brief Get the size of a binary signed with a BCH header, from the header
+ *
+ * @param addr BCH header address
+ * @param size Number of bytes available at addr
+ *
+ * @return size of the header plus payload, 0 if addr does not hold a BCH
+ * header with a single binary
+ */
+uint64_t tegrabl_get_bch_binary_size(void * const addr, uint32_t size);
+
 #if defined(CONFIG_DYNAMIC_LOAD_ADDRESS)
 /**
  * @brief Obtain address from free_dram_block.
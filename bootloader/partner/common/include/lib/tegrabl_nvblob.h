@@ -236,7 +236,9 @@ tegrabl_error_t tegrabl_blob_get_entry(tegrabl_blob_handle bh, uint32_t index,
  * @param data memory-address of the data corresponding to index-th entry,
  *        to be filled,
  *        memory is allocated inside this function, needs to be freed
- *        using blob_close
+ *        using blob_close. For compressed blobs the entry is inflated on
+ *        demand and the data is only valid until the next call
+ *        for the same handle
  * @param size size of the data, to be filled
  *
  * @return TEGRABL_NO_ERROR if successful else appropriate error.
@@ -53,6 +53,8 @@ void tegrabl_unload_bmp_blob(void);
  *        resolution - set by load_bmp_blob).
  *        user of this api should not try to free bmp, as it will be done
  *        by unload_bmp_blob at the end of android_boot
+ *        entries stored as LZ4 frames (with content size) are returned
+ *        decompressed
  *
  * @param img img structure that contains all bmp image properties
  *
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2019, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2015-2020, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -45,10 +45,19 @@ struct tegrabl_partition {
 #if defined(CONFIG_ENABLE_RECOVERY_VERIFY_WRITE)
 /**
  * @brief Stores partition list that are to be verified.
+ *
+ * written_size and written_crc32 track the data written and read back so
+ * far, as long as the partition is written front to back
+ * (verify_contiguous).
  */
 struct verify_list_info {
 	uint64_t size;
 	uint32_t crc32;
+	uint32_t name_hash;
+	uint64_t written_size;
+	uint32_t written_crc32;
+	bool verify_contiguous;
+	bool verify_failed;
 	struct list_node node;
 	char name[MAX_PARTITION_NAME];
 };
@@ -91,6 +100,17 @@ tegrabl_error_t tegrabl_partition_manager_init(void);
  */
 tegrabl_error_t tegrabl_partition_open(const char *partition_name, struct tegrabl_partition *partition);
 
+/**
+ * @brief Opens the partition with the given unique partition GUID, looked up
+ * across all published devices (case-insensitive).
+ *
+ * @param guid GUID string of the partition.
+ * @param partition Handle of the partition.
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error.
+ */
+tegrabl_error_t tegrabl_partition_open_by_guid(const char *guid, struct tegrabl_partition *partition);
+
 /**
  * @brief Looks up the partition name into published partitions of given block device
  * and updates the partition handle.
@@ -145,11 +165,17 @@ tegrabl_error_t tegrabl_partition_read(struct tegrabl_partition *partition,
  * offset from the buffer. Call to this function will be blocked till specified
  * number of bytes are wrote.
  *
+ * With CONFIG_ENABLE_RECOVERY_VERIFY_WRITE, data written to a partition in
+ * the verify list is read back and checked against buf. The read back may
+ * still be in flight on return, a mismatch is then reported by the next
+ * partition call.
+ *
  * @param partition Handle of the partition.
  * @param buf Source buffer containing data.
  * @param num_bytes Number of bytes to write.
  *
- * @return TEGRABL_NO_ERROR if successful else appropriate error.
+ * @return TEGRABL_NO_ERROR if successful, TEGRABL_ERR_VERIFY_FAILED if this
+ * or the previous write did not read back correctly, else appropriate error.
  */
 tegrabl_error_t tegrabl_partition_write(struct tegrabl_partition *partition,
 		const void *buf, size_t num_bytes);
@@ -321,6 +347,10 @@ tegrabl_error_t tegrabl_partition_pt_has_3_levels(bool *info);
  *	@brief Reads back & calculate crc32 for all the partitions
  *	present in verify list, and tally crc32 with the one sent
  *	from host.
+ *
+ *	Writes to a partition in the verify list are already read back
+ *	while flashing (see tegrabl_partition_write()), partitions that
+ *	were written front to back in full are not read again here.
  */
 tegrabl_error_t tegrabl_partition_verify_write(void);
 
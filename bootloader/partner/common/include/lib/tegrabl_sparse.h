@@ -122,6 +122,23 @@ struct tegrabl_unsparse_state {
 	 * appropriate error.
 	 */
 	tegrabl_error_t (*seeker)(uint64_t size, void *aux_info);
+
+	/**
+	 * @brief Optional handle of function which fills the next size bytes
+	 * with fill_value for a fill chunk, e.g. by erasing for zero fills or
+	 * with large writes of a pattern buffer. Must advance the offset like
+	 * writer does.
+	 *
+	 * @param fill_value 32-bit value to be repeated
+	 * @param size Bytes to fill from current location.
+	 * @param aux_info Auxiliary information passed.
+	 *
+	 * @return TEGRABL_NO_ERROR if successful, TEGRABL_ERR_NOT_SUPPORTED
+	 * (nothing written) to fill through writer instead, else appropriate
+	 * error.
+	 */
+	tegrabl_error_t (*filler)(uint32_t fill_value, uint64_t size,
+			void *aux_info);
 };
 
 struct tegrabl_sparse_state {
@@ -169,6 +186,21 @@ tegrabl_error_t tegrabl_sparse_init_unsparse_state(
 			void *aux_info),
 		tegrabl_error_t (*seeker)(uint64_t size, void *aux_info));
 
+/**
+ * @brief Registers an optional fill handler with the unsparse machine, fill
+ * chunks are written through writer if none is registered.
+ *
+ * @param unsparse_state State initialized by
+ * tegrabl_sparse_init_unsparse_state().
+ * @param filler Handle of function which fills the destination.
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error code.
+ */
+tegrabl_error_t tegrabl_sparse_set_unsparse_filler(
+		struct tegrabl_unsparse_state *unsparse_state,
+		tegrabl_error_t (*filler)(uint32_t fill_value, uint64_t size,
+			void *aux_info));
+
 /**
  * @brief Unsparses the current buffer based on state.
  *
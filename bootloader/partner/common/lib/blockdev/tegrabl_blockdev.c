@@ -47,6 +47,7 @@
 #include <tegrabl_compiler.h>
 
 static struct tegrabl_bdev_struct *bdevs;
+static tegrabl_blockdev_deferred_init_t bdev_deferred_init;
 
 #if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
 static uint32_t	xfer_id;
@@ -376,11 +377,31 @@ fail:
 	return error;
 }
 
+static tegrabl_bdev_t *blockdev_find(uint32_t device_id)
+{
+	tegrabl_bdev_t *bdev = NULL;
+	tegrabl_bdev_t *entry;
+
+	/* see if it's in our list */
+	list_for_every_entry(&bdevs->list, entry, tegrabl_bdev_t, node) {
+		if (entry->ref <= 0U) {
+			bdev = NULL;
+			break;
+		}
+		if (entry->device_id == device_id) {
+			bdev = entry;
+			bdev_inc_ref(bdev);
+			break;
+		}
+	}
+
+	return bdev;
+}
+
 tegrabl_bdev_t *tegrabl_blockdev_open(tegrabl_storage_type_t storage_type,
 		uint32_t instance)
 {
 	tegrabl_bdev_t *bdev = NULL;
-	tegrabl_bdev_t *entry;
 	uint32_t device_id;
 
 	if (storage_type >= TEGRABL_STORAGE_INVALID) {
@@ -392,17 +413,10 @@ tegrabl_bdev_t *tegrabl_blockdev_open(tegrabl_storage_type_t storage_type,
 
 	device_id = TEGRABL_BLOCK_DEVICE_ID(storage_type, instance);
 
-	/* see if it's in our list */
-	list_for_every_entry(&bdevs->list, entry, tegrabl_bdev_t, node) {
-		if (entry->ref <= 0U) {
-			bdev = NULL;
-			goto fail;
-		}
-		if (entry->device_id == device_id) {
-			bdev = entry;
-			bdev_inc_ref(bdev);
-			break;
-		}
+	bdev = blockdev_find(device_id);
+	if ((bdev == NULL) &&
+		(tegrabl_blockdev_init_deferred(storage_type, instance) == TEGRABL_NO_ERROR)) {
+		bdev = blockdev_find(device_id);
 	}
 
 fail:
@@ -412,6 +426,21 @@ fail:
 	return bdev;
 }
 
+void tegrabl_blockdev_set_deferred_init(tegrabl_blockdev_deferred_init_t deferred_init)
+{
+	bdev_deferred_init = deferred_init;
+}
+
+tegrabl_error_t tegrabl_blockdev_init_deferred(tegrabl_storage_type_t storage_type,
+		uint32_t instance)
+{
+	if (bdev_deferred_init == NULL) {
+		return TEGRABL_ERROR(TEGRABL_ERR_NOT_FOUND, 0);
+	}
+
+	return bdev_deferred_init(storage_type, instance);
+}
+
 tegrabl_bdev_t *tegrabl_blockdev_next_device(tegrabl_bdev_t *curr_bdev)
 {
 	tegrabl_bdev_t *next_bdev = NULL;
@@ -0,0 +1,394 @@
+/*
+ * Copyright (c) 2020, NVIDIA Corporation.  All Rights Reserved.
+ *
+ * NVIDIA Corporation and its licensors retain all intellectual property and
+ * proprietary rights in and to this software and related documentation.  Any
+ * use, reproduction, disclosure or distribution of this software and related
+ * documentation without an express license agreement from NVIDIA Corporation
+ * is strictly prohibited.
+ */
+
+#define MODULE TEGRABL_ERR_BOOTLOADER_UPDATE
+
+#include "build_config.h"
+
+#if defined(CONFIG_ENABLE_BL_UPDATE_DIFF)
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <tegrabl_error.h>
+#include <tegrabl_debug.h>
+#include <tegrabl_utils.h>
+#include <tegrabl_malloc.h>
+#include <tegrabl_blockdev.h>
+#include <tegrabl_partition_manager.h>
+#include <mincrypt/sha256.h>
+#include <bl_update_diff.h>
+
+#define BL_UPDATE_MANIFEST_MAGIC 0x464E4D42U /* "BMNF" */
+#define BL_UPDATE_MANIFEST_VERSION 1U
+#define BL_UPDATE_MANIFEST_MAX_ENTRIES 64U
+#define BL_UPDATE_PART_NAME_LEN 36U
+
+/* Compare granularity when the device has no erase blocks or does not
+ * report their size */
+#define BL_UPDATE_DEFAULT_REGION_SIZE (64U * 1024U)
+
+#define BL_UPDATE_ERASED_BYTE 0xFFU
+
+struct bl_update_manifest_entry {
+	char name[BL_UPDATE_PART_NAME_LEN];
+	uint32_t size;
+	uint8_t digest[SHA256_DIGEST_SIZE];
+};
+
+struct bl_update_manifest {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t num_entries;
+	uint32_t crc;
+	struct bl_update_manifest_entry entries[BL_UPDATE_MANIFEST_MAX_ENTRIES];
+};
+
+static struct bl_update_manifest manifest;
+/* The manifest partition exists */
+static bool manifest_present;
+/* The manifest partition holds a valid manifest */
+static bool manifest_on_flash;
+/* The in-memory manifest has entries not yet saved */
+static bool manifest_dirty;
+
+static tegrabl_error_t manifest_write(void *buf, uint32_t size)
+{
+	struct tegrabl_partition part;
+	tegrabl_error_t err;
+
+	err = tegrabl_partition_open(BL_UPDATE_MANIFEST_PARTITION_NAME, &part);
+	if (err != TEGRABL_NO_ERROR) {
+		return err;
+	}
+
+#if defined(CONFIG_ENABLE_QSPI)
+	if (tegrabl_blockdev_get_storage_type(part.block_device) == TEGRABL_STORAGE_QSPI_FLASH) {
+		err = tegrabl_partition_erase(&part, false);
+		if (err != TEGRABL_NO_ERROR) {
+			goto done;
+		}
+	}
+#endif
+
+	err = tegrabl_partition_write(&part, buf, size);
+
+done:
+	tegrabl_partition_close(&part);
+	return err;
+}
+
+static uint32_t manifest_crc(void)
+{
+	return tegrabl_utils_crc32(0, manifest.entries,
+							   manifest.num_entries * sizeof(manifest.entries[0]));
+}
+
+static struct bl_update_manifest_entry *manifest_find(const char *part_name)
+{
+	uint32_t i;
+
+	for (i = 0; i < manifest.num_entries; i++) {
+		if (!strncmp(manifest.entries[i].name, part_name, BL_UPDATE_PART_NAME_LEN)) {
+			return &manifest.entries[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Drops the entry of a partition about to be modified. The copy on flash is
+ * invalidated first, so that a write cut short by a reset can never be taken
+ * for the recorded image. */
+/* Must succeed before the partition is touched, a manifest left on flash
+ * could otherwise vouch for a partly written image after a reset */
+static tegrabl_error_t manifest_forget(const char *part_name)
+{
+	struct bl_update_manifest_entry *entry;
+	uint32_t header[4];
+	tegrabl_error_t err;
+
+	if (manifest_on_flash) {
+		memset(header, 0, sizeof(header));
+		err = manifest_write(header, sizeof(header));
+		if (err != TEGRABL_NO_ERROR) {
+			pr_error("Failed to invalidate %s\n", BL_UPDATE_MANIFEST_PARTITION_NAME);
+			return err;
+		}
+		manifest_on_flash = false;
+		manifest_dirty = true;
+	}
+
+	entry = manifest_find(part_name);
+	if (entry == NULL) {
+		return TEGRABL_NO_ERROR;
+	}
+
+	manifest.num_entries--;
+	memmove(entry, entry + 1,
+			(uintptr_t)&manifest.entries[manifest.num_entries] - (uintptr_t)entry);
+	manifest_dirty = true;
+
+	return TEGRABL_NO_ERROR;
+}
+
+static void manifest_record(const char *part_name, uint32_t size, const uint8_t *digest)
+{
+	struct bl_update_manifest_entry *entry;
+
+	entry = manifest_find(part_name);
+	if (entry == NULL) {
+		if (manifest.num_entries == BL_UPDATE_MANIFEST_MAX_ENTRIES) {
+			return;
+		}
+		entry = &manifest.entries[manifest.num_entries++];
+		memset(entry, 0, sizeof(*entry));
+		strncpy(entry->name, part_name, BL_UPDATE_PART_NAME_LEN - 1U);
+	} else if ((entry->size == size) &&
+			   (memcmp(entry->digest, digest, SHA256_DIGEST_SIZE) == 0)) {
+		return;
+	}
+
+	entry->size = size;
+	memcpy(entry->digest, digest, SHA256_DIGEST_SIZE);
+	manifest_dirty = true;
+}
+
+void tegrabl_bl_update_diff_begin(void)
+{
+	struct tegrabl_partition part;
+	tegrabl_error_t err;
+
+	memset(&manifest, 0, sizeof(manifest));
+	manifest_present = false;
+	manifest_on_flash = false;
+	manifest_dirty = false;
+
+	err = tegrabl_partition_open(BL_UPDATE_MANIFEST_PARTITION_NAME, &part);
+	if (err != TEGRABL_NO_ERROR) {
+		return;
+	}
+	manifest_present = true;
+
+	if (tegrabl_partition_size(&part) < sizeof(manifest)) {
+		pr_warn("%s is too small\n", BL_UPDATE_MANIFEST_PARTITION_NAME);
+		manifest_present = false;
+		goto done;
+	}
+
+	err = tegrabl_partition_read(&part, &manifest, sizeof(manifest));
+	if ((err != TEGRABL_NO_ERROR) ||
+		(manifest.magic != BL_UPDATE_MANIFEST_MAGIC) ||
+		(manifest.version != BL_UPDATE_MANIFEST_VERSION) ||
+		(manifest.num_entries > BL_UPDATE_MANIFEST_MAX_ENTRIES) ||
+		(manifest.crc != manifest_crc())) {
+		pr_info("%s is not valid, comparing all partitions\n",
+				BL_UPDATE_MANIFEST_PARTITION_NAME);
+		memset(&manifest, 0, sizeof(manifest));
+		goto done;
+	}
+
+	manifest_on_flash = true;
+
+done:
+	tegrabl_partition_close(&part);
+}
+
+void tegrabl_bl_update_diff_end(void)
+{
+	tegrabl_error_t err;
+
+	if (!manifest_present || !manifest_dirty) {
+		return;
+	}
+	manifest_dirty = false;
+
+	manifest.magic = BL_UPDATE_MANIFEST_MAGIC;
+	manifest.version = BL_UPDATE_MANIFEST_VERSION;
+	manifest.crc = manifest_crc();
+
+	err = manifest_write(&manifest, sizeof(manifest));
+	if (err != TEGRABL_NO_ERROR) {
+		pr_warn("Failed to save %s (err=%x)\n", BL_UPDATE_MANIFEST_PARTITION_NAME, err);
+		return;
+	}
+	manifest_on_flash = true;
+}
+
+static bool is_erased(const uint8_t *buf, uint32_t size)
+{
+	uint32_t i;
+
+	for (i = 0; i < size; i++) {
+		if (buf[i] != BL_UPDATE_ERASED_BYTE) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Reads back len bytes at offset into buf and checks that they start with
+ * data and, past data_len, are erased */
+static tegrabl_error_t region_matches(struct tegrabl_partition *part, uint64_t offset,
+									  uint8_t *buf, uint32_t len,
+									  const uint8_t *data, uint32_t data_len,
+									  bool *match)
+{
+	tegrabl_error_t err;
+
+	*match = false;
+
+	err = tegrabl_partition_seek(part, (int64_t)offset, TEGRABL_PARTITION_SEEK_SET);
+	if (err != TEGRABL_NO_ERROR) {
+		return err;
+	}
+	err = tegrabl_partition_read(part, buf, len);
+	if (err != TEGRABL_NO_ERROR) {
+		return err;
+	}
+
+	*match = (memcmp(buf, data, data_len) == 0) &&
+			 is_erased(buf + data_len, len - data_len);
+
+	return TEGRABL_NO_ERROR;
+}
+
+static uint32_t get_region_size(tegrabl_bdev_t *bdev)
+{
+	uint32_t size = 0;
+
+	if ((tegrabl_blockdev_ioctl(bdev, TEGRABL_IOCTL_ERASE_BLOCK_SIZE, &size) != TEGRABL_NO_ERROR) ||
+		(size < TEGRABL_BLOCKDEV_BLOCK_SIZE(bdev)) || ((size & (size - 1U)) != 0U)) {
+		size = BL_UPDATE_DEFAULT_REGION_SIZE;
+	}
+
+	return size;
+}
+
+tegrabl_error_t tegrabl_bl_update_diff_write(struct tegrabl_partition *part,
+											 const char *part_name,
+											 uint8_t *data, uint32_t size)
+{
+	tegrabl_bdev_t *bdev = part->block_device;
+	struct bl_update_manifest_entry *entry;
+	uint8_t digest[SHA256_DIGEST_SIZE];
+	uint64_t part_size = tegrabl_partition_size(part);
+	uint64_t end = size;
+	uint64_t offset;
+	uint32_t region_size;
+	uint32_t block_size_log2 = TEGRABL_BLOCKDEV_BLOCK_SIZE_LOG2(bdev);
+	uint32_t len;
+	uint32_t data_len;
+	uint32_t num_regions = 0;
+	uint32_t num_written = 0;
+	uint8_t *buf = NULL;
+	bool is_qspi = false;
+	bool modified = false;
+	bool match = false;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	if (size > part_size) {
+		pr_error("%s: image (%u bytes) does not fit the partition\n", part_name, size);
+		err = TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 0);
+		goto done;
+	}
+
+	region_size = BL_UPDATE_DEFAULT_REGION_SIZE;
+#if defined(CONFIG_ENABLE_QSPI)
+	if (tegrabl_blockdev_get_storage_type(bdev) == TEGRABL_STORAGE_QSPI_FLASH) {
+		is_qspi = true;
+		region_size = get_region_size(bdev);
+		/* The rest of the partition was erased before the image was written */
+		end = part_size;
+	}
+#endif
+
+	buf = tegrabl_memalign(TEGRABL_BLOCKDEV_MEM_ALIGN_SIZE, region_size);
+	if (buf == NULL) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
+		goto done;
+	}
+
+	sha256_hash(data, (int)size, digest);
+
+	entry = manifest_find(part_name);
+	if ((entry != NULL) && (entry->size == size) &&
+		(memcmp(entry->digest, digest, SHA256_DIGEST_SIZE) == 0)) {
+		/* Catches partitions reflashed without going through an update */
+		len = (uint32_t)MIN((uint64_t)region_size, end);
+		err = region_matches(part, 0, buf, len, data, MIN(len, size), &match);
+		if (err != TEGRABL_NO_ERROR) {
+			goto done;
+		}
+		if (match) {
+			pr_info("%s is up to date\n", part_name);
+			goto done;
+		}
+	}
+
+	for (offset = 0; offset < end; offset += len) {
+		len = (uint32_t)MIN((uint64_t)region_size, end - offset);
+		data_len = (offset < size) ? (uint32_t)MIN((uint64_t)len, size - offset) : 0U;
+		num_regions++;
+
+		err = region_matches(part, offset, buf, len, data + offset, data_len, &match);
+		if (err != TEGRABL_NO_ERROR) {
+			goto done;
+		}
+		if (match) {
+			continue;
+		}
+
+		if (!modified) {
+			err = manifest_forget(part_name);
+			if (err != TEGRABL_NO_ERROR) {
+				goto done;
+			}
+			modified = true;
+		}
+
+		if (is_qspi) {
+			err = tegrabl_blockdev_erase(bdev,
+						(bnum_t)(part->partition_info->start_sector + (offset >> block_size_log2)),
+						(bnum_t)(len >> block_size_log2), false);
+			if (err != TEGRABL_NO_ERROR) {
+				goto done;
+			}
+		}
+
+		if (data_len != 0U) {
+			err = tegrabl_partition_seek(part, (int64_t)offset, TEGRABL_PARTITION_SEEK_SET);
+			if (err != TEGRABL_NO_ERROR) {
+				goto done;
+			}
+			err = tegrabl_partition_write(part, data + offset, data_len);
+			if (err != TEGRABL_NO_ERROR) {
+				goto done;
+			}
+		}
+		num_written++;
+	}
+
+	pr_info("%s: rewrote %u of %u regions\n", part_name, num_written, num_regions);
+
+	manifest_record(part_name, size, digest);
+
+done:
+	if (buf != NULL) {
+		tegrabl_free(buf);
+	}
+	if (err != TEGRABL_NO_ERROR) {
+		TEGRABL_SET_HIGHEST_MODULE(err);
+	}
+	return err;
+}
+
+#endif /* CONFIG_ENABLE_BL_UPDATE_DIFF */
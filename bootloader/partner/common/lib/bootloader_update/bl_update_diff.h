@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2020, NVIDIA Corporation.  All Rights Reserved.
+ *
+ * NVIDIA Corporation and its licensors retain all intellectual property and
+ * proprietary rights in and to this software and related documentation.  Any
+ * use, reproduction, disclosure or distribution of this software and related
+ * documentation without an express license agreement from NVIDIA Corporation
+ * is strictly prohibited.
+ */
+
+#ifndef INCLUDED_BL_UPDATE_DIFF_H
+#define INCLUDED_BL_UPDATE_DIFF_H
+
+#if defined(CONFIG_ENABLE_BL_UPDATE_DIFF)
+
+#include <stdint.h>
+#include <tegrabl_error.h>
+#include <tegrabl_partition_manager.h>
+
+/* Optional partition holding the size and digest of the image last written
+ * to each partition by a payload update */
+#define BL_UPDATE_MANIFEST_PARTITION_NAME "bl-update-manifest"
+
+/**
+ * @brief Loads the manifest, if the manifest partition exists. Called once
+ * at the start of a payload update.
+ */
+void tegrabl_bl_update_diff_begin(void);
+
+/**
+ * @brief Saves the manifest if any partition was recorded since
+ * tegrabl_bl_update_diff_begin(). Called once at the end of a payload
+ * update, also when it failed.
+ */
+void tegrabl_bl_update_diff_end(void);
+
+/**
+ * @brief Writes data to the partition, touching only the erase blocks whose
+ * contents differ. Leaves the partition in the same state as erasing it and
+ * writing data: on QSPI everything past data reads back erased.
+ *
+ * Partitions whose manifest entry matches data are skipped after checking
+ * the first erase block only.
+ *
+ * @param part opened partition, the offset is not preserved
+ * @param part_name name of the partition, used as the manifest key
+ * @param data image to write
+ * @param size size of data
+ *
+ * @return TEGRABL_NO_ERROR if the partition holds data on return
+ */
+tegrabl_error_t tegrabl_bl_update_diff_write(struct tegrabl_partition *part,
+											 const char *part_name,
+											 uint8_t *data, uint32_t size);
+
+#endif /* CONFIG_ENABLE_BL_UPDATE_DIFF */
+
+#endif /* INCLUDED_BL_UPDATE_DIFF_H */
@@ -20,4 +20,13 @@ GLOBAL_INCLUDES += \
 MODULE_SRCS += \
 	$(LOCAL_DIR)/tegrabl_bootloader_update.c
 
+# rewrite only the erase blocks that change
+MODULE_DEFINES += CONFIG_ENABLE_BL_UPDATE_DIFF=1
+
+MODULE_DEPS += \
+	$(LOCAL_DIR)/../external/mincrypt
+
+MODULE_SRCS += \
+	$(LOCAL_DIR)/bl_update_diff.c
+
 include make/module.mk
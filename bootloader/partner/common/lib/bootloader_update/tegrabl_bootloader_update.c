@@ -21,6 +21,7 @@
 #include <tegrabl_brbct.h>
 #include <tegrabl_nct.h>
 #include <tegrabl_fuse.h>
+#include <bl_update_diff.h>
 
 #define GPT_PART_NAME_LEN			36
 
@@ -235,6 +236,15 @@ static tegrabl_error_t write_partition(const char *part_name, uint8_t *data,
 	if (status != TEGRABL_NO_ERROR) {
 		goto end;
 	}
+#if defined(CONFIG_ENABLE_BL_UPDATE_DIFF)
+	/* BCT goes through update_bct, which lays out the copies itself */
+	if (strncmp(part_name, BR_BCT_PARTITION_NAME, strlen(BR_BCT_PARTITION_NAME)) ||
+		(callbacks.update_bct == NULL)) {
+		status = tegrabl_bl_update_diff_write(&part, part_name, data, size);
+		tegrabl_partition_close(&part);
+		goto end;
+	}
+#endif
 #if defined(CONFIG_ENABLE_QSPI)
 	uint32_t storage_type;
 
@@ -391,7 +401,7 @@ static tegrabl_error_t update_partition(tegrabl_blob_handle bh,
 			goto end;
 		}
 
-#if defined(CONFIG_ENABLE_QSPI)
+#if defined(CONFIG_ENABLE_QSPI) && !defined(CONFIG_ENABLE_BL_UPDATE_DIFF)
 	uint32_t storage_type;
 	struct tegrabl_partition part;
 	status = tegrabl_partition_open(entry->partname, &part);
@@ -549,6 +559,10 @@ tegrabl_error_t tegrabl_check_and_update_bl_payload(void *buff, uint32_t size,
 		goto end;
 	}
 
+#if defined(CONFIG_ENABLE_BL_UPDATE_DIFF)
+	tegrabl_bl_update_diff_begin();
+#endif
+
 	for (i = 0; i < num_entries; i++) {
 		status = tegrabl_blob_get_entry(bh, i, (void *)&entry);
 		if (status != TEGRABL_NO_ERROR)
@@ -578,6 +592,11 @@ tegrabl_error_t tegrabl_check_and_update_bl_payload(void *buff, uint32_t size,
 	pr_info("Successfully updated partitions from payload\n");
 
 end:
+#if defined(CONFIG_ENABLE_BL_UPDATE_DIFF)
+	/* Also after a failure, for the partitions that did get updated */
+	tegrabl_bl_update_diff_end();
+#endif
+
 	pr_info("clear list\n");
 	current = list;
 	while (current) {
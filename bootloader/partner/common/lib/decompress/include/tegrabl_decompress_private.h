@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016 - 2017, NVIDIA Corporation.  All Rights Reserved.
+ * Copyright (c) 2016 - 2020, NVIDIA Corporation.  All Rights Reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property and
  * proprietary rights in and to this software and related documentation.  Any
@@ -27,6 +27,14 @@ tegrabl_error_t zlib_decompress(void *cntxt, void *in_buffer, uint32_t in_size,
 								void *out_buffer, uint32_t outbuf_size,
 								uint32_t *written_size);
 
+/* zlib algo streaming decompress api */
+tegrabl_error_t zlib_stream(void *cntxt, void *in_buffer, uint32_t in_size,
+							uint32_t *in_used, void *out_buffer,
+							uint32_t outbuf_size, uint32_t *written_size);
+
+/* zlib algo end of stream api */
+bool zlib_stream_done(void *cntxt);
+
 /* zlib algo clean up api */
 tegrabl_error_t zlib_end(void *cntxt);
 #endif
@@ -45,10 +53,48 @@ tegrabl_error_t do_lzf_decompress(void *cntxt, void *in_buffer,
 
 
 #ifdef CONFIG_ENABLE_LZ4
+/* lz4 algo context initialization, only needed for streaming */
+void *lz4_init(uint32_t compressed_size);
+
 /* lz4 algo decompress api */
 tegrabl_error_t do_lz4_decompress(void *cntxt, void *in_buffer,
 								  uint32_t in_size, void *out_buffer,
 								  uint32_t outbuf_size, uint32_t *written_size);
+
+/* lz4 algo streaming decompress api, blocks are decoded once they are
+ * entirely in the input */
+tegrabl_error_t lz4_stream(void *cntxt, void *in_buffer, uint32_t in_size,
+						   uint32_t *in_used, void *out_buffer,
+						   uint32_t outbuf_size, uint32_t *written_size);
+
+/* lz4 algo end of stream api, the legacy format ends with its input */
+bool lz4_stream_done(void *cntxt);
+
+/* lz4 algo clean up api */
+tegrabl_error_t lz4_end(void *cntxt);
+#endif
+
+
+/* zstd decompressor APIs */
+#ifdef CONFIG_ENABLE_ZSTD
+/* zstd algo context initialization */
+void *zstd_init(uint32_t compressed_size);
+
+/* zstd algo decompress api */
+tegrabl_error_t zstd_decompress(void *cntxt, void *in_buffer, uint32_t in_size,
+								void *out_buffer, uint32_t outbuf_size,
+								uint32_t *written_size);
+
+/* zstd algo streaming decompress api */
+tegrabl_error_t zstd_stream(void *cntxt, void *in_buffer, uint32_t in_size,
+							uint32_t *in_used, void *out_buffer,
+							uint32_t outbuf_size, uint32_t *written_size);
+
+/* zstd algo end of stream api */
+bool zstd_stream_done(void *cntxt);
+
+/* zstd algo clean up api */
+tegrabl_error_t zstd_end(void *cntxt);
 #endif
 
 #endif
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2017, NVIDIA Corporation.  All Rights Reserved.
+ * Copyright (c) 2016-2020, NVIDIA Corporation.  All Rights Reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property and
  * proprietary rights in and to this software and related documentation.  Any
@@ -17,28 +17,51 @@
 
 #include "tegrabl_decompress_private.h"
 
-#define ADD_METHOD(_name, _magic1, _magic2, _init, _decompress, _end)	\
+#define ADD_METHOD(_name, _magic, _init, _decompress, _stream,			\
+				   _stream_done, _end)									\
 {																		\
 	.name = _name,														\
-	.magic = {_magic1, _magic2},										\
+	.magic = _magic,													\
+	.magic_len = sizeof(_magic) - 1U,									\
 	.init = _init,														\
 	.decompress = _decompress,											\
+	.stream = _stream,													\
+	.stream_done = _stream_done,										\
 	.end = _end,														\
 }
 
 static decompressor decompressor_list[] = {
 #ifdef CONFIG_ENABLE_ZLIB
-	ADD_METHOD("zlib", 0x1f, 0x8b, zlib_init, zlib_decompress, zlib_end),
+	ADD_METHOD("zlib", "\x1f\x8b", zlib_init, zlib_decompress, zlib_stream,
+			   zlib_stream_done, zlib_end),
 #endif
 #ifdef CONFIG_ENABLE_LZF
-	ADD_METHOD("lzf", 'Z', 'V', lzf_init, do_lzf_decompress, NULL),
+	ADD_METHOD("lzf", "ZV", lzf_init, do_lzf_decompress, NULL, NULL,
+			   NULL),
 #endif
 #ifdef CONFIG_ENABLE_LZ4
-	ADD_METHOD("lz4-legacy", 0x02, 0x21, NULL, do_lz4_decompress, NULL),
-	ADD_METHOD("lz4", 0x04, 0x22, NULL, do_lz4_decompress, NULL),
+	ADD_METHOD("lz4-legacy", "\x02\x21\x4c\x18", lz4_init, do_lz4_decompress,
+			   lz4_stream, lz4_stream_done, lz4_end),
+	ADD_METHOD("lz4", "\x04\x22\x4d\x18", lz4_init, do_lz4_decompress,
+			   lz4_stream, lz4_stream_done, lz4_end),
+#endif
+#ifdef CONFIG_ENABLE_ZSTD
+	ADD_METHOD("zstd", "\x28\xb5\x2f\xfd", zstd_init, zstd_decompress,
+			   zstd_stream, zstd_stream_done, zstd_end),
 #endif
 };
 
+/* Each method has a single shared context, so initializing a method ends the
+ * stream that was started before with the same method */
+static uint32_t decompress_session[ARRAY_SIZE(decompressor_list)];
+
+static void *decompress_init(decompressor *decomp, uint32_t compressed_size)
+{
+	decompress_session[decomp - decompressor_list]++;
+
+	return decomp->init(compressed_size);
+}
+
 decompressor *decompress_method(uint8_t *c_magic, uint32_t len)
 {
 	decompressor dc;
@@ -52,7 +75,8 @@ decompressor *decompress_method(uint8_t *c_magic, uint32_t len)
 	/* search the decompression handler, exit at first match */
 	for (id = 0; id < (int32_t)ARRAY_SIZE(decompressor_list); id++) {
 		dc = decompressor_list[id];
-		if ((dc.magic[0] == c_magic[0]) && (dc.magic[1] == c_magic[1])) {
+		if ((dc.magic_len <= len) &&
+			(memcmp(dc.magic, c_magic, dc.magic_len) == 0)) {
 			pr_debug("Decompressor handler found\n");
 			return &decompressor_list[id];
 		}
@@ -70,7 +94,7 @@ bool is_compressed_content(uint8_t *head_buf, decompressor **pdecomp)
 	pr_debug("magic id:%02x %02x\n", *head_buf, *(head_buf + 1));
 
 	/* get decompression handler */
-	decomp = decompress_method(head_buf, 2);
+	decomp = decompress_method(head_buf, DECOMP_MAGIC_SIZE);
 	if (!decomp) {
 		pr_info("decompressor handler not found\n");
 	} else {
@@ -98,7 +122,7 @@ tegrabl_error_t do_decompress(decompressor *decomp, uint8_t *read_buffer,
 			pr_critical("Decompressor init api not found\n");
 			return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
 		}
-		context = decomp->init(read_size);
+		context = decompress_init(decomp, read_size);
 		if (!context) {
 			pr_critical("Decompressor init failed\n");
 			return TEGRABL_ERROR(TEGRABL_ERR_INIT_FAILED, 0);
@@ -117,8 +141,8 @@ tegrabl_error_t do_decompress(decompressor *decomp, uint8_t *read_buffer,
 		return err;
 	}
 
-	/* call decompressor cleanup */
-	if (decomp->end) {
+	/* call decompressor cleanup, lz4 has no context outside of streaming */
+	if (decomp->end && context) {
 		decomp->end(context);
 	}
 
@@ -130,3 +154,27 @@ tegrabl_error_t do_decompress(decompressor *decomp, uint8_t *read_buffer,
 	return err;
 }
 
+void *decompress_stream_start(decompressor *decomp, uint32_t compressed_size,
+							  uint32_t *session)
+{
+	void *context;
+
+	if ((decomp->init == NULL) || (decomp->stream == NULL) ||
+		(decomp->stream_done == NULL)) {
+		return NULL;
+	}
+
+	context = decompress_init(decomp, compressed_size);
+	if (context == NULL) {
+		pr_critical("Decompressor init failed\n");
+		return NULL;
+	}
+	*session = decompress_session[decomp - decompressor_list];
+
+	return context;
+}
+
+bool decompress_stream_is_valid(decompressor *decomp, uint32_t session)
+{
+	return session == decompress_session[decomp - decompressor_list];
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2017, NVIDIA Corporation.  All rights reserved.
+ * Copyright (c) 2016-2020, NVIDIA Corporation.  All rights reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property
  * and proprietary rights in and to this software and related documentation
@@ -22,6 +22,8 @@
 #define CONTENT_SIZE_FALG_MASK		(0x1<<3)
 #define BLOCK_CHECKSUM_FLAG_MASK	(0x1<<4)
 #define BLOCK_INDEP_FLAG_MASK		(0x1<<5)
+/* frame format only, the block is stored as is */
+#define BLOCK_UNCOMPRESSED_MASK		(0x1U<<31)
 
 #define MAGIC_NUMBER_SZ				(4)
 #define ORIGINAL_CONTENT_SZ			(8)
@@ -31,6 +33,29 @@
 #define BLOCK_MAX_SIZE_MASK			(0x7<<4)
 #define BLOCK_MAX_SIZE_SHIFT		(4)
 
+#define FRAME_HEADER_SZ				(3)
+#define LEGACY_BLOCK_MAX_SIZE		(8 * 1024 * 1024)
+
+#define LZ4_STREAM_HEADER			0
+#define LZ4_STREAM_BLOCKS			1
+#define LZ4_STREAM_DONE				2
+
+/* NOTE Like the zlib context, only one stream at a time */
+struct lz4_context {
+	uint32_t state;
+	bool legacy;
+	bool block_has_csum;
+	bool content_has_csum;
+	uint32_t block_max;
+	/* decompressed block not handed out yet, if the output was too small */
+	uint8_t *block;
+	uint32_t block_size;
+	uint32_t block_len;
+	uint32_t block_pos;
+};
+
+static struct lz4_context _context;
+
 tegrabl_error_t do_lz4_decompress(void *cntxt, void *in_buffer,
 								  uint32_t in_size, void *out_buffer,
 								  uint32_t outbuf_size, uint32_t *written_size)
@@ -46,6 +71,8 @@ tegrabl_error_t do_lz4_decompress(void *cntxt, void *in_buffer,
 	uint8_t frame_flag, block_descriptor, header_csum;
 	uint64_t content_size = 0;
 	bool block_has_csum = false;
+	bool legacy = false;
+	bool uncompressed;
 
 	(void)cntxt;
 
@@ -58,6 +85,7 @@ tegrabl_error_t do_lz4_decompress(void *cntxt, void *in_buffer,
 	switch (magic_number) {
 	case LZ4_LEGACY_MAGIC_NUMBER:
 		pr_debug("Content in legacy frame format\n");
+		legacy = true;
 		break;
 
 	case LZ4_CURRENT_MAGIC_NUMBER:
@@ -88,10 +116,22 @@ tegrabl_error_t do_lz4_decompress(void *cntxt, void *in_buffer,
 		if (!c_size || cbuf >= cbuf_end) {
 			break;
 		}
+		uncompressed = !legacy && ((c_size & BLOCK_UNCOMPRESSED_MASK) != 0U);
+		if (uncompressed) {
+			c_size &= ~BLOCK_UNCOMPRESSED_MASK;
+		}
 
 		d_size = dbuf_end - dbuf;
 		pr_debug("compressed_size:%d max_write_size:%d\n", c_size, d_size);
-		err = LZ4_decompress_safe((char *)cbuf, (char *)dbuf, c_size, d_size);
+		if (!uncompressed) {
+			err = LZ4_decompress_safe((char *)cbuf, (char *)dbuf, c_size,
+									  d_size);
+		} else if ((c_size > d_size) || (c_size > (cbuf_end - cbuf))) {
+			err = -1;
+		} else {
+			memcpy(dbuf, cbuf, c_size);
+			err = (int32_t)c_size;
+		}
 
 		if (err < 0) {
 			pr_critical("failed to decompress, err=%d\n", err);
@@ -124,3 +164,205 @@ fail:
 
 	return ret;
 }
+
+void *lz4_init(uint32_t compressed_size)
+{
+	struct lz4_context *context = &_context;
+
+	(void)compressed_size;
+
+	context->state = LZ4_STREAM_HEADER;
+	context->legacy = false;
+	context->block_has_csum = false;
+	context->content_has_csum = false;
+	context->block_max = 0;
+	context->block_len = 0;
+	context->block_pos = 0;
+
+	return context;
+}
+
+/* Parses the magic and frame header, all of which must be in the input */
+static uint32_t lz4_stream_header(struct lz4_context *context, uint8_t *cbuf,
+								  uint32_t in_size)
+{
+	uint32_t magic_number;
+	uint32_t header_size = MAGIC_NUMBER_SZ;
+	uint8_t frame_flag, block_descriptor;
+
+	if (in_size < MAGIC_NUMBER_SZ) {
+		return 0;
+	}
+	magic_number = *(uint32_t *)cbuf;
+
+	if (magic_number == LZ4_LEGACY_MAGIC_NUMBER) {
+		context->legacy = true;
+		context->block_max = LEGACY_BLOCK_MAX_SIZE;
+	} else if (magic_number == LZ4_CURRENT_MAGIC_NUMBER) {
+		if (in_size < (MAGIC_NUMBER_SZ + FRAME_HEADER_SZ)) {
+			return 0;
+		}
+		frame_flag = cbuf[MAGIC_NUMBER_SZ];
+		block_descriptor = cbuf[MAGIC_NUMBER_SZ + 1];
+		header_size += FRAME_HEADER_SZ;
+		if (frame_flag & CONTENT_SIZE_FALG_MASK) {
+			header_size += ORIGINAL_CONTENT_SZ;
+		}
+		if (in_size < header_size) {
+			return 0;
+		}
+		context->block_has_csum = (frame_flag & BLOCK_CHECKSUM_FLAG_MASK) != 0;
+		context->content_has_csum = (frame_flag & CONTENT_CSUM_FALG_MASK) != 0;
+		/* 4: 64KB, 5: 256KB, 6: 1MB, 7: 4MB */
+		context->block_max = 1U << (8 + 2 *
+			((block_descriptor & BLOCK_MAX_SIZE_MASK) >> BLOCK_MAX_SIZE_SHIFT));
+		if (context->block_max < (64 * 1024)) {
+			pr_error("Invalid block size in frame header\n");
+			return 0;
+		}
+	} else {
+		pr_error("Magic(0x%08x) not supported\n", magic_number);
+		return 0;
+	}
+
+	context->state = LZ4_STREAM_BLOCKS;
+
+	return header_size;
+}
+
+tegrabl_error_t lz4_stream(void *cntxt, void *in_buffer, uint32_t in_size,
+						   uint32_t *in_used, void *out_buffer,
+						   uint32_t outbuf_size, uint32_t *written_size)
+{
+	struct lz4_context *context = (struct lz4_context *)cntxt;
+	uint8_t *cbuf = (uint8_t *)in_buffer;
+	uint8_t *dbuf = (uint8_t *)out_buffer;
+	uint32_t c_size, block_in, chunk;
+	uint8_t *block_out;
+	int32_t err;
+	bool uncompressed;
+
+	*in_used = 0;
+	*written_size = 0;
+
+	if (context->state == LZ4_STREAM_HEADER) {
+		*in_used = lz4_stream_header(context, cbuf, in_size);
+		if (*in_used == 0U) {
+			return (in_size < MAGIC_NUMBER_SZ) ? TEGRABL_NO_ERROR :
+				   TEGRABL_ERROR(TEGRABL_ERR_INVALID, 2);
+		}
+	}
+
+	while (*written_size < outbuf_size) {
+		/* hand out what is left of the last block first */
+		if (context->block_pos < context->block_len) {
+			chunk = MIN(context->block_len - context->block_pos,
+						outbuf_size - *written_size);
+			memcpy(dbuf + *written_size, context->block + context->block_pos,
+				   chunk);
+			context->block_pos += chunk;
+			*written_size += chunk;
+			continue;
+		}
+
+		if (context->state != LZ4_STREAM_BLOCKS) {
+			break;
+		}
+
+		/* a block is decoded once it is all in the input */
+		if ((in_size - *in_used) < BLOCK_SIZE_SZ) {
+			/* the legacy format has no end mark and ends with the input */
+			if (context->legacy && (in_size == *in_used)) {
+				context->state = LZ4_STREAM_DONE;
+			}
+			break;
+		}
+		c_size = *(uint32_t *)(cbuf + *in_used);
+		if (c_size == 0U) {
+			/* end mark, and the content checksum if there is one */
+			block_in = BLOCK_SIZE_SZ +
+					   (context->content_has_csum ? BLOCK_CHECKSUM_SZ : 0U);
+			if ((in_size - *in_used) < block_in) {
+				break;
+			}
+			*in_used += block_in;
+			context->state = LZ4_STREAM_DONE;
+			break;
+		}
+		uncompressed = !context->legacy &&
+					   ((c_size & BLOCK_UNCOMPRESSED_MASK) != 0U);
+		if (uncompressed) {
+			c_size &= ~BLOCK_UNCOMPRESSED_MASK;
+			if (c_size > context->block_max) {
+				pr_critical("stored block larger than the block size\n");
+				return TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, 2);
+			}
+		}
+		block_in = BLOCK_SIZE_SZ + c_size +
+				   (context->block_has_csum ? BLOCK_CHECKSUM_SZ : 0U);
+		if ((c_size > (in_size - *in_used)) ||
+			(block_in > (in_size - *in_used))) {
+			break;
+		}
+
+		/* straight to the output if any block fits, else through a buffer */
+		if ((outbuf_size - *written_size) >= context->block_max) {
+			block_out = dbuf + *written_size;
+		} else {
+			if (context->block_size < context->block_max) {
+				tegrabl_free(context->block);
+				context->block_size = 0;
+				context->block = tegrabl_malloc(context->block_max);
+				if (context->block == NULL) {
+					return TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
+				}
+				context->block_size = context->block_max;
+			}
+			block_out = context->block;
+		}
+
+		if (uncompressed) {
+			memcpy(block_out, cbuf + *in_used + BLOCK_SIZE_SZ, c_size);
+			err = (int32_t)c_size;
+		} else {
+			err = LZ4_decompress_safe((char *)cbuf + *in_used + BLOCK_SIZE_SZ,
+									  (char *)block_out, c_size,
+									  context->block_max);
+		}
+		if (err < 0) {
+			pr_critical("failed to decompress, err=%d\n", err);
+			return TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, 1);
+		}
+		*in_used += block_in;
+
+		if (block_out == context->block) {
+			context->block_len = (uint32_t)err;
+			context->block_pos = 0;
+		} else {
+			*written_size += (uint32_t)err;
+		}
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+bool lz4_stream_done(void *cntxt)
+{
+	struct lz4_context *context = (struct lz4_context *)cntxt;
+
+	return (context->state == LZ4_STREAM_DONE) &&
+		   (context->block_pos == context->block_len);
+}
+
+tegrabl_error_t lz4_end(void *cntxt)
+{
+	struct lz4_context *context = (struct lz4_context *)cntxt;
+
+	tegrabl_free(context->block);
+	context->block = NULL;
+	context->block_size = 0;
+	context->block_len = 0;
+	context->block_pos = 0;
+
+	return TEGRABL_NO_ERROR;
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2014-2017, NVIDIA Corporation.  All rights reserved.
+ * Copyright (c) 2014-2020, NVIDIA Corporation.  All rights reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property
  * and proprietary rights in and to this software and related documentation
@@ -27,6 +27,7 @@
 struct zlib_context {
 	z_stream strm;
 	bool done;
+	bool active;
 };
 
 static struct zlib_context _context;
@@ -36,18 +37,26 @@ void *zlib_init(uint32_t compressed_size)
 	int ret;
 	struct zlib_context *context = &_context;
 
+	/* a stream that was never ended still holds its inflate state */
+	if (context->active) {
+		inflateEnd(&(context->strm));
+		context->active = false;
+	}
+
 	/* allocate inflate state */
 	context->strm.zalloc = Z_NULL;
 	context->strm.zfree = Z_NULL;
 	context->strm.opaque = Z_NULL;
 	context->strm.avail_in = 0;
 	context->strm.next_in = Z_NULL;
+	context->done = false;
 
 	/* add 32 to detect header type automatically */
 	ret = inflateInit2(&(context->strm), 32 + MAX_WBITS);
 	if (ret != Z_OK) {
 		return NULL;
 	}
+	context->active = true;
 
 	return context;
 }
@@ -97,11 +106,57 @@ tegrabl_error_t zlib_decompress(void *cntxt, void *in_buffer, uint32_t in_size,
 	return TEGRABL_NO_ERROR;
 }
 
+tegrabl_error_t zlib_stream(void *cntxt, void *in_buffer, uint32_t in_size,
+							uint32_t *in_used, void *out_buffer,
+							uint32_t outbuf_size, uint32_t *written_size)
+{
+	int32_t ret;
+	struct zlib_context *context = (struct zlib_context *)cntxt;
+
+	*in_used = 0;
+	*written_size = 0;
+
+	if (context->done) {
+		return TEGRABL_NO_ERROR;
+	}
+
+	context->strm.avail_in = in_size;
+	context->strm.next_in = in_buffer;
+	context->strm.avail_out = outbuf_size;
+	context->strm.next_out = out_buffer;
+
+	ret = inflate(&(context->strm), Z_NO_FLUSH);
+	/* Z_BUF_ERROR only means that no progress was possible */
+	if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+		pr_critical("zlib::inflate() returns %s (%d)\n",
+					context->strm.msg, ret);
+		return TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, 1);
+	}
+
+	*in_used = in_size - context->strm.avail_in;
+	*written_size = outbuf_size - context->strm.avail_out;
+	if (ret == Z_STREAM_END) {
+		context->done = true;
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+bool zlib_stream_done(void *cntxt)
+{
+	struct zlib_context *context = (struct zlib_context *)cntxt;
+
+	return context->done;
+}
+
 tegrabl_error_t zlib_end(void *cntxt)
 {
 	struct zlib_context *context = (struct zlib_context *)cntxt;
 
-	inflateEnd(&(context->strm));
+	if (context->active) {
+		inflateEnd(&(context->strm));
+		context->active = false;
+	}
 
 	return TEGRABL_NO_ERROR;
 }
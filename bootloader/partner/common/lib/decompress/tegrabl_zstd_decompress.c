@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2019-2020, NVIDIA Corporation.  All rights reserved.
+ *
+ * NVIDIA Corporation and its licensors retain all intellectual property
+ * and proprietary rights in and to this software and related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA Corporation is strictly prohibited.
+ */
+
+#define MODULE TEGRABL_ERR_DECOMPRESS
+
+#include "tegrabl_error.h"
+#include "tegrabl_utils.h"
+#include "stdint.h"
+#include "stdbool.h"
+#define ZSTD_STATIC_LINKING_ONLY
+#include "zstd.h"
+#include "tegrabl_decompress.h"
+#include "tegrabl_decompress_private.h"
+
+/*
+ * Largest window accepted from a frame header. Output is written straight
+ * into the caller's buffer (stable output buffer), so the decoder never
+ * allocates a window; apart from the context it only buffers one block of
+ * input. The limit rejects frames that could not be decoded by a streaming
+ * decoder with a bounded history.
+ */
+#define ZSTD_WINDOW_LOG_MAX 27
+
+/* NOTE The context is kept across calls, same as for zlib, and is not
+ * thread-safe */
+static ZSTD_DCtx *zstd_dctx;
+static ZSTD_DDict *zstd_ddict;
+/* Set once zstd_stream() has switched the context to a moving output buffer */
+static bool zstd_streaming;
+/* Set while zstd_stream() is between frames, i.e. at the end of the stream */
+static bool zstd_frame_done;
+
+tegrabl_error_t tegrabl_zstd_load_dict(const void *dict, uint32_t dict_size)
+{
+	if (zstd_ddict != NULL) {
+		ZSTD_freeDDict(zstd_ddict);
+		zstd_ddict = NULL;
+	}
+
+	if ((dict == NULL) || (dict_size == 0U)) {
+		return TEGRABL_NO_ERROR;
+	}
+
+	/* The dictionary is referenced, not copied */
+	zstd_ddict = ZSTD_createDDict_byReference(dict, dict_size);
+	if (zstd_ddict == NULL) {
+		pr_error("%s: failed to load dictionary\n", __func__);
+		return TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
+	}
+
+	pr_debug("zstd dictionary id %u loaded\n", ZSTD_getDictID_fromDDict(zstd_ddict));
+
+	return TEGRABL_NO_ERROR;
+}
+
+void *zstd_init(uint32_t compressed_size)
+{
+	TEGRABL_UNUSED(compressed_size);
+
+	if (zstd_dctx == NULL) {
+		zstd_dctx = ZSTD_createDCtx();
+		if (zstd_dctx == NULL) {
+			return NULL;
+		}
+	}
+
+	ZSTD_DCtx_reset(zstd_dctx, ZSTD_reset_session_and_parameters);
+	zstd_streaming = false;
+	zstd_frame_done = false;
+
+	if (ZSTD_isError(ZSTD_DCtx_setParameter(zstd_dctx, ZSTD_d_windowLogMax,
+											ZSTD_WINDOW_LOG_MAX)) ||
+		ZSTD_isError(ZSTD_DCtx_setParameter(zstd_dctx, ZSTD_d_stableOutBuffer,
+											1))) {
+		return NULL;
+	}
+
+	if ((zstd_ddict != NULL) &&
+		ZSTD_isError(ZSTD_DCtx_refDDict(zstd_dctx, zstd_ddict))) {
+		return NULL;
+	}
+
+	return zstd_dctx;
+}
+
+tegrabl_error_t zstd_decompress(void *cntxt, void *in_buffer, uint32_t in_size,
+								void *out_buffer, uint32_t outbuf_size,
+								uint32_t *written_size)
+{
+	ZSTD_DCtx *dctx = (ZSTD_DCtx *)cntxt;
+	ZSTD_inBuffer input = { in_buffer, in_size, 0 };
+	ZSTD_outBuffer output = { out_buffer, outbuf_size, 0 };
+	size_t ret = 0;
+
+	*written_size = 0;
+
+	pr_debug("inbuf=0x%p (size:0x%x), outbuf=0x%p\n",
+			 in_buffer, in_size, out_buffer);
+
+	/* Concatenated and skippable frames are decoded back to back */
+	while (input.pos < input.size) {
+		ret = ZSTD_decompressStream(dctx, &output, &input);
+		if (ZSTD_isError(ret)) {
+			pr_critical("zstd: %s\n", ZSTD_getErrorName(ret));
+			if (ZSTD_getErrorCode(ret) == ZSTD_error_dstSize_tooSmall) {
+				return TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 0);
+			}
+			return TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, 0);
+		}
+		if ((ret != 0U) && (output.pos == output.size)) {
+			pr_critical("%s: output buffer is too small!\n", __func__);
+			return TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 1);
+		}
+	}
+
+	if (ret != 0U) {
+		pr_critical("%s: truncated frame\n", __func__);
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+	}
+
+	*written_size = (uint32_t)output.pos;
+	pr_debug("%s: decompressed data-size: %d\n", __func__, *written_size);
+
+	return TEGRABL_NO_ERROR;
+}
+
+tegrabl_error_t zstd_stream(void *cntxt, void *in_buffer, uint32_t in_size,
+							uint32_t *in_used, void *out_buffer,
+							uint32_t outbuf_size, uint32_t *written_size)
+{
+	ZSTD_DCtx *dctx = (ZSTD_DCtx *)cntxt;
+	ZSTD_inBuffer input = { in_buffer, in_size, 0 };
+	ZSTD_outBuffer output = { out_buffer, outbuf_size, 0 };
+	size_t ret;
+
+	*in_used = 0;
+	*written_size = 0;
+
+	/* Output lands in a different buffer on every call, so the decoder has
+	 * to keep its own window. Only allowed before the first frame starts. */
+	if (!zstd_streaming) {
+		if (ZSTD_isError(ZSTD_DCtx_setParameter(dctx, ZSTD_d_stableOutBuffer, 0))) {
+			return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 1);
+		}
+		zstd_streaming = true;
+	}
+
+	ret = ZSTD_decompressStream(dctx, &output, &input);
+	if (ZSTD_isError(ret)) {
+		pr_critical("zstd: %s\n", ZSTD_getErrorName(ret));
+		return TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, 1);
+	}
+
+	*in_used = (uint32_t)input.pos;
+	*written_size = (uint32_t)output.pos;
+	/* 0 means a frame was completed and flushed; a call without progress
+	 * only returns a hint for the next frame */
+	if ((input.pos != 0U) || (output.pos != 0U)) {
+		zstd_frame_done = (ret == 0U);
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+bool zstd_stream_done(void *cntxt)
+{
+	TEGRABL_UNUSED(cntxt);
+
+	return zstd_frame_done;
+}
+
+tegrabl_error_t zstd_end(void *cntxt)
+{
+	/* Keep the context around for the next image */
+	TEGRABL_UNUSED(cntxt);
+
+	return TEGRABL_NO_ERROR;
+}
@@ -148,9 +148,31 @@ static struct tegrabl_eeprom_ops_info eeprom_ops[TEGRABL_EEPROM_DEVICE_MAX] = {
 	}
 };
 
+static struct tegrabl_eeprom_ops_info *eeprom_get_ops(struct tegrabl_eeprom *eeprom)
+{
+	uint8_t index = 0;
+
+	if (!eeprom->name) {
+		return NULL;
+	}
+
+	for (index = 0; index < TEGRABL_EEPROM_DEVICE_MAX; index++) {
+		if (!eeprom_ops[index].name) {
+			return &eeprom_ops[index];
+		}
+
+		if (!strcmp(eeprom->name, eeprom_ops[index].name)) {
+			return &eeprom_ops[index];
+		}
+	}
+
+	return NULL;
+}
+
 static tegrabl_error_t eeprom_general_read(struct tegrabl_eeprom *eeprom,
 										   const void *in_data)
 {
+	struct tegrabl_eeprom_ops_info *ops_info;
 
 	if (!eeprom) {
 		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
@@ -160,19 +182,109 @@ static tegrabl_error_t eeprom_general_read(struct tegrabl_eeprom *eeprom,
 		return eeprom_read(eeprom, in_data);
 	}
 
-	uint8_t index = 0;
+	ops_info = eeprom_get_ops(eeprom);
+	if (ops_info != NULL) {
+		return ops_info->ops(eeprom, in_data);
+	}
 
-	for (index = 0; index < TEGRABL_EEPROM_DEVICE_MAX; index++) {
-		if (!eeprom_ops[index].name) {
-			return eeprom_ops[index].ops(eeprom, in_data);
-		}
+	return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
+}
 
-		if (!strcmp(eeprom->name, eeprom_ops[index].name)) {
-			return eeprom_ops[index].ops(eeprom, in_data);
+/**
+ * @brief EEPROM listed in the DT, read before it gets a slot in eeproms[]
+ */
+struct eeprom_candidate {
+	struct tegrabl_eeprom eeprom;
+	int node;
+	uint32_t slave_addr;
+	char bus_name[ALIAS_NAME_LEN];
+	bool is_started;
+	bool is_done;
+	tegrabl_error_t error;
+};
+
+/* Releases the buffers a candidate still owns */
+static void eeprom_candidate_free(struct eeprom_candidate *cand)
+{
+	if (cand->eeprom.name) {
+		tegrabl_free(cand->eeprom.name);
+		cand->eeprom.name = NULL;
+	}
+	if (cand->eeprom.data) {
+		tegrabl_free(cand->eeprom.data);
+		cand->eeprom.data = NULL;
+	}
+}
+
+/* Plain eeproms can be read with the non-blocking API, others (cam) need
+ * their own power sequence around the read */
+static bool eeprom_is_async_readable(struct eeprom_candidate *cand)
+{
+	struct tegrabl_eeprom_ops_info *ops_info;
+
+	if (cand->eeprom.instance >= TEGRABL_INSTANCE_I2C_INVALID) {
+		return false;
+	}
+
+	ops_info = eeprom_get_ops(&cand->eeprom);
+
+	return (ops_info == NULL) || (ops_info->ops == eeprom_read);
+}
+
+/**
+ * @brief Reads all candidates. One read is kept in flight on every i2c
+ * controller that has eeproms, CRCs are checked as each read completes.
+ */
+static void eeprom_read_candidates(struct eeprom_candidate *cands, uint32_t num)
+{
+	bool bus_busy[TEGRABL_INSTANCE_I2C_INVALID] = { false };
+	struct eeprom_candidate *cand;
+	uint32_t pending = num;
+	uint32_t i;
+
+	/* Reads that need a power sequence go first, before the buses are busy */
+	for (i = 0; i < num; i++) {
+		cand = &cands[i];
+		if (!eeprom_is_async_readable(cand)) {
+			cand->error = eeprom_general_read(&cand->eeprom, &cand->node);
+			cand->is_done = true;
+			pending--;
 		}
 	}
 
-	return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
+	while (pending != 0U) {
+		for (i = 0; i < num; i++) {
+			cand = &cands[i];
+			if (cand->is_done) {
+				continue;
+			}
+
+			if (!cand->is_started) {
+				if (bus_busy[cand->eeprom.instance]) {
+					continue;
+				}
+				cand->eeprom.data_valid = false;
+				cand->error = tegrabl_eeprom_read_start(&cand->eeprom);
+				if (cand->error != TEGRABL_NO_ERROR) {
+					cand->is_done = true;
+					pending--;
+					continue;
+				}
+				cand->is_started = true;
+				bus_busy[cand->eeprom.instance] = true;
+				continue;
+			}
+
+			cand->error = tegrabl_eeprom_read_poll(&cand->eeprom);
+			if (TEGRABL_ERROR_REASON(cand->error) == TEGRABL_ERR_NOT_READY) {
+				continue;
+			}
+			cand->eeprom.data_valid = (cand->error == TEGRABL_NO_ERROR);
+			cand->is_done = true;
+			bus_busy[cand->eeprom.instance] = false;
+			pending--;
+		}
+	}
 }
 
 static tegrabl_error_t tegrabl_get_i2c_instance(int node, int *instance,
@@ -366,6 +478,10 @@ static tegrabl_error_t tegrabl_eeprom_manager_init(void)
 	uint32_t eeprom_size = 0, slave_addr = 0;
 	const char *node_value;
 	uint8_t new_count = 0;
+	struct eeprom_candidate *cands = NULL;
+	struct eeprom_candidate *cand;
+	uint32_t num_cands = 0;
+	uint32_t i;
 	count = 0;
 
 	error = tegrabl_dt_get_node_with_path(fdt, "/eeprom-manager",
@@ -413,23 +529,33 @@ static tegrabl_error_t tegrabl_eeprom_manager_init(void)
 		return TEGRABL_ERROR(TEGRABL_ERR_NOT_FOUND, 0);
 	}
 
+	cands = tegrabl_calloc(TEGRABL_EEPROM_MAX_NUM, sizeof(*cands));
+	if (!cands) {
+		pr_error("%s: Malloc for eeprom list failed\n", __func__);
+		return TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
+	}
+
+	/* Collect all eeproms first so that they can be read in parallel */
 	tegrabl_dt_for_each_child(fdt, manager_node, manager_subnode) {
 		/* Get i2c alias instance. */
 		tegrabl_get_i2c_instance(manager_subnode, &instance_addr, i2c_nodename);
 
 		/* TODO: with scan-all-eeprom will scan from 0x50 to 0x57 */
 		tegrabl_dt_for_each_child(fdt, manager_subnode, eeprom_node) {
-			if (count == TEGRABL_EEPROM_MAX_NUM) {
+			if (num_cands == TEGRABL_EEPROM_MAX_NUM) {
 				pr_error("%s: Too many eeprom node scanned\n", __func__);
-				return TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
+				error = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
+				goto fail;
 			}
+			cand = &cands[num_cands];
 
 			/* Get slave address */
 			error = tegrabl_dt_get_prop_u32(fdt, eeprom_node,
 											"slave-address", &slave_addr);
 			if (error != TEGRABL_NO_ERROR) {
 				pr_error("%s: Slave address not found\n", __func__);
-				return TEGRABL_ERROR(TEGRABL_ERR_NOT_FOUND, 0);
+				error = TEGRABL_ERROR(TEGRABL_ERR_NOT_FOUND, 0);
+				goto fail;
 			}
 
 			/* Get label (optional) property */
@@ -437,63 +563,92 @@ static tegrabl_error_t tegrabl_eeprom_manager_init(void)
 											   "label", &node_value);
 			if (error == TEGRABL_NO_ERROR) {
 				/* Do we need to malloc(&copy) it? */
-				eeproms[count].name = tegrabl_malloc(EEPROM_NAME_LEN);
-				if (!eeproms[count].name) {
+				cand->eeprom.name = tegrabl_malloc(EEPROM_NAME_LEN);
+				if (!cand->eeprom.name) {
 					pr_error("%s: Malloc for eeprom name failed\n", __func__);
-					return TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
+					error = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
+					goto fail;
 				}
-				tegrabl_snprintf(eeproms[count].name, EEPROM_NAME_LEN, "%s",
+				tegrabl_snprintf(cand->eeprom.name, EEPROM_NAME_LEN, "%s",
 								 (char *)node_value);
 			} else {
-				eeproms[count].name = NULL;
+				cand->eeprom.name = NULL;
 			}
 
-			eeproms[count].size = (eeprom_size > EEPROM_SZ) ?
-								  EEPROM_SZ : eeprom_size;
+			cand->eeprom.size = (eeprom_size > EEPROM_SZ) ?
+								EEPROM_SZ : eeprom_size;
 
-			eeproms[count].data = tegrabl_malloc(eeproms[count].size);
-			if (!eeproms[count].data) {
+			cand->eeprom.data = tegrabl_malloc(cand->eeprom.size);
+			if (!cand->eeprom.data) {
 				pr_error("%s: Malloc for eeprom data failed\n", __func__);
-				return TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
+				error = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
+				goto fail;
 			}
 
-			eeproms[count].instance = instance_addr;
-			eeproms[count].crc_valid = false;
-			eeproms[count].data_valid = false;
-			eeproms[count].slave_addr = slave_addr << 1;
+			cand->eeprom.instance = instance_addr;
+			cand->eeprom.crc_valid = false;
+			cand->eeprom.data_valid = false;
+			cand->eeprom.slave_addr = slave_addr << 1;
+			cand->node = eeprom_node;
+			cand->slave_addr = slave_addr;
+			tegrabl_snprintf(cand->bus_name, ALIAS_NAME_LEN, "%s", i2c_nodename);
 			pr_info("Reading eeprom i2c=%d address=0x%x\n",
 					instance_addr, slave_addr);
+			num_cands++;
+		}
+	}
 
-			error = eeprom_general_read(&eeproms[count], &eeprom_node);
-
-			if (!eeproms[count].data_valid) {
-				pr_info("Eeprom read failed 0x%08x\n", error);
-				if (eeproms[count].name) {
-					tegrabl_free(eeproms[count].name);
-				}
-				tegrabl_free(eeproms[count].data);
-				continue;
-			}
+	eeprom_read_candidates(cands, num_cands);
 
-			eeproms[count].bus_node_name = tegrabl_malloc(BUS_NODE_NAME);
-			if (!eeproms[count].bus_node_name) {
-				pr_error("%s: Malloc for eeprom bus node name failed\n",
-					     __func__);
-				return TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
-			}
-			tegrabl_snprintf(eeproms[count].bus_node_name, BUS_NODE_NAME, "%s",
-							i2c_nodename);
-			pr_info("Device at %s:0x%02x\n", i2c_nodename, slave_addr);
+	/* Register the ones that were read, in DT order */
+	for (i = 0; i < num_cands; i++) {
+		cand = &cands[i];
 
-			eeproms[count].data_valid = true;
+		if (!cand->eeprom.data_valid) {
+			pr_info("Eeprom read failed 0x%08x\n", cand->error);
+			eeprom_candidate_free(cand);
+			continue;
+		}
 
-			tegrabl_read_muxed_eeprom(count, &new_count);
+		if (count == TEGRABL_EEPROM_MAX_NUM) {
+			pr_error("%s: Too many eeprom node scanned\n", __func__);
+			error = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
+			goto fail;
+		}
 
-			count = new_count;
+		eeproms[count] = cand->eeprom;
+		eeproms[count].bus_node_name = tegrabl_malloc(BUS_NODE_NAME);
+		if (!eeproms[count].bus_node_name) {
+			pr_error("%s: Malloc for eeprom bus node name failed\n",
+				     __func__);
+			error = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
+			goto fail;
 		}
+		tegrabl_snprintf(eeproms[count].bus_node_name, BUS_NODE_NAME, "%s",
+						cand->bus_name);
+		pr_info("Device at %s:0x%02x\n", cand->bus_name, cand->slave_addr);
+
+		eeproms[count].data_valid = true;
+		/* name and data now belong to eeproms[] */
+		cand->eeprom.name = NULL;
+		cand->eeprom.data = NULL;
+
+		tegrabl_read_muxed_eeprom(count, &new_count);
+
+		count = new_count;
 	}
+	tegrabl_free(cands);
+
 	eeprom_manager_initialized = true;
 	return TEGRABL_NO_ERROR;
+
+fail:
+	/* cands is zeroed, so slots never filled in have nothing to free */
+	for (i = 0; i < TEGRABL_EEPROM_MAX_NUM; i++) {
+		eeprom_candidate_free(&cands[i]);
+	}
+	tegrabl_free(cands);
+	return error;
 }
 
 tegrabl_error_t tegrabl_eeprom_manager_max(uint8_t *num)
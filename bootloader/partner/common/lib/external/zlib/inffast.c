@@ -3,6 +3,16 @@
  * For conditions of distribution and use, see copyright notice in zlib.h
  */
 
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.  All rights reserved.
+ */
+
+/*
+ * Modifications by Nvidia:
+ *
+ * Added a wide inflate_fast() for 64-bit little-endian targets
+ */
+
 #include "zutil.h"
 #include "inftrees.h"
 #include "inflate.h"
@@ -10,6 +20,310 @@
 
 #ifndef ASMINF
 
+#ifdef INFLATE_FAST_WIDE
+
+/* Little-endian unaligned loads and stores, the memcpy()s compile to
+   single instructions */
+local unsigned long load64 OF((const unsigned char FAR *p));
+local void copy8 OF((unsigned char FAR *dst, const unsigned char FAR *src));
+local unsigned char FAR *copy_match OF((unsigned char FAR *out, unsigned dist,
+                                        unsigned len));
+
+local unsigned long load64(p)
+const unsigned char FAR *p;
+{
+    unsigned long v;
+
+    zmemcpy(&v, p, sizeof(v));
+    return v;
+}
+
+local void copy8(dst, src)
+unsigned char FAR *dst;
+const unsigned char FAR *src;
+{
+    unsigned long v;
+
+    zmemcpy(&v, src, sizeof(v));
+    zmemcpy(dst, &v, sizeof(v));
+}
+
+/*
+   Copy len bytes from dist bytes back in the output.  For distances of
+   eight or more every eight byte chunk read has already been written, so
+   the copy goes a chunk at a time and may store up to seven bytes past
+   out + len; those are overwritten by whatever is decoded next.  Shorter
+   distances repeat a pattern that overlaps the destination.
+ */
+local unsigned char FAR *copy_match(out, dist, len)
+unsigned char FAR *out;
+unsigned dist;
+unsigned len;
+{
+    unsigned char FAR *from = out - dist;
+    unsigned char FAR *stop = out + len;
+    unsigned period;
+
+    if (dist >= 8) {
+        do {
+            copy8(out, from);
+            out += 8;
+            from += 8;
+        } while (out < stop);
+    }
+    else if (dist == 1) {
+        memset(out, *from, len);
+    }
+    else {
+        /* the pattern also repeats at any multiple of dist, so once one
+           multiple of eight or more is in place copy in chunks from there */
+        period = dist;
+        while (period < 8)
+            period += dist;
+        len = len < period ? len : period;
+        do {
+            *out++ = *from++;
+        } while (--len);
+        while (out < stop) {
+            copy8(out, out - period);
+            out += 8;
+        }
+    }
+    return stop;
+}
+
+/*
+   Same as the inflate_fast() below, with these changes:
+
+    - The bit buffer is refilled to at least 56 bits with one eight byte
+      load at the top of each loop, which covers the 48 bits a
+      length/distance pair can use, so no further refills are needed in the
+      loop.  The load can read up to seven bytes more than it keeps, hence
+      strm->avail_in >= INFLATE_FAST_MIN_HAVE.
+
+    - Matches are copied by copy_match() and window copies with zmemcpy().
+      The chunked copy can write up to seven bytes past the match, hence
+      strm->avail_out >= INFLATE_FAST_MIN_LEFT.
+
+    - After a literal, up to two more literals are decoded from the bits
+      already in the buffer before going around the loop.
+ */
+void ZLIB_INTERNAL inflate_fast(strm, start)
+z_streamp strm;
+unsigned start;         /* inflate()'s starting value for strm->avail_out */
+{
+    struct inflate_state FAR *state;
+    unsigned char FAR *in;      /* local strm->next_in */
+    unsigned char FAR *last;    /* while in < last, enough input available */
+    unsigned char FAR *out;     /* local strm->next_out */
+    unsigned char FAR *beg;     /* inflate()'s initial strm->next_out */
+    unsigned char FAR *end;     /* while out < end, enough space available */
+#ifdef INFLATE_STRICT
+    unsigned dmax;              /* maximum distance from zlib header */
+#endif
+    unsigned wsize;             /* window size or zero if not using window */
+    unsigned whave;             /* valid bytes in the window */
+    unsigned wnext;             /* window write index */
+    unsigned char FAR *window;  /* allocated sliding window, if wsize != 0 */
+    unsigned long hold;         /* local strm->hold */
+    unsigned bits;              /* local strm->bits */
+    code const FAR *lcode;      /* local strm->lencode */
+    code const FAR *dcode;      /* local strm->distcode */
+    unsigned lmask;             /* mask for first level of length codes */
+    unsigned dmask;             /* mask for first level of distance codes */
+    code here;                  /* retrieved table entry */
+    unsigned op;                /* code bits, operation, extra bits, or */
+                                /*  window position, window bytes to copy */
+    unsigned len;               /* match length, unused bytes */
+    unsigned dist;              /* match distance */
+    unsigned char FAR *from;    /* where to copy match from */
+    int lits;                   /* extra literals left for this loop */
+
+    /* copy state to local variables */
+    state = (struct inflate_state FAR *)strm->state;
+    in = strm->next_in;
+    last = in + (strm->avail_in - (INFLATE_FAST_MIN_HAVE - 1));
+    out = strm->next_out;
+    beg = out - (start - strm->avail_out);
+    end = out + (strm->avail_out - (INFLATE_FAST_MIN_LEFT - 1));
+#ifdef INFLATE_STRICT
+    dmax = state->dmax;
+#endif
+    wsize = state->wsize;
+    whave = state->whave;
+    wnext = state->wnext;
+    window = state->window;
+    hold = state->hold;
+    bits = state->bits;
+    lcode = state->lencode;
+    dcode = state->distcode;
+    lmask = (1U << state->lenbits) - 1;
+    dmask = (1U << state->distbits) - 1;
+
+    /* decode literals and length/distances until end-of-block or not enough
+       input data or output space */
+    do {
+        /* bits < 64 here, keep whole bytes only: 56 <= bits < 64 after */
+        hold |= load64(in) << bits;
+        in += (63 - bits) >> 3;
+        bits |= 56;
+        here = lcode[hold & lmask];
+        lits = 2;
+      dolen:
+        op = (unsigned)(here.bits);
+        hold >>= op;
+        bits -= op;
+        op = (unsigned)(here.op);
+        if (op == 0) {                          /* literal */
+            Tracevv((stderr, here.val >= 0x20 && here.val < 0x7f ?
+                    "inflate:         literal '%c'\n" :
+                    "inflate:         literal 0x%02x\n", here.val));
+            *out++ = (unsigned char)(here.val);
+            /* at most 3 * 15 bits are used for literals in one loop */
+            if (lits-- > 0) {
+                here = lcode[hold & lmask];
+                if (here.op == 0)
+                    goto dolen;
+            }
+        }
+        else if (op & 16) {                     /* length base */
+            len = (unsigned)(here.val);
+            op &= 15;                           /* number of extra bits */
+            if (op) {
+                len += (unsigned)hold & ((1U << op) - 1);
+                hold >>= op;
+                bits -= op;
+            }
+            Tracevv((stderr, "inflate:         length %u\n", len));
+            here = dcode[hold & dmask];
+          dodist:
+            op = (unsigned)(here.bits);
+            hold >>= op;
+            bits -= op;
+            op = (unsigned)(here.op);
+            if (op & 16) {                      /* distance base */
+                dist = (unsigned)(here.val);
+                op &= 15;                       /* number of extra bits */
+                dist += (unsigned)hold & ((1U << op) - 1);
+#ifdef INFLATE_STRICT
+                if (dist > dmax) {
+                    strm->msg = (char *)"invalid distance too far back";
+                    state->mode = BAD;
+                    break;
+                }
+#endif
+                hold >>= op;
+                bits -= op;
+                Tracevv((stderr, "inflate:         distance %u\n", dist));
+                op = (unsigned)(out - beg);     /* max distance in output */
+                if (dist > op) {                /* see if copy from window */
+                    op = dist - op;             /* distance back in window */
+                    if (op > whave) {
+                        if (state->sane) {
+                            strm->msg =
+                                (char *)"invalid distance too far back";
+                            state->mode = BAD;
+                            break;
+                        }
+#ifdef INFLATE_ALLOW_INVALID_DISTANCE_TOOFAR_ARRR
+                        if (len <= op - whave) {
+                            do {
+                                *out++ = 0;
+                            } while (--len);
+                            continue;
+                        }
+                        len -= op - whave;
+                        do {
+                            *out++ = 0;
+                        } while (--op > whave);
+                        if (op == 0) {
+                            out = copy_match(out, dist, len);
+                            continue;
+                        }
+#endif
+                    }
+                    from = window;
+                    if (wnext == 0) {           /* very common case */
+                        from += wsize - op;
+                    }
+                    else if (wnext < op) {      /* wrap around window */
+                        from += wsize + wnext - op;
+                        op -= wnext;
+                        if (op < len) {         /* some from end of window */
+                            len -= op;
+                            zmemcpy(out, from, op);
+                            out += op;
+                            from = window;
+                            op = wnext;         /* rest from start of window */
+                        }
+                    }
+                    else {                      /* contiguous in window */
+                        from += wnext - op;
+                    }
+                    /* the window never overlaps the output */
+                    if (op < len) {             /* some from window */
+                        len -= op;
+                        zmemcpy(out, from, op);
+                        out += op;
+                        out = copy_match(out, dist, len);   /* rest from output */
+                    }
+                    else {
+                        zmemcpy(out, from, len);
+                        out += len;
+                    }
+                }
+                else {
+                    out = copy_match(out, dist, len);   /* direct from output */
+                }
+            }
+            else if ((op & 64) == 0) {          /* 2nd level distance code */
+                here = dcode[here.val + (hold & ((1U << op) - 1))];
+                goto dodist;
+            }
+            else {
+                strm->msg = (char *)"invalid distance code";
+                state->mode = BAD;
+                break;
+            }
+        }
+        else if ((op & 64) == 0) {              /* 2nd level length code */
+            here = lcode[here.val + (hold & ((1U << op) - 1))];
+            goto dolen;
+        }
+        else if (op & 32) {                     /* end-of-block */
+            Tracevv((stderr, "inflate:         end of block\n"));
+            state->mode = TYPE;
+            break;
+        }
+        else {
+            strm->msg = (char *)"invalid literal/length code";
+            state->mode = BAD;
+            break;
+        }
+    } while (in < last && out < end);
+
+    /* return unused bytes (on entry, bits < 8, so in won't go too far back) */
+    len = bits >> 3;
+    in -= len;
+    bits -= len << 3;
+    hold &= ((unsigned long)1 << bits) - 1;
+
+    /* update state and return */
+    strm->next_in = in;
+    strm->next_out = out;
+    strm->avail_in = (unsigned)(in < last ?
+                                (INFLATE_FAST_MIN_HAVE - 1) + (last - in) :
+                                (INFLATE_FAST_MIN_HAVE - 1) - (in - last));
+    strm->avail_out = (unsigned)(out < end ?
+                                 (INFLATE_FAST_MIN_LEFT - 1) + (end - out) :
+                                 (INFLATE_FAST_MIN_LEFT - 1) - (out - end));
+    state->hold = hold;
+    state->bits = bits;
+    return;
+}
+
+#else /* !INFLATE_FAST_WIDE */
+
 /* Allow machine dependent optimization for post-increment or pre-increment.
    Based on testing to date,
    Pre-increment preferred for:
@@ -323,6 +637,8 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
     return;
 }
 
+#endif /* INFLATE_FAST_WIDE */
+
 /*
    inflate_fast() speedups that turned out slower (on a PowerPC G3 750CXe):
    - Using bit fields for code structure
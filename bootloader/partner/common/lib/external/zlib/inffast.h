@@ -8,4 +8,28 @@
    subject to change. Applications should only use zlib.h.
  */
 
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.  All rights reserved.
+ */
+
+/*
+ * Modifications by Nvidia:
+ *
+ * Added INFLATE_FAST_MIN_HAVE and INFLATE_FAST_MIN_LEFT for the wide
+ * inflate_fast() on 64-bit little-endian targets
+ */
+
+/* inflate_fast() on 64-bit little-endian targets refills the bit buffer
+   eight bytes at a time and copies matches in eight byte chunks, so it may
+   load and store up to seven bytes past what it actually uses */
+#if defined(__LP64__) && defined(__BYTE_ORDER__) && \
+    (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) && !defined(INFLATE_FAST_NARROW)
+#  define INFLATE_FAST_WIDE
+#  define INFLATE_FAST_MIN_HAVE 8
+#  define INFLATE_FAST_MIN_LEFT 266
+#else
+#  define INFLATE_FAST_MIN_HAVE 6
+#  define INFLATE_FAST_MIN_LEFT 258
+#endif
+
 void ZLIB_INTERNAL inflate_fast OF((z_streamp strm, unsigned start));
@@ -80,6 +80,16 @@
  * The history for versions after 1.2.0 are in ChangeLog in zlib distribution.
  */
 
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.  All rights reserved.
+ */
+
+/*
+ * Modifications by Nvidia:
+ *
+ * Take the inflate_fast() entry limits from inffast.h
+ */
+
 #include "zutil.h"
 #include "inftrees.h"
 #include "inflate.h"
@@ -1020,7 +1030,7 @@ int flush;
             state->mode = LEN;
             /* Fall through */
         case LEN:
-            if (have >= 6 && left >= 258) {
+            if (have >= INFLATE_FAST_MIN_HAVE && left >= INFLATE_FAST_MIN_LEFT) {
                 RESTORE();
                 inflate_fast(strm, out);
                 LOAD();
@@ -20,7 +20,8 @@ GLOBAL_INCLUDES += \
 MODULE_DEPS += \
 	$(LOCAL_DIR)/../../../common/drivers/usbf/class/transport \
 	$(LOCAL_DIR)/../../../common/drivers/usbf/xusbf \
-	$(LOCAL_DIR)/../../../common/lib/sparse
+	$(LOCAL_DIR)/../../../common/lib/sparse \
+	$(LOCAL_DIR)/../../../common/lib/decompress
 
 MODULE_SRCS += \
 	$(LOCAL_DIR)/tegrabl_fastboot_partinfo.c \
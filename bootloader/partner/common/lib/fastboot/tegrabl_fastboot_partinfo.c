@@ -8,12 +8,16 @@
  * license agreement from NVIDIA CORPORATION is strictly prohibited
  */
 
+#define MODULE TEGRABL_ERR_FASTBOOT
+
 #include <string.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <tegrabl_debug.h>
 #include <tegrabl_error.h>
 #include <tegrabl_utils.h>
+#include <tegrabl_malloc.h>
+#include <tegrabl_blockdev.h>
 #include <tegrabl_partition_manager.h>
 #include <tegrabl_fastboot_partinfo.h>
 #include <tegrabl_a_b_partition_naming.h>
@@ -129,3 +133,103 @@ tegrabl_error_t tegrabl_fastboot_partition_seek(uint64_t size, void *aux_info)
 								  TEGRABL_PARTITION_SEEK_CUR);
 }
 
+/* Fill chunks are written from a pattern buffer of up to this size, zero fills
+ * of at least FASTBOOT_ERASE_MIN_SIZE are erased instead if possible */
+#define FASTBOOT_FILL_BUFFER_SIZE	(1024UL * 1024UL)
+#define FASTBOOT_ERASE_MIN_SIZE		(1024UL * 1024UL)
+
+static uint32_t *fill_buffer;
+static uint64_t fill_buffer_size;
+static uint32_t fill_buffer_value;
+
+static tegrabl_error_t fastboot_partition_erase_fill(struct tegrabl_partition *partition,
+													 uint64_t size)
+{
+	tegrabl_bdev_t *bdev = partition->block_device;
+	uint32_t log2 = TEGRABL_BLOCKDEV_BLOCK_SIZE_LOG2(bdev);
+	uint64_t block_mask = TEGRABL_BLOCKDEV_BLOCK_SIZE(bdev) - 1UL;
+	bool erased_reads_zero = false;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	if ((size < FASTBOOT_ERASE_MIN_SIZE) || ((size & block_mask) != 0UL) ||
+		((partition->offset & block_mask) != 0UL) ||
+		((partition->offset + size) > partition->partition_info->total_size)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
+	}
+
+	error = tegrabl_blockdev_ioctl(bdev, TEGRABL_IOCTL_ERASED_READS_ZERO, &erased_reads_zero);
+	if ((error != TEGRABL_NO_ERROR) || !erased_reads_zero) {
+		return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 1);
+	}
+
+	pr_debug("Erasing %"PRIu64" bytes of partition\n", size);
+
+	error = tegrabl_blockdev_erase(bdev,
+			(bnum_t)(partition->partition_info->start_sector + (partition->offset >> log2)),
+			(bnum_t)(size >> log2), false);
+	if (error != TEGRABL_NO_ERROR) {
+		return error;
+	}
+
+	return tegrabl_partition_seek(partition, (int64_t)size, TEGRABL_PARTITION_SEEK_CUR);
+}
+
+tegrabl_error_t tegrabl_fastboot_partition_fill(uint32_t fill_value,
+												uint64_t size, void *aux_info)
+{
+	struct tegrabl_partition *partition = (struct tegrabl_partition *)aux_info;
+	uint64_t buffer_size = MIN(size, FASTBOOT_FILL_BUFFER_SIZE);
+	uint64_t filled;
+	uint64_t chunk;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	if (fill_value == 0U) {
+		error = fastboot_partition_erase_fill(partition, size);
+		if (TEGRABL_ERROR_REASON(error) != TEGRABL_ERR_NOT_SUPPORTED) {
+			return error;
+		}
+	}
+
+	if ((fill_buffer == NULL) || (fill_buffer_size < buffer_size)) {
+		tegrabl_fastboot_partition_fill_done();
+		fill_buffer = tegrabl_memalign(TEGRABL_BLOCKDEV_MEM_ALIGN_SIZE, FASTBOOT_FILL_BUFFER_SIZE);
+		if (fill_buffer == NULL) {
+			return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 2);
+		}
+		fill_buffer_size = FASTBOOT_FILL_BUFFER_SIZE;
+		fill_buffer_value = ~fill_value;
+	}
+
+	/* Replicate the value by doubling the filled part of the buffer */
+	if (fill_buffer_value != fill_value) {
+		fill_buffer[0] = fill_value;
+		for (filled = sizeof(uint32_t); filled < fill_buffer_size; filled += chunk) {
+			chunk = MIN(filled, fill_buffer_size - filled);
+			memcpy((uint8_t *)fill_buffer + filled, fill_buffer, chunk);
+		}
+		fill_buffer_value = fill_value;
+	}
+
+	pr_debug("Filling %"PRIu64" bytes of partition with 0x%08x\n", size, fill_value);
+
+	while (size != 0UL) {
+		chunk = MIN(size, fill_buffer_size);
+		error = tegrabl_partition_write(partition, fill_buffer, chunk);
+		if (error != TEGRABL_NO_ERROR) {
+			break;
+		}
+		size -= chunk;
+	}
+
+	return error;
+}
+
+void tegrabl_fastboot_partition_fill_done(void)
+{
+	if (fill_buffer != NULL) {
+		tegrabl_free(fill_buffer);
+		fill_buffer = NULL;
+		fill_buffer_size = 0;
+	}
+}
+
@@ -74,4 +74,24 @@ tegrabl_error_t tegrabl_fastboot_partition_write(const void *buffer,
  * @return TEGRABL_NO_ERROR if successful else appropriate error.
  */
 tegrabl_error_t tegrabl_fastboot_partition_seek(uint64_t size, void *aux_info);
+
+/**
+ * @brief Fills bytes of the partition from current location with a 32-bit
+ * value. Zero fills are erased when the device reads erased blocks as zero,
+ * other fills are written from a pattern buffer in large transfers.
+ *
+ * @param fill_value 32-bit value to be repeated
+ * @param size Bytes to fill from current location.
+ * @param aux_info Handle of partition.
+ *
+ * @return TEGRABL_NO_ERROR if successful, TEGRABL_ERR_NOT_SUPPORTED if the
+ * pattern buffer cannot be allocated, else appropriate error.
+ */
+tegrabl_error_t tegrabl_fastboot_partition_fill(uint32_t fill_value,
+												uint64_t size, void *aux_info);
+
+/**
+ * @brief Frees the pattern buffer kept by tegrabl_fastboot_partition_fill()
+ */
+void tegrabl_fastboot_partition_fill_done(void);
 #endif
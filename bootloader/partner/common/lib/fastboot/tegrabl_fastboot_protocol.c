@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2016-2020, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -36,8 +36,11 @@
  * SUCH DAMAGE.
  */
 
+#define MODULE TEGRABL_ERR_FASTBOOT
+
 #include <stdbool.h>
 #include <stdio.h>
+#include <inttypes.h>
 #include <tegrabl_debug.h>
 #include <tegrabl_error.h>
 #include <tegrabl_malloc.h>
@@ -48,9 +51,14 @@
 #include <tegrabl_transport_usbf.h>
 #include <tegrabl_partition_manager.h>
 #include <tegrabl_sparse.h>
+#include <tegrabl_decompress.h>
+#include <tegrabl_blockdev.h>
 #include <tegrabl_exit.h>
 #include <tegrabl_board_info.h>
 #include <linux_load.h>
+#if defined(CONFIG_ENABLE_STAGED_SCRUBBING)
+#include <tegrabl_linuxboot_helper.h>
+#endif
 #include <tegrabl_bootloader_update.h>
 #include <tegrabl_a_b_partition_naming.h>
 #include <menu.h>
@@ -58,6 +66,9 @@
 #define MAX_SERIALNO_LEN 32
 #define MAX_PART_NAME_LEN 16
 
+/* Compressed downloads are decompressed in chunks of this size */
+#define FASTBOOT_DECOMP_CHUNK_SIZE (4UL * 1024UL * 1024UL)
+
 static uint32_t fastboot_state = STATE_OFFLINE;
 static struct fastboot_cmd *cmdlist;
 static void *download_base;
@@ -471,10 +482,122 @@ static void cmd_boot(const char *arg, void *data, uint32_t sz)
 		return;
 	}
 
+#if defined(CONFIG_ENABLE_STAGED_SCRUBBING)
+	err = dram_staged_scrub_wait();
+	if (err != TEGRABL_NO_ERROR) {
+		pr_error("dram scrub failed\n");
+		return;
+	}
+#endif
+
 	kernel_entry = (void *)kernel_entry_point;
 	kernel_entry((uintptr_t) kernel_dtb);
 }
 
+/*
+ * Flashes a compressed download, decompressing it chunk by chunk into the
+ * partition or, if it holds a sparse image, into the unsparse machine.
+ */
+static tegrabl_error_t fastboot_flash_compressed(decompressor *decomp,
+												 struct tegrabl_partition *partition)
+{
+	struct tegrabl_unsparse_state unsparse_state;
+	uint8_t *chunk = NULL;
+	void *context = NULL;
+	uint32_t session = 0;
+	uint32_t in_pos = 0;
+	uint32_t used;
+	uint32_t written;
+	uint64_t total = 0;
+	bool is_sparse = false;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	pr_info("Flashing %s compressed image (%u bytes)\n", decomp->name, download_size);
+
+	chunk = tegrabl_memalign(TEGRABL_BLOCKDEV_MEM_ALIGN_SIZE, FASTBOOT_DECOMP_CHUNK_SIZE);
+	if (chunk == NULL) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
+		goto done;
+	}
+
+	context = decompress_stream_start(decomp, download_size, &session);
+	if (context == NULL) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_INIT_FAILED, 0);
+		goto done;
+	}
+
+	while (true) {
+		error = decomp->stream(context, (uint8_t *)download_base + in_pos,
+							   download_size - in_pos, &used, chunk,
+							   FASTBOOT_DECOMP_CHUNK_SIZE, &written);
+		if (error != TEGRABL_NO_ERROR) {
+			goto done;
+		}
+		in_pos += used;
+		if ((used == 0U) && (written == 0U)) {
+			break;
+		}
+		if (written == 0U) {
+			continue;
+		}
+
+		if (total == 0UL) {
+			is_sparse = tegrabl_sparse_image_check(chunk, written);
+			if (is_sparse) {
+				error = tegrabl_sparse_init_unsparse_state(&unsparse_state,
+					tegrabl_partition_size(partition),
+					tegrabl_fastboot_partition_write,
+					tegrabl_fastboot_partition_seek);
+				if (error != TEGRABL_NO_ERROR) {
+					pr_error("Failed to initialize unsparse state\n");
+					goto done;
+				}
+				tegrabl_sparse_set_unsparse_filler(&unsparse_state,
+												   tegrabl_fastboot_partition_fill);
+			}
+		}
+
+		if (is_sparse) {
+			error = tegrabl_sparse_unsparse(&unsparse_state, chunk, written, partition);
+		} else if ((total + written) > tegrabl_partition_size(partition)) {
+			pr_error("Decompressed image is larger than the partition\n");
+			error = TEGRABL_ERROR(TEGRABL_ERR_TOO_LARGE, 0);
+		} else {
+			error = tegrabl_fastboot_partition_write(chunk, written, partition);
+		}
+		if (error != TEGRABL_NO_ERROR) {
+			goto done;
+		}
+		total += written;
+	}
+
+	if (!decomp->stream_done(context)) {
+		pr_error("Compressed image is truncated (%u of %u bytes used)\n",
+				 in_pos, download_size);
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+		goto done;
+	}
+	if (in_pos != download_size) {
+		pr_error("Compressed image has trailing data (%u of %u bytes used)\n",
+				 in_pos, download_size);
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 1);
+		goto done;
+	}
+
+	pr_info("Wrote %"PRIu64" bytes%s\n", total, is_sparse ? " (unsparsed)" : "");
+
+done:
+	if (is_sparse) {
+		tegrabl_fastboot_partition_fill_done();
+	}
+	if ((context != NULL) && (decomp->end != NULL) &&
+		decompress_stream_is_valid(decomp, session)) {
+		decomp->end(context);
+	}
+	tegrabl_free(chunk);
+	return error;
+}
+
 static void cmd_flash(const char *arg, void *data, uint32_t sz)
 {
 	const struct tegrabl_fastboot_partition_info *partinfo = NULL;
@@ -482,6 +605,7 @@ static void cmd_flash(const char *arg, void *data, uint32_t sz)
 	struct tegrabl_partition partition;
 	bool is_sparse = false;
 	struct tegrabl_unsparse_state unsparse_state;
+	decompressor *decomp = NULL;
 	bool is_unlocked;
 	const char *suffix = NULL;
 	const char *tegra_part_name = NULL;
@@ -523,6 +647,14 @@ static void cmd_flash(const char *arg, void *data, uint32_t sz)
 		return;
 	}
 
+	if (download_size >= DECOMP_MAGIC_SIZE) {
+		decomp = decompress_method((uint8_t *)download_base, DECOMP_MAGIC_SIZE);
+		if ((decomp != NULL) && (decomp->stream != NULL)) {
+			error = fastboot_flash_compressed(decomp, &partition);
+			goto flash_exit;
+		}
+	}
+
 	is_sparse = tegrabl_sparse_image_check(download_base, download_size);
 
 	if (is_sparse) {
@@ -534,11 +666,14 @@ static void cmd_flash(const char *arg, void *data, uint32_t sz)
 			pr_error("Failed to initialize unsparse state\n");
 			return;
 		}
+		tegrabl_sparse_set_unsparse_filler(&unsparse_state,
+										   tegrabl_fastboot_partition_fill);
 	}
 
 	if (is_sparse) {
 		error = tegrabl_sparse_unsparse(&unsparse_state, download_base,
 										download_size, &partition);
+		tegrabl_fastboot_partition_fill_done();
 	} else {
 		tegrabl_fastboot_partition_write(download_base, download_size,
 										 &partition);
@@ -17,6 +17,15 @@
 #include <tegrabl_render_image.h>
 
 #define BMP_HEADER_LENGTH 54
+#define BMP_FILE_HEADER_LENGTH 14
+#define BMP_MAX_COLORS 256
+
+/* Destination rows produced per pass when blitting rotated by 90/270 */
+#define BMP_BLIT_TILE 8
+
+/* bitmap_info_header compression types */
+#define BMP_COMPRESSION_NONE 0
+#define BMP_COMPRESSION_RLE8 1
 
 /**
  * Defines BMP file Header
@@ -98,7 +107,7 @@ static void fill_bmp_header(struct bitmap_file *bmf, uint8_t *buf)
 	bmf->bih.width = hdr[9] | hdr[10] << 16;
 	bmf->bih.height = hdr[11] | hdr[12] << 16;
 	bmf->bih.planes = hdr[13];
-	bmf->bih.depth = hdr[14] | hdr[15] << 16;
+	bmf->bih.depth = hdr[14];
 	bmf->bih.compression_type = hdr[15] | hdr[16] << 16;
 	bmf->bih.image_size = hdr[17] | hdr[18] << 16;
 	bmf->bih.horizontal_resolution = hdr[19] | hdr[20] << 16;
@@ -146,6 +155,195 @@ fail:
 	return err;
 }
 
+/**
+ * Converts count pixels starting at src, step bytes apart, into the surface
+ * pixel format (A8B8G8R8, alpha left 0). A negative step walks backwards,
+ * a step of one source row walks down a column.
+ */
+typedef void (*bmp_row_fn)(uint32_t *dst, const uint8_t *src, intptr_t step,
+						   uint32_t count, const uint32_t *palette);
+
+static void bmp_row_32bpp(uint32_t *dst, const uint8_t *src, intptr_t step,
+						  uint32_t count, const uint32_t *palette)
+{
+	uint32_t v;
+	uint32_t i;
+
+	TEGRABL_UNUSED(palette);
+
+	/* B,G,R,X in memory is X<<24|R<<16|G<<8|B, byte reversal yields
+	 * B<<24|G<<16|R<<8|X */
+	for (i = 0; i < count; i++) {
+		memcpy(&v, src, sizeof(v));
+		dst[i] = __builtin_bswap32(v) >> 8;
+		src += step;
+	}
+}
+
+static void bmp_row_24bpp(uint32_t *dst, const uint8_t *src, intptr_t step,
+						  uint32_t count, const uint32_t *palette)
+{
+	uint32_t i;
+
+	TEGRABL_UNUSED(palette);
+
+	for (i = 0; i < count; i++) {
+		dst[i] = src[2] | (src[1] << 8) | (src[0] << 16);
+		src += step;
+	}
+}
+
+static void bmp_row_16bpp(uint32_t *dst, const uint8_t *src, intptr_t step,
+						  uint32_t count, const uint32_t *palette)
+{
+	uint32_t color, r, g, b;
+	uint32_t i;
+
+	TEGRABL_UNUSED(palette);
+
+	/* X1R5G5B5, each channel is widened to 8 bits */
+	for (i = 0; i < count; i++) {
+		color = src[0] | (src[1] << 8);
+		b = color & 0x1f;
+		g = (color >> 5) & 0x1f;
+		r = (color >> 10) & 0x1f;
+		b = (b << 3) | (b >> 2);
+		g = (g << 3) | (g >> 2);
+		r = (r << 3) | (r >> 2);
+		dst[i] = r | (g << 8) | (b << 16);
+		src += step;
+	}
+}
+
+static void bmp_row_8bpp(uint32_t *dst, const uint8_t *src, intptr_t step,
+						 uint32_t count, const uint32_t *palette)
+{
+	uint32_t i;
+
+	for (i = 0; i < count; i++) {
+		dst[i] = palette[*src];
+		src += step;
+	}
+}
+
+/* Mirrors the row addressing of tegrabl_surface_write(), pitch layout only */
+static uint32_t *bmp_surface_row(struct tegrabl_surface *surf, uint32_t x,
+								 uint32_t y, uint32_t row)
+{
+	uint8_t *dest;
+
+	dest = (uint8_t *)surf->base + (y * surf->pitch) + (x * sizeof(uint32_t));
+	if (surf->scan_format == SCAN_FORMAT_INTERLACIVE) {
+		dest += (row >> 1) * surf->pitch;
+		if ((row + y) & 1) {
+			dest += surf->second_field_offset;
+		}
+	} else {
+		dest += row * surf->pitch;
+	}
+
+	return (uint32_t *)dest;
+}
+
+/* Loads the color table following the info header into the surface format */
+static tegrabl_error_t bmp_load_palette(struct bitmap_file *bmf, uint8_t *buf,
+										uint32_t *palette)
+{
+	uint32_t num_colors = bmf->bih.num_colors;
+	uint32_t offset = BMP_FILE_HEADER_LENGTH + bmf->bih.header_size;
+	uint8_t *entry;
+	uint32_t i;
+
+	if ((num_colors == 0) || (num_colors > BMP_MAX_COLORS)) {
+		num_colors = BMP_MAX_COLORS;
+	}
+	if ((offset + (num_colors * 4)) > bmf->bfh.start_offset) {
+		pr_error("(%s) color table overlaps pixel data\n", __func__);
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 5);
+	}
+
+	memset(palette, 0, BMP_MAX_COLORS * sizeof(uint32_t));
+	entry = buf + offset;
+	for (i = 0; i < num_colors; i++) {
+		palette[i] = entry[2] | (entry[1] << 8) | (entry[0] << 16);
+		entry += 4;
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+/**
+ * Expands BI_RLE8 data into one palette index per pixel, rows stored
+ * bottom-up with a pitch of the image width. Pixels skipped by delta or
+ * end-of-line escapes keep index 0.
+ */
+static tegrabl_error_t bmp_decode_rle8(const uint8_t *src, uint32_t len,
+									   uint8_t *dst, uint32_t width,
+									   uint32_t height)
+{
+	const uint8_t *end = src + len;
+	uint32_t x = 0;
+	uint32_t y = 0;
+	uint32_t count;
+	uint8_t value;
+
+	while ((src + 2) <= end) {
+		count = *src++;
+		value = *src++;
+
+		if (count != 0) {
+			/* Encoded run */
+			if ((y >= height) || (count > (width - x))) {
+				goto fail;
+			}
+			memset(dst + (y * width) + x, value, count);
+			x += count;
+			continue;
+		}
+
+		switch (value) {
+		case 0:
+			/* End of line */
+			x = 0;
+			y++;
+			break;
+		case 1:
+			/* End of bitmap */
+			return TEGRABL_NO_ERROR;
+		case 2:
+			/* Delta */
+			if ((src + 2) > end) {
+				goto fail;
+			}
+			x += src[0];
+			y += src[1];
+			src += 2;
+			if (x > width) {
+				goto fail;
+			}
+			break;
+		default:
+			/* Absolute run of value pixels, padded to 16 bits */
+			count = value;
+			if ((y >= height) || (count > (width - x)) ||
+				((src + count) > end)) {
+				goto fail;
+			}
+			memcpy(dst + (y * width) + x, src, count);
+			x += count;
+			src += ALIGN(count, 2);
+			break;
+		}
+	}
+
+	/* Data ended without an end of bitmap escape, keep what was decoded */
+	return TEGRABL_NO_ERROR;
+
+fail:
+	pr_error("(%s) corrupt RLE8 data at line %u\n", __func__, y);
+	return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 6);
+}
+
 tegrabl_error_t tegrabl_render_bmp(struct tegrabl_surface *surf,
 								   uint8_t *buf, uint32_t length)
 {
@@ -154,21 +352,36 @@ tegrabl_error_t tegrabl_render_bmp(struct tegrabl_surface *surf,
 
 	uint32_t draw_height = 0;
 	uint32_t draw_width = 0;
-	uint32_t *temp1 = NULL;
-	uint32_t surface_offset, image_offset;
-	int32_t x, y;
-	uint32_t r, g, b;
-	uint32_t color = 0xffffff;
+	uint32_t *palette = NULL;
+	uint8_t *indices = NULL;
+	const uint8_t *pixels;
+	const uint8_t *src;
+	uint32_t width, height;
+	uint32_t src_pitch;
 	uint32_t bytes_per_pixel = 0;
-	uint32_t pixel_offset = 0;
 	uint32_t rotate_angle;
 	uint32_t x_off = 0, y_off = 0;
+	uint32_t row, col;
+	uint32_t tile = 0;
+	uint32_t i;
+	uint32_t *dst[BMP_BLIT_TILE];
+	uint32_t tile_pixels[BMP_BLIT_TILE];
+	intptr_t step;
+	bmp_row_fn convert_row;
 
 	if (!buf || !surf || !length) {
 		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 3);
 		goto fail;
 	}
 
+	/* Rows are written straight into the framebuffer, like
+	 * tegrabl_surface_write() only pitch linear surfaces are handled */
+	if (surf->layout != SURFACE_LAYOUT_PITCH) {
+		pr_error("(%s) Unsupported surface layout %u\n", __func__, surf->layout);
+		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 9);
+		goto fail;
+	}
+
 	/* Allocate bmp file structure */
 	bmf = tegrabl_malloc(sizeof(struct bitmap_file));
 	if (!bmf) {
@@ -185,9 +398,12 @@ tegrabl_error_t tegrabl_render_bmp(struct tegrabl_surface *surf,
 	length = bmf->bih.image_size;
 	pr_debug("%s, image size = %d\n", __func__, length);
 
-	if (bmf->bih.compression_type) {
+	if ((bmf->bih.compression_type != BMP_COMPRESSION_NONE) &&
+		!((bmf->bih.compression_type == BMP_COMPRESSION_RLE8) &&
+		  (bmf->bih.depth == 8))) {
 		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 4);
-		pr_error("(%s) Only uncompressed BMP image is supported\n",	__func__);
+		pr_error("(%s) Only uncompressed or RLE8 BMP image is supported\n",
+				 __func__);
 		goto fail;
 	}
 
@@ -196,16 +412,22 @@ tegrabl_error_t tegrabl_render_bmp(struct tegrabl_surface *surf,
 		pr_error("(%s) Invalid height or width in BMP image\n",	__func__);
 		goto fail;
 	}
+	width = (uint32_t)bmf->bih.width;
+	height = (uint32_t)bmf->bih.height;
+	if ((width == 0) || (height == 0)) {
+		/* Nothing to draw */
+		goto fail;
+	}
 
 	/* Get Panel details before setting up logistics */
 	rotate_angle = image_get_rotation_angle();
 
 	if ((rotate_angle == 90) || (rotate_angle == 270)) {
-		draw_height = bmf->bih.width;
-		draw_width = bmf->bih.height;
+		draw_height = width;
+		draw_width = height;
 	} else if ((rotate_angle == 0) || (rotate_angle == 180)) {
-		draw_height = bmf->bih.height;
-		draw_width = bmf->bih.width;
+		draw_height = height;
+		draw_width = width;
 	} else {
 		pr_error("Not a valid rotation angle\n");
 		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 5);
@@ -228,56 +450,115 @@ tegrabl_error_t tegrabl_render_bmp(struct tegrabl_surface *surf,
 	pr_debug("draw width = %d, draw height = %d\n",	draw_width, draw_height);
 
 	bytes_per_pixel = bmf->bih.depth / 8;
-	temp1 = tegrabl_malloc(draw_width * draw_height * sizeof(uint32_t));
-	memset(temp1, 0, draw_width * draw_height * sizeof(uint32_t));
-
-	for (y = 0; y < bmf->bih.height; y++) {
-		image_offset =  y * ALIGN(bmf->bih.width *
-			(bmf->bih.depth / (8 * sizeof(uint8_t))), sizeof(uint32_t));
-
-		for (x = 0; x < bmf->bih.width; x++) {
-			pixel_offset = image_offset + (x * bytes_per_pixel);
-			if (bytes_per_pixel == 2) {
-				color = bmf->bitmap_data[pixel_offset] |
-					(bmf->bitmap_data[pixel_offset + 1] << 8);
-				r = color & 0x1f;
-				g = (color >> 5) & 0x1f;
-				b = (color >> 10) & 0x1f;
-			} else if (bytes_per_pixel == 3 || bytes_per_pixel == 4) {
-				r = bmf->bitmap_data[pixel_offset];
-				g = bmf->bitmap_data[pixel_offset + 1];
-				b = bmf->bitmap_data[pixel_offset + 2];
+	switch (bmf->bih.depth) {
+	case 32:
+		convert_row = bmp_row_32bpp;
+		break;
+	case 24:
+		convert_row = bmp_row_24bpp;
+		break;
+	case 16:
+		convert_row = bmp_row_16bpp;
+		break;
+	case 8:
+		convert_row = bmp_row_8bpp;
+		break;
+	default:
+		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 8);
+		pr_error("(%s) Only 8,16,24 and 32 bits per pixel is supported\n",
+				 __func__);
+		goto fail;
+	}
+
+	if (bytes_per_pixel == 1) {
+		palette = tegrabl_malloc(BMP_MAX_COLORS * sizeof(uint32_t));
+		if (palette == NULL) {
+			err = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 2);
+			goto fail;
+		}
+		err = bmp_load_palette(bmf, buf, palette);
+		if (err != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+	}
+
+	if (bmf->bih.compression_type == BMP_COMPRESSION_RLE8) {
+		indices = tegrabl_calloc(1, width * height);
+		if (indices == NULL) {
+			err = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 3);
+			goto fail;
+		}
+		err = bmp_decode_rle8(bmf->bitmap_data, length, indices, width, height);
+		if (err != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+		pixels = indices;
+		src_pitch = width;
+	} else {
+		pixels = bmf->bitmap_data;
+		src_pitch = ALIGN(width * bytes_per_pixel, sizeof(uint32_t));
+		if (((uint64_t)src_pitch * height) > length) {
+			err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 7);
+			pr_error("(%s) BMP pixel data is truncated\n", __func__);
+			goto fail;
+		}
+	}
+
+	/*
+	 * Rows are stored bottom-up. Destination rows are built straight in the
+	 * surface: for 0/180 degrees each one is a source row walked forwards or
+	 * backwards, for 90/270 degrees each one is a source column.
+	 */
+	if ((rotate_angle == 0) || (rotate_angle == 180)) {
+		for (row = 0; row < draw_height; row++) {
+			if (rotate_angle == 180) {
+				src = pixels + (row * src_pitch) +
+					((width - 1) * bytes_per_pixel);
+				step = -(intptr_t)bytes_per_pixel;
 			} else {
-				err = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 8);
-				pr_error("(%s) Only 16,24 and 32 bits per pixel is supported\n",
-						 __func__);
-				goto fail;
+				src = pixels + ((height - 1 - row) * src_pitch);
+				step = (intptr_t)bytes_per_pixel;
 			}
-			color = b | (g << 8) | (r << 16);
-			if (rotate_angle == 90) {
-				surface_offset = x * draw_width;
-				temp1[surface_offset + y] = color;
-			} else if (rotate_angle == 180) {
-				surface_offset = y * draw_width;
-				temp1[surface_offset + (draw_width - x - 1)] = color;
-			} else if (rotate_angle == 270) {
-				surface_offset = (draw_height - x - 1) * draw_width;
-				temp1[surface_offset + (draw_width - y - 1)] = color;
-			} else {
-				surface_offset = (draw_height - y - 1) * draw_width;
-				temp1[surface_offset + x] = color;
+			convert_row(bmp_surface_row(surf, x_off, y_off, row), src, step,
+						draw_width, palette);
+		}
+	} else {
+		/*
+		 * Walking a source column touches a new line for every pixel, so
+		 * produce BMP_BLIT_TILE destination rows at a time from contiguous
+		 * pieces of each source row.
+		 */
+		for (row = 0; row < draw_height; row += tile) {
+			tile = MIN(draw_height - row, BMP_BLIT_TILE);
+			for (i = 0; i < tile; i++) {
+				dst[i] = bmp_surface_row(surf, x_off, y_off, row + i);
+			}
+			for (col = 0; col < draw_width; col++) {
+				if (rotate_angle == 90) {
+					src = pixels + (col * src_pitch) + (row * bytes_per_pixel);
+					step = (intptr_t)bytes_per_pixel;
+				} else {
+					src = pixels + ((height - 1 - col) * src_pitch) +
+						((width - 1 - row) * bytes_per_pixel);
+					step = -(intptr_t)bytes_per_pixel;
+				}
+				convert_row(tile_pixels, src, step, tile, palette);
+				for (i = 0; i < tile; i++) {
+					dst[i][col] = tile_pixels[i];
+				}
 			}
 		}
 	}
-	err = tegrabl_surface_write(surf, x_off, y_off,	draw_width, draw_height,
-								temp1);
 
 fail:
 	if (err != TEGRABL_NO_ERROR) {
 		pr_error("Unsuccesful attempt to draw BMP image\n");
 	}
-	if (temp1 != NULL) {
-		tegrabl_free(temp1);
+	if (indices != NULL) {
+		tegrabl_free(indices);
+	}
+	if (palette != NULL) {
+		tegrabl_free(palette);
 	}
 	if (bmf != NULL) {
 		tegrabl_free(bmf);
@@ -20,6 +20,9 @@
 #include <tegrabl_ipc_soc.h>
 #include <tegrabl_soc_misc.h>
 #include <tegrabl_io.h>
+#if defined(CONFIG_ENABLE_BPMP_IPC_LOCK)
+#include <kernel/mutex.h>
+#endif
 
 #define KB (1024LU)
 #define MB (1024*KB)
@@ -54,6 +57,11 @@
 #define FLAG_DO_ACK                     (1 << 0)
 #define FLAG_RING_DOORBELL              (1 << 1)
 
+#if defined(CONFIG_ENABLE_BPMP_IPC_LOCK)
+/* The channel has a single outstanding frame, one request at a time */
+static mutex_t bpmp_xfer_lock = MUTEX_INITIAL_VALUE(bpmp_xfer_lock);
+#endif
+
 #define HSP_DB_READ(reg)        NV_READ32(NV_ADDRESS_MAP_TOP0_HSP_DB_0_BASE \
 											+ reg)
 #define HSP_DB_WRITE(reg, val)  NV_WRITE32((NV_ADDRESS_MAP_TOP0_HSP_DB_0_BASE \
@@ -391,6 +399,10 @@ tegrabl_error_t tegrabl_ccplex_bpmp_xfer(
 		return -1;
 	}
 
+#if defined(CONFIG_ENABLE_BPMP_IPC_LOCK)
+	mutex_acquire(&bpmp_xfer_lock);
+#endif
+
 	NV_CHECK_ERROR_CLEANUP(tegrabl_do_sanity_check());
 
 	p = s_ipc_callbacks->get_next_out_frame(channel_id);
@@ -422,9 +434,17 @@ tegrabl_error_t tegrabl_ccplex_bpmp_xfer(
 	}
 	NV_CHECK_ERROR_CLEANUP(s_ipc_callbacks->free_master(channel_id));
 
+#if defined(CONFIG_ENABLE_BPMP_IPC_LOCK)
+	mutex_release(&bpmp_xfer_lock);
+#endif
+
 	return TEGRABL_NO_ERROR;
 
 fail:
+#if defined(CONFIG_ENABLE_BPMP_IPC_LOCK)
+	mutex_release(&bpmp_xfer_lock);
+#endif
+
 	if (e) {
 		pr_error("%s: failed to send/receive, err:%x\n", __func__, e);
 	}
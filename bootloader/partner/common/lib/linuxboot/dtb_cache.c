@@ -0,0 +1,315 @@
+/*
+ * Copyright (c) 2020, NVIDIA Corporation.  All Rights Reserved.
+ *
+ * NVIDIA Corporation and its licensors retain all intellectual property and
+ * proprietary rights in and to this software and related documentation.  Any
+ * use, reproduction, disclosure or distribution of this software and related
+ * documentation without an express license agreement from NVIDIA Corporation
+ * is strictly prohibited.
+ */
+
+#define MODULE TEGRABL_ERR_LINUXBOOT
+
+#include "build_config.h"
+
+#if defined(CONFIG_ENABLE_DTB_CACHE)
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <libfdt.h>
+#include <tegrabl_error.h>
+#include <tegrabl_debug.h>
+#include <tegrabl_utils.h>
+#include <tegrabl_malloc.h>
+#include <tegrabl_linuxboot_helper.h>
+#include <tegrabl_sdram_usage.h>
+#include <tegrabl_devicetree.h>
+#include <tegrabl_odmdata_lib.h>
+#include <tegrabl_board_info.h>
+#include <tegrabl_soc_misc.h>
+#include <tegrabl_fuse.h>
+#include <tegrabl_partition_manager.h>
+#include <tegrabl_blockdev.h>
+#include <tegrabl_nct.h>
+#include <mincrypt/sha256.h>
+#include <dtb_cache.h>
+
+#define DTB_CACHE_MAGIC 0x43425444U /* "DTBC" */
+/* Bump when the header or the set of hashed inputs changes */
+#define DTB_CACHE_VERSION 1U
+/* The DTB starts at the next sector */
+#define DTB_CACHE_HEADER_SIZE 512U
+
+struct dtb_cache_header {
+	uint32_t magic;
+	uint32_t version;
+	uint8_t key[SHA256_DIGEST_SIZE];
+	uint32_t dtb_size;
+	uint32_t dtb_crc;
+};
+
+static uint8_t dtb_cache_key[SHA256_DIGEST_SIZE];
+static bool dtb_cache_key_valid;
+
+static void dtb_cache_hash(struct HASH_CTX *ctx, const void *data, uint32_t size)
+{
+	/* Size goes in first so that moving bytes between inputs changes the key */
+	sha256_update(ctx, &size, sizeof(size));
+	if (size != 0U) {
+		sha256_update(ctx, data, (int)size);
+	}
+}
+
+static tegrabl_error_t dtb_cache_compute_key(void *fdt, uint8_t *key)
+{
+	struct HASH_CTX ctx;
+	void *bl_fdt = NULL;
+	char sno[SNO_SIZE + 1];
+	uint32_t odmdata;
+	struct tegrabl_chip_info chip_info;
+	struct tegrabl_linuxboot_memblock *memblk = NULL;
+	struct tegrabl_linuxboot_memblock region;
+	uint32_t num_memblk = 0;
+	uint32_t idx;
+#if defined(CONFIG_ENABLE_NCT)
+	char id[NCT_MAX_SPEC_LENGTH], config[NCT_MAX_SPEC_LENGTH];
+#endif
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	/* Plugin-manager ids are read from the EEPROMs when the BL DTB does not
+	 * carry them; the EEPROM contents are not part of the key */
+	err = tegrabl_dt_get_fdt_handle(TEGRABL_DT_BL, &bl_fdt);
+	if ((err != TEGRABL_NO_ERROR) || (bl_fdt == NULL) ||
+		(fdt_path_offset(bl_fdt, "/chosen/plugin-manager") < 0)) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
+		goto fail;
+	}
+
+	memset(sno, 0, sizeof(sno));
+	err = tegrabl_get_serial_no((uint8_t *)sno);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	err = tegrabl_get_memblk_info_array(&num_memblk, &memblk);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	sha256_init(&ctx);
+
+	dtb_cache_hash(&ctx, fdt, fdt_totalsize(fdt));
+	dtb_cache_hash(&ctx, bl_fdt, fdt_totalsize(bl_fdt));
+
+	odmdata = tegrabl_odmdata_get();
+	dtb_cache_hash(&ctx, &odmdata, sizeof(odmdata));
+	dtb_cache_hash(&ctx, sno, sizeof(sno));
+
+	memset(&chip_info, 0, sizeof(chip_info));
+	tegrabl_get_chip_info(&chip_info);
+	dtb_cache_hash(&ctx, &chip_info, sizeof(chip_info));
+
+#if defined(CONFIG_ENABLE_NCT)
+	memset(id, 0, sizeof(id));
+	memset(config, 0, sizeof(config));
+	if (tegrabl_nct_get_spec(id, config) == TEGRABL_NO_ERROR) {
+		dtb_cache_hash(&ctx, id, sizeof(id));
+		dtb_cache_hash(&ctx, config, sizeof(config));
+	}
+#endif
+
+	dtb_cache_hash(&ctx, memblk, num_memblk * sizeof(*memblk));
+
+	for (idx = 0; ; idx++) {
+		err = tegrabl_linuxboot_helper_get_info(TEGRABL_LINUXBOOT_INFO_DTB_CACHE_KEY,
+												&idx, &region);
+		if (err != TEGRABL_NO_ERROR) {
+			/* The platform must describe its inputs for the key to be valid */
+			goto fail;
+		}
+		if (region.size == 0U) {
+			break;
+		}
+		dtb_cache_hash(&ctx, (void *)(uintptr_t)region.base, (uint32_t)region.size);
+	}
+
+	memcpy(key, sha256_final(&ctx), SHA256_DIGEST_SIZE);
+
+fail:
+	return err;
+}
+
+/*
+ * The cache partition is optional, so look for it only on devices that are
+ * already registered: a miss must neither log an error nor bring up
+ * deferred storage.
+ */
+static tegrabl_error_t dtb_cache_partition_open(struct tegrabl_partition *part)
+{
+	tegrabl_bdev_t *bdev = NULL;
+	tegrabl_error_t err = TEGRABL_ERROR(TEGRABL_ERR_NOT_FOUND, 0);
+
+	while ((bdev = tegrabl_blockdev_next_device(bdev)) != NULL) {
+		err = tegrabl_partition_lookup_bdev(DTB_CACHE_PARTITION_NAME, part, bdev);
+		if (err == TEGRABL_NO_ERROR) {
+			break;
+		}
+	}
+
+	if (err != TEGRABL_NO_ERROR) {
+		pr_debug("%s partition not present\n", DTB_CACHE_PARTITION_NAME);
+	}
+	return err;
+}
+
+bool tegrabl_linuxboot_dtb_cache_load(void *fdt)
+{
+	struct tegrabl_partition part;
+	struct dtb_cache_header hdr;
+	void *buf = NULL;
+	bool part_open = false;
+	bool loaded = false;
+	tegrabl_error_t err;
+
+	dtb_cache_key_valid = false;
+
+	/* The cache partition is not covered by the kernel-dtb signature */
+	if (fuse_is_odm_production_mode()) {
+		goto done;
+	}
+
+	err = dtb_cache_compute_key(fdt, dtb_cache_key);
+	if (err != TEGRABL_NO_ERROR) {
+		pr_debug("%s: no key (err=%x)\n", __func__, err);
+		goto done;
+	}
+
+	err = dtb_cache_partition_open(&part);
+	if (err != TEGRABL_NO_ERROR) {
+		goto done;
+	}
+	part_open = true;
+	dtb_cache_key_valid = true;
+
+	err = tegrabl_partition_read(&part, &hdr, sizeof(hdr));
+	if (err != TEGRABL_NO_ERROR) {
+		goto done;
+	}
+
+	if ((hdr.magic != DTB_CACHE_MAGIC) || (hdr.version != DTB_CACHE_VERSION) ||
+		(memcmp(hdr.key, dtb_cache_key, SHA256_DIGEST_SIZE) != 0)) {
+		pr_info("Kernel DTB cache is stale\n");
+		goto done;
+	}
+
+	if ((hdr.dtb_size > DTB_MAX_SIZE) ||
+		((DTB_CACHE_HEADER_SIZE + (uint64_t)hdr.dtb_size) > tegrabl_partition_size(&part))) {
+		goto done;
+	}
+
+	/* fdt still has to be fixed up if the cached copy turns out to be bad */
+	buf = tegrabl_malloc(hdr.dtb_size);
+	if (buf == NULL) {
+		goto done;
+	}
+
+	err = tegrabl_partition_seek(&part, DTB_CACHE_HEADER_SIZE, TEGRABL_PARTITION_SEEK_SET);
+	if (err != TEGRABL_NO_ERROR) {
+		goto done;
+	}
+	err = tegrabl_partition_read(&part, buf, hdr.dtb_size);
+	if (err != TEGRABL_NO_ERROR) {
+		goto done;
+	}
+
+	if ((tegrabl_utils_crc32(0, buf, hdr.dtb_size) != hdr.dtb_crc) ||
+		(fdt_check_header(buf) != 0) || (fdt_totalsize(buf) != hdr.dtb_size)) {
+		pr_warn("Kernel DTB cache is corrupted\n");
+		goto done;
+	}
+
+	memcpy(fdt, buf, hdr.dtb_size);
+	loaded = true;
+	pr_info("Using cached kernel DTB\n");
+
+done:
+	if (buf != NULL) {
+		tegrabl_free(buf);
+	}
+	if (part_open) {
+		tegrabl_partition_close(&part);
+	}
+	return loaded;
+}
+
+void tegrabl_linuxboot_dtb_cache_store(void *fdt)
+{
+	struct tegrabl_partition part;
+	struct dtb_cache_header *hdr;
+	uint32_t dtb_size = fdt_totalsize(fdt);
+	uint8_t *buf = NULL;
+	bool part_open = false;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	if (!dtb_cache_key_valid) {
+		goto done;
+	}
+	dtb_cache_key_valid = false;
+
+	err = dtb_cache_partition_open(&part);
+	if (err != TEGRABL_NO_ERROR) {
+		goto done;
+	}
+	part_open = true;
+
+	if ((DTB_CACHE_HEADER_SIZE + (uint64_t)dtb_size) > tegrabl_partition_size(&part)) {
+		pr_warn("Kernel DTB (%u bytes) does not fit %s\n", dtb_size, DTB_CACHE_PARTITION_NAME);
+		goto done;
+	}
+
+	/* Header and DTB go out in one write; a torn write fails the crc check */
+	buf = tegrabl_malloc(DTB_CACHE_HEADER_SIZE + dtb_size);
+	if (buf == NULL) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
+		goto done;
+	}
+	memset(buf, 0, DTB_CACHE_HEADER_SIZE);
+	memcpy(buf + DTB_CACHE_HEADER_SIZE, fdt, dtb_size);
+
+	hdr = (struct dtb_cache_header *)buf;
+	hdr->magic = DTB_CACHE_MAGIC;
+	hdr->version = DTB_CACHE_VERSION;
+	memcpy(hdr->key, dtb_cache_key, SHA256_DIGEST_SIZE);
+	hdr->dtb_size = dtb_size;
+	hdr->dtb_crc = tegrabl_utils_crc32(0, buf + DTB_CACHE_HEADER_SIZE, dtb_size);
+
+#if defined(CONFIG_ENABLE_QSPI)
+	if (tegrabl_blockdev_get_storage_type(part.block_device) == TEGRABL_STORAGE_QSPI_FLASH) {
+		err = tegrabl_partition_erase(&part, false);
+		if (err != TEGRABL_NO_ERROR) {
+			goto done;
+		}
+	}
+#endif
+
+	err = tegrabl_partition_write(&part, buf, DTB_CACHE_HEADER_SIZE + dtb_size);
+	if (err != TEGRABL_NO_ERROR) {
+		goto done;
+	}
+
+	pr_info("Saved kernel DTB to %s\n", DTB_CACHE_PARTITION_NAME);
+
+done:
+	if (err != TEGRABL_NO_ERROR) {
+		pr_warn("Failed to update kernel DTB cache (err=%x)\n", err);
+	}
+	if (buf != NULL) {
+		tegrabl_free(buf);
+	}
+	if (part_open) {
+		tegrabl_partition_close(&part);
+	}
+}
+
+#endif /* CONFIG_ENABLE_DTB_CACHE */
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2020, NVIDIA Corporation.  All Rights Reserved.
+ *
+ * NVIDIA Corporation and its licensors retain all intellectual property and
+ * proprietary rights in and to this software and related documentation.  Any
+ * use, reproduction, disclosure or distribution of this software and related
+ * documentation without an express license agreement from NVIDIA Corporation
+ * is strictly prohibited.
+ */
+
+#ifndef INCLUDED_DTB_CACHE_H
+#define INCLUDED_DTB_CACHE_H
+
+#if defined(CONFIG_ENABLE_DTB_CACHE)
+
+#include <stdbool.h>
+
+/* Partition holding the kernel DTB from the last boot, after all fixups that
+ * are not TEGRABL_LINUXBOOT_DTNODE_PER_BOOT */
+#define DTB_CACHE_PARTITION_NAME "kernel-dtb-cache"
+
+/**
+ * @brief Computes the digest of all inputs to the kernel DTB fixups (the
+ * DTB itself, BL DTB, odmdata, serial number, chip info, DRAM layout and the
+ * platform inputs from TEGRABL_LINUXBOOT_INFO_DTB_CACHE_KEY) and, if the
+ * cache partition holds a DTB for the same digest, copies it over fdt.
+ *
+ * @param fdt kernel DTB, not modified unless the cached DTB is used
+ *
+ * @return true if fdt was replaced with the cached DTB
+ */
+bool tegrabl_linuxboot_dtb_cache_load(void *fdt);
+
+/**
+ * @brief Saves fdt to the cache partition under the digest computed by the
+ * last tegrabl_linuxboot_dtb_cache_load() call. Failures are not fatal, the
+ * cache is just not updated.
+ *
+ * @param fdt kernel DTB with the cacheable fixups applied
+ */
+void tegrabl_linuxboot_dtb_cache_store(void *fdt);
+
+#endif /* CONFIG_ENABLE_DTB_CACHE */
+
+#endif /* INCLUDED_DTB_CACHE_H */
@@ -28,6 +28,7 @@
 #include <tegrabl_board_info.h>
 #include <tegrabl_nct.h>
 #include <tegrabl_sdram_usage.h>
+#include <dtb_cache.h>
 
 #if defined(CONFIG_ENABLE_DISPLAY)
 #include <tegrabl_display.h>
@@ -725,13 +726,13 @@ fail:
 static struct tegrabl_linuxboot_dtnode_info common_nodes[] = {
 	/* keep this sorted by the node_name field */
 	{ "bpmp", add_bpmp_info},
-	{ "chosen", add_initrd_info},
+	{ "chosen", add_initrd_info, TEGRABL_LINUXBOOT_DTNODE_PER_BOOT},
 #if defined(POPULATE_BOARDINFO) /* Only use this for T210 */
-	{ "chosen", add_board_info},
+	{ "chosen", add_board_info, TEGRABL_LINUXBOOT_DTNODE_PER_BOOT},
 #endif
-	{ "chosen", add_bootarg_info},
+	{ "chosen", add_bootarg_info, TEGRABL_LINUXBOOT_DTNODE_PER_BOOT},
 #if defined(CONFIG_ENABLE_EEPROM)
-	{ "chosen", add_mac_addr_info},
+	{ "chosen", add_mac_addr_info, TEGRABL_LINUXBOOT_DTNODE_PER_BOOT},
 #endif
 #if defined(CONFIG_ENABLE_PLUGIN_MANAGER)
 	{ "chosen", add_plugin_manager_ids},
@@ -742,7 +743,7 @@ static struct tegrabl_linuxboot_dtnode_info common_nodes[] = {
 #endif
 	{ "memory", add_memory_info},
 #if defined(CONFIG_ENABLE_DISPLAY)
-	{ "reserved-memory", add_disp_param},
+	{ "reserved-memory", add_disp_param, TEGRABL_LINUXBOOT_DTNODE_PER_BOOT},
 #endif
 	{ NULL, NULL},
 };
@@ -805,22 +806,23 @@ tegrabl_error_t tegrabl_get_memblk_info_array(uint32_t *array_items_num,
 	return TEGRABL_NO_ERROR;
 }
 
-tegrabl_error_t tegrabl_linuxboot_update_dtb(void *fdt)
+/* Fills the nodes whose (flags & flags_mask) equals flags */
+static tegrabl_error_t fill_dt_nodes(void *fdt, struct tegrabl_linuxboot_dtnode_info *nodes,
+									 uint32_t flags_mask, uint32_t flags)
 {
 	uint32_t i;
 	int node = -1;
 	int prev_offset = -1;
 	char *prev_name = NULL;
 	tegrabl_error_t status;
-	struct tegrabl_linuxboot_dtnode_info *extra_nodes = NULL;
 
-	if (fdt == NULL)
-		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+	for (i = 0; nodes[i].node_name != NULL; i++) {
+		if ((nodes[i].flags & flags_mask) != flags)
+			continue;
 
-	for (i = 0; common_nodes[i].node_name != NULL; i++) {
-		if (!prev_name || strcmp(prev_name, common_nodes[i].node_name)) {
+		if (!prev_name || strcmp(prev_name, nodes[i].node_name)) {
 			node = tegrabl_add_subnode_if_absent(fdt, 0,
-				common_nodes[i].node_name);
+				nodes[i].node_name);
 		} else {
 			node = prev_offset;
 		}
@@ -829,50 +831,56 @@ tegrabl_error_t tegrabl_linuxboot_update_dtb(void *fdt)
 			continue;
 
 		prev_offset = node;
-		prev_name = common_nodes[i].node_name;
+		prev_name = nodes[i].node_name;
 
-		pr_debug("%d) node_name=%s\n", i, common_nodes[i].node_name);
+		pr_debug("%d) node_name=%s\n", i, nodes[i].node_name);
 
-		if (common_nodes[i].fill_dtnode) {
-			status = common_nodes[i].fill_dtnode(fdt, node);
-		    if (status != TEGRABL_NO_ERROR) {
+		if (nodes[i].fill_dtnode) {
+			status = nodes[i].fill_dtnode(fdt, node);
+			if (status != TEGRABL_NO_ERROR) {
 				pr_error("%s: %p failed\n", __func__,
-						 common_nodes[i].fill_dtnode);
+						 nodes[i].fill_dtnode);
 				return status;
 			}
 		}
 	}
 
-	prev_name = NULL;
-	if (tegrabl_linuxboot_helper_get_info(TEGRABL_LINUXBOOT_INFO_EXTRA_DT_NODES,
-			NULL, &extra_nodes) == TEGRABL_NO_ERROR) {
-		pr_debug("%s: extra_nodes: %p\n", __func__, extra_nodes);
-
-		for (i = 0; extra_nodes[i].node_name != NULL; i++) {
-			if (!prev_name || strcmp(prev_name, extra_nodes[i].node_name)) {
-				node = tegrabl_add_subnode_if_absent(fdt, 0,
-					extra_nodes[i].node_name);
-			} else {
-				node = prev_offset;
-			}
+	return TEGRABL_NO_ERROR;
+}
 
-			if (node < 0)
-				continue;
+tegrabl_error_t tegrabl_linuxboot_update_dtb(void *fdt)
+{
+	tegrabl_error_t status;
+	struct tegrabl_linuxboot_dtnode_info *extra_nodes = NULL;
+#if defined(CONFIG_ENABLE_DTB_CACHE)
+	/* Per-boot nodes are filled last, on top of the (cached) rest */
+	uint32_t flags_mask = TEGRABL_LINUXBOOT_DTNODE_PER_BOOT;
+#else
+	uint32_t flags_mask = 0;
+#endif
 
-			prev_offset = node;
-			prev_name = extra_nodes[i].node_name;
+	if (fdt == NULL)
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
 
-			pr_debug("%d) node_name=%s\n", i, extra_nodes[i].node_name);
+	if (tegrabl_linuxboot_helper_get_info(TEGRABL_LINUXBOOT_INFO_EXTRA_DT_NODES,
+			NULL, &extra_nodes) != TEGRABL_NO_ERROR) {
+		extra_nodes = NULL;
+	}
+	pr_debug("%s: extra_nodes: %p\n", __func__, extra_nodes);
 
-			if (extra_nodes[i].fill_dtnode) {
-				status = extra_nodes[i].fill_dtnode(fdt, node);
-				if (status != TEGRABL_NO_ERROR) {
-					pr_error("%s: %p failed\n", __func__,
-							 extra_nodes[i].fill_dtnode);
-					return status;
-				}
-			}
-		}
+#if defined(CONFIG_ENABLE_DTB_CACHE)
+	if (tegrabl_linuxboot_dtb_cache_load(fdt))
+		goto per_boot;
+#endif
+
+	status = fill_dt_nodes(fdt, common_nodes, flags_mask, 0);
+	if (status != TEGRABL_NO_ERROR)
+		return status;
+
+	if (extra_nodes != NULL) {
+		status = fill_dt_nodes(fdt, extra_nodes, flags_mask, 0);
+		if (status != TEGRABL_NO_ERROR)
+			return status;
 	}
 
 	/* update secureos nodes present in kernel dtb */
@@ -886,6 +894,21 @@ tegrabl_error_t tegrabl_linuxboot_update_dtb(void *fdt)
 	tegrabl_plugin_manager_overlay(fdt);
 #endif
 
+#if defined(CONFIG_ENABLE_DTB_CACHE)
+	tegrabl_linuxboot_dtb_cache_store(fdt);
+
+per_boot:
+	status = fill_dt_nodes(fdt, common_nodes, flags_mask, TEGRABL_LINUXBOOT_DTNODE_PER_BOOT);
+	if (status != TEGRABL_NO_ERROR)
+		return status;
+
+	if (extra_nodes != NULL) {
+		status = fill_dt_nodes(fdt, extra_nodes, flags_mask, TEGRABL_LINUXBOOT_DTNODE_PER_BOOT);
+		if (status != TEGRABL_NO_ERROR)
+			return status;
+	}
+#endif
+
 	pr_debug("%s: done\n", __func__);
 
 	return TEGRABL_NO_ERROR;
@@ -30,6 +30,9 @@
 #include <extlinux_boot.h>
 #include <linux_load.h>
 #include <tegrabl_auth.h>
+#if defined(CONFIG_ENABLE_EXTLINUX_PRELOAD)
+#include <kernel/thread.h>
+#endif
 
 #define EXTLINUX_CONF_PATH			"/boot/extlinux/extlinux.conf"
 #define EXTLINUX_CONF_MAX_SIZE		4096UL
@@ -41,6 +44,45 @@ static bool extlinux_boot_is_success;
 static char *g_ramdisk_path;
 static char *g_boot_args;
 
+#if defined(CONFIG_ENABLE_EXTLINUX_PRELOAD)
+/* Same as the kernel_boot app, signature validation runs on this stack */
+#define EXTLINUX_PRELOAD_STACK_SIZE	32768
+
+/*
+ * Images of the default entry are loaded (and validated) by a background
+ * thread while the boot menu waits for input. If the default entry gets
+ * booted they are used as they are, otherwise the images of the selected
+ * entry are loaded over them. The menu does not touch storage or the heap,
+ * and the thread is joined before the menu returns.
+ */
+struct extlinux_preload {
+	thread_t *thread;
+	struct tegrabl_fm_handle *fm_handle;
+	uint32_t entry;
+	char *linux_path;
+	char *dtb_path;
+	char *initrd_path;
+	volatile bool cancel;
+	bool kernel_ready;
+	bool dtb_ready;
+	bool ramdisk_ready;
+	uint32_t kernel_size;
+	/* Load addresses are handed out once each, keep the ones used */
+	void *dtb_addr;
+	void *ramdisk_addr;
+	uint32_t ramdisk_size;
+};
+
+static struct extlinux_preload preload;
+
+static tegrabl_error_t load_binary_with_sig(struct tegrabl_fm_handle *fm_handle,
+											uint32_t bin_type,
+											uint32_t bin_max_size,
+											char *bin_path,
+											void *bin_load_addr,
+											uint32_t *load_size);
+#endif
+
 static char *skip_leading_whitespace(char * const str)
 {
 	char *first_non_space_char = str;
@@ -256,6 +298,108 @@ fail:
 	return err;
 }
 
+#if defined(CONFIG_ENABLE_EXTLINUX_PRELOAD)
+static int extlinux_preload_thread(void *arg)
+{
+	struct extlinux_preload *p = (struct extlinux_preload *)arg;
+	void *load_addr = NULL;
+	uint32_t file_size;
+	tegrabl_error_t err;
+
+	err = tegrabl_get_boot_img_load_addr(&load_addr);
+	if (err != TEGRABL_NO_ERROR) {
+		goto exit;
+	}
+	err = load_binary_with_sig(p->fm_handle, TEGRABL_BINARY_KERNEL, BOOT_IMAGE_MAX_SIZE,
+							   p->linux_path, load_addr, &p->kernel_size);
+	if (err != TEGRABL_NO_ERROR) {
+		goto exit;
+	}
+	p->kernel_ready = true;
+
+#if defined(CONFIG_DT_SUPPORT)
+	/* Only needed if there is no kernel-dtb yet, same as when booting */
+	err = tegrabl_dt_get_fdt_handle(TEGRABL_DT_KERNEL, &load_addr);
+	if ((err != TEGRABL_NO_ERROR) || (load_addr == NULL)) {
+		if (p->cancel) {
+			goto exit;
+		}
+		p->dtb_addr = (void *)tegrabl_get_dtb_load_addr();
+		err = load_binary_with_sig(p->fm_handle, TEGRABL_BINARY_KERNEL_DTB, DTB_MAX_SIZE,
+								   p->dtb_path, p->dtb_addr, &file_size);
+		if (err != TEGRABL_NO_ERROR) {
+			goto exit;
+		}
+		p->dtb_ready = true;
+	}
+#endif
+
+	if ((p->initrd_path == NULL) || p->cancel) {
+		goto exit;
+	}
+	file_size = RAMDISK_MAX_SIZE;
+	p->ramdisk_addr = (void *)tegrabl_get_ramdisk_load_addr();
+	err = tegrabl_fm_read(p->fm_handle, p->initrd_path, NULL, p->ramdisk_addr, &file_size, NULL);
+	if (err != TEGRABL_NO_ERROR) {
+		goto exit;
+	}
+	p->ramdisk_size = file_size;
+	p->ramdisk_ready = true;
+
+exit:
+	return 0;
+}
+
+static void extlinux_preload_start(struct tegrabl_fm_handle *fm_handle,
+								   struct conf * const extlinux_conf)
+{
+	struct boot_section *section;
+
+	memset(&preload, 0, sizeof(preload));
+
+	if (extlinux_conf->default_boot_entry >= extlinux_conf->num_boot_entries) {
+		return;
+	}
+	section = extlinux_conf->section[extlinux_conf->default_boot_entry];
+	if (section == NULL) {
+		return;
+	}
+
+	preload.fm_handle = fm_handle;
+	preload.entry = extlinux_conf->default_boot_entry;
+	preload.linux_path = section->linux_path;
+	preload.dtb_path = section->dtb_path;
+	preload.initrd_path = section->initrd_path;
+
+	preload.thread = thread_create("extlinux-preload", extlinux_preload_thread, &preload,
+								   DEFAULT_PRIORITY, EXTLINUX_PRELOAD_STACK_SIZE);
+	if (preload.thread == NULL) {
+		pr_warn("Failed to start preload of default boot entry\n");
+		return;
+	}
+	thread_resume(preload.thread);
+}
+
+static void extlinux_preload_finish(uint32_t entry)
+{
+	if (preload.thread == NULL) {
+		return;
+	}
+
+	/* A read in flight cannot be aborted, only the remaining ones are skipped */
+	preload.cancel = (entry != preload.entry);
+	thread_join(preload.thread, NULL, INFINITE_TIME);
+	preload.thread = NULL;
+
+	if (preload.cancel) {
+		pr_info("Discarding preloaded images of default boot entry\n");
+		preload.kernel_ready = false;
+		preload.dtb_ready = false;
+		preload.ramdisk_ready = false;
+	}
+}
+#endif
+
 static int display_boot_menu(struct conf * const extlinux_conf)
 {
 	uint32_t idx;
@@ -320,8 +464,16 @@ static tegrabl_error_t get_boot_details(struct tegrabl_fm_handle *fm_handle,
 		goto fail;
 	}
 
+#if defined(CONFIG_ENABLE_EXTLINUX_PRELOAD)
+	extlinux_preload_start(fm_handle, extlinux_conf);
+#endif
+
 	*boot_entry = display_boot_menu(extlinux_conf);
 
+#if defined(CONFIG_ENABLE_EXTLINUX_PRELOAD)
+	extlinux_preload_finish(*boot_entry);
+#endif
+
 fail:
 	return err;
 }
@@ -518,7 +670,18 @@ tegrabl_error_t extlinux_boot_load_kernel_and_dtb(struct tegrabl_fm_handle *fm_h
 		pr_error("Failed to get kernel load addr.\n");
 		goto fail;
 	}
+#if !defined(CONFIG_DT_SUPPORT)
 	*dtb_load_addr = (void *)tegrabl_get_dtb_load_addr();
+#endif
+
+#if defined(CONFIG_ENABLE_EXTLINUX_PRELOAD)
+	if (preload.kernel_ready) {
+		pr_info("Using preloaded kernel\n");
+		preload.kernel_ready = false;
+		*kernel_size = preload.kernel_size;
+		goto load_dtb;
+	}
+#endif
 
 	linux_path = extlinux_conf.section[boot_entry]->linux_path;
 	err = load_binary_with_sig(fm_handle,
@@ -532,6 +695,9 @@ tegrabl_error_t extlinux_boot_load_kernel_and_dtb(struct tegrabl_fm_handle *fm_h
 		goto fail;
 	}
 
+#if defined(CONFIG_ENABLE_EXTLINUX_PRELOAD)
+load_dtb:
+#endif
 #if defined(CONFIG_DT_SUPPORT)
 	uint32_t dtb_size;
 	char *dtb_path = NULL;
@@ -541,6 +707,17 @@ tegrabl_error_t extlinux_boot_load_kernel_and_dtb(struct tegrabl_fm_handle *fm_h
 		goto fail;
 	}
 
+#if defined(CONFIG_ENABLE_EXTLINUX_PRELOAD)
+	if (preload.dtb_ready) {
+		pr_info("Using preloaded kernel-dtb\n");
+		preload.dtb_ready = false;
+		*dtb_load_addr = preload.dtb_addr;
+		err = TEGRABL_NO_ERROR;
+		goto fail;
+	}
+#endif
+
+	*dtb_load_addr = (void *)tegrabl_get_dtb_load_addr();
 	dtb_path = extlinux_conf.section[boot_entry]->dtb_path;
 	err = load_binary_with_sig(fm_handle,
 							   TEGRABL_BINARY_KERNEL_DTB,
@@ -581,8 +758,19 @@ tegrabl_error_t extlinux_boot_load_ramdisk(struct tegrabl_fm_handle *fm_handle,
 		goto fail;
 	}
 
-	pr_info("Loading ramdisk from rootfs ...\n");
+#if defined(CONFIG_ENABLE_EXTLINUX_PRELOAD)
+	if (preload.ramdisk_ready) {
+		pr_info("Using preloaded ramdisk\n");
+		preload.ramdisk_ready = false;
+		*ramdisk_load_addr = preload.ramdisk_addr;
+		*ramdisk_size = preload.ramdisk_size;
+		goto fail;
+	}
+#endif
+
 	*ramdisk_load_addr = (void *)tegrabl_get_ramdisk_load_addr();
+
+	pr_info("Loading ramdisk from rootfs ...\n");
 	err = tegrabl_fm_read(fm_handle,
 						  g_ramdisk_path,
 						  NULL,
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2019, NVIDIA Corporation.  All Rights Reserved.
+ * Copyright (c) 2016-2020, NVIDIA Corporation.  All Rights Reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property and
  * proprietary rights in and to this software and related documentation.  Any
@@ -29,6 +29,7 @@
 #include <dtb_overlay.h>
 #include <tegrabl_cbo.h>
 #include <tegrabl_usbh.h>
+#include <tegrabl_gpcdma.h>
 #include <tegrabl_cpubl_params.h>
 #include <tegrabl_file_manager.h>
 #include <tegrabl_partition_manager.h>
@@ -88,6 +89,81 @@ tegrabl_error_t tegrabl_get_os_version(union android_os_version *os_version)
 }
 #endif
 
+#if defined(CONFIG_ENABLE_GPCDMA_ASYNC)
+/* Fence of the last image move handed to the DMA engine */
+static tegrabl_dma_fence_t image_move_fence;
+/* Moves are mostly done by the time they are waited for, this only catches a
+ * hung engine */
+#define IMAGE_MOVE_TIMEOUT_US 5000000U
+#endif
+
+/* Move an image to its load address. Moves that do not overlap are done by the
+ * DMA engine, in the background of kernel decompression and DTB fixups, and are
+ * only complete once wait_image_moves() returns */
+static void move_image(void *dst, const void *src, uint64_t size)
+{
+#if defined(CONFIG_ENABLE_GPCDMA_ASYNC)
+	uintptr_t d = (uintptr_t)dst;
+	uintptr_t s = (uintptr_t)src;
+
+	if (((d + size) <= s) || ((s + size) <= d)) {
+		if (tegrabl_dma_memcpy_async(dst, src, size, &image_move_fence) == TEGRABL_NO_ERROR) {
+			return;
+		}
+	}
+#endif
+	memmove(dst, src, size);
+}
+
+static tegrabl_error_t wait_image_moves(void)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+#if defined(CONFIG_ENABLE_GPCDMA_ASYNC)
+	err = tegrabl_dma_fence_wait(image_move_fence, IMAGE_MOVE_TIMEOUT_US);
+	if (err != TEGRABL_NO_ERROR) {
+		pr_error("Error (%u) moving the kernel images\n", err);
+	}
+	image_move_fence = 0;
+#endif
+	return err;
+}
+
+#if defined(CONFIG_ENABLE_KERNEL_INPLACE_DECOMP)
+/* Copy of the boot image header, the boot image is overwritten when the kernel
+ * is extracted in place */
+static union tegrabl_bootimg_header bootimg_hdr;
+
+/* How far a gzip or lz4 stream can run ahead of its output, out_size being the
+ * largest output. Within a deflate block (at most 16K symbols) the remaining
+ * input exceeds the remaining output by far less than 64KB, lz4 blocks by 1/256
+ * of their size; stored blocks and block headers cost less than 1/256 overall */
+#define INPLACE_MARGIN(out_size)	(((out_size) >> 8) + 0x10000ULL)
+
+static bool can_decompress_in_place(decompressor *decomp)
+{
+	return (strcmp(decomp->name, "zlib") == 0) || (strcmp(decomp->name, "lz4") == 0) ||
+		   (strcmp(decomp->name, "lz4-legacy") == 0);
+}
+
+/* Largest output that can be produced at dst from the stream at payload_addr
+ * without overwriting input not consumed yet, 0 if there is none */
+static uint64_t inplace_out_size(uint64_t dst, uint64_t payload_addr, uint32_t payload_size)
+{
+	uint64_t span;
+
+	if (payload_addr < dst) {
+		return 0;
+	}
+	span = payload_addr + payload_size - dst;
+	if (span <= INPLACE_MARGIN(span)) {
+		return 0;
+	}
+
+	return span - INPLACE_MARGIN(span);
+}
+#endif
+
 /* Extract kernel from an Android boot image, and return the address where it is installed in memory */
 static tegrabl_error_t extract_kernel(void *boot_img_load_addr,
 									  uint32_t kernel_bin_size,
@@ -99,6 +175,11 @@ static tegrabl_error_t extract_kernel(void *boot_img_load_addr,
 	union tegrabl_bootimg_header *hdr = NULL;
 	uint64_t payload_addr;
 	uint32_t kernel_size;
+#if defined(CONFIG_ENABLE_KERNEL_INPLACE_DECOMP)
+	bool in_place = false;
+	void *payload_copy = NULL;
+	uint64_t max_size;
+#endif
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
 
 	pr_trace("%s(): %u\n", __func__, __LINE__);
@@ -123,27 +204,108 @@ static tegrabl_error_t extract_kernel(void *boot_img_load_addr,
 
 	*kernel_load_addr = (void *)tegrabl_get_kernel_load_addr();
 	is_compressed = is_compressed_content((uint8_t *)payload_addr, &decomp);
+
+#if defined(CONFIG_ENABLE_KERNEL_INPLACE_DECOMP)
+	in_place = (payload_addr < ((uintptr_t)*kernel_load_addr + MAX_KERNEL_IMAGE_SIZE)) &&
+			   ((payload_addr + kernel_size) > (uintptr_t)*kernel_load_addr);
+	if (in_place && HAS_BOOT_IMG_HDR(hdr)) {
+		memcpy(&bootimg_hdr, hdr, sizeof(bootimg_hdr));
+		bootimg_cmdline = (char *)bootimg_hdr.cmdline;
+#if defined(CONFIG_OS_IS_ANDROID)
+		if (android_hdr != NULL) {
+			android_hdr = &bootimg_hdr;
+		}
+#endif
+	}
+	if (in_place && is_compressed && !can_decompress_in_place(decomp)) {
+		/* No margin known for the format, decompress from a copy */
+		payload_copy = tegrabl_malloc(kernel_size);
+		if (payload_copy == NULL) {
+			pr_error("Failed to allocate 0x%08x bytes for %s kernel\n", kernel_size, decomp->name);
+			err = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
+			goto fail;
+		}
+		memcpy(payload_copy, (void *)(uintptr_t)payload_addr, kernel_size);
+		payload_addr = (uintptr_t)payload_copy;
+		in_place = false;
+	}
+#endif
+
 	if (!is_compressed) {
 		pr_info("Copying kernel image (%u bytes) from %p to %p ... ",
 				kernel_size, (char *)payload_addr, *kernel_load_addr);
-		memmove(*kernel_load_addr, (char *)payload_addr, kernel_size);
+		move_image(*kernel_load_addr, (char *)payload_addr, kernel_size);
 	} else {
 		pr_info("Decompressing kernel image (%u bytes) from %p to %p ... ",
 				kernel_size, (char *)payload_addr, *kernel_load_addr);
 		decomp_size = MAX_KERNEL_IMAGE_SIZE;
+#if defined(CONFIG_ENABLE_KERNEL_INPLACE_DECOMP)
+		if (in_place) {
+			max_size = inplace_out_size((uintptr_t)*kernel_load_addr, payload_addr, kernel_size);
+			if (max_size == 0ULL) {
+				pr_error("\nNo room to decompress kernel in place\n");
+				err = TEGRABL_ERROR(TEGRABL_ERR_TOO_LARGE, 1);
+				goto fail;
+			}
+			decomp_size = (uint32_t)MIN(max_size, (uint64_t)MAX_KERNEL_IMAGE_SIZE);
+		}
+#endif
 		err = do_decompress(decomp, (uint8_t *)payload_addr, kernel_size, *kernel_load_addr, &decomp_size);
 		if (err != TEGRABL_NO_ERROR) {
 			pr_error("\nError %d decompress kernel\n", err);
-			return err;
+			goto fail;
 		}
 	}
 
 	pr_info("Done\n");
 
 fail:
+#if defined(CONFIG_ENABLE_KERNEL_INPLACE_DECOMP)
+	tegrabl_free(payload_copy);
+#endif
 	return err;
 }
 
+/* The kernel unpacks gzip/lz4 initramfs itself but has no zstd support, so a
+ * zstd ramdisk is decompressed straight to its load address. Returns false if
+ * the ramdisk is not zstd or cannot be unpacked in place, the caller then moves
+ * it as is */
+static bool unpack_ramdisk(void *hdr, uint64_t ramdisk_offset)
+{
+	decompressor *decomp = NULL;
+	uint32_t decomp_size = RAMDISK_MAX_SIZE;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	if (ramdisk_size < DECOMP_MAGIC_SIZE) {
+		return false;
+	}
+
+	decomp = decompress_method((uint8_t *)((uintptr_t)ramdisk_offset),
+							   DECOMP_MAGIC_SIZE);
+	if ((decomp == NULL) || (strcmp(decomp->name, "zstd") != 0)) {
+		return false;
+	}
+
+	/* Output must not run over the boot image, it still holds the kernel */
+	if ((ramdisk_load < (ramdisk_offset + ramdisk_size)) &&
+		((ramdisk_load + RAMDISK_MAX_SIZE) > (uintptr_t)hdr)) {
+		pr_warn("zstd ramdisk overlaps boot image, passing it to kernel as is\n");
+		return false;
+	}
+
+	pr_info("Decompressing ramdisk (len: %"PRIu64") from 0x%"PRIx64" to 0x%"PRIx64
+			"\n", ramdisk_size, ramdisk_offset, ramdisk_load);
+	err = do_decompress(decomp, (uint8_t *)((uintptr_t)ramdisk_offset), (uint32_t)ramdisk_size,
+						(void *)((uintptr_t)ramdisk_load), &decomp_size);
+	if (err != TEGRABL_NO_ERROR) {
+		pr_warn("Error %d decompress ramdisk, passing it to kernel as is\n", err);
+		return false;
+	}
+
+	ramdisk_size = decomp_size;
+	return true;
+}
+
 static tegrabl_error_t extract_ramdisk(void *boot_img_load_addr)
 {
 	union tegrabl_bootimg_header *hdr = NULL;
@@ -168,10 +330,18 @@ static tegrabl_error_t extract_ramdisk(void *boot_img_load_addr)
 	ramdisk_offset = (uintptr_t)hdr + ramdisk_offset;
 	ramdisk_size = hdr->ramdisksize;
 
-	if (ramdisk_offset != ramdisk_load) {
+	if (unpack_ramdisk(hdr, ramdisk_offset)) {
+		pr_info("Ramdisk size after decompressing: %"PRIu64"\n", ramdisk_size);
+	} else if (ramdisk_offset != ramdisk_load) {
 		pr_info("Move ramdisk (len: %"PRIu64") from 0x%"PRIx64" to 0x%"PRIx64
 				"\n", ramdisk_size, ramdisk_offset, ramdisk_load);
-		memmove((void *)((uintptr_t)ramdisk_load), (void *)((uintptr_t)ramdisk_offset), ramdisk_size);
+		/* The kernel is extracted after this, the move must be complete before
+		 * returning if it lands on the kernel payload */
+		if ((ramdisk_load < ramdisk_offset) && ((ramdisk_load + ramdisk_size) > (uintptr_t)hdr)) {
+			memmove((void *)((uintptr_t)ramdisk_load), (void *)((uintptr_t)ramdisk_offset), ramdisk_size);
+		} else {
+			move_image((void *)((uintptr_t)ramdisk_load), (void *)((uintptr_t)ramdisk_offset), ramdisk_size);
+		}
 	}
 
 	bootimg_cmdline = (char *)hdr->cmdline;
@@ -237,6 +407,24 @@ static tegrabl_error_t extract_kernel_dtb(void **kernel_dtb, void *kernel_dtbo)
 #endif  /* CONFIG_DT_SUPPORT */
 
 #if defined(CONFIG_ENABLE_BOOT_DEVICE_SELECT)
+#if defined(CONFIG_ENABLE_USB_SD_BOOT) && defined(CONFIG_ENABLE_USB_MS)
+/* Power up the USB host as soon as the boot order is known, so that the device
+ * connect time runs in the background of the boot sources tried before it */
+static void usb_boot_early_init(uint8_t *boot_order, uint32_t start)
+{
+	uint32_t i;
+
+	for (i = start; boot_order[i] != BOOT_DEFAULT; i++) {
+		if (boot_order[i] == BOOT_FROM_USB) {
+			if (tegrabl_usbh_init_start() != TEGRABL_NO_ERROR) {
+				pr_warn("Failed to start USB host early\n");
+			}
+			break;
+		}
+	}
+}
+#endif
+
 tegrabl_error_t tegrabl_load_kernel_and_dtb(struct tegrabl_kernel_bin *kernel,
 											void **kernel_entry_point,
 											void **kernel_dtb,
@@ -245,6 +433,7 @@ tegrabl_error_t tegrabl_load_kernel_and_dtb(struct tegrabl_kernel_bin *kernel,
 											uint32_t data_size)
 {
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	tegrabl_error_t move_err;
 	void *kernel_dtbo = NULL;
 	bool is_load_done = false;
 	uint32_t i = 0;
@@ -288,6 +477,10 @@ tegrabl_error_t tegrabl_load_kernel_and_dtb(struct tegrabl_kernel_bin *kernel,
 	}
 #endif
 
+#if defined(CONFIG_ENABLE_USB_SD_BOOT) && defined(CONFIG_ENABLE_USB_MS)
+	usb_boot_early_init(boot_order, bootorder_start);
+#endif
+
 	/* Try loading boot image and dtb from devices as per boot order */
 	for (i = bootorder_start; (boot_order[i] != BOOT_DEFAULT) && (!is_load_done); i++) {
 
@@ -366,12 +559,8 @@ tegrabl_error_t tegrabl_load_kernel_and_dtb(struct tegrabl_kernel_bin *kernel,
 		callbacks->verify_boot(boot_img_load_addr, *kernel_dtb, kernel_dtbo);
 	}
 
-	err = extract_kernel(boot_img_load_addr, kernel_size, kernel_entry_point);
-	if (err != TEGRABL_NO_ERROR) {
-		pr_error("Error (%u) extracting the kernel\n", err);
-		goto fail;
-	}
-
+	/* Ramdisk first, its move runs on the DMA engine while the kernel is
+	 * decompressed */
 	if (HAS_BOOT_IMG_HDR((union tegrabl_bootimg_header *)boot_img_load_addr)) {
 		err = extract_ramdisk(boot_img_load_addr);
 		if (err != TEGRABL_NO_ERROR) {
@@ -380,6 +569,12 @@ tegrabl_error_t tegrabl_load_kernel_and_dtb(struct tegrabl_kernel_bin *kernel,
 		}
 	}
 
+	err = extract_kernel(boot_img_load_addr, kernel_size, kernel_entry_point);
+	if (err != TEGRABL_NO_ERROR) {
+		pr_error("Error (%u) extracting the kernel\n", err);
+		goto fail;
+	}
+
 	err = extract_kernel_dtb(kernel_dtb, kernel_dtbo);
 	if (err != TEGRABL_NO_ERROR) {
 		pr_error("Error (%u) extracting the kernel DTB\n", err);
@@ -389,6 +584,10 @@ tegrabl_error_t tegrabl_load_kernel_and_dtb(struct tegrabl_kernel_bin *kernel,
 	pr_info("%s: Done\n", __func__);
 
 fail:
+	move_err = wait_image_moves();
+	if (err == TEGRABL_NO_ERROR) {
+		err = move_err;
+	}
 	tegrabl_free(kernel_dtbo);
 	tegrabl_usbh_close();
 
@@ -405,6 +604,7 @@ tegrabl_error_t tegrabl_load_kernel_and_dtb(struct tegrabl_kernel_bin *kernel,
 											uint32_t data_size)
 {
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	tegrabl_error_t move_err;
 	void *kernel_dtbo = NULL;
 	void *boot_img_load_addr = NULL;
 	void *ramdisk_load_addr = NULL;
@@ -442,12 +642,8 @@ tegrabl_error_t tegrabl_load_kernel_and_dtb(struct tegrabl_kernel_bin *kernel,
 		callbacks->verify_boot(boot_img_load_addr, *kernel_dtb, kernel_dtbo);
 	}
 
-	err = extract_kernel(boot_img_load_addr, kernel_size, kernel_entry_point);
-	if (err != TEGRABL_NO_ERROR) {
-		pr_error("Error %u loading the kernel\n", err);
-		goto fail;
-	}
-
+	/* Ramdisk first, its move runs on the DMA engine while the kernel is
+	 * decompressed */
 	if (HAS_BOOT_IMG_HDR((union tegrabl_bootimg_header *)boot_img_load_addr)) {
 		err = extract_ramdisk(boot_img_load_addr);
 		if (err != TEGRABL_NO_ERROR) {
@@ -456,6 +652,12 @@ tegrabl_error_t tegrabl_load_kernel_and_dtb(struct tegrabl_kernel_bin *kernel,
 		}
 	}
 
+	err = extract_kernel(boot_img_load_addr, kernel_size, kernel_entry_point);
+	if (err != TEGRABL_NO_ERROR) {
+		pr_error("Error %u loading the kernel\n", err);
+		goto fail;
+	}
+
 	err = extract_kernel_dtb(kernel_dtb, kernel_dtbo);
 	if (err != TEGRABL_NO_ERROR) {
 		pr_error("Error %u loading the kernel DTB\n", err);
@@ -465,6 +667,10 @@ tegrabl_error_t tegrabl_load_kernel_and_dtb(struct tegrabl_kernel_bin *kernel,
 	pr_info("%s: Done\n", __func__);
 
 fail:
+	move_err = wait_image_moves();
+	if (err == TEGRABL_NO_ERROR) {
+		err = move_err;
+	}
 	tegrabl_free(kernel_dtbo);
 
 	return err;
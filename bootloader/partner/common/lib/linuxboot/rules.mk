@@ -58,6 +58,19 @@ MODULE_SRCS += \
 	$(LOCAL_DIR)/usb_sd_boot.c \
 	$(LOCAL_DIR)/net_boot.c \
 	$(LOCAL_DIR)/extlinux_boot.c
+
+# keep the fixed-up kernel DTB in the kernel-dtb-cache partition
+TEGRABL_DTB_CACHE := yes
+endif
+
+ifeq ($(TEGRABL_DTB_CACHE), yes)
+MODULE_DEFINES += CONFIG_ENABLE_DTB_CACHE=1
+
+MODULE_DEPS += \
+	$(LOCAL_DIR)/../external/mincrypt
+
+MODULE_SRCS += \
+	$(LOCAL_DIR)/dtb_cache.c
 endif
 
 include make/module.mk
@@ -16,6 +16,9 @@
 #include <tegrabl_utils.h>
 #include <tegrabl_debug.h>
 #include <tegrabl_malloc.h>
+#if defined(CONFIG_ENABLE_HEAP_LOCK)
+#include <kernel/mutex.h>
+#endif
 
 /**
  * @brief Magic number for free memory block.
@@ -66,6 +69,32 @@ static tegrabl_heap_free_block_t *tegrabl_heap_free_list[TEGRABL_HEAP_TYPE_MAX];
  */
 static size_t max_heap_size[TEGRABL_HEAP_TYPE_MAX];
 
+#if defined(CONFIG_ENABLE_HEAP_LOCK)
+/**
+ * @brief Serializes the free lists between threads running at the same time,
+ * e.g. the background display init and the kernel load.
+ */
+static mutex_t heap_lock = MUTEX_INITIAL_VALUE(heap_lock);
+
+static inline void heap_lock_acquire(void)
+{
+	mutex_acquire(&heap_lock);
+}
+
+static inline void heap_lock_release(void)
+{
+	mutex_release(&heap_lock);
+}
+#else
+static inline void heap_lock_acquire(void)
+{
+}
+
+static inline void heap_lock_release(void)
+{
+}
+#endif
+
 tegrabl_error_t tegrabl_heap_init(tegrabl_heap_type_t heap_type, size_t start,
 			size_t size)
 {
@@ -217,16 +246,24 @@ static void *tegrabl_generic_malloc(tegrabl_heap_free_block_t *free_list,
 
 void *tegrabl_malloc(size_t size)
 {
+	void *ptr;
+
 	if (size > max_heap_size[TEGRABL_HEAP_DEFAULT]) {
 		return NULL;
 	}
 
-	return tegrabl_generic_malloc(tegrabl_heap_free_list[TEGRABL_HEAP_DEFAULT],
-								   size);
+	heap_lock_acquire();
+	ptr = tegrabl_generic_malloc(tegrabl_heap_free_list[TEGRABL_HEAP_DEFAULT],
+								 size);
+	heap_lock_release();
+
+	return ptr;
 }
 
 void *tegrabl_alloc(tegrabl_heap_type_t heap_type, size_t size)
 {
+	void *ptr;
+
 	if ((heap_type == TEGRABL_HEAP_DMA) &&
 		(tegrabl_heap_free_list[TEGRABL_HEAP_DMA] != NULL)) {
 
@@ -234,8 +271,12 @@ void *tegrabl_alloc(tegrabl_heap_type_t heap_type, size_t size)
 			return NULL;
 		}
 
-		return tegrabl_generic_malloc(tegrabl_heap_free_list[TEGRABL_HEAP_DMA],
-									  size);
+		heap_lock_acquire();
+		ptr = tegrabl_generic_malloc(tegrabl_heap_free_list[TEGRABL_HEAP_DMA],
+									 size);
+		heap_lock_release();
+
+		return ptr;
 	} else {
 		return tegrabl_malloc(size);
 	}
@@ -353,6 +394,8 @@ void tegrabl_dealloc(tegrabl_heap_type_t heap_type, void *ptr)
 {
 	tegrabl_heap_free_block_t *tmp_free = NULL;
 
+	heap_lock_acquire();
+
 	if ((heap_type == TEGRABL_HEAP_DMA) &&
 		(tegrabl_heap_free_list[TEGRABL_HEAP_DMA] != NULL)) {
 		tmp_free = tegrabl_generic_free(
@@ -364,7 +407,7 @@ void tegrabl_dealloc(tegrabl_heap_type_t heap_type, void *ptr)
 	}
 
 	if (tmp_free == NULL) {
-		return;
+		goto done;
 	}
 
 	/* If free list does not have any blocks or if freed block points to memory
@@ -375,6 +418,9 @@ void tegrabl_dealloc(tegrabl_heap_type_t heap_type, void *ptr)
 		((uintptr_t) tegrabl_heap_free_list[heap_type] > (uintptr_t) tmp_free)) {
 		tegrabl_heap_free_list[heap_type] = tmp_free;
 	}
+
+done:
+	heap_lock_release();
 }
 
 void tegrabl_free(void *ptr)
@@ -568,16 +614,28 @@ static void *tegrabl_memalign_generic(
 void *tegrabl_alloc_align(tegrabl_heap_type_t heap_type,
 		size_t alignment, size_t size)
 {
+	void *ptr;
+
+	heap_lock_acquire();
 	if ((heap_type == TEGRABL_HEAP_DMA) &&
 		(tegrabl_heap_free_list[TEGRABL_HEAP_DMA] != NULL)) {
-		return tegrabl_memalign_generic(TEGRABL_HEAP_DMA, alignment, size);
+		ptr = tegrabl_memalign_generic(TEGRABL_HEAP_DMA, alignment, size);
 	} else {
-		return tegrabl_memalign_generic(TEGRABL_HEAP_DEFAULT, alignment, size);
+		ptr = tegrabl_memalign_generic(TEGRABL_HEAP_DEFAULT, alignment, size);
 	}
+	heap_lock_release();
+
+	return ptr;
 }
 
 void *tegrabl_memalign(size_t alignment, size_t size)
 {
-	return tegrabl_memalign_generic(TEGRABL_HEAP_DEFAULT, alignment, size);
+	void *ptr;
+
+	heap_lock_acquire();
+	ptr = tegrabl_memalign_generic(TEGRABL_HEAP_DEFAULT, alignment, size);
+	heap_lock_release();
+
+	return ptr;
 }
 
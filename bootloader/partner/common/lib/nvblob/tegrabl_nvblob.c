@@ -16,6 +16,7 @@
 #include <tegrabl_partition_manager.h>
 #include <tegrabl_debug.h>
 #include <tegrabl_malloc.h>
+#include <tegrabl_utils.h>
 #include <tegrabl_decompress.h>
 
 /* Definitions and Structures below this point should be synchronized with
@@ -30,6 +31,11 @@
 #define LEGACY_BLOB_HEADER_LEN 36
 #define MAX_BLOB_SIZE (60 * 1024 * 1024)
 
+/* Chunk inflated at a time when skipping over data of a compressed blob */
+#define BLOB_STREAM_SKIP_SIZE (64 * 1024)
+/* Sanity limit on the entry table of a compressed blob */
+#define BLOB_STREAM_MAX_ENTRIES 1024
+
 /**
  * @brief blob signed header
  *
@@ -43,6 +49,33 @@ struct signed_header {
 	uint32_t signature_size;
 };
 
+/**
+ * @brief compressed blob inflated on demand
+ *
+ * @decomp decompressor of the blob
+ * @context decompressor context, NULL until the stream is started
+ * @session decompressor session of context
+ * @data compressed data, starting at the entry table
+ * @size size of the compressed data
+ * @start blob offset of the entry table
+ * @in_pos compressed data consumed so far
+ * @out_pos blob offset of the next byte the stream produces
+ * @blob compressed blob to free on close, NULL if owned by the caller
+ * @entry_buf data of the entry last returned by tegrabl_blob_get_entry_data
+ */
+struct blob_stream {
+	decompressor *decomp;
+	void *context;
+	uint32_t session;
+	uint8_t *data;
+	uint32_t size;
+	uint32_t start;
+	uint32_t in_pos;
+	uint32_t out_pos;
+	uint8_t *blob;
+	uint8_t *entry_buf;
+};
+
 /**
  * @brief blob related info
  *
@@ -50,12 +83,15 @@ struct signed_header {
  * @offset data offset of the blob
  * @data_mem_size blob data memory size
  * @info_mem_size blob info memory size
+ * @stream set if only the header and entry table are at start and the
+ *         entry data is inflated on demand
  */
 struct blob_info {
 	uint8_t *start;
 	uint32_t offset;
 	uint32_t data_mem_size;
 	uint32_t info_mem_size;
+	struct blob_stream *stream;
 };
 
 /* blob entry descriptor */
@@ -170,6 +206,199 @@ fail:
 	return err;
 }
 
+static uint32_t blob_entry_size(tegrabl_blob_type_t t)
+{
+	switch (t) {
+	case BLOB_UPDATE:
+		return sizeof(struct tegrabl_image_entry);
+	case BLOB_BMP:
+		return sizeof(struct tegrabl_bmp_entry);
+	default:
+		return 0;
+	}
+}
+
+static tegrabl_error_t blob_stream_restart(struct blob_stream *stream)
+{
+	if ((stream->context != NULL) && (stream->decomp->end != NULL) &&
+		decompress_stream_is_valid(stream->decomp, stream->session)) {
+		stream->decomp->end(stream->context);
+	}
+
+	stream->context = decompress_stream_start(stream->decomp, stream->size,
+											  &stream->session);
+	if (stream->context == NULL) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INIT_FAILED, 0);
+	}
+
+	stream->in_pos = 0;
+	stream->out_pos = stream->start;
+
+	return TEGRABL_NO_ERROR;
+}
+
+static tegrabl_error_t blob_stream_inflate(struct blob_stream *stream,
+										   uint8_t *out, uint32_t len)
+{
+	uint32_t used;
+	uint32_t written;
+	tegrabl_error_t err;
+
+	while (len > 0U) {
+		err = stream->decomp->stream(stream->context,
+									 stream->data + stream->in_pos,
+									 stream->size - stream->in_pos, &used,
+									 out, len, &written);
+		if (err != TEGRABL_NO_ERROR) {
+			return err;
+		}
+		if ((used == 0U) && (written == 0U)) {
+			pr_error("%s: compressed blob is truncated\n", __func__);
+			return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 1);
+		}
+		stream->in_pos += used;
+		stream->out_pos += written;
+		out += written;
+		len -= written;
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+/*
+ * Inflates len bytes at blob offset into buf. Reads at or past the current
+ * position continue the stream, anything else restarts it from the entry
+ * table; entries are normally read in order.
+ */
+static tegrabl_error_t blob_stream_read(struct blob_stream *stream,
+										uint32_t offset, uint8_t *buf,
+										uint32_t len)
+{
+	uint8_t *scratch = NULL;
+	uint32_t chunk;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	if (offset < stream->start) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 2);
+	}
+
+	if ((stream->context == NULL) || (offset < stream->out_pos) ||
+		!decompress_stream_is_valid(stream->decomp, stream->session)) {
+		pr_debug("%s: restarting stream for offset 0x%x\n", __func__, offset);
+		err = blob_stream_restart(stream);
+		if (err != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+	}
+
+	if (offset > stream->out_pos) {
+		chunk = MIN(BLOB_STREAM_SKIP_SIZE, offset - stream->out_pos);
+		scratch = tegrabl_malloc(chunk);
+		if (scratch == NULL) {
+			err = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 1);
+			goto fail;
+		}
+		while (stream->out_pos < offset) {
+			err = blob_stream_inflate(stream, scratch,
+									  MIN(chunk, offset - stream->out_pos));
+			if (err != TEGRABL_NO_ERROR) {
+				goto fail;
+			}
+		}
+	}
+
+	err = blob_stream_inflate(stream, buf, len);
+
+fail:
+	if (scratch != NULL) {
+		tegrabl_free(scratch);
+	}
+	return err;
+}
+
+/*
+ * Sets up bh to inflate the entries of a compressed blob on demand. Only the
+ * header and entry table are kept uncompressed, so the working set is the
+ * largest entry instead of the whole blob.
+ */
+static tegrabl_error_t blob_stream_open(struct blob_info *bh, uint8_t *blob,
+										uint32_t data_size, decompressor *decomp,
+										bool blob_owned)
+{
+	struct blob_header *blobheader = (struct blob_header *)blob;
+	struct blob_stream *stream = NULL;
+	uint8_t *table = NULL;
+	uint32_t table_size;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	if ((blobheader->num_entries == 0U) ||
+		(blobheader->num_entries > BLOB_STREAM_MAX_ENTRIES) ||
+		(blobheader->entries_offset >= data_size)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 2);
+	}
+	table_size = blobheader->num_entries * blob_entry_size(blobheader->type);
+	if (table_size == 0U) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 3);
+	}
+
+	stream = tegrabl_calloc(1, sizeof(*stream));
+	table = tegrabl_malloc(blobheader->entries_offset + table_size);
+	if ((stream == NULL) || (table == NULL)) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 1);
+		goto fail;
+	}
+
+	/* header is uncompressed, copy directly */
+	memcpy(table, blob, blobheader->entries_offset);
+
+	stream->decomp = decomp;
+	stream->data = blob + blobheader->entries_offset;
+	stream->size = data_size - blobheader->entries_offset;
+	stream->start = blobheader->entries_offset;
+
+	err = blob_stream_read(stream, stream->start, table + stream->start,
+						   table_size);
+	if (err != TEGRABL_NO_ERROR) {
+		pr_error("%s: failed to inflate entry table\n", __func__);
+		goto fail;
+	}
+
+	stream->blob = blob_owned ? blob : NULL;
+	bh->stream = stream;
+	bh->start = table;
+	bh->data_mem_size = blobheader->entries_offset + table_size;
+
+	return TEGRABL_NO_ERROR;
+
+fail:
+	if (stream != NULL) {
+		if ((stream->context != NULL) && (decomp->end != NULL) &&
+			decompress_stream_is_valid(stream->decomp, stream->session)) {
+			decomp->end(stream->context);
+		}
+		tegrabl_free(stream);
+	}
+	if (table != NULL) {
+		tegrabl_free(table);
+	}
+	return err;
+}
+
+static void blob_stream_close(struct blob_stream *stream)
+{
+	if ((stream->context != NULL) && (stream->decomp->end != NULL) &&
+		decompress_stream_is_valid(stream->decomp, stream->session)) {
+		stream->decomp->end(stream->context);
+	}
+	if (stream->entry_buf != NULL) {
+		tegrabl_free(stream->entry_buf);
+	}
+	if (stream->blob != NULL) {
+		tegrabl_free(stream->blob);
+	}
+	tegrabl_free(stream);
+}
+
 tegrabl_error_t tegrabl_blob_init(char *part_name, uint8_t *bptr,
 								  tegrabl_blob_handle *bhdl)
 {
@@ -246,6 +475,19 @@ tegrabl_error_t tegrabl_blob_init(char *part_name, uint8_t *bptr,
 		}
 	}
 
+	if (bptr && (bh->offset == 0U)) {
+		struct blob_header *blobheader = (struct blob_header *)header;
+		decomp = decompress_method(bptr + blobheader->entries_offset,
+								   DECOMP_MAGIC_SIZE);
+		if ((decomp != NULL) && (decomp->stream != NULL)) {
+			pr_info("inflating %s blob on demand\n", decomp->name);
+			error = blob_stream_open(bh, bptr, data_size, decomp, false);
+			if (TEGRABL_NO_ERROR != error) {
+				goto fail;
+			}
+		}
+	}
+
 	if (!bptr) {
 		tegrabl_free(header);
 		header = tegrabl_malloc(data_size);
@@ -273,7 +515,17 @@ tegrabl_error_t tegrabl_blob_init(char *part_name, uint8_t *bptr,
 
 		struct blob_header *blobheader = (struct blob_header *)header;
 		if (is_compressed_content(
-				(uint8_t *)header + blobheader->entries_offset, &decomp)) {
+				(uint8_t *)header + blobheader->entries_offset, &decomp) &&
+			(decomp->stream != NULL) && (bh->offset == 0U)) {
+			pr_info("inflating %s blob on demand\n", part_name);
+			error = blob_stream_open(bh, header, data_size, decomp, true);
+			if (TEGRABL_NO_ERROR != error) {
+				goto fail;
+			}
+			/* the compressed blob is owned by the stream now */
+			header = NULL;
+			header_asize = 0;
+		} else if (decomp != NULL) {
 			pr_info("decompressing %s blob ...\n", part_name);
 			error = blob_decompress(&blob_buf, (uint32_t *)&blob_asize, header,
 									blobheader->entries_offset, data_size,
@@ -295,8 +547,10 @@ tegrabl_error_t tegrabl_blob_init(char *part_name, uint8_t *bptr,
 		}
 	}
 
-	bh->start = (uint8_t *)header;
-	bh->data_mem_size = (uint32_t)data_size;
+	if (bh->stream == NULL) {
+		bh->start = (uint8_t *)header;
+		bh->data_mem_size = (uint32_t)data_size;
+	}
 fail:
 	if (error != TEGRABL_NO_ERROR) {
 		if (header && header_asize) {
@@ -562,8 +816,29 @@ tegrabl_error_t tegrabl_blob_get_entry_data(tegrabl_blob_handle b,
 		goto fail;
 	}
 
+	if (bh->stream != NULL) {
+		/* only the last entry read is kept around */
+		if (bh->stream->entry_buf != NULL) {
+			tegrabl_free(bh->stream->entry_buf);
+		}
+		bh->stream->entry_buf = tegrabl_malloc(MAX(length, 1U));
+		if (bh->stream->entry_buf == NULL) {
+			pr_error("%s: Not enough memory\n", __func__);
+			error = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 2);
+			goto fail;
+		}
+		error = blob_stream_read(bh->stream, offset, bh->stream->entry_buf,
+								 length);
+		if (error != TEGRABL_NO_ERROR) {
+			tegrabl_free(bh->stream->entry_buf);
+			bh->stream->entry_buf = NULL;
+			goto fail;
+		}
+	}
+
 	if (data) {
-		*data = bh->start + bh->offset + offset;
+		*data = (bh->stream != NULL) ? bh->stream->entry_buf :
+									   bh->start + bh->offset + offset;
 	}
 	if (size) {
 		*size = length;
@@ -579,6 +854,10 @@ void tegrabl_blob_close(tegrabl_blob_handle b)
 		return;
 	}
 
+	if (bh->stream) {
+		blob_stream_close(bh->stream);
+	}
+
 	if (bh->start && bh->data_mem_size) {
 		tegrabl_free(bh->start);
 	}
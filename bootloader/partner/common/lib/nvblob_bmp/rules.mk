@@ -14,6 +14,9 @@ MODULE := $(LOCAL_DIR)
 
 GLOBAL_INCLUDES += $(LOCAL_DIR)
 
+MODULE_DEPS += \
+	$(LOCAL_DIR)/../decompress
+
 MODULE_SRCS += \
 	$(LOCAL_DIR)/tegrabl_parse_bmp.c
 
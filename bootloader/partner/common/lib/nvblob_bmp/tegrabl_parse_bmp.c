@@ -14,11 +14,25 @@
 #include <tegrabl_nvblob.h>
 #include <tegrabl_debug.h>
 #include <tegrabl_error.h>
+#include <tegrabl_malloc.h>
+#include <tegrabl_decompress.h>
+#include <string.h>
+
+/* LZ4 frame header: magic, FLG, BD, optional 8 byte content size */
+#define LZ4_FRAME_MAGIC 0x184D2204U
+#define LZ4_FRAME_FLG_OFFSET 4
+#define LZ4_FRAME_CONTENT_SIZE_OFFSET 6
+#define LZ4_FRAME_FLG_CONTENT_SIZE (1U << 3)
 
 tegrabl_blob_handle bh;
 bool is_initialized;
 uint32_t num_images;
 
+/* Last image decompressed out of the blob, kept until the blob is unloaded */
+static uint8_t *bmp_unpacked;
+static int bmp_unpacked_entry = -1;
+static uint32_t bmp_unpacked_size;
+
 static tegrabl_bmp_resolution_t get_optimal_bmp_resolution(
 	uint32_t panel_resolution, bool is_panel_portrait, uint32_t rotation_angle)
 {
@@ -89,12 +103,94 @@ fail:
 	return error;
 }
 
+static void release_unpacked_bmp(void)
+{
+	if (bmp_unpacked != NULL) {
+		tegrabl_free(bmp_unpacked);
+	}
+	bmp_unpacked = NULL;
+	bmp_unpacked_entry = -1;
+	bmp_unpacked_size = 0;
+}
+
 void tegrabl_unload_bmp_blob(void)
 {
+	release_unpacked_bmp();
 	tegrabl_blob_close(bh);
 	is_initialized = false;
 }
 
+/**
+ * Splash images may be stored in the blob as LZ4 frames to keep the
+ * partition (and the read of it) small. The frame must record the content
+ * size so that the output buffer can be sized up front.
+ */
+static tegrabl_error_t unpack_bmp(int entry, uint8_t **data, uint32_t *size)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	decompressor *decomp;
+	uint32_t magic;
+	uint64_t content_size;
+	uint32_t out_size;
+	uint8_t *out = NULL;
+
+	if ((*size < (LZ4_FRAME_CONTENT_SIZE_OFFSET + sizeof(content_size))) ||
+		((*data)[0] == 'B' && (*data)[1] == 'M')) {
+		/* Raw bmp */
+		goto fail;
+	}
+
+	memcpy(&magic, *data, sizeof(magic));
+	decomp = decompress_method(*data, DECOMP_MAGIC_SIZE);
+	if ((magic != LZ4_FRAME_MAGIC) || (decomp == NULL)) {
+		goto fail;
+	}
+
+	if (entry == bmp_unpacked_entry) {
+		*data = bmp_unpacked;
+		*size = bmp_unpacked_size;
+		goto fail;
+	}
+
+	if (((*data)[LZ4_FRAME_FLG_OFFSET] & LZ4_FRAME_FLG_CONTENT_SIZE) == 0U) {
+		pr_error("%s: lz4 bmp without content size\n", __func__);
+		error = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 3);
+		goto fail;
+	}
+	memcpy(&content_size, *data + LZ4_FRAME_CONTENT_SIZE_OFFSET,
+		   sizeof(content_size));
+	if ((content_size == 0) || (content_size > UINT32_MAX)) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 3);
+		goto fail;
+	}
+
+	out = tegrabl_malloc((size_t)content_size);
+	if (out == NULL) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
+		goto fail;
+	}
+
+	out_size = (uint32_t)content_size;
+	error = do_decompress(decomp, *data, *size, out, &out_size);
+	if (error != TEGRABL_NO_ERROR) {
+		tegrabl_free(out);
+		goto fail;
+	}
+	pr_debug("%s: bmp %d unpacked %u -> %u bytes\n", __func__, entry, *size,
+			 out_size);
+
+	release_unpacked_bmp();
+	bmp_unpacked = out;
+	bmp_unpacked_entry = entry;
+	bmp_unpacked_size = out_size;
+
+	*data = out;
+	*size = out_size;
+
+fail:
+	return error;
+}
+
 tegrabl_error_t tegrabl_get_bmp(struct tegrabl_bmp_image *img)
 {
 	tegrabl_bmp_resolution_t default_image_res = BMPRES_480P;
@@ -147,6 +243,11 @@ tegrabl_error_t tegrabl_get_bmp(struct tegrabl_bmp_image *img)
 		goto fail;
 	}
 
+	error = unpack_bmp(desired_entry, &(img->bmp), &bmp_length);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
 	img->image_size = bmp_length;
 
 fail:
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2019, NVIDIA Corporation.  All Rights Reserved.
+ * Copyright (c) 2015-2020, NVIDIA Corporation.  All Rights Reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property and
  * proprietary rights in and to this software and related documentation.  Any
@@ -23,7 +23,7 @@
 #include <ctype.h>
 
 #if defined(CONFIG_ENABLE_A_B_SLOT)
-#include <tegrabl_a_b_partition_naming.h>
+#include <tegrabl_a_b_boot_control.h>
 #endif
 
 #define AUX_INFO_PARTITION_LOOKUP_ERR		20
@@ -32,14 +32,27 @@
 #define AUX_INFO_PARTITION_NOT_INIT			23
 #define AUX_INFO_PARTITION_GUID_NOT_FOUND	24
 
+/* Keys of the per-device partition index */
+#define PART_KEY_NAME		0U
+#define PART_KEY_GUID		1U
+#define PART_KEY_PTYPE_GUID	2U
+#define PART_NUM_KEYS		3U
+
 /**
  * @brief Stores the partition list for storage devices
+ *
+ * index holds PART_NUM_KEYS open-addressed tables of index_size slots each,
+ * a slot is the partition number + 1 or 0 if empty. Partitions are inserted in
+ * table order so for duplicate keys the first one in the table is found first.
+ * index is NULL if it could not be allocated, lookups then scan the table.
  */
 struct tegrabl_storage_info {
 	struct list_node node;
 	tegrabl_bdev_t *bdev;
 	uint32_t num_partitions;
 	struct tegrabl_partition_info *partitions;
+	uint32_t index_size;
+	uint16_t *index;
 };
 
 /* List of storage device information */
@@ -49,6 +62,10 @@ static struct list_node *storage_list;
 static uint32_t set_verify_flag;
 static bool verify_all_partitions;
 static struct list_node verify_list;
+
+static tegrabl_error_t verify_pending_complete(void);
+static tegrabl_error_t verify_written_region(struct tegrabl_partition *partition,
+		const void *buf, uint64_t offset, size_t num_bytes);
 #endif
 
 /**
@@ -86,13 +103,167 @@ tegrabl_error_t tegrabl_partition_pt_has_3_levels(bool *info)
 	return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
 }
 
-static inline bool match_partition_name(const char *partition_name, const char *name)
+static const char *partition_key(struct tegrabl_partition_info *info, uint32_t key)
 {
+	if (key == PART_KEY_GUID) {
+		return info->guid;
+	} else if (key == PART_KEY_PTYPE_GUID) {
+		return info->ptype_guid;
+	} else {
+		return info->name;
+	}
+}
+
+/* FNV-1a, GUIDs are hashed case-insensitively as they are compared that way */
+static uint32_t partition_key_hash(const char *str, uint32_t key)
+{
+	uint32_t hash = 2166136261U;
+	uint32_t len = (key == PART_KEY_NAME) ? MAX_PARTITION_NAME : GUID_STR_LEN;
+	int c;
+
+	while ((len-- != 0U) && (*str != '\0')) {
+		c = (uint8_t)*str++;
+		if (key != PART_KEY_NAME) {
+			c = tolower(c);
+		}
+		hash = (hash ^ (uint32_t)c) * 16777619U;
+	}
+
+	return hash;
+}
+
+static bool partition_key_match(struct tegrabl_partition_info *info, const char *str, uint32_t key)
+{
+	if (key == PART_KEY_NAME) {
+		return strcmp(info->name, str) == 0;
+	}
+	return strncasecmp(partition_key(info, key), str, GUID_STR_LEN) == 0;
+}
+
+static void partition_index_build(struct tegrabl_storage_info *storage_info)
+{
+	uint32_t num = storage_info->num_partitions;
+	uint32_t size = 4;
+	uint32_t key;
+	uint32_t i;
+	uint32_t slot;
+	uint16_t *table;
+
+	storage_info->index = NULL;
+	storage_info->index_size = 0;
+
+	if ((num == 0U) || (num >= 0xFFFFU)) {
+		return;
+	}
+
+	/* Keep the load factor at or below 1/2 */
+	while (size < (num * 2U)) {
+		size <<= 1;
+	}
+
+	storage_info->index = tegrabl_calloc(PART_NUM_KEYS * size, sizeof(uint16_t));
+	if (storage_info->index == NULL) {
+		pr_warn("No memory for partition index, using linear lookups\n");
+		return;
+	}
+	storage_info->index_size = size;
+
+	for (key = 0; key < PART_NUM_KEYS; key++) {
+		table = &storage_info->index[key * size];
+		for (i = 0; i < num; i++) {
+			slot = partition_key_hash(partition_key(&storage_info->partitions[i], key), key);
+			slot &= size - 1U;
+			while (table[slot] != 0U) {
+				slot = (slot + 1U) & (size - 1U);
+			}
+			table[slot] = (uint16_t)(i + 1U);
+		}
+	}
+}
+
+/* Returns the first partition of the device whose key matches str, or
+ * num_partitions if there is none */
+static uint32_t partition_index_find(struct tegrabl_storage_info *storage_info, const char *str, uint32_t key)
+{
+	struct tegrabl_partition_info *partitions = storage_info->partitions;
+	uint32_t size = storage_info->index_size;
+	uint16_t *table;
+	uint32_t slot;
+	uint32_t i;
+
+	if (storage_info->index == NULL) {
+		for (i = 0; i < storage_info->num_partitions; i++) {
+			if (partition_key_match(&partitions[i], str, key)) {
+				break;
+			}
+		}
+		return i;
+	}
+
+	table = &storage_info->index[key * size];
+	slot = partition_key_hash(str, key) & (size - 1U);
+	while (table[slot] != 0U) {
+		i = table[slot] - 1U;
+		if (partition_key_match(&partitions[i], str, key)) {
+			return i;
+		}
+		slot = (slot + 1U) & (size - 1U);
+	}
+
+	return storage_info->num_partitions;
+}
+
+/* Name lookup, with A/B slots enabled "<name>_a" also finds a partition called
+ * "<name>" (see tegrabl_a_b_match_part_name()) */
+static uint32_t partition_find_by_name(struct tegrabl_storage_info *storage_info, const char *partition_name)
+{
+	uint32_t i;
+#if defined(CONFIG_ENABLE_A_B_SLOT)
+	char base_name[MAX_PARTITION_NAME];
+	size_t len = strlen(partition_name);
+	uint32_t j;
+#endif
+
+	i = partition_index_find(storage_info, partition_name, PART_KEY_NAME);
+
 #if defined(CONFIG_ENABLE_A_B_SLOT)
-	return tegrabl_a_b_match_part_name(partition_name, name);
-#else
-	return strcmp(partition_name, name) == 0;
+	if ((len > BOOT_CHAIN_SUFFIX_LEN) && (len < MAX_PARTITION_NAME) &&
+		(strcmp(&partition_name[len - BOOT_CHAIN_SUFFIX_LEN], BOOT_CHAIN_SUFFIX_A) == 0)) {
+		memcpy(base_name, partition_name, len - BOOT_CHAIN_SUFFIX_LEN);
+		base_name[len - BOOT_CHAIN_SUFFIX_LEN] = '\0';
+		j = partition_index_find(storage_info, base_name, PART_KEY_NAME);
+		if (j < i) {
+			i = j;
+		}
+	}
 #endif
+
+	return i;
+}
+
+/**
+ * @brief Initializes the storage devices whose initialization was deferred
+ * and publishes their partitions. Used when a lookup misses in the devices
+ * published so far.
+ *
+ * @return true if any device got initialized, i.e. the lookup is worth retrying
+ */
+static bool partition_publish_deferred(void)
+{
+	tegrabl_bdev_t *dev = NULL;
+
+	if (tegrabl_blockdev_init_deferred(TEGRABL_STORAGE_INVALID, 0) != TEGRABL_NO_ERROR) {
+		return false;
+	}
+
+	while ((dev = tegrabl_blockdev_next_device(dev)) != NULL) {
+		if ((dev->published == false) &&
+			(tegrabl_blockdev_get_storage_type(dev) != TEGRABL_STORAGE_SDMMC_RPMB)) {
+			(void)tegrabl_partition_publish(dev, 0);
+		}
+	}
+
+	return true;
 }
 
 tegrabl_error_t tegrabl_partition_lookup_bdev(const char *partition_name, struct tegrabl_partition *partition,
@@ -125,11 +296,7 @@ tegrabl_error_t tegrabl_partition_lookup_bdev(const char *partition_name, struct
 		num_partitions = entry->num_partitions;
 		partition_info = entry->partitions;
 
-		for (i = 0; i < num_partitions; i++) {
-			if (strcmp(partition_info[i].name, partition_name) == 0) {
-				break;
-			}
-		}
+		i = partition_index_find(entry, partition_name, PART_KEY_NAME);
 
 		if (i >= num_partitions) {
 			partition_info = NULL;
@@ -177,11 +344,10 @@ tegrabl_error_t tegrabl_partition_boot_guid_lookup_bdev(char *pt_type_guid,
 		partition_info = entry->partitions;
 
 		/* Check for boot partition by matching partition type UUID */
-		for (i = 0; i < num_partitions; i++) {
-			if (strncasecmp(partition_info[i].ptype_guid, pt_type_guid, GUID_STR_LEN) == 0) {
-				pr_trace("Partition type GUID matched\n\n");
-				goto partition_found;
-			}
+		i = partition_index_find(entry, pt_type_guid, PART_KEY_PTYPE_GUID);
+		if (i < num_partitions) {
+			pr_trace("Partition type GUID matched\n\n");
+			goto partition_found;
 		}
 	}
 
@@ -232,16 +398,13 @@ tegrabl_error_t tegrabl_partition_open(const char *partition_name,
 		goto fail;
 	}
 
+lookup:
 	list_for_every_entry(storage_list, entry,
 									struct tegrabl_storage_info, node) {
 		num_partitions = entry->num_partitions;
 		partition_info = entry->partitions;
 
-		for (i = 0; i < num_partitions; i++) {
-			if (match_partition_name(partition_info[i].name, partition_name)) {
-				break;
-			}
-		}
+		i = partition_find_by_name(entry, partition_name);
 
 		if (i >= num_partitions) {
 			partition_info = NULL;
@@ -250,6 +413,10 @@ tegrabl_error_t tegrabl_partition_open(const char *partition_name,
 		}
 	}
 
+	if ((partition_info == NULL) && partition_publish_deferred()) {
+		goto lookup;
+	}
+
 	if (partition_info == NULL) {
 		pr_error("Cannot find partition %s\n", partition_name);
 		error = TEGRABL_ERROR(TEGRABL_ERR_NOT_FOUND, 0);
@@ -265,6 +432,47 @@ fail:
 	return error;
 }
 
+tegrabl_error_t tegrabl_partition_open_by_guid(const char *guid,
+											   struct tegrabl_partition *partition)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	struct tegrabl_storage_info *entry = NULL;
+	uint32_t i = 0;
+
+	if ((guid == NULL) || (partition == NULL)) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 25);
+		goto fail;
+	}
+
+	if (storage_list == NULL) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_NOT_INITIALIZED, AUX_INFO_PARTITION_NOT_INIT);
+		pr_error("Partition manager might not be initialized.\n");
+		goto fail;
+	}
+
+lookup:
+	list_for_every_entry(storage_list, entry, struct tegrabl_storage_info, node) {
+		i = partition_index_find(entry, guid, PART_KEY_GUID);
+		if (i < entry->num_partitions) {
+			partition->partition_info = &entry->partitions[i];
+			partition->block_device = entry->bdev;
+			partition->offset = 0;
+			goto fail;
+		}
+	}
+
+	if (partition_publish_deferred()) {
+		goto lookup;
+	}
+
+	pr_error("Cannot find partition with GUID %s\n", guid);
+	error = TEGRABL_ERROR(TEGRABL_ERR_NOT_FOUND, AUX_INFO_PARTITION_GUID_NOT_FOUND);
+	memset(partition, 0x0, sizeof(*partition));
+
+fail:
+	return error;
+}
+
 uint64_t tegrabl_partition_size(struct tegrabl_partition *partition)
 {
 	struct tegrabl_partition_info *partition_info = NULL;
@@ -313,6 +521,11 @@ tegrabl_error_t tegrabl_partition_erase(struct tegrabl_partition *partition,
 
 	pr_debug("Erasing partition %s\n", partition_info->name);
 
+#if defined(CONFIG_ENABLE_RECOVERY_VERIFY_WRITE)
+	/* A failed read back is kept in the verify list */
+	(void)verify_pending_complete();
+#endif
+
 	error = tegrabl_blockdev_erase(partition->block_device,
 								   (uint32_t)partition_info->start_sector,
 								   (uint32_t)partition_info->num_sectors,
@@ -359,6 +572,14 @@ tegrabl_error_t tegrabl_partition_write(struct tegrabl_partition *partition,
 	offset = partition->offset + (partition_info->start_sector <<
 								  partition->block_device->block_size_log2);
 
+#if defined(CONFIG_ENABLE_RECOVERY_VERIFY_WRITE)
+	/* Stop flashing as soon as the previous write fails to read back */
+	error = verify_pending_complete();
+	if (TEGRABL_NO_ERROR != error) {
+		goto fail;
+	}
+#endif
+
 	error = tegrabl_blockdev_write(partition->block_device, buf,
 			offset, num_bytes);
 
@@ -366,6 +587,13 @@ tegrabl_error_t tegrabl_partition_write(struct tegrabl_partition *partition,
 		error = tegrabl_err_set_highest_module(error, MODULE);
 	}
 
+#if defined(CONFIG_ENABLE_RECOVERY_VERIFY_WRITE)
+	if (TEGRABL_NO_ERROR == error) {
+		error = verify_written_region(partition, buf, partition->offset,
+				num_bytes);
+	}
+#endif
+
 	partition->offset += num_bytes;
 
 fail:
@@ -429,6 +657,10 @@ tegrabl_error_t tegrabl_partition_read(struct tegrabl_partition *partition,
 	pr_debug("Reading %s from offset %"PRIu64 "num_bytes %zd\n",
 			 partition_info->name, partition->offset, num_bytes);
 
+#if defined(CONFIG_ENABLE_RECOVERY_VERIFY_WRITE)
+	(void)verify_pending_complete();
+#endif
+
 	offset = partition->offset + (partition_info->start_sector <<
 								  partition->block_device->block_size_log2);
 
@@ -548,6 +780,10 @@ tegrabl_error_t tegrabl_partition_async_read(
 	pr_debug("Async read %s %"PRIu64" sectors from %"PRIu64" sector\n",
 			 partition_info->name, num_sectors, start_sector);
 
+#if defined(CONFIG_ENABLE_RECOVERY_VERIFY_WRITE)
+	(void)verify_pending_complete();
+#endif
+
 	xfer = tegrabl_malloc(sizeof(struct tegrabl_blockdev_xfer_info));
 	if (xfer == NULL) {
 		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 10);
@@ -602,6 +838,10 @@ tegrabl_error_t tegrabl_partition_async_write(
 	pr_debug("Async write %s %"PRIu64" sectors from %"PRIu64" sector\n",
 			 partition_info->name, num_sectors, start_sector);
 
+#if defined(CONFIG_ENABLE_RECOVERY_VERIFY_WRITE)
+	(void)verify_pending_complete();
+#endif
+
 	xfer = tegrabl_malloc(sizeof(struct tegrabl_blockdev_xfer_info));
 	if (xfer == NULL) {
 	    err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 14);
@@ -662,6 +902,7 @@ tegrabl_error_t tegrabl_partition_publish(tegrabl_bdev_t *dev, off_t offset)
 				storage_info->partitions = partitions;
 				storage_info->num_partitions = num;
 				storage_info->bdev = dev;
+				partition_index_build(storage_info);
 
 				list_add_head(storage_list, &storage_info->node);
 
@@ -710,6 +951,7 @@ tegrabl_error_t tegrabl_partitions_unpublish(tegrabl_bdev_t *dev)
 		list_for_every_entry(storage_list, entry,
 											struct tegrabl_storage_info, node) {
 			if (entry->bdev->device_id == dev->device_id) {
+				tegrabl_free(entry->index);
 				tegrabl_free(entry->partitions);
 				list_delete(&entry->node);
 				tegrabl_free(entry);
@@ -776,22 +1018,30 @@ void tegrabl_partition_manager_flush_cache(void)
 
 #if defined(CONFIG_ENABLE_RECOVERY_VERIFY_WRITE)
 #define READ_BUFFER_SIZE (10 * 1024 * 1024)
-static tegrabl_error_t read_verify_partition(
+#define VERIFY_XFER_TIMEOUT_US (10 * 1000 * 1000)
+
+/* Read back of the last write, still in flight */
+struct verify_pending_info {
+	struct verify_list_info *entry;
+	struct tegrabl_blockdev_xfer_info *xfer;
+	struct tegrabl_partition partition;
+	uint64_t offset;
+	uint64_t size;
+	uint32_t crc32;
+};
+
+static struct verify_pending_info verify_pending;
+static uint8_t *verify_buffer;
+
+static tegrabl_error_t read_partition_crc(
 		struct tegrabl_partition partition,
-		struct verify_list_info *verify_info,
-		uint8_t *buffer)
+		uint64_t offset, uint64_t size,
+		uint8_t *buffer, uint32_t *crc32)
 {
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
-
 	uint64_t chunk_size = 0;
-	uint64_t size = 0;
-	uint64_t offset = 0;
 	uint32_t read_partition_crc32 = 0;
 
-	/* Set offset and size appropriately. */
-	offset = partition.offset;
-	size = verify_info->size;
-
 	pr_debug("Seeking partition to %"PRIu64" bytes\n", offset);
 
 	error = tegrabl_partition_seek(&partition, offset,
@@ -814,6 +1064,27 @@ static tegrabl_error_t read_verify_partition(
 				read_partition_crc32, buffer, chunk_size);
 		size -= chunk_size;
 	}
+
+	*crc32 = read_partition_crc32;
+
+fail:
+	return error;
+}
+
+static tegrabl_error_t read_verify_partition(
+		struct tegrabl_partition partition,
+		struct verify_list_info *verify_info,
+		uint8_t *buffer)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	uint32_t read_partition_crc32 = 0;
+
+	error = read_partition_crc(partition, partition.offset,
+			verify_info->size, buffer, &read_partition_crc32);
+	if (TEGRABL_NO_ERROR != error) {
+		goto fail;
+	}
+
 	pr_debug("crc32: Actual=0x%08x | Calculated=0x%08x\n",
 			read_partition_crc32, verify_info->crc32);
 
@@ -824,41 +1095,59 @@ fail:
 	return error;
 }
 
+static tegrabl_error_t verify_buffer_alloc(void)
+{
+	if (verify_buffer == NULL) {
+		verify_buffer = (uint8_t *) tegrabl_memalign(4096, READ_BUFFER_SIZE);
+		if (verify_buffer == NULL) {
+			pr_info("Failed to allocate verify buffer\n");
+			return TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 1);
+		}
+	}
+	return TEGRABL_NO_ERROR;
+}
+
 tegrabl_error_t tegrabl_partition_verify_write(void)
 {
 	struct verify_list_info *entry = NULL, *temp;
 	struct tegrabl_partition partition;
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
-	uint8_t *buffer = NULL;
 	bool verify_status = false;
 
+	/* Failures are recorded in the entry */
+	(void)verify_pending_complete();
+
 	/* Check & return if verify list empty */
 	if (list_is_empty(&verify_list))
 		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 17);
 
-	buffer = (uint8_t *) tegrabl_memalign(4096, READ_BUFFER_SIZE);
-	if (!buffer) {
-		error = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
-		pr_info("Failed to allocate nv3p buffer");
+	error = verify_buffer_alloc();
+	if (TEGRABL_NO_ERROR != error) {
 		goto fail;
 	}
 
 	list_for_every_entry_safe(&verify_list, entry,
 		temp, struct verify_list_info, node) {
-		error = tegrabl_partition_open(entry->name, &partition);
-		if (TEGRABL_NO_ERROR != error) {
-			pr_error("Failed to open partition");
-			break;
-		}
 		/* Call verify only if crc for the partition is received */
-		if (entry->crc32 != 0) {
-			error = read_verify_partition(partition, entry, buffer);
-		} else {
+		if (entry->verify_failed) {
+			error = TEGRABL_ERR_VERIFY_FAILED;
+		} else if (entry->crc32 == 0) {
 			error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 18);
+		} else if (entry->verify_contiguous &&
+				   (entry->written_size == entry->size) &&
+				   (entry->written_crc32 == entry->crc32)) {
+			/* Every region was read back right after it was written */
+			error = TEGRABL_NO_ERROR;
+		} else {
+			error = tegrabl_partition_open(entry->name, &partition);
+			if (TEGRABL_NO_ERROR != error) {
+				pr_error("Failed to open partition");
+				break;
+			}
+			error = read_verify_partition(partition, entry, verify_buffer);
+			tegrabl_partition_close(&partition);
 		}
 
-		tegrabl_partition_close(&partition);
-
 		if (error == TEGRABL_ERR_VERIFY_FAILED) {
 			pr_error("Verifying %s Partition [Failed]\n", entry->name);
 			verify_status = true;
@@ -870,24 +1159,186 @@ tegrabl_error_t tegrabl_partition_verify_write(void)
 	}
 
 fail:
-	if (buffer)
-		tegrabl_free(buffer);
+	if (verify_buffer) {
+		tegrabl_free(verify_buffer);
+		verify_buffer = NULL;
+	}
 
 	return verify_status ? TEGRABL_ERR_VERIFY_FAILED : error;
 }
 
+static struct verify_list_info *find_verify_node(const char *partition_name)
+{
+	struct verify_list_info *entry = NULL;
+	uint32_t hash = partition_key_hash(partition_name, PART_KEY_NAME);
+
+	list_for_every_entry(&verify_list, entry,
+			struct verify_list_info, node) {
+		if ((entry->name_hash == hash) && (strcmp(entry->name, partition_name) == 0)) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+static tegrabl_error_t verify_region_check(struct verify_list_info *entry,
+		tegrabl_error_t error, uint32_t crc32, uint32_t expected_crc32,
+		uint64_t offset)
+{
+	if ((TEGRABL_NO_ERROR == error) && (crc32 == expected_crc32)) {
+		return TEGRABL_NO_ERROR;
+	}
+
+	pr_error("Verifying %s Partition at offset %"PRIu64" [Failed]\n",
+			 entry->name, offset);
+	entry->verify_failed = true;
+
+	return TEGRABL_ERR_VERIFY_FAILED;
+}
+
+static tegrabl_error_t verify_pending_complete(void)
+{
+	struct verify_pending_info pending = verify_pending;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	uint8_t status = TEGRABL_BLOCKDEV_XFER_IN_PROGRESS;
+	uint32_t crc32 = 0;
+
+	if (pending.entry == NULL) {
+		goto fail;
+	}
+	memset(&verify_pending, 0, sizeof(verify_pending));
+
+	error = tegrabl_blockdev_xfer_wait(pending.xfer, VERIFY_XFER_TIMEOUT_US,
+			&status);
+	if ((TEGRABL_NO_ERROR == error) &&
+		(status != TEGRABL_BLOCKDEV_XFER_COMPLETE)) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_TIMEOUT, 0);
+	}
+	tegrabl_free(pending.xfer);
+
+	if (TEGRABL_NO_ERROR == error) {
+		crc32 = tegrabl_utils_crc32(0, verify_buffer, pending.size);
+	}
+
+	if ((TEGRABL_NO_ERROR != error) || (crc32 != pending.crc32)) {
+		/* Data is gone from the caller's buffer, read once more in case
+		 * the read back itself went wrong */
+		pr_warn("Read back of %s at offset %"PRIu64" failed, retrying\n",
+				pending.entry->name, pending.offset);
+		error = read_partition_crc(pending.partition, pending.offset,
+				pending.size, verify_buffer, &crc32);
+	}
+
+	error = verify_region_check(pending.entry, error, crc32, pending.crc32,
+			pending.offset);
+
+fail:
+	return error;
+}
+
+/**
+ * @brief Reads back a region just written to a partition in the verify list.
+ * Sector aligned regions are read asynchronously if the device supports it
+ * and checked by the next partition call, so that the read back overlaps
+ * with the caller fetching the next region. Others are checked right away
+ * and written once more if they do not read back correctly.
+ */
+static tegrabl_error_t verify_written_region(struct tegrabl_partition *partition,
+		const void *buf, uint64_t offset, size_t num_bytes)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	struct verify_list_info *entry = NULL;
+	tegrabl_bdev_t *dev = partition->block_device;
+	uint32_t block_size_log2 = dev->block_size_log2;
+	uint64_t start = partition->partition_info->start_sector << block_size_log2;
+	uint32_t expected_crc32 = 0;
+	uint32_t crc32 = 0;
+#if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
+	uint64_t block_mask = TEGRABL_BLOCKDEV_BLOCK_SIZE(dev) - 1ULL;
+	struct tegrabl_blockdev_xfer_info *xfer = NULL;
+#endif
+
+	if (!set_verify_flag) {
+		goto fail;
+	}
+
+	entry = find_verify_node(partition->partition_info->name);
+	if ((entry == NULL) || entry->verify_failed) {
+		goto fail;
+	}
+
+	/* A write from the start begins a new image */
+	if (offset == 0ULL) {
+		entry->written_size = 0;
+		entry->written_crc32 = 0;
+		entry->verify_contiguous = true;
+	} else if (offset != entry->written_size) {
+		entry->verify_contiguous = false;
+	}
+
+	expected_crc32 = tegrabl_utils_crc32(0, (void *)buf, num_bytes);
+	if (entry->verify_contiguous) {
+		entry->written_crc32 = tegrabl_utils_crc32(entry->written_crc32,
+				(void *)buf, num_bytes);
+		entry->written_size += num_bytes;
+	}
+
+	if (verify_buffer_alloc() != TEGRABL_NO_ERROR) {
+		/* Leave it to tegrabl_partition_verify_write() */
+		entry->verify_contiguous = false;
+		goto fail;
+	}
+
+#if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
+	if ((dev->xfer != NULL) && (dev->xfer_wait != NULL) &&
+		((offset & block_mask) == 0ULL) &&
+		((num_bytes & block_mask) == 0ULL) &&
+		(num_bytes <= READ_BUFFER_SIZE)) {
+		error = tegrabl_partition_async_read(partition, verify_buffer,
+				offset >> block_size_log2, num_bytes >> block_size_log2, &xfer);
+		if (TEGRABL_NO_ERROR == error) {
+			verify_pending.entry = entry;
+			verify_pending.xfer = xfer;
+			verify_pending.partition = *partition;
+			verify_pending.offset = offset;
+			verify_pending.size = num_bytes;
+			verify_pending.crc32 = expected_crc32;
+			goto fail;
+		}
+		if (xfer != NULL) {
+			tegrabl_free(xfer);
+		}
+	}
+#endif
+
+	error = read_partition_crc(*partition, offset, num_bytes, verify_buffer,
+			&crc32);
+	if ((TEGRABL_NO_ERROR != error) || (crc32 != expected_crc32)) {
+		pr_warn("Read back of %s at offset %"PRIu64" failed, rewriting\n",
+				entry->name, offset);
+		error = tegrabl_blockdev_write(dev, buf, start + offset, num_bytes);
+		if (TEGRABL_NO_ERROR == error) {
+			error = read_partition_crc(*partition, offset, num_bytes,
+					verify_buffer, &crc32);
+		}
+	}
+
+	error = verify_region_check(entry, error, crc32, expected_crc32, offset);
+
+fail:
+	return error;
+}
+
 static tegrabl_error_t tegrabl_partition_add_verify_node(char *partition_name)
 {
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
 	struct verify_list_info *verify_handle;
 
 	/* Check for duplicate node */
-	list_for_every_entry(&verify_list, verify_handle,
-			struct verify_list_info, node) {
-		if (strcmp(verify_handle->name, partition_name) == 0) {
-			pr_info("Partition already enabled for verification\n");
-			goto fail;
-		}
+	if (find_verify_node(partition_name) != NULL) {
+		pr_info("Partition already enabled for verification\n");
+		goto fail;
 	}
 
 	verify_handle = tegrabl_malloc(sizeof(struct verify_list_info));
@@ -898,7 +1349,12 @@ static tegrabl_error_t tegrabl_partition_add_verify_node(char *partition_name)
 	}
 	verify_handle->size = 0;
 	verify_handle->crc32 = 0;
+	verify_handle->written_size = 0;
+	verify_handle->written_crc32 = 0;
+	verify_handle->verify_contiguous = true;
+	verify_handle->verify_failed = false;
 	strcpy(verify_handle->name, partition_name);
+	verify_handle->name_hash = partition_key_hash(partition_name, PART_KEY_NAME);
 	list_add_head(&verify_list, &verify_handle->node);
 	pr_debug("Added %s Partition to verify list\n",	verify_handle->name);
 
@@ -913,23 +1369,22 @@ tegrabl_error_t tegrabl_partition_set_crc(struct tegrabl_partition *partition,
 	char *partition_name = partition->partition_info->name;
 	struct verify_list_info *entry = NULL;
 
-	list_for_every_entry(&verify_list, entry,
-			struct verify_list_info, node) {
-		if (strcmp(entry->name, partition_name) == 0) {
-			break;
-		}
+	/* The entry may be deleted below */
+	(void)verify_pending_complete();
+
+	entry = find_verify_node(partition_name);
+	if (entry == NULL) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_NOT_FOUND, 0);
+		goto fail;
 	}
+
 	/*
 	 *  Currently sparse partition verification is not supported.
 	 *  So delete this node from verify list.
 	 */
 	if (is_sparse) {
 		list_delete(&entry->node);
-		goto fail;
-	}
-
-	if (entry == NULL) {
-		error = TEGRABL_ERROR(TEGRABL_ERR_NOT_FOUND, 0);
+		tegrabl_free(entry);
 		goto fail;
 	}
 	entry->size = verify_size;
@@ -944,7 +1399,6 @@ bool tegrabl_partition_is_verify_enabled(struct tegrabl_partition *partition)
 	bool status = false;
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
 	char *partition_name = partition->partition_info->name;
-	struct verify_list_info *entry = NULL;
 
 	if (set_verify_flag) {
 		if (verify_all_partitions) {
@@ -957,13 +1411,7 @@ bool tegrabl_partition_is_verify_enabled(struct tegrabl_partition *partition)
 				status = true;
 		} else {
 			/* find in verify list, if verify all is not set */
-			list_for_every_entry(&verify_list, entry,
-				struct verify_list_info, node) {
-				if (!strcmp(entry->name, partition_name)) {
-					status = true;
-					break;
-				}
-			}
+			status = (find_verify_node(partition_name) != NULL);
 		}
 	}
 	return status;
@@ -973,8 +1421,6 @@ tegrabl_error_t tegrabl_partition_verify_enable(char *partition_name,
 		uint32_t device_type, uint32_t instance)
 {
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
-	struct verify_list_info *part_entry = NULL;
-
 	if (!strcmp(partition_name, "all")) {
 		verify_all_partitions = true;
 		set_verify_flag = true;
@@ -985,7 +1431,7 @@ tegrabl_error_t tegrabl_partition_verify_enable(char *partition_name,
 	if (error == TEGRABL_NO_ERROR) {
 		set_verify_flag = true;
 		pr_debug("Added %s partition to verify list\n",
-				part_entry->name);
+				partition_name);
 	}
 
 	TEGRABL_UNUSED(device_type);
@@ -37,6 +37,20 @@ tegrabl_error_t tegrabl_sparse_init_unsparse_state(
 	return TEGRABL_NO_ERROR;
 }
 
+tegrabl_error_t tegrabl_sparse_set_unsparse_filler(
+		struct tegrabl_unsparse_state *unsparse_state,
+		tegrabl_error_t (*filler)(uint32_t fill_value, uint64_t size,
+			void *aux_info))
+{
+	if (!unsparse_state) {
+		return TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, 2);
+	}
+
+	unsparse_state->filler = filler;
+
+	return TEGRABL_NO_ERROR;
+}
+
 /**
  * @brief Validates header and checks if unsparsed size mentioned
  * in header is less or equal to maximum allowed size specified.
@@ -294,6 +308,29 @@ tegrabl_error_t tegrabl_sparse_unsparse(
 				buffer[i] = buffer[0];
 			}
 
+			if (unsparse_state->filler && remaining) {
+				error = unsparse_state->filler(unsparse_state->fill_value,
+						remaining, aux_info);
+				if (error == TEGRABL_NO_ERROR) {
+#ifdef TEGRABL_CONFIG_ENABLE_SPARSE_CRC32
+					while (remaining) {
+						size = MIN(remaining, SPARSE_MAX_LOCAL_BUFFER);
+						remaining -= size;
+						computed_crc = tegrabl_utils_crc32(computed_crc,
+								(void *)buffer, size);
+					}
+#endif
+					remaining = 0;
+				} else if (TEGRABL_ERROR_REASON(error) ==
+						TEGRABL_ERR_NOT_SUPPORTED) {
+					error = TEGRABL_NO_ERROR;
+				} else {
+					pr_debug("Failed to fill unsparse image\n");
+					TEGRABL_SET_HIGHEST_MODULE(error);
+					goto fail;
+				}
+			}
+
 			while (remaining) {
 				size = MIN(remaining, SPARSE_MAX_LOCAL_BUFFER);
 				remaining -= size;
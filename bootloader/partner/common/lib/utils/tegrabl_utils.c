@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2018, NVIDIA Corporation.  All rights reserved.
+ * Copyright (c) 2015-2020, NVIDIA Corporation.  All rights reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property and
  * proprietary rights in and to this software and related documentation.  Any
@@ -63,11 +63,63 @@ static uint32_t tegrabl_crc32_tab[] = {
     0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
 };
 
+#if defined(__aarch64__)
+/* ID_AA64ISAR0_EL1.CRC32, non-zero if the CRC32 instructions are implemented */
+#define ID_AA64ISAR0_CRC32_SHIFT 16U
+#define ID_AA64ISAR0_CRC32_MASK 0xFULL
+
+static bool crc32_hw_present(void)
+{
+	static int8_t present = -1;
+	uint64_t isar0;
+
+	if (present < 0) {
+		__asm__ volatile ("mrs %0, id_aa64isar0_el1" : "=r" (isar0));
+		present = (((isar0 >> ID_AA64ISAR0_CRC32_SHIFT) & ID_AA64ISAR0_CRC32_MASK) != 0U) ? 1 : 0;
+	}
+
+	return present == 1;
+}
+
+/* Same polynomial and bit order as tegrabl_crc32_tab, 8 bytes per instruction */
+static uint32_t crc32_hw(uint32_t crc, const uint8_t *buf, size_t len)
+{
+	uint64_t dword;
+
+	while ((len != 0U) && (((uintptr_t)buf & 7U) != 0U)) {
+		__asm__ (".arch_extension crc\n\tcrc32b %w0, %w0, %w1" : "+r" (crc) : "r" ((uint32_t)*buf));
+		buf++;
+		len--;
+	}
+
+	while (len >= 8U) {
+		dword = *(const uint64_t *)(uintptr_t)buf;
+		__asm__ (".arch_extension crc\n\tcrc32x %w0, %w0, %x1" : "+r" (crc) : "r" (dword));
+		buf += 8;
+		len -= 8U;
+	}
+
+	while (len != 0U) {
+		__asm__ (".arch_extension crc\n\tcrc32b %w0, %w0, %w1" : "+r" (crc) : "r" ((uint32_t)*buf));
+		buf++;
+		len--;
+	}
+
+	return crc;
+}
+#endif
+
 uint32_t tegrabl_utils_crc32(uint32_t val, void *buffer, size_t buffer_size)
 {
 	uint32_t final_crc = val ^ ~0U;
 	uint8_t *buf = (uint8_t *) buffer;
 
+#if defined(__aarch64__)
+	if (crc32_hw_present()) {
+		return crc32_hw(final_crc, buf, buffer_size) ^ ~0U;
+	}
+#endif
+
 	while (buffer_size != 0U) {
 		final_crc = (tegrabl_crc32_tab[(final_crc ^ *buf) & 0xFFU] ^
 					(final_crc >> 8));
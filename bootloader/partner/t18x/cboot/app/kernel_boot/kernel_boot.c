@@ -203,12 +203,26 @@ tegrabl_error_t load_and_boot_kernel(struct tegrabl_kernel_bin *kernel)
 	err = display_boot_logo();
 	if (err != TEGRABL_NO_ERROR)
 		pr_warn("Boot logo display failed...\n");
+#if defined(CONFIG_ENABLE_DISPLAY_ASYNC_INIT)
+	/* Display registers must not be touched once the kernel runs */
+	tegrabl_display_wait_init();
+#endif
 #endif
 
 #if defined(IS_T186)
 	tegrabl_profiler_record("kernel_boot exit", 0, DETAILED);
 #endif
 
+#if defined(CONFIG_ENABLE_STAGED_SCRUBBING)
+	/* Background scrub must be done before DRAM is handed to the kernel */
+	err = dram_staged_scrub_wait();
+	if (err != TEGRABL_NO_ERROR) {
+		pr_error("dram scrub failed, will reset.\n");
+		tegrabl_reset();
+		return err;
+	}
+#endif
+
 	pr_info("Kernel EP: %p, DTB: %p\n", kernel_entry_point, kernel_dtb);
 
 	platform_uninit();
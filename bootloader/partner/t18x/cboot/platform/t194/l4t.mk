@@ -20,7 +20,14 @@ GLOBAL_DEFINES += \
 	CONFIG_ENABLE_DISPLAY=1 \
 	CONFIG_ENABLE_SHELL=1 \
 	CONFIG_ENABLE_L4T_RECOVERY=1 \
-	CONFIG_ENABLE_EXTLINUX_BOOT=1
+	CONFIG_ENABLE_EXTLINUX_BOOT=1 \
+	CONFIG_ENABLE_EXTLINUX_PRELOAD=1 \
+	CONFIG_ENABLE_DEFERRED_STORAGE_INIT=1 \
+	CONFIG_ENABLE_DISPLAY_ASYNC_INIT=1 \
+	CONFIG_ENABLE_HEAP_LOCK=1 \
+	CONFIG_ENABLE_BPMP_IPC_LOCK=1 \
+	CONFIG_ENABLE_I2C_LOCK=1 \
+	CONFIG_ENABLE_CLK_CACHE_LOCK=1
 
 MODULE_DEPS +=	\
 	lib/lwip \
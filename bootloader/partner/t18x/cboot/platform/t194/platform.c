@@ -643,7 +643,11 @@ void platform_init(void)
 	}
 
 #if defined(CONFIG_ENABLE_DISPLAY)
+#if defined(CONFIG_ENABLE_DISPLAY_ASYNC_INIT)
+	err = tegrabl_display_init_async();
+#else
 	err = tegrabl_display_init();
+#endif
 	if (err != TEGRABL_NO_ERROR) {
 		pr_warn("display init failed\n");
 	}
@@ -130,6 +130,8 @@ GLOBAL_DEFINES += \
 	CONFIG_ENABLE_STAGED_SCRUBBING=1 \
 	CONFIG_ENABLE_WAR_CBOOT_STAGED_SCRUBBING=1 \
 	CONFIG_SKIP_GPCDMA_RESET=1 \
+	CONFIG_ENABLE_GPCDMA_ASYNC=1 \
+	CONFIG_ENABLE_KERNEL_INPLACE_DECOMP=1 \
 	CONFIG_DEBUG_LOGLEVEL=TEGRABL_LOG_INFO
 
 ALLMODULE_OBJS += $(LOCAL_DIR)/../../../../t19x/common/drivers/se/prebuilt/se.mod.o
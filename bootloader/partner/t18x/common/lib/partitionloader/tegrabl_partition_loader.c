@@ -27,6 +27,7 @@
 #include <tegrabl_bootimg.h>
 #include <tegrabl_linuxboot_helper.h>
 #include <tegrabl_exit.h>
+#include <libfdt.h>
 
 #ifdef CONFIG_ENABLE_A_B_SLOT
 #include <tegrabl_a_b_boot_control.h>
@@ -35,6 +36,9 @@
 /* boot.img signature size for verify_boot */
 #define BOOT_IMG_SIG_SIZE (4 * 1024)
 
+/* Read first to size the other binaries, covers a BCH header */
+#define BINARY_HEAD_SIZE (4 * 1024)
+
 tegrabl_error_t tegrabl_get_partition_name(tegrabl_binary_type_t bin_type,
 						tegrabl_binary_copy_t binary_copy,
 						char *partition_name)
@@ -203,6 +207,23 @@ static tegrabl_error_t tegrabl_get_binary_info(
 	return err;
 }
 
+/* Reads the rest of a binary whose first head_size bytes are at load_address */
+static tegrabl_error_t read_partition_rest(struct tegrabl_partition *partition,
+	void *load_address, uint64_t head_size, uint64_t total_size)
+{
+	uint32_t device_type;
+
+	device_type = BITFIELD_GET(partition->block_device->device_id, 16, 16);
+	if (device_type == TEGRABL_STORAGE_USB_MS) {
+		/* TODO: WAR for reading kernel image from usb stick */
+		partition->offset = 0;
+		return tegrabl_partition_read(partition, load_address, total_size);
+	}
+
+	return tegrabl_partition_read(partition, (char *)load_address + head_size,
+								  total_size - head_size);
+}
+
 static tegrabl_error_t read_kernel_partition(
 	struct tegrabl_partition *partition, void *load_address,
 	uint64_t *partition_size)
@@ -210,7 +231,6 @@ static tegrabl_error_t read_kernel_partition(
 	tegrabl_error_t err;
 	uint32_t remain_size;
 	union tegrabl_bootimg_header *hdr;
-	uint32_t device_type;
 
 	pr_trace("%s(): %u\n", __func__, __LINE__);
 
@@ -250,19 +270,8 @@ static tegrabl_error_t read_kernel_partition(
 	}
 
 	/* read the remaining pages */
-	device_type = BITFIELD_GET(partition->block_device->device_id, 16, 16);
-	if (device_type == TEGRABL_STORAGE_USB_MS) {
-		/* TODO: WAR for reading kernel image from usb stick */
-		partition->offset = 0;
-		err = tegrabl_partition_read(partition,
-									(char *)load_address,
-									remain_size + ANDROID_HEADER_SIZE);
-	} else {
-		err = tegrabl_partition_read(partition,
-									(char *)load_address + ANDROID_HEADER_SIZE,
-									remain_size);
-	}
-
+	err = read_partition_rest(partition, load_address, ANDROID_HEADER_SIZE,
+							  remain_size + ANDROID_HEADER_SIZE);
 	if (err != TEGRABL_NO_ERROR) {
 		pr_error("Error reading kernel partition remaining pages\n");
 		TEGRABL_SET_HIGHEST_MODULE(err);
@@ -273,6 +282,55 @@ static tegrabl_error_t read_kernel_partition(
 	return err;
 }
 
+/* Size of the binary starting with head, 0 if unknown */
+static uint64_t binary_content_size(void *head, uint64_t head_size)
+{
+	if ((head_size >= sizeof(struct fdt_header)) && (fdt_magic(head) == FDT_MAGIC)) {
+		return fdt_totalsize(head);
+	}
+
+	return tegrabl_get_bch_binary_size(head, (uint32_t)head_size);
+}
+
+static tegrabl_error_t read_binary_partition(
+	struct tegrabl_partition *partition, void *load_address,
+	uint64_t *partition_size)
+{
+	tegrabl_error_t err;
+	uint64_t head_size;
+	uint64_t content_size;
+
+	pr_trace("%s(): %u\n", __func__, __LINE__);
+
+	/* read head to find out how much of the partition is used */
+	head_size = MIN(*partition_size, BINARY_HEAD_SIZE);
+	err = tegrabl_partition_read(partition, load_address, head_size);
+	if (err != TEGRABL_NO_ERROR) {
+		pr_error("Error reading partition header\n");
+		TEGRABL_SET_HIGHEST_MODULE(err);
+		return err;
+	}
+
+	content_size = binary_content_size(load_address, head_size);
+	if ((content_size == 0ULL) || (content_size > *partition_size)) {
+		/* unknown content, read the rest partition */
+		content_size = *partition_size;
+	}
+	pr_trace("%u: partition: read size: 0x%"PRIx64"\n", __LINE__, content_size);
+
+	if (content_size > head_size) {
+		err = read_partition_rest(partition, load_address, head_size, content_size);
+		if (err != TEGRABL_NO_ERROR) {
+			pr_error("Error reading partition remaining pages\n");
+			TEGRABL_SET_HIGHEST_MODULE(err);
+			return err;
+		}
+	}
+
+	*partition_size = content_size;
+	return err;
+}
+
 #define AUX_INFO_LOAD_BINARY_BIN_TYPE_ERR	100
 #define AUX_INFO_LOAD_BINARY_BDEV_ERR		101
 #define AUX_INFO_INVALID_PARTITION_SIZE		102
@@ -347,8 +405,8 @@ tegrabl_error_t tegrabl_load_binary_bdev(tegrabl_binary_type_t bin_type, void **
 		err = read_kernel_partition(&partition, binary.load_address,
 									&partition_size);
 	} else {
-		err = tegrabl_partition_read(&partition, binary.load_address,
-									 partition_size);
+		err = read_binary_partition(&partition, binary.load_address,
+									&partition_size);
 	}
 
 	if (err != TEGRABL_NO_ERROR) {
@@ -449,8 +507,8 @@ tegrabl_error_t tegrabl_load_binary_copy(
 		err = read_kernel_partition(&partition, binary.load_address,
 									&partition_size);
 	else
-		err = tegrabl_partition_read(&partition, binary.load_address,
-									 partition_size);
+		err = read_binary_partition(&partition, binary.load_address,
+									&partition_size);
 
 	if (err != TEGRABL_NO_ERROR) {
 		pr_error("Error reading partition %s\n", binary.partition_name);
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017-2019, NVIDIA Corporation.  All rights reserved.
+ * Copyright (c) 2017-2020, NVIDIA Corporation.  All rights reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -17,6 +17,10 @@
 #include <tegrabl_qspi.h>
 #include <tegrabl_soc_misc.h>
 #include <tegrabl_soc_clock.h>
+#include <string.h>
+#if defined(CONFIG_ENABLE_CLK_CACHE_LOCK)
+#include <kernel/mutex.h>
+#endif
 
 #include <bpmp_abi.h>
 #include <clk-t194.h>
@@ -58,6 +62,84 @@
 
 static uint32_t pllc4_muxed_rate;
 
+/* Flags for clk_cache entries */
+#define CLK_CACHE_RATE_VALID    (1U << 0)
+#define CLK_CACHE_PARENT_VALID  (1U << 1)
+#define CLK_CACHE_STATE_VALID   (1U << 2)
+#define CLK_CACHE_ENABLED       (1U << 3)
+
+/**
+ * Clock state last reported by or programmed into BPMP, indexed by bpmp clock
+ * id, so that repeated queries do not cost an IVC round-trip each.
+ * Rates and parents depend on the whole clock tree, hence any set_rate or
+ * set_parent drops all of them. Enable state is tracked per clock for
+ * is_enabled queries only, enables and disables always go to BPMP.
+ */
+struct clk_cache_entry {
+	uint32_t rate_khz;
+	uint16_t parent_id;
+	uint8_t flags;
+};
+
+static struct clk_cache_entry clk_cache[TEGRA194_MAX_CLK_ID];
+
+#if defined(CONFIG_ENABLE_CLK_CACHE_LOCK)
+/**
+ * Held across each BPMP clock request and the cache update that follows it,
+ * so a reply from before a concurrent set_rate or set_parent is never cached
+ * after that change dropped the entry.
+ */
+static mutex_t clk_cache_lock = MUTEX_INITIAL_VALUE(clk_cache_lock);
+
+static inline void clk_cache_lock_acquire(void)
+{
+	mutex_acquire(&clk_cache_lock);
+}
+
+static inline void clk_cache_lock_release(void)
+{
+	mutex_release(&clk_cache_lock);
+}
+#else
+static inline void clk_cache_lock_acquire(void)
+{
+}
+
+static inline void clk_cache_lock_release(void)
+{
+}
+#endif
+
+static inline struct clk_cache_entry *clk_cache_get(uint32_t clk_id)
+{
+	if (clk_id >= TEGRA194_MAX_CLK_ID) {
+		return NULL;
+	}
+
+	return &clk_cache[clk_id];
+}
+
+static void clk_cache_drop_rates(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < TEGRA194_MAX_CLK_ID; i++) {
+		clk_cache[i].flags &= ~(CLK_CACHE_RATE_VALID | CLK_CACHE_PARENT_VALID);
+	}
+}
+
+static void clk_cache_invalidate(void)
+{
+	memset(clk_cache, 0, sizeof(clk_cache));
+}
+
+void tegrabl_car_invalidate_clk_cache(void)
+{
+	clk_cache_lock_acquire();
+	clk_cache_invalidate();
+	clk_cache_lock_release();
+}
+
 static uint32_t tegrabl_pllid_to_bpmp_pllid[TEGRABL_CLK_PLL_ID_MAX] = {
 		[TEGRABL_CLK_PLL_ID_PLLP] = TEGRA194_CLK_PLLP,
 		[TEGRABL_CLK_PLL_ID_PLLC4] = TEGRA194_CLK_PLLC4,
@@ -799,6 +881,7 @@ static tegrabl_error_t internal_tegrabl_car_set_clk_src(
 {
 	struct mrq_clk_request req_clk_set_src;
 	struct mrq_clk_response resp_clk_set_src;
+	struct clk_cache_entry *entry;
 
 	if ((clk_id == MODULE_NOT_SUPPORTED) ||
 		(clk_src == TEGRA194_MAX_CLK_ID)) {
@@ -812,6 +895,8 @@ static tegrabl_error_t internal_tegrabl_car_set_clk_src(
 
 	pr_trace("(%s,%d) bpmp_src: %d\n", __func__, __LINE__, clk_src);
 
+	clk_cache_lock_acquire();
+
 	/* TX */
 	if (TEGRABL_NO_ERROR != tegrabl_ccplex_bpmp_xfer(
 					&req_clk_set_src, &resp_clk_set_src,
@@ -819,9 +904,21 @@ static tegrabl_error_t internal_tegrabl_car_set_clk_src(
 					sizeof(struct mrq_clk_response),
 					MRQ_CLK)) {
 		pr_error("Error in tx-rx: %s,%d\n", __func__, __LINE__);
+		clk_cache_drop_rates();
+		clk_cache_lock_release();
 		return TEGRABL_ERR_INVALID;
 	}
 
+	/* Rates of clk_id and everything below it may have changed */
+	clk_cache_drop_rates();
+	entry = clk_cache_get(clk_id);
+	if (entry != NULL) {
+		entry->parent_id = (uint16_t)clk_src;
+		entry->flags |= CLK_CACHE_PARENT_VALID;
+	}
+
+	clk_cache_lock_release();
+
 	return TEGRABL_NO_ERROR;
 }
 
@@ -831,11 +928,21 @@ static tegrabl_error_t internal_tegrabl_car_get_clk_rate(
 {
 	struct mrq_clk_request req_clk_get_rate;
 	struct mrq_clk_response resp_clk_get_rate;
+	struct clk_cache_entry *entry;
 
 	if (clk_id == TEGRA194_MAX_CLK_ID) {
 		return TEGRABL_ERR_NOT_SUPPORTED;
 	}
 
+	clk_cache_lock_acquire();
+
+	entry = clk_cache_get(clk_id);
+	if ((entry != NULL) && ((entry->flags & CLK_CACHE_RATE_VALID) != 0U)) {
+		*rate_khz = entry->rate_khz;
+		clk_cache_lock_release();
+		return TEGRABL_NO_ERROR;
+	}
+
 	req_clk_get_rate.cmd_and_id = BPMP_CLK_CMD(CMD_CLK_GET_RATE, clk_id);
 
 	/* TX */
@@ -845,6 +952,7 @@ static tegrabl_error_t internal_tegrabl_car_get_clk_rate(
 					sizeof(struct mrq_clk_response),
 					MRQ_CLK)) {
 		pr_error("Error in tx-rx: %s,%d\n", __func__, __LINE__);
+		clk_cache_lock_release();
 		return TEGRABL_ERR_INVALID;
 	}
 
@@ -852,6 +960,13 @@ static tegrabl_error_t internal_tegrabl_car_get_clk_rate(
 	*rate_khz = (resp_clk_get_rate.clk_get_rate.rate)/HZ_1K;
 	pr_trace("Received data (from BPMP) %d\n", *rate_khz);
 
+	if (entry != NULL) {
+		entry->rate_khz = *rate_khz;
+		entry->flags |= CLK_CACHE_RATE_VALID;
+	}
+
+	clk_cache_lock_release();
+
 	return TEGRABL_NO_ERROR;
 }
 
@@ -862,6 +977,7 @@ static tegrabl_error_t internal_tegrabl_car_set_clk_rate(
 {
 	struct mrq_clk_request req_clk_set_rate;
 	struct mrq_clk_response resp_clk_set_rate;
+	struct clk_cache_entry *entry;
 
 	if (clk_id == MODULE_NOT_SUPPORTED) {
 		return TEGRABL_ERR_NOT_SUPPORTED;
@@ -870,6 +986,8 @@ static tegrabl_error_t internal_tegrabl_car_set_clk_rate(
 	req_clk_set_rate.cmd_and_id = BPMP_CLK_CMD(CMD_CLK_SET_RATE, clk_id);
 	req_clk_set_rate.clk_set_rate.rate = rate_khz*HZ_1K;
 
+	clk_cache_lock_acquire();
+
 	/* TX */
 	if (TEGRABL_NO_ERROR != tegrabl_ccplex_bpmp_xfer(
 					&req_clk_set_rate, &resp_clk_set_rate,
@@ -877,12 +995,24 @@ static tegrabl_error_t internal_tegrabl_car_set_clk_rate(
 					sizeof(struct mrq_clk_response),
 					MRQ_CLK)) {
 		pr_error("Error in tx-rx: %s,%d\n", __func__, __LINE__);
+		clk_cache_drop_rates();
+		clk_cache_lock_release();
 		return TEGRABL_ERR_INVALID;
 	}
 
 	/* RX */
 	*rate_set_khz = (resp_clk_set_rate.clk_set_rate.rate)/HZ_1K;
 
+	/* Children of clk_id follow its rate */
+	clk_cache_drop_rates();
+	entry = clk_cache_get(clk_id);
+	if (entry != NULL) {
+		entry->rate_khz = *rate_set_khz;
+		entry->flags |= CLK_CACHE_RATE_VALID;
+	}
+
+	clk_cache_lock_release();
+
 	pr_trace("(%s,%d) Enabled rate %d for %d\n", __func__, __LINE__,
 			 *rate_set_khz, clk_id);
 
@@ -893,6 +1023,7 @@ static tegrabl_error_t internal_tegrabl_car_clk_enable(uint32_t clk_id)
 {
 	struct mrq_clk_request req_clk_enable;
 	struct mrq_clk_response resp_clk_enable;
+	struct clk_cache_entry *entry;
 
 	if (clk_id == MODULE_NOT_SUPPORTED) {
 		return TEGRABL_ERR_NOT_SUPPORTED;
@@ -901,8 +1032,13 @@ static tegrabl_error_t internal_tegrabl_car_clk_enable(uint32_t clk_id)
 		return TEGRABL_NO_ERROR;
 	}
 
+	/* Always forwarded, BPMP counts enables and a disable drops one of them */
+	entry = clk_cache_get(clk_id);
+
 	req_clk_enable.cmd_and_id = BPMP_CLK_CMD(CMD_CLK_ENABLE, clk_id);
 
+	clk_cache_lock_acquire();
+
 	/* TX */
 	if (TEGRABL_NO_ERROR != tegrabl_ccplex_bpmp_xfer(
 					&req_clk_enable, &resp_clk_enable,
@@ -910,11 +1046,18 @@ static tegrabl_error_t internal_tegrabl_car_clk_enable(uint32_t clk_id)
 					sizeof(struct mrq_clk_response),
 					MRQ_CLK)) {
 		pr_error("Error in tx-rx: %s,%d\n", __func__, __LINE__);
+		clk_cache_lock_release();
 		return TEGRABL_ERR_INVALID;
 	}
 
 	pr_trace("(%s,%d) Enabled - %d\n", __func__, __LINE__, clk_id);
 
+	if (entry != NULL) {
+		entry->flags |= CLK_CACHE_STATE_VALID | CLK_CACHE_ENABLED;
+	}
+
+	clk_cache_lock_release();
+
 		return TEGRABL_NO_ERROR;
 }
 
@@ -922,11 +1065,22 @@ static bool internal_tegrabl_car_clk_is_enabled(uint32_t clk_id)
 {
 	struct mrq_clk_request req_clk_is_enabled;
 	struct mrq_clk_response resp_clk_is_enabled;
+	struct clk_cache_entry *entry;
+	bool is_enabled;
 
 	if (clk_id == MODULE_NOT_SUPPORTED) {
 		return false;
 	}
 
+	clk_cache_lock_acquire();
+
+	entry = clk_cache_get(clk_id);
+	if ((entry != NULL) && ((entry->flags & CLK_CACHE_STATE_VALID) != 0U)) {
+		is_enabled = (entry->flags & CLK_CACHE_ENABLED) != 0U;
+		clk_cache_lock_release();
+		return is_enabled;
+	}
+
 	req_clk_is_enabled.cmd_and_id = BPMP_CLK_CMD(CMD_CLK_IS_ENABLED, clk_id);
 
 	/* TX */
@@ -936,12 +1090,23 @@ static bool internal_tegrabl_car_clk_is_enabled(uint32_t clk_id)
 					sizeof(struct mrq_clk_response),
 					MRQ_CLK)) {
 		pr_error("Error in tx-rx: %s,%d\n", __func__, __LINE__);
+		clk_cache_lock_release();
 		return false;
 	}
 
 	pr_trace("(%s,%d) clk(%d) state = %d\n", __func__, __LINE__, clk_id,
 			 resp_clk_is_enabled.clk_is_enabled.state);
 
+	if (entry != NULL) {
+		entry->flags &= ~CLK_CACHE_ENABLED;
+		if (resp_clk_is_enabled.clk_is_enabled.state != 0) {
+			entry->flags |= CLK_CACHE_ENABLED;
+		}
+		entry->flags |= CLK_CACHE_STATE_VALID;
+	}
+
+	clk_cache_lock_release();
+
 	return (bool)resp_clk_is_enabled.clk_is_enabled.state;
 }
 
@@ -978,6 +1143,8 @@ static tegrabl_error_t internal_tegrabl_car_clk_disable(uint32_t clk_id)
 
 	req_clk_disable.cmd_and_id = BPMP_CLK_CMD(CMD_CLK_DISABLE, clk_id);
 
+	clk_cache_lock_acquire();
+
 	/* TX */
 	if (TEGRABL_NO_ERROR != tegrabl_ccplex_bpmp_xfer(
 					&req_clk_disable, &resp_clk_disable,
@@ -985,11 +1152,19 @@ static tegrabl_error_t internal_tegrabl_car_clk_disable(uint32_t clk_id)
 					sizeof(struct mrq_clk_response),
 					MRQ_CLK)) {
 		pr_error("Error in tx-rx: %s,%d\n", __func__, __LINE__);
+		clk_cache_lock_release();
 		return TEGRABL_ERR_INVALID;
 	}
 
 	pr_trace("(%s,%d) Disabled - %d\n", __func__, __LINE__, clk_id);
 
+	/* Other users may still hold the clock, ask BPMP next time */
+	if (clk_id < TEGRA194_MAX_CLK_ID) {
+		clk_cache[clk_id].flags &= ~(CLK_CACHE_STATE_VALID | CLK_CACHE_ENABLED);
+	}
+
+	clk_cache_lock_release();
+
 		return TEGRABL_NO_ERROR;
 }
 
@@ -1045,6 +1220,8 @@ tegrabl_clk_src_id_t tegrabl_car_get_clk_src(
 {
 	struct mrq_clk_request req_clk_get_src;
 	struct mrq_clk_response resp_clk_get_src;
+	struct clk_cache_entry *entry;
+	uint32_t parent_id;
 	int32_t clk_id;
 
 	pr_trace("(%s,%d) %d, %d\n", __func__, __LINE__,
@@ -1055,6 +1232,15 @@ tegrabl_clk_src_id_t tegrabl_car_get_clk_src(
 		return TEGRABL_ERR_NOT_SUPPORTED;
 	}
 
+	clk_cache_lock_acquire();
+
+	entry = clk_cache_get((uint32_t)clk_id);
+	if ((entry != NULL) && ((entry->flags & CLK_CACHE_PARENT_VALID) != 0U)) {
+		parent_id = entry->parent_id;
+		clk_cache_lock_release();
+		return src_clk_bpmp_to_tegrabl(parent_id);
+	}
+
 	req_clk_get_src.cmd_and_id = BPMP_CLK_CMD(CMD_CLK_GET_PARENT, clk_id);
 
 	/* TX */
@@ -1064,6 +1250,7 @@ tegrabl_clk_src_id_t tegrabl_car_get_clk_src(
 					sizeof(struct mrq_clk_response),
 					MRQ_CLK)) {
 		pr_error("Error in tx-rx: %s,%d\n", __func__, __LINE__);
+		clk_cache_lock_release();
 		return TEGRABL_CLK_SRC_INVALID;
 	}
 
@@ -1071,6 +1258,13 @@ tegrabl_clk_src_id_t tegrabl_car_get_clk_src(
 	pr_trace("Received parent_id (from BPMP): %d\n",
 			 resp_clk_get_src.clk_get_parent.parent_id);
 
+	if (entry != NULL) {
+		entry->parent_id = (uint16_t)resp_clk_get_src.clk_get_parent.parent_id;
+		entry->flags |= CLK_CACHE_PARENT_VALID;
+	}
+
+	clk_cache_lock_release();
+
 	return src_clk_bpmp_to_tegrabl(resp_clk_get_src.clk_get_parent.parent_id);
 }
 
@@ -1192,7 +1386,7 @@ tegrabl_error_t tegrabl_car_set_clk_rate(
 	pr_trace("(%s,%d) %d, %d, %d\n", __func__, __LINE__,
 			 module, instance, rate_khz);
 
-	/* TODO - Add a condition to check if already enabled */
+	/* Always sent to BPMP, which counts it as one more enable of the clock */
 	tegrabl_car_clk_enable(module, instance, NULL);
 
 	return internal_tegrabl_car_set_clk_rate(
@@ -1468,6 +1662,20 @@ bool tegrabl_set_fuse_reg_visibility(bool visibility)
 	return true;
 }
 
+/* XUSB resets are controlled by PG sequence and cannot be asserted directly */
+static bool rst_controlled_by_pg(tegrabl_module_t module)
+{
+	switch (module) {
+	case TEGRABL_MODULE_XUSBF:
+	case TEGRABL_MODULE_XUSB_DEV:
+	case TEGRABL_MODULE_XUSB_HOST:
+	case TEGRABL_MODULE_XUSB_SS:
+		return true;
+	default:
+		return false;
+	}
+}
+
 /**
  * @brief Puts the module in reset
  *
@@ -1481,17 +1689,9 @@ tegrabl_error_t tegrabl_car_rst_set(tegrabl_module_t module,
 	pr_trace("(%s,%d) %d, %d\n", __func__, __LINE__,
 			 module, instance);
 
-	/* Handle XUSB RST exceptions - These resets are controlled by PG sequence */
-	switch (module) {
-	case TEGRABL_MODULE_XUSBF:
-	case TEGRABL_MODULE_XUSB_DEV:
-	case TEGRABL_MODULE_XUSB_HOST:
-	case TEGRABL_MODULE_XUSB_SS:
+	/* Handle XUSB RST exceptions */
+	if (rst_controlled_by_pg(module)) {
 		return TEGRABL_NO_ERROR;
-		break;
-	default:
-		/* Do nothing */
-		break;
 	}
 
 	return internal_tegrabl_car_rst(
@@ -1517,6 +1717,84 @@ tegrabl_error_t tegrabl_car_rst_clear(tegrabl_module_t module,
 				CMD_RESET_DEASSERT);
 }
 
+static tegrabl_error_t car_run_op(const struct tegrabl_car_op *op)
+{
+	uint32_t rate_set_khz;
+
+	switch (op->type) {
+	case TEGRABL_CAR_OP_CLK_ENABLE:
+		return tegrabl_car_clk_enable(op->module, op->instance, NULL);
+	case TEGRABL_CAR_OP_CLK_DISABLE:
+		return tegrabl_car_clk_disable(op->module, op->instance);
+	case TEGRABL_CAR_OP_CLK_SET_SRC:
+		return tegrabl_car_set_clk_src(op->module, op->instance,
+									   (tegrabl_clk_src_id_t)op->arg);
+	case TEGRABL_CAR_OP_CLK_SET_RATE:
+		return tegrabl_car_set_clk_rate(op->module, op->instance, op->arg,
+										&rate_set_khz);
+	case TEGRABL_CAR_OP_RST_SET:
+		return tegrabl_car_rst_set(op->module, op->instance);
+	case TEGRABL_CAR_OP_RST_CLEAR:
+		return tegrabl_car_rst_clear(op->module, op->instance);
+	default:
+		return TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, 0);
+	}
+}
+
+/**
+ * @brief Runs a sequence of clock/reset operations in order, stopping at the
+ * first failure.
+ *
+ * The IVC channel to BPMP holds a single frame and MRQ_CLK/MRQ_RESET carry
+ * one command each, so operations cannot share a message. Instead a reset
+ * assert immediately followed by a deassert of the same module becomes one
+ * CMD_RESET_MODULE. Every other operation is one request, enables included,
+ * as BPMP counts enables and disables per clock.
+ *
+ * @ops - Operations to run
+ * @num_ops - Number of entries in ops
+ * @return - TEGRABL_NO_ERROR if success, error of the failed operation otherwise.
+ */
+tegrabl_error_t tegrabl_car_run_ops(const struct tegrabl_car_op *ops,
+									uint32_t num_ops)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	const struct tegrabl_car_op *op;
+	const struct tegrabl_car_op *next;
+	uint32_t i;
+
+	if ((ops == NULL) && (num_ops != 0U)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, 0);
+	}
+
+	for (i = 0; i < num_ops; i++) {
+		op = &ops[i];
+		next = (i + 1U < num_ops) ? &ops[i + 1U] : NULL;
+
+		if ((op->type == TEGRABL_CAR_OP_RST_SET) && (next != NULL) &&
+			(next->type == TEGRABL_CAR_OP_RST_CLEAR) &&
+			(next->module == op->module) && (next->instance == op->instance) &&
+			!rst_controlled_by_pg(op->module)) {
+			pr_trace("(%s,%d) pulse reset %d, %d\n", __func__, __LINE__,
+					 op->module, op->instance);
+			err = internal_tegrabl_car_rst(
+					tegrabl_module_to_bpmp_id(op->module, op->instance, MOD_RST),
+					CMD_RESET_MODULE);
+			i++;
+		} else {
+			err = car_run_op(op);
+		}
+
+		if (err != TEGRABL_NO_ERROR) {
+			pr_error("%s: op %u (type %u) on module %d, %d failed\n", __func__,
+					 i, op->type, op->module, op->instance);
+			break;
+		}
+	}
+
+	return err;
+}
+
 tegrabl_error_t tegrabl_car_clk_get_reset_state(tegrabl_module_t module, uint8_t instance, bool *state)
 {
 	TEGRABL_UNUSED(module);
@@ -1593,18 +1871,22 @@ tegrabl_error_t tegrabl_usbf_clock_init(void)
 		}
 	}
 
-	/* unPowerGate XUSB */
+	/* unPowerGate XUSB, BPMP reprograms the partition clocks */
+	clk_cache_lock_acquire();
+	clk_cache_invalidate();
 	while (xusb_pg_request.id <= TEGRA194_POWER_DOMAIN_XUSBC) {
 		err = tegrabl_ccplex_bpmp_xfer(&xusb_pg_request, NULL, sizeof(xusb_pg_request), 0, MRQ_PG);
 		if (err != TEGRABL_NO_ERROR) {
 			pr_error("PG_STATE_ON for %d failed. Skipping others.\n", xusb_pg_request.id);
 			TEGRABL_SET_HIGHEST_MODULE(err);
+			clk_cache_lock_release();
 			goto fail;
 		} else {
 			pr_trace("un-Powergated %d\n", xusb_pg_request.id);
 		}
 		++(xusb_pg_request.id);
 	}
+	clk_cache_lock_release();
 	err = TEGRABL_NO_ERROR;
 
 fail:
@@ -1624,17 +1906,21 @@ tegrabl_error_t tegrabl_usb_powergate(void)
 	};
 
 	/* PowerGate XUSBA and XUSBC partitions */
+	clk_cache_lock_acquire();
+	clk_cache_invalidate();
 	while (xusb_pg_request.id <= TEGRA194_POWER_DOMAIN_XUSBC) {
 		err = tegrabl_ccplex_bpmp_xfer(&xusb_pg_request, NULL, sizeof(xusb_pg_request), 0, MRQ_PG);
 		if (err != TEGRABL_NO_ERROR) {
 			pr_error("PG_STATE_OFF for %d failed. Skipping others.\n", xusb_pg_request.id);
 			TEGRABL_SET_HIGHEST_MODULE(err);
+			clk_cache_lock_release();
 			goto fail;
 		} else {
 			pr_trace("Powergated %d\n", xusb_pg_request.id);
 		}
 		++(xusb_pg_request.id);
 	}
+	clk_cache_lock_release();
 	err = TEGRABL_NO_ERROR;
 
 fail:
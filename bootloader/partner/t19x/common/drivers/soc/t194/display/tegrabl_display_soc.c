@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017-2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2017-2020, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -16,6 +16,7 @@
 #include <powergate-t194.h>
 #include <tegrabl_i2c.h>
 #include <tegrabl_error.h>
+#include <tegrabl_clock.h>
 
 void tegrabl_display_unpowergate(void)
 {
@@ -38,6 +39,11 @@ void tegrabl_display_unpowergate(void)
 		(disp_pg_request.id)++;
 	}
 
+	/* BPMP reprogrammed the display clocks while changing the partition
+	 * state. Dropped once it is done, so that nothing another thread cached
+	 * in the meantime survives */
+	tegrabl_car_invalidate_clk_cache();
+
 	pr_debug("%s: display unpowergate done\n", __func__);
 }
 
@@ -62,6 +68,11 @@ void tegrabl_display_powergate(void)
 		(disp_pg_request.id)++;
 	}
 
+	/* BPMP reprogrammed the display clocks while changing the partition
+	 * state. Dropped once it is done, so that nothing another thread cached
+	 * in the meantime survives */
+	tegrabl_car_invalidate_clk_cache();
+
 	pr_debug("%s: display powergate done\n", __func__);
 }
 
@@ -18,7 +18,9 @@
 #ifndef INCLUDE_TEGRABL_QUAL_ENGINE_H
 #define INCLUDE_TEGRABL_QUAL_ENGINE_H
 
+#include <stdbool.h>
 #include <tegrabl_error.h>
+#include <tegrabl_timer.h>
 
 /**
  * @brief Initialize/Scrub memory using MSS qual engine
@@ -37,4 +39,15 @@ tegrabl_error_t tegrabl_sdram_qual_engine_init(uint64_t phy_addr_start, uint64_t
  */
 tegrabl_error_t tegrabl_sdram_qual_engine_wait_for_idle(void);
 
+/**
+ * @brief Check once whether Qual engine is idle, without waiting
+ *
+ * @param start_time_us Timestamp at which the scrub was started
+ * @param is_idle Set to true if Qual engine is idle (output)
+ *
+ * @return TEGRABL_NO_ERROR if idle or still within the scrub timeout;
+ * TEGRABL_ERR_TIMEOUT if busy past the timeout
+ */
+tegrabl_error_t tegrabl_sdram_qual_engine_check_idle(time_t start_time_us, bool *is_idle);
+
 #endif /* INCLUDE_TEGRABL_QUAL_ENGINE_H */
@@ -375,6 +375,57 @@ tegrabl_storage_type_t mb2_get_boot_device(void)
 	return boot_device;
 }
 
+#if defined(CONFIG_ENABLE_DEFERRED_STORAGE_INIT)
+/**
+* @brief Secondary storage devices, initialized on first use
+*/
+struct deferred_storage_device {
+	tegrabl_storage_type_t device_type;
+	uint32_t instance;
+	bool pending;
+};
+
+static struct deferred_storage_device deferred_devices[TEGRABL_MAX_STORAGE_DEVICES];
+static uint32_t num_deferred_devices;
+static struct tegrabl_device_config_params *deferred_device_config;
+
+static tegrabl_error_t init_deferred_storage_device(tegrabl_storage_type_t device_type,
+													uint32_t instance)
+{
+	tegrabl_error_t err = TEGRABL_ERROR(TEGRABL_ERR_NOT_FOUND, 0);
+	tegrabl_error_t dev_err;
+	struct deferred_storage_device *dev;
+	bool initialized = false;
+	uint32_t i;
+
+	for (i = 0; i < num_deferred_devices; i++) {
+		dev = &deferred_devices[i];
+		if (!dev->pending) {
+			continue;
+		}
+		if ((device_type != TEGRABL_STORAGE_INVALID) &&
+			((dev->device_type != device_type) || (dev->instance != instance))) {
+			continue;
+		}
+
+		/* Tried only once, a failed device stays uninitialized */
+		dev->pending = false;
+
+		pr_info("Initializing deferred %s-%u\n", tegrabl_blockdev_get_name(dev->device_type),
+				dev->instance);
+		dev_err = init_storage_device(deferred_device_config, dev->device_type, &dev->instance);
+		if (dev_err != TEGRABL_NO_ERROR) {
+			pr_error("Failed to initialize device %d-%d\n", dev->device_type, dev->instance);
+			err = dev_err;
+			continue;
+		}
+		initialized = true;
+	}
+
+	return initialized ? TEGRABL_NO_ERROR : err;
+}
+#endif
+
 tegrabl_error_t config_storage(struct tegrabl_device_config_params *device_config,
 							   struct tegrabl_device *devices)
 {
@@ -437,13 +488,30 @@ tegrabl_error_t config_storage(struct tegrabl_device_config_params *device_confi
 		instance = (uint32_t)devices[i].instance;
 		device = correct_device_and_instance(device, &instance);
 
+#if defined(CONFIG_ENABLE_DEFERRED_STORAGE_INIT)
+		/* Initialized by the first blockdev open or partition lookup that
+		 * needs it */
+		deferred_devices[num_deferred_devices].device_type = device;
+		deferred_devices[num_deferred_devices].instance = instance;
+		deferred_devices[num_deferred_devices].pending = true;
+		num_deferred_devices++;
+		pr_debug("Deferring init of %s-%u\n", tegrabl_blockdev_get_name(device), instance);
+#else
 		err = init_storage_device(device_config, device, &instance);
 		if (err != TEGRABL_NO_ERROR) {
 			pr_error("Failed to initialize device %d-%d\n", device, instance);
 			goto fail;
 		}
+#endif
 	}
 
+#if defined(CONFIG_ENABLE_DEFERRED_STORAGE_INIT)
+	if (num_deferred_devices != 0U) {
+		deferred_device_config = device_config;
+		tegrabl_blockdev_set_deferred_init(init_deferred_storage_device);
+	}
+#endif
+
 fail:
 	return err;
 }
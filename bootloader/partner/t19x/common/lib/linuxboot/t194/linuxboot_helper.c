@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2019, NVIDIA Corporation.  All Rights Reserved.
+ * Copyright (c) 2015-2020, NVIDIA Corporation.  All Rights Reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property and
  * proprietary rights in and to this software and related documentation.  Any
@@ -48,6 +48,9 @@
 
 #if defined(CONFIG_ENABLE_STAGED_SCRUBBING)
 #include <qual_engine.h>
+#include <tegrabl_timer.h>
+#include <kernel/thread.h>
+#include <kernel/mutex.h>
 #endif
 
 #if defined(CONFIG_ENABLE_A_B_SLOT)
@@ -1011,7 +1014,7 @@ storage:
 }
 
 static struct tegrabl_linuxboot_dtnode_info extra_nodes[] = {
-	{ "chosen", add_reset_info},
+	{ "chosen", add_reset_info, TEGRABL_LINUXBOOT_DTNODE_PER_BOOT },
 	{ "cpus" , update_cpu_floorsweeping_config },
 	{ "arm-pmu", update_armpmu_floorsweeping_config },
 	{ "reserved-memory", update_vpr_info },
@@ -1020,6 +1023,63 @@ static struct tegrabl_linuxboot_dtnode_info extra_nodes[] = {
 	{ NULL, NULL},
 };
 
+#if defined(CONFIG_ENABLE_DTB_CACHE)
+extern int __version_start;
+
+/* Inputs of the extra node fixups that are not part of boot_params */
+static struct {
+	uint32_t num_cores;
+	uint32_t mpidr[MAX_T194_CPUS];
+	uint32_t vpr_resize;
+	uint32_t secureos_type;
+	uint32_t boot_dev;
+	uint32_t boot_dev_instance;
+} dtb_fixup_inputs;
+
+static void get_dtb_cache_key(uint32_t region, struct tegrabl_linuxboot_memblock *memblock)
+{
+	tegrabl_storage_type_t boot_dev = 0;
+	uint32_t instance = 0;
+	uint32_t cpu;
+
+	memblock->base = 0;
+	memblock->size = 0;
+
+	switch (region) {
+	case 0:
+		/* The fixups themselves change with the bootloader */
+		memblock->base = (uintptr_t)&__version_start;
+		memblock->size = strlen((char *)&__version_start);
+		break;
+	case 1:
+		memblock->base = (uintptr_t)boot_params->carveout_info;
+		memblock->size = sizeof(boot_params->carveout_info);
+		break;
+	case 2:
+		memblock->base = (uintptr_t)boot_params->storage_devices;
+		memblock->size = sizeof(boot_params->storage_devices);
+		break;
+	case 3:
+		memset(&dtb_fixup_inputs, 0, sizeof(dtb_fixup_inputs));
+		dtb_fixup_inputs.num_cores = tegrabl_ccplex_nvg_num_cores();
+		for (cpu = 0; (cpu < dtb_fixup_inputs.num_cores) && (cpu < MAX_T194_CPUS); cpu++) {
+			dtb_fixup_inputs.mpidr[cpu] = tegrabl_ccplex_nvg_logical_to_mpidr(cpu);
+		}
+		dtb_fixup_inputs.vpr_resize = tegrabl_is_vpr_resize_enabled() ? 1U : 0U;
+		dtb_fixup_inputs.secureos_type = boot_params->secureos_type;
+		if (tegrabl_soc_get_bootdev(&boot_dev, &instance) == TEGRABL_NO_ERROR) {
+			dtb_fixup_inputs.boot_dev = boot_dev;
+			dtb_fixup_inputs.boot_dev_instance = instance;
+		}
+		memblock->base = (uintptr_t)&dtb_fixup_inputs;
+		memblock->size = sizeof(dtb_fixup_inputs);
+		break;
+	default:
+		break;
+	}
+}
+#endif
+
 /**
  * @brief Compare BOM/base of two carveouts
  *
@@ -1292,6 +1352,16 @@ tegrabl_error_t tegrabl_linuxboot_helper_get_info(tegrabl_linux_boot_info_t info
 		*(uint32_t *)out_data = boot_params->secureos_type;
 		break;
 
+#if defined(CONFIG_ENABLE_DTB_CACHE)
+	case TEGRABL_LINUXBOOT_INFO_DTB_CACHE_KEY:
+		if (in_data == NULL) {
+			err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+			goto fail;
+		}
+		get_dtb_cache_key(*((uint32_t *)in_data), (struct tegrabl_linuxboot_memblock *)out_data);
+		break;
+#endif
+
 	case TEGRABL_LINUXBOOT_INFO_BOARD:
 	default:
 		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
@@ -1404,13 +1474,38 @@ static void calculate_unscrubbed_dram_regions(void)
 	unscrubbed_dram_block_count = rgn;
 }
 
-tegrabl_error_t dram_staged_scrub(void)
+/* Background scrub is done in chunks so that on-demand ranges do not wait
+ * behind a whole multi-GB region */
+#define DRAM_SCRUB_CHUNK_SIZE		(256ULL * 1024ULL * 1024ULL)
+/* Each on-demand range can split a pending region into three */
+#define DRAM_SCRUB_PENDING_MAX		(CARVEOUT_NUM + 16U)
+#define DRAM_SCRUB_STACK_SIZE		8192U
+/* Qual engine page size */
+#define DRAM_SCRUB_ALIGNMENT		(16ULL * 1024ULL)
+
+struct dram_scrub_state {
+	thread_t *thread;
+	mutex_t lock;
+	/* Regions not yet handed to the qual engine, in scrub order */
+	struct tegrabl_linuxboot_memblock pending[DRAM_SCRUB_PENDING_MAX];
+	uint32_t pending_count;
+	/* Chunk being scrubbed by the qual engine, size 0 if none */
+	struct tegrabl_linuxboot_memblock inflight;
+	tegrabl_error_t err;
+};
+
+static struct dram_scrub_state dram_scrub;
+
+static bool dram_scrub_overlaps(struct tegrabl_linuxboot_memblock *blk, uint64_t base, uint64_t size)
+{
+	return (blk->size != 0ULL) && (blk->base < (base + size)) && (base < (blk->base + blk->size));
+}
+
+static tegrabl_error_t dram_scrub_blocking(void)
 {
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
 	uint32_t i = 0;
 
-	calculate_unscrubbed_dram_regions();
-
 	for (i = 0; (i < unscrubbed_dram_block_count); i++) {
 		/* Scrub region */
 		err = tegrabl_sdram_qual_engine_init(unscrubbed_dram_block[i].base, unscrubbed_dram_block[i].size);
@@ -1430,7 +1525,195 @@ tegrabl_error_t dram_staged_scrub(void)
 		pr_info("dram scrub successful\n");
 	}
 	return err;
+}
+
+static int dram_scrub_thread(void *arg)
+{
+	struct tegrabl_linuxboot_memblock chunk;
+	struct tegrabl_linuxboot_memblock *head;
+	time_t start_time_us;
+	bool is_idle = false;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	TEGRABL_UNUSED(arg);
+
+	while (err == TEGRABL_NO_ERROR) {
+		mutex_acquire(&dram_scrub.lock);
+		if (dram_scrub.pending_count == 0U) {
+			mutex_release(&dram_scrub.lock);
+			break;
+		}
+		head = &dram_scrub.pending[0];
+		chunk.base = head->base;
+		chunk.size = (head->size > DRAM_SCRUB_CHUNK_SIZE) ? DRAM_SCRUB_CHUNK_SIZE : head->size;
+		head->base += chunk.size;
+		head->size -= chunk.size;
+		if (head->size == 0ULL) {
+			dram_scrub.pending_count--;
+			memmove(&dram_scrub.pending[0], &dram_scrub.pending[1],
+					dram_scrub.pending_count * sizeof(dram_scrub.pending[0]));
+		}
+		dram_scrub.inflight = chunk;
+		mutex_release(&dram_scrub.lock);
+
+		pr_trace("scrub 0x%"PRIx64" - 0x%"PRIx64"\n", chunk.base, chunk.base + chunk.size);
+		err = tegrabl_sdram_qual_engine_init(chunk.base, chunk.size);
+		start_time_us = tegrabl_get_timestamp_us();
+		while (err == TEGRABL_NO_ERROR) {
+			err = tegrabl_sdram_qual_engine_check_idle(start_time_us, &is_idle);
+			if (is_idle) {
+				break;
+			}
+			/* Let the boot continue while the qual engine runs */
+			thread_sleep(1);
+		}
+
+		mutex_acquire(&dram_scrub.lock);
+		dram_scrub.inflight.size = 0ULL;
+		dram_scrub.err = err;
+		mutex_release(&dram_scrub.lock);
+	}
+
+	if (err != TEGRABL_NO_ERROR) {
+		pr_error("dram scrub failed\n");
+	} else {
+		pr_info("dram scrub successful\n");
+	}
+	return 0;
+}
+
+/* Move the parts of the pending regions that overlap [base, base + size) to
+ * the head of the scrub order. Called with the lock held. */
+static void dram_scrub_prioritize(uint64_t base, uint64_t size)
+{
+	static struct tegrabl_linuxboot_memblock front[DRAM_SCRUB_PENDING_MAX];
+	static struct tegrabl_linuxboot_memblock back[DRAM_SCRUB_PENDING_MAX];
+	struct tegrabl_linuxboot_memblock *blk;
+	uint32_t num_front = 0;
+	uint32_t num_back = 0;
+	uint64_t start;
+	uint64_t end;
+	uint32_t i;
+
+	for (i = 0; i < dram_scrub.pending_count; i++) {
+		if (dram_scrub_overlaps(&dram_scrub.pending[i], base, size)) {
+			num_front++;
+		}
+	}
+	if ((dram_scrub.pending_count + (2U * num_front)) > DRAM_SCRUB_PENDING_MAX) {
+		/* Out of slots, the range is still scrubbed, just not first */
+		return;
+	}
+	num_front = 0;
+
+	for (i = 0; i < dram_scrub.pending_count; i++) {
+		blk = &dram_scrub.pending[i];
+		if (!dram_scrub_overlaps(blk, base, size)) {
+			back[num_back++] = *blk;
+			continue;
+		}
+		/* Keep split points on qual engine page boundaries */
+		start = ROUND_DOWN(base, DRAM_SCRUB_ALIGNMENT);
+		end = ROUND_UP(base + size, DRAM_SCRUB_ALIGNMENT);
+		start = (start > blk->base) ? start : blk->base;
+		end = (end < (blk->base + blk->size)) ? end : (blk->base + blk->size);
+		front[num_front].base = start;
+		front[num_front].size = end - start;
+		num_front++;
+		if (start > blk->base) {
+			back[num_back].base = blk->base;
+			back[num_back].size = start - blk->base;
+			num_back++;
+		}
+		if (end < (blk->base + blk->size)) {
+			back[num_back].base = end;
+			back[num_back].size = (blk->base + blk->size) - end;
+			num_back++;
+		}
+	}
+
+	memcpy(&dram_scrub.pending[0], front, num_front * sizeof(front[0]));
+	memcpy(&dram_scrub.pending[num_front], back, num_back * sizeof(back[0]));
+	dram_scrub.pending_count = num_front + num_back;
+}
+
+tegrabl_error_t dram_staged_scrub(void)
+{
+	uint32_t i;
+
+	calculate_unscrubbed_dram_regions();
+
+	if (dram_scrub.thread != NULL) {
+		return TEGRABL_NO_ERROR;
+	}
+
+	mutex_init(&dram_scrub.lock);
+	for (i = 0; i < unscrubbed_dram_block_count; i++) {
+		dram_scrub.pending[i] = unscrubbed_dram_block[i];
+	}
+	dram_scrub.pending_count = unscrubbed_dram_block_count;
+	dram_scrub.inflight.size = 0ULL;
+	dram_scrub.err = TEGRABL_NO_ERROR;
+
+	dram_scrub.thread = thread_create("dram_scrub", dram_scrub_thread, NULL,
+									  DEFAULT_PRIORITY, DRAM_SCRUB_STACK_SIZE);
+	if (dram_scrub.thread == NULL) {
+		pr_warn("Failed to create dram scrub thread, scrubbing inline\n");
+		dram_scrub.pending_count = 0U;
+		return dram_scrub_blocking();
+	}
+	thread_resume(dram_scrub.thread);
+
+	return TEGRABL_NO_ERROR;
+}
+
+tegrabl_error_t dram_staged_scrub_range(uint64_t base, uint64_t size)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	bool is_pending;
+	uint32_t i;
+
+	if ((dram_scrub.thread == NULL) || (size == 0ULL)) {
+		return TEGRABL_NO_ERROR;
+	}
+
+	mutex_acquire(&dram_scrub.lock);
+	dram_scrub_prioritize(base, size);
+	mutex_release(&dram_scrub.lock);
+
+	do {
+		mutex_acquire(&dram_scrub.lock);
+		err = dram_scrub.err;
+		is_pending = dram_scrub_overlaps(&dram_scrub.inflight, base, size);
+		for (i = 0; !is_pending && (i < dram_scrub.pending_count); i++) {
+			is_pending = dram_scrub_overlaps(&dram_scrub.pending[i], base, size);
+		}
+		mutex_release(&dram_scrub.lock);
+		if (err != TEGRABL_NO_ERROR) {
+			break;
+		}
+		if (is_pending) {
+			thread_sleep(1);
+		}
+	} while (is_pending);
+
+	if (err != TEGRABL_NO_ERROR) {
+		pr_error("dram scrub of 0x%"PRIx64" - 0x%"PRIx64" failed\n", base, base + size);
+	}
+	return err;
+}
 
+tegrabl_error_t dram_staged_scrub_wait(void)
+{
+	if (dram_scrub.thread == NULL) {
+		return TEGRABL_NO_ERROR;
+	}
+
+	pr_info("Waiting for dram scrub to complete\n");
+	thread_join(dram_scrub.thread, NULL, INFINITE_TIME);
+	dram_scrub.thread = NULL;
+
+	return dram_scrub.err;
 }
 #endif /* CONFIG_ENABLE_STAGED_SCRUBBING */
 
@@ -1462,8 +1745,15 @@ tegrabl_error_t tegrabl_get_boot_img_load_addr(void **load_addr)
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
 
 	if (boot_img_load_addr == NULL) {
+#if defined(CONFIG_ENABLE_KERNEL_INPLACE_DECOMP)
+		/* Tail of the kernel region, the kernel is extracted forward over it.
+		 * The region is scrubbed before anything is loaded into it. */
+		*load_addr = (void *)(uintptr_t)(ROUND_DOWN(tegrabl_get_kernel_load_addr(), KERNEL_ALIGNMENT) +
+										 MAX_KERNEL_IMAGE_SIZE - BOOT_IMAGE_MAX_SIZE);
+#else
 		*load_addr = tegrabl_alloc_align(TEGRABL_HEAP_DMA,
 			BOOT_IMAGE_ALIGNMENT, BOOT_IMAGE_MAX_SIZE);
+#endif
 		if (*load_addr == NULL) {
 			pr_error("Failed to allocate memory (0x%08x) to load boot image\n", BOOT_IMAGE_MAX_SIZE);
 			err = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
@@ -1479,6 +1769,17 @@ fail:
 	return err;
 }
 
+static void os_carveout_scrub(uint64_t base, uint64_t size)
+{
+#if defined(CONFIG_ENABLE_STAGED_SCRUBBING)
+	/* Failures are reported again by dram_staged_scrub_wait() before handoff */
+	(void)dram_staged_scrub_range(base, size);
+#else
+	TEGRABL_UNUSED(base);
+	TEGRABL_UNUSED(size);
+#endif
+}
+
 uint64_t tegrabl_get_kernel_load_addr(void)
 {
 	uint64_t kernel_load_addr;
@@ -1493,6 +1794,7 @@ uint64_t tegrabl_get_kernel_load_addr(void)
 	if (os_carveout_next_free_addr == 0ULL) {
 		os_carveout_next_free_addr = kernel_load_addr + MAX_KERNEL_IMAGE_SIZE;
 	}
+	os_carveout_scrub(kernel_load_addr, MAX_KERNEL_IMAGE_SIZE);
 
 	/* Load kernel at text offset */
 	return kernel_load_addr + 0x80000ULL;
@@ -1514,6 +1816,7 @@ uint64_t tegrabl_get_dtb_load_addr(void)
 
 	/* Update next free addr ptr */
 	os_carveout_next_free_addr = dtb_load_addr + DTB_MAX_SIZE;
+	os_carveout_scrub(dtb_load_addr, DTB_MAX_SIZE);
 
 	return dtb_load_addr;
 }
@@ -1534,6 +1837,7 @@ uint64_t tegrabl_get_ramdisk_load_addr(void)
 
 	/* Update next free addr ptr */
 	os_carveout_next_free_addr = ramdisk_load_addr + RAMDISK_MAX_SIZE;
+	os_carveout_scrub(ramdisk_load_addr, RAMDISK_MAX_SIZE);
 
 	return ramdisk_load_addr;
 }
@@ -1576,3 +1880,19 @@ bool tegrabl_do_ratchet_check(uint8_t bin_type, void * const addr)
 fail:
 	return status;
 }
+
+uint64_t tegrabl_get_bch_binary_size(void * const addr, uint32_t size)
+{
+	NvBootComponentHeader *bch_addr = addr;
+
+	if ((size < sizeof(*bch_addr)) || (memcmp(bch_addr->HeaderMagic, "NVDA", 4) != 0)) {
+		return 0;
+	}
+
+	/* Only component 0 is authenticated, its payload follows the header */
+	if (bch_addr->NumBinaries2 != 1U) {
+		return 0;
+	}
+
+	return sizeof(*bch_addr) + (uint64_t)bch_addr->Stage2Components[0].BinaryLen;
+}
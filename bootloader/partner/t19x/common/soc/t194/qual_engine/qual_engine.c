@@ -64,10 +64,9 @@ tegrabl_error_t tegrabl_sdram_qual_engine_init(uint64_t phy_addr_start, uint64_t
 	return err;
 }
 
-tegrabl_error_t tegrabl_sdram_qual_engine_wait_for_idle(void)
+tegrabl_error_t tegrabl_sdram_qual_engine_check_idle(time_t start_time_us, bool *is_idle)
 {
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
-	time_t start_time_us = tegrabl_get_timestamp_us();
 	time_t timeout_us;
 
 	if (tegrabl_is_fpga()) {
@@ -77,10 +76,23 @@ tegrabl_error_t tegrabl_sdram_qual_engine_wait_for_idle(void)
 	}
 
 	/* status of Qual Engine (0=IDLE, 1=BUSY) */
-	while (tegrabl_qualengine_check_status()) {
-		if ((tegrabl_get_timestamp_us() - start_time_us) > timeout_us) {
-			pr_error("Qual engine NOT idle post timeout\n");
-			error = TEGRABL_ERROR(TEGRABL_ERR_TIMEOUT, 0);
+	*is_idle = !tegrabl_qualengine_check_status();
+	if (!(*is_idle) && ((tegrabl_get_timestamp_us() - start_time_us) > timeout_us)) {
+		pr_error("Qual engine NOT idle post timeout\n");
+		error = TEGRABL_ERROR(TEGRABL_ERR_TIMEOUT, 0);
+	}
+	return error;
+}
+
+tegrabl_error_t tegrabl_sdram_qual_engine_wait_for_idle(void)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	time_t start_time_us = tegrabl_get_timestamp_us();
+	bool is_idle = false;
+
+	while (true) {
+		error = tegrabl_sdram_qual_engine_check_idle(start_time_us, &is_idle);
+		if ((error != TEGRABL_NO_ERROR) || is_idle) {
 			break;
 		}
 		/* delay before next check */
@@ -88,4 +100,3 @@ tegrabl_error_t tegrabl_sdram_qual_engine_wait_for_idle(void)
 	}
 	return error;
 }
-